@@ -0,0 +1,169 @@
+// Offline benchmark for the analysis stages.
+// Feeds a WAV file (or a synthesized mix of chords and drum hits when none is
+// given) through SpectrumAnalyzer block by block, exactly as the capture
+// thread does, and reports per-block cost against the HPSS budget. The
+// loudness meter, which runs per capture packet rather than as a stage, is
+// timed alongside.
+//
+// Usage: AnalysisBenchmark [input.wav] [--budget <microseconds>] [--repeat <n>]
+
+#include "SpectrumAnalyzer.h"
+#include "WavReader.h"
+#include "LoudnessMeter.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// 30 s of sustained chords with a kick every beat and a noise snare on the
+// off-beats at 120 BPM, so both HPSS outputs have something to find
+static void SynthesizeMix(WavData& wav) {
+    const int sampleRate = 48000;
+    const int seconds = 30;
+    wav.sampleRate = sampleRate;
+    wav.channels = 1;
+    wav.samples.assign(sampleRate * seconds, 0.0f);
+
+    const float chords[4][3] = { {220.0f, 277.2f, 329.6f}, {196.0f, 246.9f, 293.7f},
+                                 {174.6f, 220.0f, 261.6f}, {164.8f, 207.7f, 246.9f} };
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+
+    for (size_t i = 0; i < wav.samples.size(); i++) {
+        double t = (double)i / sampleRate;
+        const float* chord = chords[(int)(t / 2.0) % 4];
+        float v = 0.0f;
+        for (int n = 0; n < 3; n++) {
+            for (int h = 1; h <= 4; h++) {
+                v += 0.05f / h * (float)sin(2.0 * M_PI * chord[n] * h * t);
+            }
+        }
+
+        double beat = fmod(t, 0.5);
+        if (beat < 0.15) {
+            // Kick: falling sine sweep
+            double f = 50.0 + 100.0 * exp(-beat * 40.0);
+            v += 0.6f * (float)(exp(-beat * 25.0) * sin(2.0 * M_PI * f * beat));
+        }
+        double offBeat = fmod(t + 0.25, 0.5);
+        if (offBeat < 0.08) {
+            v += 0.3f * (float)exp(-offBeat * 50.0) * noise(rng);
+        }
+        wav.samples[i] = v;
+    }
+}
+
+static float Percentile(std::vector<float> values, float p) {
+    if (values.empty()) return 0.0f;
+    size_t k = (size_t)(p * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+int main(int argc, char** argv) {
+    std::string path;
+    float budget = HarmonicPercussiveSeparator::DEFAULT_BUDGET_MICROS;
+    int repeat = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc) budget = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) repeat = std::max(1, atoi(argv[++i]));
+        else path = argv[i];
+    }
+
+    WavData wav;
+    if (!path.empty()) {
+        if (!ReadWavFile(path, wav)) return 1;
+        std::cout << "Input: " << path << " (" << wav.sampleRate << " Hz, " << wav.channels << " ch, "
+                  << (double)wav.samples.size() / wav.sampleRate << " s)" << std::endl;
+    } else {
+        SynthesizeMix(wav);
+        std::cout << "Input: synthesized mix (" << wav.samples.size() / wav.sampleRate << " s)" << std::endl;
+    }
+
+    const int blockSize = SpectrumAnalyzer::FFT_SIZE;
+    if (wav.samples.size() < (size_t)blockSize) {
+        std::cerr << "Input is shorter than one FFT block" << std::endl;
+        return 1;
+    }
+
+    // AudioData is ~130 KB; keep it off the stack
+    std::unique_ptr<SpectrumAnalyzer> analyzer(new SpectrumAnalyzer());
+    std::unique_ptr<AudioData> data(new AudioData());
+    analyzer->SetRequiredFeatures(Feature_SpectrumNormalized | Feature_HarmonicPercussive);
+    HarmonicPercussiveSeparator& separator = analyzer->GetSeparator();
+    separator.SetBudgetMicros(budget);
+
+    // The WAV is already mixed to mono, so the meter sees one channel
+    std::unique_ptr<LoudnessMeter> loudness(new LoudnessMeter());
+    loudness->Configure(wav.sampleRate, 1);
+
+    std::vector<float> block(blockSize);
+    std::vector<float> blockMicros, hpssMicros, loudnessMicros;
+    double harmonicEnergy = 0.0, percussiveEnergy = 0.0;
+    float deltaTime = (float)blockSize / wav.sampleRate;
+    size_t blocks = wav.samples.size() / blockSize;
+
+    typedef std::chrono::steady_clock Clock;
+    for (int r = 0; r < repeat; r++) {
+        for (size_t b = 0; b < blocks; b++) {
+            memcpy(block.data(), &wav.samples[b * blockSize], blockSize * sizeof(float));
+
+            Clock::time_point start = Clock::now();
+            loudness->Process(block.data(), blockSize);
+            loudnessMicros.push_back(std::chrono::duration<float, std::micro>(Clock::now() - start).count());
+
+            start = Clock::now();
+            analyzer->Process(block, deltaTime, *data);
+            blockMicros.push_back(std::chrono::duration<float, std::micro>(Clock::now() - start).count());
+            hpssMicros.push_back(separator.GetLastMicros());
+
+            for (int i = 0; i < SpectrumAnalyzer::NUM_BINS; i++) {
+                harmonicEnergy += data->SpectrumHarmonic[i] * data->SpectrumHarmonic[i];
+                percussiveEnergy += data->SpectrumPercussive[i] * data->SpectrumPercussive[i];
+            }
+        }
+    }
+
+    double blockPeriod = 1e6 * blockSize / wav.sampleRate;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Blocks: " << blockMicros.size() << " (" << blockPeriod << " us of audio each)" << std::endl;
+    std::cout << "HPSS budget: " << budget << " us" << std::endl;
+    std::cout << std::endl;
+    std::cout << "           mean      p50      p99      max" << std::endl;
+
+    const struct { const char* name; std::vector<float>* values; } rows[] = {
+        { "Block", &blockMicros }, { "HPSS ", &hpssMicros }, { "LUFS ", &loudnessMicros }
+    };
+    for (const auto& row : rows) {
+        double sum = 0.0;
+        for (float v : *row.values) sum += v;
+        std::cout << row.name << "  " << std::setw(8) << sum / row.values->size()
+                  << " " << std::setw(8) << Percentile(*row.values, 0.5f)
+                  << " " << std::setw(8) << Percentile(*row.values, 0.99f)
+                  << " " << std::setw(8) << *std::max_element(row.values->begin(), row.values->end())
+                  << "  us" << std::endl;
+    }
+
+    std::cout << std::endl;
+    std::cout << "Budget cutoffs: " << separator.GetCutoffCount() << " of " << separator.GetBlockCount() << " blocks" << std::endl;
+    std::cout << "Final percussive window: " << separator.GetPercussiveWindow() << " bins" << std::endl;
+    std::cout << "Loudness: " << loudness->GetShortTermLUFS() << " LUFS short-term, true peak "
+              << loudness->GetTruePeakDB() << " dBTP" << std::endl;
+    double total = harmonicEnergy + percussiveEnergy;
+    if (total > 0.0) {
+        std::cout << "Energy split: " << 100.0 * harmonicEnergy / total << "% harmonic, "
+                  << 100.0 * percussiveEnergy / total << "% percussive" << std::endl;
+    }
+    return 0;
+}
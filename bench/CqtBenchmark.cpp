@@ -0,0 +1,143 @@
+// Compares the sparse-kernel constant-Q transform against the naive per-bin
+// CQT (a direct windowed correlation for every bin), and the kernel build
+// against loading it from the disk cache.
+//
+// Usage: CqtBenchmark [input.wav] [--blocks <n>]
+
+#include "ConstantQ.h"
+#include "WavReader.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+static double MicrosSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+// Reference: correlate each bin's window directly with the time signal
+class NaiveCQT {
+public:
+    explicit NaiveCQT(const ConstantQ& geometry) {
+        for (int bin = 0; bin < ConstantQ::NUM_BINS; bin++) {
+            int length = geometry.BinLength(bin);
+            m_offsets.push_back((ConstantQ::FFT_SIZE - length) / 2);
+            double step = 2.0 * M_PI * geometry.BinFrequency(bin) / geometry.GetSampleRate();
+            std::vector<std::complex<float>> kernel(length);
+            for (int n = 0; n < length; n++) {
+                double window = 0.5 - 0.5 * cos(2.0 * M_PI * n / length);
+                double phase = step * n;
+                kernel[n] = std::complex<float>((float)(window / length * cos(phase)), (float)(-window / length * sin(phase)));
+            }
+            m_kernels.push_back(kernel);
+        }
+    }
+
+    // window holds FFT_SIZE samples, oldest first
+    void Process(const float* window, float* out) const {
+        for (int bin = 0; bin < ConstantQ::NUM_BINS; bin++) {
+            const std::vector<std::complex<float>>& kernel = m_kernels[bin];
+            const float* x = window + m_offsets[bin];
+            std::complex<float> sum(0.0f, 0.0f);
+            for (size_t n = 0; n < kernel.size(); n++) sum += x[n] * kernel[n];
+            out[bin] = std::abs(sum);
+        }
+    }
+
+private:
+    std::vector<int> m_offsets;
+    std::vector<std::vector<std::complex<float>>> m_kernels;
+};
+
+int main(int argc, char** argv) {
+    std::string path;
+    int maxBlocks = 2000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--blocks") == 0 && i + 1 < argc) maxBlocks = std::max(1, atoi(argv[++i]));
+        else path = argv[i];
+    }
+
+    // Input: a WAV, or a chord sweep across the CQ range
+    WavData wav;
+    if (!path.empty()) {
+        if (!ReadWavFile(path, wav)) return 1;
+    } else {
+        wav.sampleRate = 48000;
+        wav.channels = 1;
+        wav.samples.resize(48000 * 20);
+        for (size_t i = 0; i < wav.samples.size(); i++) {
+            double t = (double)i / wav.sampleRate;
+            double root = 110.0 * pow(2.0, (int)(t * 2.0) % 48 / 12.0);
+            wav.samples[i] = (float)(0.3 * sin(2.0 * M_PI * root * t) + 0.2 * sin(2.0 * M_PI * root * 1.2599 * t) +
+                                     0.2 * sin(2.0 * M_PI * root * 1.4983 * t));
+        }
+    }
+
+    // Kernel build vs cached load
+    std::filesystem::path cacheDir = std::filesystem::temp_directory_path() / "musicvis_cqt_bench";
+    std::filesystem::remove_all(cacheDir);
+    std::filesystem::create_directories(cacheDir);
+
+    std::unique_ptr<ConstantQ> cqt(new ConstantQ());
+    Clock::time_point start = Clock::now();
+    cqt->Configure(wav.sampleRate, cacheDir);
+    double buildMicros = MicrosSince(start);
+
+    std::unique_ptr<ConstantQ> cached(new ConstantQ());
+    start = Clock::now();
+    cached->Configure(wav.sampleRate, cacheDir);
+    double loadMicros = MicrosSince(start);
+    std::filesystem::remove_all(cacheDir);
+
+    printf("Kernel: %d bins, %d non-zeros (%.1f%% of dense)\n", ConstantQ::NUM_BINS, cqt->GetNonZeroCount(),
+           100.0 * cqt->GetNonZeroCount() / (ConstantQ::NUM_BINS * (ConstantQ::FFT_SIZE / 2 + 1)));
+    printf("Kernel build: %.0f us, cache load: %.0f us%s\n", buildMicros, loadMicros,
+           cached->IsLoadedFromCache() ? "" : " (cache NOT used)");
+
+    // Per-block cost and agreement
+    NaiveCQT naive(*cqt);
+    const int hop = 512;
+    int blocks = std::min(maxBlocks, (int)(wav.samples.size() / hop));
+    std::vector<float> sparseOut(ConstantQ::NUM_BINS), naiveOut(ConstantQ::NUM_BINS), window(ConstantQ::FFT_SIZE);
+    double sparseMicros = 0.0, naiveMicros = 0.0, maxError = 0.0;
+
+    for (int b = 0; b < blocks; b++) {
+        start = Clock::now();
+        cqt->Process(&wav.samples[(size_t)b * hop], hop, sparseOut.data());
+        sparseMicros += MicrosSince(start);
+
+        cqt->CopyWindow(window.data());
+        start = Clock::now();
+        naive.Process(window.data(), naiveOut.data());
+        naiveMicros += MicrosSince(start);
+
+        // Compare once the ring is full; the zero-padded start is all edge
+        float peak = *std::max_element(naiveOut.begin(), naiveOut.end());
+        if ((b + 1) * hop >= ConstantQ::FFT_SIZE && peak > 1e-4f) {
+            for (int i = 0; i < ConstantQ::NUM_BINS; i++) {
+                maxError = std::max(maxError, (double)fabsf(sparseOut[i] - naiveOut[i]) / peak);
+            }
+        }
+    }
+
+    printf("\nBlocks: %d\n", blocks);
+    printf("Sparse CQT: %8.1f us/block\n", sparseMicros / blocks);
+    printf("Naive CQT:  %8.1f us/block\n", naiveMicros / blocks);
+    printf("Speed-up:   %8.1fx\n", naiveMicros / sparseMicros);
+    printf("Max error:  %8.4f%% of block peak\n", 100.0 * maxError);
+    return 0;
+}
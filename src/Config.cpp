@@ -1,4 +1,6 @@
 #include "Config.h"
+#include <windows.h>
+#include <shlobj.h>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -57,6 +59,12 @@ bool Config::Load() {
         
         // Parse settings
         if (key == "useNormalized") useNormalized = (value == "1" || value == "true");
+        else if (key == "loudnessAgc") loudnessAgc = (value == "1" || value == "true");
+        else if (key == "spectrumWeighting") spectrumWeighting = std::stoi(value);
+        else if (key == "noiseGate") noiseGate = (value == "1" || value == "true");
+        else if (key == "sharedMemoryOutput") sharedMemoryOutput = (value == "1" || value == "true");
+        else if (key == "udpOutput") udpOutput = value;
+        else if (key == "udpBands") udpBands = std::stoi(value);
         else if (key == "isFullscreen") isFullscreen = (value == "1" || value == "true");
         else if (key == "showBackground") showBackground = (value == "1" || value == "true");
         else if (key == "clockEnabled") clockEnabled = (value == "1" || value == "true");
@@ -112,6 +120,12 @@ bool Config::Save() {
     
     file << "# Main Settings\n";
     file << "useNormalized=" << (useNormalized ? "1" : "0") << "\n";
+    file << "loudnessAgc=" << (loudnessAgc ? "1" : "0") << "\n";
+    file << "spectrumWeighting=" << spectrumWeighting << "\n";
+    file << "noiseGate=" << (noiseGate ? "1" : "0") << "\n";
+    file << "sharedMemoryOutput=" << (sharedMemoryOutput ? "1" : "0") << "\n";
+    file << "udpOutput=" << udpOutput << "\n";
+    file << "udpBands=" << udpBands << "\n";
     file << "isFullscreen=" << (isFullscreen ? "1" : "0") << "\n";
     file << "showBackground=" << (showBackground ? "1" : "0") << "\n";
     file << "clockEnabled=" << (clockEnabled ? "1" : "0") << "\n";
@@ -163,6 +177,11 @@ bool Config::Save() {
 void Config::Reset() {
     // Reset to defaults
     useNormalized = true;
+    loudnessAgc = false;
+    spectrumWeighting = 0;
+    noiseGate = false;
+    // sharedMemoryOutput and udpOutput are left alone: they're set up for
+    // the venue, not a look
     isFullscreen = false;
     showBackground = false;
     clockEnabled = false;
@@ -1,8 +1,6 @@
 #pragma once
 #include <string>
 #include <vector>
-#include <windows.h>
-#include <shlobj.h>
 
 class Config {
 public:
@@ -10,6 +8,12 @@ public:
     
     // Main settings
     bool useNormalized = true;
+    bool loudnessAgc = false;    // AGC follows LUFS instead of peak magnitude
+    int spectrumWeighting = 0;   // 0 = flat, 1 = A-weighting, 2 = tilt
+    bool noiseGate = false;      // Subtract the tracked noise floor before normalizing
+    bool sharedMemoryOutput = false;  // Publish the spectrum for other processes (MusicVisShm.h)
+    std::string udpOutput;       // "host:port" to stream spectrum bands to; empty = off
+    int udpBands = 32;           // Log-spaced bands per streamed frame (1-128)
     bool isFullscreen = false;
     bool showBackground = false;
     bool clockEnabled = false;
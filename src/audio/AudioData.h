@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+
+class SpectrumHistory;
+
+// Analysis outputs a visualization can ask for.
+// The engine only runs the stages needed to produce the requested set.
+enum AnalysisFeature : uint32_t {
+    Feature_None               = 0,
+    Feature_Spectrum           = 1u << 0,  // Spectrum
+    Feature_SpectrumNormalized = 1u << 1,  // SpectrumNormalized + Scale
+    Feature_History            = 1u << 2,  // History
+    Feature_HistoryNormalized  = 1u << 3,  // HistoryNormalized
+    Feature_HighestSample      = 1u << 4,  // SpectrumHighestSample
+    // 1u << 5 is free; the bits are kept stable for shared-memory readers
+    Feature_HarmonicPercussive = 1u << 6,  // SpectrumHarmonic + SpectrumPercussive
+    Feature_Tempo              = 1u << 7,  // TempoBPM, TempoConfidence, BeatPhase
+    Feature_Loudness           = 1u << 8,  // LoudnessMomentary/ShortTerm, TruePeak
+    Feature_LongHistory        = 1u << 9,  // LongHistory (seconds to minutes)
+    Feature_ConstantQ          = 1u << 10, // SpectrumCQT
+    Feature_Descriptors        = 1u << 11, // Chroma, SpectralCentroid/Rolloff/Flatness/Flux
+    Feature_NoiseFloor         = 1u << 12, // NoiseFloor
+    Feature_Envelope           = 1u << 13, // SpectrumSmoothed + SpectrumPeak
+    Feature_All                = 0xFFFFFFFFu
+};
+
+struct AudioData {
+    bool playing = false;
+    float Spectrum[256] = {0};
+    float History[60][256] = {0};
+    float Scale = 1.0f;
+    float SpectrumNormalized[256] = {0};
+    float HistoryNormalized[60][256] = {0};
+    float SpectrumHighestSample[256] = {0};
+
+    // Helper for circular buffer index
+    int historyIndex = 0;
+
+    // SpectrumNormalized split into tonal and transient parts (they sum to it)
+    float SpectrumHarmonic[256] = {0};
+    float SpectrumPercussive[256] = {0};
+
+    // Tempo from the onset envelope. TempoBPM is 0 until one is found;
+    // BeatPhase runs 0 -> 1 between beats (0 = on the beat).
+    float TempoBPM = 0.0f;
+    float TempoConfidence = 0.0f;
+    float BeatPhase = 0.0f;
+
+    // BS.1770 loudness of the captured stream (LUFS, -70 = silence) and the
+    // 4x oversampled true peak over the last 400 ms (dBTP)
+    float LoudnessMomentary = -70.0f;
+    float LoudnessShortTerm = -70.0f;
+    float TruePeak = -70.0f;
+
+    // Normalized spectrum history over seconds to minutes, read through
+    // SpectrumHistory::Read(). nullptr unless Feature_LongHistory is requested.
+    const SpectrumHistory* LongHistory = nullptr;
+
+    // Constant-Q spectrum: 84 semitone bins from A2 (110 Hz), 0-1 with its own AGC
+    float SpectrumCQT[84] = {0};
+
+    // Pitch-class profile (C, C#, ... B; strongest = 1) and spectral shape.
+    // Centroid and rolloff (85% of the magnitude below it) are in Hz;
+    // flatness runs 0 (tonal) to 1 (noise); flux is the rise in the spectrum
+    // since the previous block, relative to its total.
+    float Chroma[12] = {0};
+    float SpectralCentroid = 0.0f;
+    float SpectralRolloff = 0.0f;
+    float SpectralFlatness = 0.0f;
+    float SpectralFlux = 0.0f;
+
+    // Per-bin noise floor estimate in Spectrum units (multiply by Scale to
+    // compare with SpectrumNormalized). Tracked when requested or while the
+    // noise gate is on.
+    float NoiseFloor[256] = {0};
+
+    // SpectrumNormalized through per-bin envelope followers on the audio
+    // thread, timed from the capture clock. Smoothed has a short attack and
+    // release; Peak jumps up instantly and falls slowly (peak markers).
+    float SpectrumSmoothed[256] = {0};
+    float SpectrumPeak[256] = {0};
+};
+
+// One published analysis frame, stamped with the capture time of the last
+// sample in its FFT block (seconds, same clock as the renderer's QPC time).
+struct SpectrumFrame {
+    double timestamp = 0.0;
+    float Scale = 1.0f;
+    float Spectrum[256] = {0};
+    float SpectrumNormalized[256] = {0};
+    float SpectrumHighestSample[256] = {0};
+    float SpectrumHarmonic[256] = {0};
+    float SpectrumPercussive[256] = {0};
+    float TempoBPM = 0.0f;
+    float TempoConfidence = 0.0f;
+    float BeatPhase = 0.0f;
+    float LoudnessMomentary = -70.0f;
+    float LoudnessShortTerm = -70.0f;
+    float TruePeak = -70.0f;
+    float SpectrumCQT[84] = {0};
+    float Chroma[12] = {0};
+    float SpectralCentroid = 0.0f;
+    float SpectralRolloff = 0.0f;
+    float SpectralFlatness = 0.0f;
+    float SpectralFlux = 0.0f;
+    float NoiseFloor[256] = {0};
+    float SpectrumSmoothed[256] = {0};
+    float SpectrumPeak[256] = {0};
+};
@@ -2,15 +2,15 @@
 #include <windows.h>
 #include <mmdeviceapi.h>
 #include <audioclient.h>
+#include <shlobj.h>
 #include <cmath>
-#include <complex>
 #include <iostream>
+#include <cstring>
+#include <filesystem>
+#include "../common/Profiler.h"
 
-#define M_PI 3.14159265358979323846
-
-AudioEngine::AudioEngine() : m_running(false) {
+AudioEngine::AudioEngine() : m_running(false), m_sharedMemoryOutput(false) {
     QueryPerformanceFrequency(&m_frequency);
-    QueryPerformanceCounter(&m_lastTime);
 }
 
 AudioEngine::~AudioEngine() {
@@ -30,28 +30,35 @@ void AudioEngine::Update() {
     // Main thread updates if necessary
 }
 
-// Simple FFT implementation
-void fft(std::vector<std::complex<float>>& x) {
-    const size_t N = x.size();
-    if (N <= 1) return;
+double AudioEngine::GetTime() const {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)m_frequency.QuadPart;
+}
 
-    std::vector<std::complex<float>> even(N / 2), odd(N / 2);
-    for (size_t i = 0; i < N / 2; ++i) {
-        even[i] = x[2 * i];
-        odd[i] = x[2 * i + 1];
-    }
+bool AudioEngine::GetInterpolatedData(double presentTime, AudioData& out) const {
+    out.playing = m_data.playing;
 
-    fft(even);
-    fft(odd);
+    // Interpolate one FFT block behind so we normally sit between the two
+    // newest frames rather than extrapolating past the latest one
+    double blockDuration = (double)SpectrumAnalyzer::FFT_SIZE / m_sampleRate;
+    if (!m_publisher.Interpolate(presentTime, blockDuration, out)) return false;
 
-    for (size_t k = 0; k < N / 2; ++k) {
-        std::complex<float> t = std::polar(1.0f, (float)(-2 * M_PI * k / N)) * odd[k];
-        x[k] = even[k] + t;
-        x[k + N / 2] = even[k] - t;
+    // History is not interpolated; copy it only when someone reads it
+    uint32_t features = m_analyzer.GetRequiredFeatures();
+    if (features & Feature_History) {
+        memcpy(out.History, m_data.History, sizeof(out.History));
+    }
+    if (features & Feature_HistoryNormalized) {
+        memcpy(out.HistoryNormalized, m_data.HistoryNormalized, sizeof(out.HistoryNormalized));
     }
+    out.historyIndex = m_data.historyIndex;
+    out.LongHistory = (features & Feature_LongHistory) ? &m_analyzer.GetLongHistory() : nullptr;
+    return true;
 }
 
 void AudioEngine::AudioThread() {
+    PROFILE_THREAD("Audio");
     HRESULT hr;
     CoInitialize(NULL);
 
@@ -83,10 +90,23 @@ void AudioEngine::AudioThread() {
     hr = pAudioClient->Start();
     if (FAILED(hr)) return;
 
+    m_sampleRate = (double)pwfx->nSamplesPerSec;
+    m_analyzer.SetSampleRate(m_sampleRate);
+
+    // Precomputed analysis kernels are cached next to the config
+    WCHAR profilePath[MAX_PATH];
+    if (SUCCEEDED(SHGetFolderPathW(NULL, CSIDL_PROFILE, NULL, 0, profilePath))) {
+        std::filesystem::path cacheDir = std::filesystem::path(profilePath) / L".musicvibecode";
+        CreateDirectoryW(cacheDir.c_str(), NULL);
+        m_analyzer.SetCacheDirectory(cacheDir);
+    }
+    m_loudness.Configure(m_sampleRate, pwfx->nChannels);
+
     UINT32 packetLength = 0;
     BYTE* pData;
     UINT32 numFramesAvailable;
     DWORD flags;
+    UINT64 qpcPosition = 0;
 
     // FFT buffer
     const int FFT_SIZE = 512; // 256 bins
@@ -98,9 +118,26 @@ void AudioEngine::AudioThread() {
         if (FAILED(hr)) break;
 
         while (packetLength != 0) {
-            hr = pCaptureClient->GetBuffer(&pData, &numFramesAvailable, &flags, NULL, NULL);
+            hr = pCaptureClient->GetBuffer(&pData, &numFramesAvailable, &flags, NULL, &qpcPosition);
             if (FAILED(hr)) break;
 
+            // Capture time of the packet's first frame (QPC, 100ns units)
+            double packetTime = (double)qpcPosition * 1e-7;
+            if ((flags & AUDCLNT_BUFFERFLAGS_TIMESTAMP_ERROR) || qpcPosition == 0) {
+                packetTime = GetTime() - numFramesAvailable / m_sampleRate;
+            }
+
+            // Loudness runs on the capture buffer itself, all channels, before
+            // the mono mix-down
+            bool measureLoudness = (m_analyzer.GetRequiredFeatures() & Feature_Loudness) || m_analyzer.GetLoudnessAgc();
+            if (measureLoudness) {
+                bool silent = (flags & AUDCLNT_BUFFERFLAGS_SILENT) != 0;
+                m_loudness.Process(silent ? nullptr : (const float*)pData, numFramesAvailable);
+                m_data.LoudnessMomentary = m_loudness.GetMomentaryLUFS();
+                m_data.LoudnessShortTerm = m_loudness.GetShortTermLUFS();
+                m_data.TruePeak = m_loudness.GetTruePeakDB();
+            }
+
             if (flags & AUDCLNT_BUFFERFLAGS_SILENT) {
                 m_data.playing = false;
             } else {
@@ -122,7 +159,8 @@ void AudioEngine::AudioThread() {
                     sampleBuffer.push_back(sample);
 
                     if (sampleBuffer.size() >= FFT_SIZE) {
-                        PerformFFT(sampleBuffer);
+                        // Stamp the block with the time of its last sample
+                        PerformFFT(sampleBuffer, packetTime + (i + 1) / m_sampleRate);
                         sampleBuffer.clear();
                     }
                 }
@@ -147,89 +185,67 @@ void AudioEngine::AudioThread() {
     CoUninitialize();
 }
 
-void AudioEngine::PerformFFT(std::vector<float>& samples) {
+void AudioEngine::PerformFFT(std::vector<float>& samples, double timestamp) {
+    PROFILE_ZONE("PerformFFT");
     const int FFT_SIZE = 512;
     if (samples.size() < FFT_SIZE) return;
 
-    // DC Removal (High-pass filter)
-    float sum = 0.0f;
-    for (float s : samples) sum += s;
-    float mean = sum / samples.size();
-    for (float& s : samples) s -= mean;
-
-    std::vector<std::complex<float>> complexSamples(FFT_SIZE);
-    for (int i = 0; i < FFT_SIZE; i++) {
-        // Apply Hanning window
-        float window = 0.5f * (1.0f - cos(2.0f * M_PI * i / (FFT_SIZE - 1)));
-        complexSamples[i] = samples[i] * window;
-    }
-
-    fft(complexSamples);
-
     // Update Data
     // std::lock_guard<std::mutex> lock(m_mutex); // Optional: if strict thread safety needed, but atomic types might suffice for simple vis
 
-    // Update History Index
-    m_data.historyIndex = (m_data.historyIndex + 1) % 60;
-
-    float maxVal = 0.0f;
-
-    for (int i = 0; i < 256; i++) {
-        float magnitude = std::abs(complexSamples[i]);
-        // Logarithmic scaling or simple magnitude? Let's stick to magnitude for now, maybe sqrt
-        magnitude = sqrt(magnitude); 
-        
-        m_data.Spectrum[i] = magnitude;
-        m_data.History[m_data.historyIndex][i] = magnitude;
-
-        if (magnitude > maxVal) maxVal = magnitude;
+    // Contiguous blocks are exactly FFT_SIZE samples apart. The QPC stamps
+    // jitter in their low bits, which would give every block a slightly
+    // different interval (and the envelopes new coefficients), so they only
+    // decide when capture skipped: after silence or a glitch the real gap is
+    // used. Either way, how late this thread got to a block doesn't matter.
+    double blockInterval = FFT_SIZE / m_sampleRate;
+    double elapsed = timestamp - m_lastBlockTime;
+    float deltaTime = 0.0f;
+    if (m_lastBlockTime > 0.0) deltaTime = (float)(elapsed > blockInterval * 1.5 ? elapsed : blockInterval);
+    m_lastBlockTime = timestamp;
+
+    // Only the stages the active visualization needs are evaluated
+    m_analyzer.Process(samples, deltaTime, m_data);
+
+    m_publisher.Publish(m_data, timestamp);
+
+    // External consumers. Opened here so only this thread touches the
+    // segment; a failed open isn't retried until the setting changes.
+    bool shared = m_sharedMemoryOutput.load(std::memory_order_relaxed);
+    if (!shared) {
+        m_sharedSpectrum.Close();
+        m_sharedMemoryTried = false;
+    } else if (!m_sharedSpectrum.IsOpen() && !m_sharedMemoryTried) {
+        m_sharedMemoryTried = true;
+        if (m_sharedSpectrum.Open()) std::cout << "Publishing spectrum to shared memory " << MUSICVIS_SHM_NAME << std::endl;
     }
-
-    // Auto-scale Logic
-    // Dynamic Scaling (AGC)
-    // Expansion: If maxVal > currentScale (Peak), snap to it immediately.
-    // Contraction: If maxVal < currentScale (Peak), decay by 5% per second.
-    
-    LARGE_INTEGER currentTime;
-    QueryPerformanceCounter(&currentTime);
-    float deltaTime = (float)(currentTime.QuadPart - m_lastTime.QuadPart) / m_frequency.QuadPart;
-    m_lastTime = currentTime;
-
-    // m_data.Scale is the Multiplier (1.0 / Peak).
-    // We want to track the Peak.
-    float currentPeak = (m_data.Scale > 0.00001f) ? (1.0f / m_data.Scale) : 1.0f;
-
-    if (maxVal > currentPeak) {
-        // Expansion (Immediate)
-        currentPeak = maxVal;
-    } else {
-        // Contraction (Gradual)
-        // User wants it to "creep up" (Peak creep down) over 5 seconds.
-        // 50% decay per second.
-        float decay = 0.50f * deltaTime;
-        currentPeak -= (currentPeak * decay);
+    m_sharedSpectrum.Publish(m_data, timestamp, m_analyzer.GetRequiredFeatures());
+
+    uint32_t udpGeneration = m_udpGeneration.load(std::memory_order_acquire);
+    if (udpGeneration != m_udpAppliedGeneration) {
+        m_udpAppliedGeneration = udpGeneration;
+        std::string address;
+        int bands;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            address = m_udpAddress;
+            bands = m_udpBands;
+        }
+        m_streamer.Stop();
+        if (!address.empty() && m_streamer.Start(address, bands)) {
+            std::cout << "Streaming " << bands << " spectrum bands to udp://" << address << std::endl;
+        }
     }
+    m_streamer.Push(m_data.SpectrumSmoothed, 256, timestamp);
+}
 
-    // Safety clamp - Cap Scale at 1.5 (minimum peak of 0.667)
-    if (currentPeak < 0.667f) currentPeak = 0.667f;
-
-    m_data.Scale = 1.0f / currentPeak;
-
-    // Normalize
-    for (int i = 0; i < 256; i++) {
-        m_data.SpectrumNormalized[i] = m_data.Spectrum[i] * m_data.Scale;
-        if (m_data.SpectrumNormalized[i] > 1.0f) m_data.SpectrumNormalized[i] = 1.0f;
-        
-        m_data.HistoryNormalized[m_data.historyIndex][i] = m_data.SpectrumNormalized[i];
-
-        // Calculate Highest Sample
-        float highest = 0.0f;
-        for (int h = 0; h < 6; h++) {
-            int idx = (m_data.historyIndex - h + 60) % 60;
-            if (m_data.HistoryNormalized[idx][i] > highest) {
-                highest = m_data.HistoryNormalized[idx][i];
-            }
-        }
-        m_data.SpectrumHighestSample[i] = highest;
+void AudioEngine::SetUdpOutput(const std::string& address, int bands) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (address == m_udpAddress && bands == m_udpBands) return;
+        m_udpAddress = address;
+        m_udpBands = bands;
     }
+    m_udpOutputEnabled = !address.empty();
+    m_udpGeneration.fetch_add(1, std::memory_order_release);
 }
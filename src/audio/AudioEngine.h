@@ -4,19 +4,13 @@
 #include <atomic>
 #include <thread>
 #include <windows.h>
-
-struct AudioData {
-    bool playing = false;
-    float Spectrum[256] = {0};
-    float History[60][256] = {0};
-    float Scale = 1.0f;
-    float SpectrumNormalized[256] = {0};
-    float HistoryNormalized[60][256] = {0};
-    float SpectrumHighestSample[256] = {0};
-    
-    // Helper for circular buffer index
-    int historyIndex = 0;
-};
+#include "AudioData.h"
+#include "SpectrumAnalyzer.h"
+#include "SpectrumPublisher.h"
+#include "LoudnessMeter.h"
+#include "SharedSpectrum.h"
+#include "SpectrumStream.h"
+#include <string>
 
 class AudioEngine {
 public:
@@ -27,12 +21,53 @@ public:
     void Update(); // Called every frame to process data if needed, or data can be updated in background
     const AudioData& GetData() const { return m_data; }
 
+    // Fill out with the spectrum interpolated to presentTime (seconds, GetTime() clock).
+    // Returns false until the first frame has been analyzed.
+    bool GetInterpolatedData(double presentTime, AudioData& out) const;
+    double GetTime() const;
+
+    // Features the active visualization reads; only their stages are computed
+    void SetRequiredFeatures(uint32_t features) {
+        if (m_sharedMemoryOutput) features |= SHARED_MEMORY_FEATURES;
+        if (m_udpOutputEnabled) features |= Feature_Envelope;
+        m_analyzer.SetRequiredFeatures(features);
+    }
+    const SpectrumAnalyzer& GetAnalyzer() const { return m_analyzer; }
+
+    // Drive the AGC from short-term loudness instead of peak magnitude
+    void SetLoudnessAgc(bool enabled) { m_analyzer.SetLoudnessAgc(enabled); }
+    void SetSpectrumWeighting(SpectrumWeighting weighting) { m_analyzer.SetWeighting(weighting); }
+    void SetNoiseGate(bool enabled) { m_analyzer.SetNoiseGate(enabled); }
+    void SetPeakRelease(float seconds) { m_analyzer.SetPeakRelease(seconds); }
+
+    // Publish every frame to shared memory for other processes (MusicVisShm.h).
+    // The segment is opened and closed by the audio thread on its next block.
+    static const uint32_t SHARED_MEMORY_FEATURES =
+        Feature_SpectrumNormalized | Feature_Envelope | Feature_Tempo | Feature_Loudness;
+    void SetSharedMemoryOutput(bool enabled) { m_sharedMemoryOutput = enabled; }
+
+    // Stream smoothed spectrum bands over UDP to "host:port" (SpectrumStream.h);
+    // empty turns it off. Applied by the audio thread on its next block.
+    void SetUdpOutput(const std::string& address, int bands);
+
 private:
     void AudioThread();
     void ProcessAudio(const float* buffer, int numFrames);
-    void PerformFFT(std::vector<float>& samples);
+    void PerformFFT(std::vector<float>& samples, double timestamp);
 
     AudioData m_data;
+    SpectrumAnalyzer m_analyzer;
+    SpectrumPublisher m_publisher;
+    LoudnessMeter m_loudness;
+    SharedSpectrumWriter m_sharedSpectrum;
+    std::atomic<bool> m_sharedMemoryOutput;
+    bool m_sharedMemoryTried = false;  // Open attempted for the current request
+    SpectrumStreamer m_streamer;
+    std::string m_udpAddress;          // Guarded by m_mutex
+    int m_udpBands = 32;
+    std::atomic<bool> m_udpOutputEnabled{false};
+    std::atomic<uint32_t> m_udpGeneration{0};
+    uint32_t m_udpAppliedGeneration = 0;  // Audio thread
     std::atomic<bool> m_running;
     std::thread m_audioThread;
     std::mutex m_mutex;
@@ -40,5 +75,6 @@ private:
     // Scaling state
     float m_lastScaleUpdateTime = 0.0f;
     LARGE_INTEGER m_frequency;
-    LARGE_INTEGER m_lastTime;
+    double m_lastBlockTime = 0.0;
+    double m_sampleRate = 48000.0;
 };
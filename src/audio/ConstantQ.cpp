@@ -0,0 +1,193 @@
+#include "ConstantQ.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Bump when the kernel definition changes so stale caches are rebuilt
+static const uint32_t KERNEL_FILE_VERSION = 2;
+static const char KERNEL_FILE_MAGIC[4] = { 'C', 'Q', 'T', 'K' };
+
+ConstantQ::ConstantQ() : m_fft(FFT_SIZE), m_ring(FFT_SIZE, 0.0f), m_window(FFT_SIZE),
+      m_spectrum(FFT_SIZE / 2 + 1) {
+}
+
+double ConstantQ::Q() {
+    return 1.0 / (pow(2.0, 1.0 / BINS_PER_OCTAVE) - 1.0);
+}
+
+float ConstantQ::BinFrequency(int bin) const {
+    return MIN_FREQUENCY * powf(2.0f, (float)bin / BINS_PER_OCTAVE);
+}
+
+int ConstantQ::BinLength(int bin) const {
+    int length = (int)ceil(Q() * m_sampleRate / BinFrequency(bin));
+    return length > FFT_SIZE ? FFT_SIZE : length;
+}
+
+void ConstantQ::Configure(double sampleRate, const std::filesystem::path& cacheDirectory) {
+    if (sampleRate == m_sampleRate && !m_rowStart.empty()) return;
+    m_sampleRate = sampleRate;
+    m_loadedFromCache = false;
+    Reset();
+
+    std::filesystem::path path = cacheDirectory.empty() ? std::filesystem::path() : CachePath(cacheDirectory);
+    if (!path.empty() && LoadKernel(path)) {
+        m_loadedFromCache = true;
+        return;
+    }
+
+    BuildKernel();
+    if (!path.empty() && !SaveKernel(path)) {
+        std::cerr << "Failed to save CQT kernel cache: " << path.u8string() << std::endl;
+    }
+}
+
+void ConstantQ::Reset() {
+    std::fill(m_ring.begin(), m_ring.end(), 0.0f);
+    m_ringHead = 0;
+}
+
+void ConstantQ::BuildKernel() {
+    m_rowStart.assign(1, 0);
+    m_columns.clear();
+    m_values.clear();
+
+    FftPlan fft(FFT_SIZE);  // Kernels are complex, so they need the full transform
+    std::vector<std::complex<float>> kernel(FFT_SIZE);
+    for (int bin = 0; bin < NUM_BINS; bin++) {
+        // Hann-windowed complex sinusoid, centred in the frame, normalized by
+        // its length. The phase steps by the bin frequency rather than q
+        // cycles per window, so bins whose window was clipped to FFT_SIZE
+        // (low bins above ~54 kHz) stay in tune, only wider.
+        int length = BinLength(bin);
+        double step = 2.0 * M_PI * BinFrequency(bin) / m_sampleRate;
+        int offset = (FFT_SIZE - length) / 2;
+        std::fill(kernel.begin(), kernel.end(), std::complex<float>(0.0f, 0.0f));
+        for (int n = 0; n < length; n++) {
+            double window = 0.5 - 0.5 * cos(2.0 * M_PI * n / length);
+            double phase = step * n;
+            kernel[offset + n] = std::complex<float>((float)(window / length * cos(phase)),
+                                                     (float)(window / length * sin(phase)));
+        }
+        fft.Forward(kernel.data());
+
+        // Keep only the significant part of the spectral kernel. A positive
+        // frequency kernel has (almost) nothing above Nyquist.
+        float peak = 0.0f;
+        for (int k = 0; k <= FFT_SIZE / 2; k++) peak = std::max(peak, std::abs(kernel[k]));
+        for (int k = 0; k <= FFT_SIZE / 2; k++) {
+            if (std::abs(kernel[k]) >= peak * KERNEL_THRESHOLD) {
+                m_columns.push_back(k);
+                m_values.push_back(std::conj(kernel[k]) / (float)FFT_SIZE);
+            }
+        }
+        m_rowStart.push_back((int)m_columns.size());
+    }
+}
+
+std::filesystem::path ConstantQ::CachePath(const std::filesystem::path& directory) const {
+    std::ostringstream name;
+    name << "cqt_" << (int)m_sampleRate << "_" << FFT_SIZE << "_" << NUM_BINS << "_" << BINS_PER_OCTAVE << ".bin";
+    return directory / name.str();
+}
+
+bool ConstantQ::LoadKernel(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    char magic[4];
+    uint32_t version = 0, fftSize = 0, bins = 0, binsPerOctave = 0, nonZero = 0;
+    double sampleRate = 0.0;
+    float minFrequency = 0.0f, threshold = 0.0f;
+    file.read(magic, 4);
+    file.read((char*)&version, sizeof(version));
+    file.read((char*)&sampleRate, sizeof(sampleRate));
+    file.read((char*)&fftSize, sizeof(fftSize));
+    file.read((char*)&bins, sizeof(bins));
+    file.read((char*)&binsPerOctave, sizeof(binsPerOctave));
+    file.read((char*)&minFrequency, sizeof(minFrequency));
+    file.read((char*)&threshold, sizeof(threshold));
+    file.read((char*)&nonZero, sizeof(nonZero));
+    if (!file || memcmp(magic, KERNEL_FILE_MAGIC, 4) != 0 || version != KERNEL_FILE_VERSION ||
+        sampleRate != m_sampleRate || fftSize != FFT_SIZE || bins != NUM_BINS ||
+        binsPerOctave != BINS_PER_OCTAVE || minFrequency != MIN_FREQUENCY || threshold != KERNEL_THRESHOLD ||
+        nonZero > (uint32_t)NUM_BINS * (FFT_SIZE / 2 + 1)) {
+        return false;  // Different configuration; rebuild
+    }
+
+    m_rowStart.resize(NUM_BINS + 1);
+    m_columns.resize(nonZero);
+    m_values.resize(nonZero);
+    file.read((char*)m_rowStart.data(), m_rowStart.size() * sizeof(int));
+    file.read((char*)m_columns.data(), m_columns.size() * sizeof(int));
+    file.read((char*)m_values.data(), m_values.size() * sizeof(std::complex<float>));
+    // Process trusts the indices, so every row range and column must be in bounds
+    bool valid = file && m_rowStart[0] == 0 && m_rowStart[NUM_BINS] == (int)nonZero;
+    for (int bin = 0; valid && bin < NUM_BINS; bin++) valid = m_rowStart[bin] <= m_rowStart[bin + 1];
+    for (size_t j = 0; valid && j < m_columns.size(); j++) valid = m_columns[j] >= 0 && m_columns[j] <= FFT_SIZE / 2;
+    if (!valid) {
+        std::cerr << "Corrupt CQT kernel cache, rebuilding: " << path.u8string() << std::endl;
+        m_rowStart.clear();
+        return false;
+    }
+    return true;
+}
+
+bool ConstantQ::SaveKernel(const std::filesystem::path& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    uint32_t version = KERNEL_FILE_VERSION, fftSize = FFT_SIZE, bins = NUM_BINS;
+    uint32_t binsPerOctave = BINS_PER_OCTAVE, nonZero = (uint32_t)m_columns.size();
+    float minFrequency = MIN_FREQUENCY, threshold = KERNEL_THRESHOLD;
+    file.write(KERNEL_FILE_MAGIC, 4);
+    file.write((const char*)&version, sizeof(version));
+    file.write((const char*)&m_sampleRate, sizeof(m_sampleRate));
+    file.write((const char*)&fftSize, sizeof(fftSize));
+    file.write((const char*)&bins, sizeof(bins));
+    file.write((const char*)&binsPerOctave, sizeof(binsPerOctave));
+    file.write((const char*)&minFrequency, sizeof(minFrequency));
+    file.write((const char*)&threshold, sizeof(threshold));
+    file.write((const char*)&nonZero, sizeof(nonZero));
+    file.write((const char*)m_rowStart.data(), m_rowStart.size() * sizeof(int));
+    file.write((const char*)m_columns.data(), m_columns.size() * sizeof(int));
+    file.write((const char*)m_values.data(), m_values.size() * sizeof(std::complex<float>));
+    return (bool)file;
+}
+
+void ConstantQ::CopyWindow(float* out) const {
+    int tail = FFT_SIZE - m_ringHead;
+    memcpy(out, &m_ring[m_ringHead], tail * sizeof(float));
+    memcpy(out + tail, &m_ring[0], m_ringHead * sizeof(float));
+}
+
+void ConstantQ::Process(const float* samples, int count, float* out) {
+    for (int i = 0; i < count; i++) {
+        m_ring[m_ringHead] = samples[i];
+        m_ringHead = (m_ringHead + 1) % FFT_SIZE;
+    }
+
+    CopyWindow(m_window.data());
+    m_fft.Forward(m_window.data(), m_spectrum.data());
+
+    // Sparse kernel times spectrum, on explicit real/imaginary parts
+    const float* spectrum = reinterpret_cast<const float*>(m_spectrum.data());
+    const float* values = reinterpret_cast<const float*>(m_values.data());
+    for (int bin = 0; bin < NUM_BINS; bin++) {
+        float re = 0.0f, im = 0.0f;
+        for (int j = m_rowStart[bin]; j < m_rowStart[bin + 1]; j++) {
+            const float* x = spectrum + 2 * m_columns[j];
+            const float* k = values + 2 * j;
+            re += x[0] * k[0] - x[1] * k[1];
+            im += x[0] * k[1] + x[1] * k[0];
+        }
+        out[bin] = sqrtf(re * re + im * im);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <complex>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+#include "Fft.h"
+
+// Constant-Q transform using a precomputed sparse spectral kernel
+// (Brown & Puckette). Each CQ bin is a windowed complex sinusoid whose length
+// gives it a constant Q. The FFTs of those kernels are mostly near zero, so
+// only the significant coefficients are kept (CSR). Each block is then one
+// FFT of the newest FFT_SIZE samples plus a sparse matrix-vector product.
+//
+// The 512-point analysis FFT can't resolve semitones below ~1 kHz, so the
+// transform keeps its own ring of the last FFT_SIZE samples and a real FFT.
+class ConstantQ {
+public:
+    static const int FFT_SIZE = 8192;
+    static const int NUM_BINS = 84;            // 7 octaves
+    static const int BINS_PER_OCTAVE = 12;
+    static constexpr float MIN_FREQUENCY = 110.0f;  // A2
+    static constexpr float KERNEL_THRESHOLD = 0.0054f;  // Relative to each kernel's peak
+
+    ConstantQ();
+
+    // Builds or loads the kernel for this sample rate. With a cache
+    // directory, a kernel built here is saved there and later runs load it.
+    void Configure(double sampleRate, const std::filesystem::path& cacheDirectory = {});
+    bool IsLoadedFromCache() const { return m_loadedFromCache; }
+
+    void Reset();
+
+    // Append one block of mono samples, then recompute every CQ bin.
+    // out receives NUM_BINS magnitudes.
+    void Process(const float* samples, int count, float* out);
+
+    // Kernel geometry, shared with reference implementations
+    static double Q();
+    float BinFrequency(int bin) const;
+    int BinLength(int bin) const;              // Window length in samples
+    int GetNonZeroCount() const { return (int)m_columns.size(); }
+    double GetSampleRate() const { return m_sampleRate; }
+
+    // Ring contents, oldest first
+    void CopyWindow(float* out) const;
+
+private:
+    void BuildKernel();
+    std::filesystem::path CachePath(const std::filesystem::path& directory) const;
+    bool LoadKernel(const std::filesystem::path& path);
+    bool SaveKernel(const std::filesystem::path& path) const;
+
+    double m_sampleRate = 0.0;
+    bool m_loadedFromCache = false;
+    RealFftPlan m_fft;
+
+    // Sparse kernel, CSR by CQ bin. Values are conj(K)/N, ready to multiply.
+    std::vector<int> m_rowStart;               // NUM_BINS + 1
+    std::vector<int> m_columns;
+    std::vector<std::complex<float>> m_values;
+
+    std::vector<float> m_ring;                 // FFT_SIZE samples
+    int m_ringHead = 0;                        // Oldest sample / next write
+    std::vector<float> m_window;               // Ring unrolled, oldest first
+    std::vector<std::complex<float>> m_spectrum;  // FFT_SIZE / 2 + 1 bins
+};
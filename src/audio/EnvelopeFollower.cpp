@@ -0,0 +1,58 @@
+#include "EnvelopeFollower.h"
+#include <algorithm>
+#include <cmath>
+
+EnvelopeFollowerBank::EnvelopeFollowerBank(int numBands)
+    : m_numBands(numBands), m_attack(numBands, 0.0f), m_release(numBands, 0.0f),
+      m_attackCoeff(numBands, 1.0f), m_releaseCoeff(numBands, 1.0f), m_envelope(numBands, 0.0f) {
+}
+
+void EnvelopeFollowerBank::SetTimes(float attackSeconds, float releaseSeconds) {
+    std::fill(m_attack.begin(), m_attack.end(), attackSeconds);
+    std::fill(m_release.begin(), m_release.end(), releaseSeconds);
+    m_coeffDeltaTime = -1.0f;
+}
+
+void EnvelopeFollowerBank::SetBandTimes(int band, float attackSeconds, float releaseSeconds) {
+    if (band < 0 || band >= m_numBands) return;
+    m_attack[band] = attackSeconds;
+    m_release[band] = releaseSeconds;
+    m_coeffDeltaTime = -1.0f;
+}
+
+void EnvelopeFollowerBank::Reset() {
+    std::fill(m_envelope.begin(), m_envelope.end(), 0.0f);
+    m_primed = false;
+}
+
+void EnvelopeFollowerBank::UpdateCoefficients(float deltaTime) {
+    // Contiguous blocks are passed the same nominal interval, so the
+    // exponentials are only recomputed after a gap or a change of times
+    m_coeffDeltaTime = deltaTime;
+    for (int i = 0; i < m_numBands; i++) {
+        m_attackCoeff[i] = m_attack[i] > 0.0f ? 1.0f - expf(-deltaTime / m_attack[i]) : 1.0f;
+        m_releaseCoeff[i] = m_release[i] > 0.0f ? 1.0f - expf(-deltaTime / m_release[i]) : 1.0f;
+    }
+}
+
+void EnvelopeFollowerBank::Process(const float* input, float deltaTime, float* output) {
+    if (!m_primed) {
+        std::copy(input, input + m_numBands, m_envelope.begin());
+        std::copy(input, input + m_numBands, output);
+        m_primed = true;
+        return;
+    }
+    if (deltaTime != m_coeffDeltaTime) UpdateCoefficients(deltaTime);
+
+    // Branch-free: the rise takes the attack coefficient, the fall the release
+    Float4 zero = F4Zero();
+    for (int i = 0; i < m_numBands; i += 4) {
+        Float4 envelope = F4Load(&m_envelope[i]);
+        Float4 diff = F4Sub(F4Load(input + i), envelope);
+        Float4 rise = F4Mul(F4Max(diff, zero), F4Load(&m_attackCoeff[i]));
+        Float4 fall = F4Mul(F4Min(diff, zero), F4Load(&m_releaseCoeff[i]));
+        envelope = F4Add(envelope, F4Add(rise, fall));
+        F4Store(&m_envelope[i], envelope);
+        F4Store(output + i, envelope);
+    }
+}
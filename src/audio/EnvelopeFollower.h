@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include "VectorOps.h"
+
+// A bank of attack/release envelope followers, one per band.
+// Each band rises towards its input with the attack time constant and falls
+// with the release time constant. Coefficients are the exact one-pole
+// 1 - exp(-dt / tau) for the real time between blocks, so the envelope moves
+// the same in seconds whatever the block rate, and a late block catches up
+// by exactly the time it missed. A time of 0 follows the input instantly.
+class EnvelopeFollowerBank {
+public:
+    explicit EnvelopeFollowerBank(int numBands);  // numBands must be a multiple of 4
+
+    // Times in seconds. SetTimes sets every band.
+    void SetTimes(float attackSeconds, float releaseSeconds);
+    void SetBandTimes(int band, float attackSeconds, float releaseSeconds);
+    void Reset();  // The next block seeds the envelopes from its input
+
+    // Advance every band by deltaTime seconds towards input; writes the
+    // envelopes to output (may be the same array as input)
+    void Process(const float* input, float deltaTime, float* output);
+
+    const float* GetEnvelope() const { return m_envelope.data(); }
+
+private:
+    void UpdateCoefficients(float deltaTime);
+
+    int m_numBands;
+    bool m_primed = false;
+    float m_coeffDeltaTime = -1.0f;    // deltaTime the coefficients were built for; -1 = rebuild
+    std::vector<float> m_attack;       // Time constants, seconds
+    std::vector<float> m_release;
+    std::vector<float> m_attackCoeff;  // 1 - exp(-dt / tau) per band
+    std::vector<float> m_releaseCoeff;
+    std::vector<float> m_envelope;
+};
@@ -0,0 +1,120 @@
+#include "Fft.h"
+#include "VectorOps.h"
+#include <cmath>
+#include <utility>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+FftPlan::FftPlan(int size) : m_size(size) {
+    int bits = 0;
+    while ((1 << bits) < size) bits++;
+
+    m_bitReverse.resize(size);
+    for (int i = 0; i < size; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        }
+        m_bitReverse[i] = r;
+    }
+
+    // Twiddles in double so large sizes stay accurate
+    m_twiddleRe.assign(2 * size, 0.0f);
+    m_twiddleIm.assign(2 * size, 0.0f);
+    for (int half = 1; half < size; half <<= 1) {
+        for (int k = 0; k < half; k++) {
+            double angle = -M_PI * k / half;
+            float wr = (float)cos(angle), wi = (float)sin(angle);
+            m_twiddleRe[2 * (half + k)] = m_twiddleRe[2 * (half + k) + 1] = wr;
+            m_twiddleIm[2 * (half + k)] = -wi;
+            m_twiddleIm[2 * (half + k) + 1] = wi;
+        }
+    }
+}
+
+void FftPlan::Forward(std::complex<float>* data) const {
+    Transform(data, false);
+}
+
+void FftPlan::Inverse(std::complex<float>* data) const {
+    Transform(data, true);
+    float scale = 1.0f / (float)m_size;
+    for (int i = 0; i < m_size; i++) data[i] *= scale;
+}
+
+void FftPlan::Transform(std::complex<float>* data, bool inverse) const {
+    const int n = m_size;
+    for (int i = 0; i < n; i++) {
+        int j = m_bitReverse[i];
+        if (i < j) std::swap(data[i], data[j]);
+    }
+
+    float* d = reinterpret_cast<float*>(data);
+    if (n >= 2) {
+        // First stage: twiddle is 1
+        for (int i = 0; i < 2 * n; i += 4) {
+            float ur = d[i], ui = d[i + 1];
+            d[i] = ur + d[i + 2];
+            d[i + 1] = ui + d[i + 3];
+            d[i + 2] = ur - d[i + 2];
+            d[i + 3] = ui - d[i + 3];
+        }
+    }
+
+    // Remaining stages, two butterflies per Float4. With b = (br, bi) and the
+    // twiddle as (wr, wr) and (-wi, wi): b * w = b * Re + swap(b) * Im.
+    // The inverse uses conj(w), i.e. negated Im.
+    const Float4 sign = F4Set1(inverse ? -1.0f : 1.0f);
+    for (int half = 2; half < n; half <<= 1) {
+        const float* twiddleRe = &m_twiddleRe[2 * half];
+        const float* twiddleIm = &m_twiddleIm[2 * half];
+        for (int start = 0; start < n; start += 2 * half) {
+            float* a = d + 2 * start;
+            float* b = a + 2 * half;
+            for (int k = 0; k < 2 * half; k += 4) {
+                Float4 vb = F4Load(b + k);
+                Float4 im = F4Mul(F4Load(twiddleIm + k), sign);
+                Float4 v = F4Add(F4Mul(vb, F4Load(twiddleRe + k)), F4Mul(F4SwapPairs(vb), im));
+                Float4 va = F4Load(a + k);
+                F4Store(a + k, F4Add(va, v));
+                F4Store(b + k, F4Sub(va, v));
+            }
+        }
+    }
+}
+
+RealFftPlan::RealFftPlan(int size) : m_size(size), m_half(size / 2) {
+    m_twiddles.resize(size / 2);
+    for (int k = 0; k < size / 2; k++) {
+        double angle = -2.0 * M_PI * k / size;
+        m_twiddles[k] = std::complex<float>((float)cos(angle), (float)sin(angle));
+    }
+}
+
+void RealFftPlan::Forward(const float* input, std::complex<float>* output) const {
+    const int half = m_size / 2;
+    for (int i = 0; i < half; i++) {
+        output[i] = std::complex<float>(input[2 * i], input[2 * i + 1]);
+    }
+    m_half.Forward(output);
+
+    // Split Z into the even/odd spectra E and O, then X[k] = E[k] + W^k O[k].
+    // Bins k and half - k come from the same pair of Z values, so both are
+    // written together and the split can run in place.
+    float e = output[0].real(), o = output[0].imag();
+    output[0] = std::complex<float>(e + o, 0.0f);
+    output[half] = std::complex<float>(e - o, 0.0f);
+    for (int k = 1; k <= half / 2; k++) {
+        std::complex<float> z = output[k];
+        std::complex<float> zm = std::conj(output[half - k]);
+        float er = 0.5f * (z.real() + zm.real()), ei = 0.5f * (z.imag() + zm.imag());
+        // O = (z - zm) / 2i
+        float orr = 0.5f * (z.imag() - zm.imag()), oi = -0.5f * (z.real() - zm.real());
+        float wr = m_twiddles[k].real(), wi = m_twiddles[k].imag();
+        float tr = wr * orr - wi * oi, ti = wr * oi + wi * orr;
+        output[k] = std::complex<float>(er + tr, ei + ti);
+        output[half - k] = std::complex<float>(er - tr, -(ei - ti));
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <complex>
+
+// Iterative in-place radix-2 FFT with precomputed twiddles and bit-reversal
+// order. Build one plan per transform size and reuse it; Forward/Inverse
+// don't allocate. Butterflies run two complex values per Float4.
+class FftPlan {
+public:
+    explicit FftPlan(int size);  // size must be a power of two
+
+    int Size() const { return m_size; }
+
+    void Forward(std::complex<float>* data) const;
+    // Scaled by 1/N so Inverse(Forward(x)) == x
+    void Inverse(std::complex<float>* data) const;
+
+private:
+    void Transform(std::complex<float>* data, bool inverse) const;
+
+    int m_size;
+    std::vector<int> m_bitReverse;
+    // Per-stage twiddles, laid out to match interleaved complex data: stage
+    // with half-length h starts at float 2h. Re holds (wr, wr), Im (-wi, wi).
+    std::vector<float> m_twiddleRe;
+    std::vector<float> m_twiddleIm;
+};
+
+// FFT of real input through a half-size complex FFT: the even and odd samples
+// are packed as real and imaginary parts, transformed, then split apart.
+// About half the work of a full complex transform of the same size.
+class RealFftPlan {
+public:
+    explicit RealFftPlan(int size);  // size must be a power of two, >= 4
+
+    int Size() const { return m_size; }
+
+    // input: size samples. output: bins 0..size/2 (size/2 + 1 values).
+    void Forward(const float* input, std::complex<float>* output) const;
+
+private:
+    int m_size;
+    FftPlan m_half;
+    std::vector<std::complex<float>> m_twiddles;  // exp(-2*pi*i*k/N), k < N/2
+};
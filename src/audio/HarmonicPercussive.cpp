@@ -0,0 +1,94 @@
+#include "HarmonicPercussive.h"
+#include <chrono>
+
+// Check the clock every this many bins in the frequency pass
+static const int BUDGET_CHECK_BINS = 16;
+// Blocks in a row well under budget before the frequency window grows back
+static const int COOL_BLOCKS_TO_GROW = 100;
+
+HarmonicPercussiveSeparator::HarmonicPercussiveSeparator(int numBins)
+    : m_numBins(numBins),
+      m_timeMedians(numBins, SlidingMedian(HARMONIC_FRAMES)),
+      m_frequencyMedian(PERCUSSIVE_BINS),
+      m_harmonicMedian(numBins, 0.0f),
+      m_mask(numBins, 0.5f) {
+}
+
+void HarmonicPercussiveSeparator::Reset() {
+    for (int i = 0; i < m_numBins; i++) {
+        m_timeMedians[i].Reset();
+        m_mask[i] = 0.5f;
+    }
+    m_percussiveWindow = PERCUSSIVE_BINS;
+    m_coolBlocks = 0;
+}
+
+void HarmonicPercussiveSeparator::Process(const float* magnitude, const float* input, float* harmonic, float* percussive) {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
+    // Time medians always advance so their windows stay contiguous
+    for (int i = 0; i < m_numBins; i++) {
+        m_timeMedians[i].Push(magnitude[i]);
+        m_harmonicMedian[i] = m_timeMedians[i].Median();
+    }
+
+    // Frequency median, sliding a centred window along the bins. The window
+    // is clipped at both ends of the spectrum.
+    int half = m_percussiveWindow / 2;
+    m_frequencyMedian.Reset();
+    for (int i = 0; i < half && i < m_numBins; i++) {
+        m_frequencyMedian.Push(magnitude[i]);
+    }
+
+    bool cutoff = false;
+    for (int i = 0; i < m_numBins; i++) {
+        if (i % BUDGET_CHECK_BINS == 0 && i > 0) {
+            float elapsed = std::chrono::duration<float, std::micro>(Clock::now() - start).count();
+            if (elapsed > m_budgetMicros) {
+                cutoff = true;
+                break;
+            }
+        }
+
+        if (i - half - 1 >= 0) m_frequencyMedian.PopOldest();
+        if (i + half < m_numBins) m_frequencyMedian.Push(magnitude[i + half]);
+
+        // Wiener-style soft mask from squared medians
+        float h = m_harmonicMedian[i] * m_harmonicMedian[i];
+        float p = m_frequencyMedian.Median();
+        p *= p;
+        float total = h + p;
+        m_mask[i] = total > 1e-12f ? h / total : 0.5f;
+    }
+    // Bins past a cutoff keep last block's mask
+
+    for (int b = 0; b < m_numBins; b++) {
+        harmonic[b] = input[b] * m_mask[b];
+        percussive[b] = input[b] - harmonic[b];
+    }
+
+    m_lastMicros = std::chrono::duration<float, std::micro>(Clock::now() - start).count();
+    m_blocks++;
+    if (cutoff) m_cutoffs++;
+    AdaptWindow(m_lastMicros, cutoff);
+}
+
+void HarmonicPercussiveSeparator::AdaptWindow(float micros, bool cutoff) {
+    if (cutoff || micros > m_budgetMicros * 0.8f) {
+        // Running hot: halve the frequency window (17 -> 9 -> 5)
+        int window = (m_percussiveWindow / 2) | 1;
+        if (window < MIN_PERCUSSIVE_BINS) window = MIN_PERCUSSIVE_BINS;
+        m_percussiveWindow = window;
+        m_coolBlocks = 0;
+    } else if (micros < m_budgetMicros * 0.3f && m_percussiveWindow < PERCUSSIVE_BINS) {
+        if (++m_coolBlocks >= COOL_BLOCKS_TO_GROW) {
+            int window = m_percussiveWindow * 2 - 1;
+            if (window > PERCUSSIVE_BINS) window = PERCUSSIVE_BINS;
+            m_percussiveWindow = window;
+            m_coolBlocks = 0;
+        }
+    } else {
+        m_coolBlocks = 0;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "SlidingMedian.h"
+
+// Median-filtering harmonic/percussive separation (HPSS).
+// Tonal energy is steady over time in a bin, so a median across time keeps
+// it and rejects hits; a hit is broadband within one frame, so a median
+// across frequency keeps it and rejects partials. The two medians become a
+// soft mask that splits the input spectrum into harmonic + percussive parts.
+//
+// The time median is causal (the last HARMONIC_FRAMES blocks). Each block is
+// held to a CPU budget: the frequency window shrinks when the stage runs
+// hot, and if a block still overruns, the remaining bins reuse the previous
+// block's mask.
+class HarmonicPercussiveSeparator {
+public:
+    static const int HARMONIC_FRAMES = 17;      // ~180 ms at 48 kHz / 512
+    static const int PERCUSSIVE_BINS = 17;      // Widest frequency window
+    static const int MIN_PERCUSSIVE_BINS = 5;
+    static constexpr float DEFAULT_BUDGET_MICROS = 200.0f;
+
+    explicit HarmonicPercussiveSeparator(int numBins);
+
+    void Reset();
+
+    // magnitude drives the medians; input is the spectrum that gets split
+    // (usually the normalized one). harmonic[i] + percussive[i] == input[i].
+    void Process(const float* magnitude, const float* input, float* harmonic, float* percussive);
+
+    void SetBudgetMicros(float micros) { m_budgetMicros = micros; }
+    float GetBudgetMicros() const { return m_budgetMicros; }
+
+    int GetPercussiveWindow() const { return m_percussiveWindow; }
+    float GetLastMicros() const { return m_lastMicros; }
+    uint64_t GetBlockCount() const { return m_blocks; }
+    uint64_t GetCutoffCount() const { return m_cutoffs; }  // Blocks that hit the budget
+
+private:
+    void AdaptWindow(float micros, bool cutoff);
+
+    int m_numBins;
+    std::vector<SlidingMedian> m_timeMedians;  // One per bin
+    SlidingMedian m_frequencyMedian;
+    std::vector<float> m_harmonicMedian;
+    std::vector<float> m_mask;                 // Harmonic share per bin, kept for cutoffs
+
+    float m_budgetMicros = DEFAULT_BUDGET_MICROS;
+    int m_percussiveWindow = PERCUSSIVE_BINS;
+    int m_coolBlocks = 0;
+    float m_lastMicros = 0.0f;
+    uint64_t m_blocks = 0;
+    uint64_t m_cutoffs = 0;
+};
@@ -0,0 +1,311 @@
+#include "LibraryAnalyzer.h"
+#include "SpectrumAnalyzer.h"
+#include "LoudnessMeter.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+static const char CACHE_MAGIC[4] = { 'M', 'V', 'T', 'S' };
+
+bool AnalyzeTrack(const WavData& wav, TrackSummary& out) {
+    const int blockSize = SpectrumAnalyzer::FFT_SIZE;
+    if (wav.sampleRate <= 0 || wav.samples.size() < (size_t)blockSize) return false;
+
+    out = TrackSummary();
+    out.durationSeconds = (float)wav.samples.size() / wav.sampleRate;
+
+    // Energy curve straight from the samples, one RMS value per second
+    for (size_t start = 0; start < wav.samples.size(); start += wav.sampleRate) {
+        size_t end = std::min(wav.samples.size(), start + (size_t)wav.sampleRate);
+        double sum = 0.0;
+        for (size_t i = start; i < end; i++) sum += (double)wav.samples[i] * wav.samples[i];
+        out.energyCurve.push_back((float)sqrt(sum / (end - start)));
+    }
+
+    // AudioData is ~130 KB; keep it off the stack
+    std::unique_ptr<SpectrumAnalyzer> analyzer(new SpectrumAnalyzer());
+    std::unique_ptr<AudioData> data(new AudioData());
+    std::unique_ptr<LoudnessMeter> loudness(new LoudnessMeter());
+    analyzer->SetSampleRate(wav.sampleRate);
+    analyzer->SetRequiredFeatures(Feature_Spectrum | Feature_Tempo);
+    // Loudness is measured on the channels themselves, like the live meter
+    // (BS.1770 sums per-channel power; the mix-down would cancel and
+    // reweight). WavData built in memory may only have the mix.
+    int meterChannels = 1;
+    if (wav.channels > 1 && wav.interleaved.size() >= wav.samples.size() * wav.channels) meterChannels = wav.channels;
+    loudness->Configure(wav.sampleRate, meterChannels);
+
+    // Octave bands over the bins; bin 0 (DC to half a bin) joins the lowest
+    int bandStart[TrackSummary::NUM_BANDS + 1];
+    for (int b = 0; b <= TrackSummary::NUM_BANDS; b++) bandStart[b] = b == 0 ? 0 : (1 << b);
+    for (int b = 0; b < TrackSummary::NUM_BANDS; b++) {
+        out.bandLowHz[b] = (float)(b == 0 ? 0.0 : (double)bandStart[b] * wav.sampleRate / blockSize);
+    }
+    double bandEnergy[TrackSummary::NUM_BANDS] = {0};
+    double loudnessPower = 0.0;
+    int loudBlocks = 0;
+
+    std::vector<float> block(blockSize);
+    size_t blocks = wav.samples.size() / blockSize;
+    float deltaTime = (float)blockSize / wav.sampleRate;
+    for (size_t b = 0; b < blocks; b++) {
+        memcpy(block.data(), &wav.samples[b * blockSize], blockSize * sizeof(float));
+        loudness->Process(meterChannels > 1 ? &wav.interleaved[b * blockSize * meterChannels] : block.data(), blockSize);
+        analyzer->Process(block, deltaTime, *data);
+
+        // Spectrum is sqrt(|X|), so |X|^2 is its fourth power
+        for (int band = 0; band < TrackSummary::NUM_BANDS; band++) {
+            for (int i = bandStart[band]; i < bandStart[band + 1]; i++) {
+                float s2 = data->Spectrum[i] * data->Spectrum[i];
+                bandEnergy[band] += s2 * s2;
+            }
+        }
+
+        float lufs = loudness->GetShortTermLUFS();
+        if (lufs > LoudnessMeter::SILENCE_LUFS) {
+            loudnessPower += pow(10.0, lufs / 10.0);
+            loudBlocks++;
+        }
+        // The tracker refines its estimate as the track goes on; keep the surest one
+        if (data->TempoConfidence > out.tempoConfidence) {
+            out.tempoConfidence = data->TempoConfidence;
+            out.tempoBPM = data->TempoBPM;
+        }
+    }
+
+    double total = 0.0;
+    for (double e : bandEnergy) total += e;
+    for (int band = 0; band < TrackSummary::NUM_BANDS; band++) {
+        out.bandEnergy[band] = total > 0.0 ? (float)(bandEnergy[band] / total) : 0.0f;
+        if (out.bandEnergy[band] > out.bandEnergy[out.dominantBand]) out.dominantBand = band;
+    }
+    if (loudBlocks > 0) out.loudnessLUFS = (float)(10.0 * log10(loudnessPower / loudBlocks));
+    return true;
+}
+
+uint64_t HashContent(const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+FeatureCache::FeatureCache(const std::string& directory) : m_directory(directory) {
+    std::error_code error;
+    fs::create_directories(m_directory, error);
+}
+
+std::string FeatureCache::DefaultDirectory() {
+    const char* home = getenv("USERPROFILE");
+    if (!home) home = getenv("HOME");
+    fs::path path = fs::path(home ? home : ".") / ".musicvibecode" / "library";
+    return path.string();
+}
+
+std::string FeatureCache::PathFor(uint64_t hash) const {
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << hash << ".trk";
+    return (fs::path(m_directory) / name.str()).string();
+}
+
+template <typename T> static void Put(std::ofstream& f, const T& v) { f.write((const char*)&v, sizeof(T)); }
+template <typename T> static bool Get(std::ifstream& f, T& v) { return (bool)f.read((char*)&v, sizeof(T)); }
+
+bool FeatureCache::Load(uint64_t hash, TrackSummary& out) const {
+    std::ifstream f(PathFor(hash), std::ios::binary);
+    if (!f) return false;
+
+    char magic[4];
+    uint32_t version = 0, curveLength = 0;
+    if (!f.read(magic, 4) || memcmp(magic, CACHE_MAGIC, 4) != 0) return false;
+    if (!Get(f, version) || version != VERSION || !Get(f, curveLength)) return false;
+
+    TrackSummary summary;
+    int32_t dominant = 0;
+    bool ok = Get(f, summary.durationSeconds) && Get(f, summary.tempoBPM) && Get(f, summary.tempoConfidence) &&
+              Get(f, summary.loudnessLUFS) && Get(f, summary.bandEnergy) && Get(f, summary.bandLowHz) &&
+              Get(f, dominant);
+    if (!ok || dominant < 0 || dominant >= TrackSummary::NUM_BANDS || curveLength > (1u << 24)) return false;
+    summary.dominantBand = dominant;
+    summary.energyCurve.resize(curveLength);
+    if (curveLength > 0 && !f.read((char*)summary.energyCurve.data(), curveLength * sizeof(float))) return false;
+
+    out = std::move(summary);
+    return true;
+}
+
+bool FeatureCache::Store(uint64_t hash, const TrackSummary& summary) const {
+    // Write beside the entry and rename over it, so a reader (or a second
+    // worker with an identical file) never sees half an entry
+    std::string path = PathFor(hash);
+    std::ostringstream tempName;
+    tempName << path << "." << std::this_thread::get_id() << ".tmp";
+    std::string tempPath = tempName.str();
+    {
+        std::ofstream f(tempPath, std::ios::binary);
+        if (!f) return false;
+        f.write(CACHE_MAGIC, 4);
+        Put(f, (uint32_t)VERSION);
+        Put(f, (uint32_t)summary.energyCurve.size());
+        Put(f, summary.durationSeconds);
+        Put(f, summary.tempoBPM);
+        Put(f, summary.tempoConfidence);
+        Put(f, summary.loudnessLUFS);
+        Put(f, summary.bandEnergy);
+        Put(f, summary.bandLowHz);
+        Put(f, (int32_t)summary.dominantBand);
+        f.write((const char*)summary.energyCurve.data(), summary.energyCurve.size() * sizeof(float));
+        if (!f) return false;
+    }
+    std::error_code error;
+    fs::rename(tempPath, path, error);
+    if (error) {
+        fs::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
+
+static bool IsWav(const fs::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)tolower(c); });
+    return ext == ".wav";
+}
+
+static void AnalyzeOne(const FeatureCache& cache, LibraryTrack& track) {
+    std::ifstream file(track.path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open " << track.path << std::endl;
+        return;
+    }
+    std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    track.hash = HashContent(bytes.data(), bytes.size());
+
+    if (cache.Load(track.hash, track.summary)) {
+        track.ok = track.cached = true;
+        return;
+    }
+
+    WavData wav;
+    if (!ParseWav(bytes, track.path, wav)) return;
+    bytes = std::vector<unsigned char>();  // Release the raw file before analyzing
+    if (!AnalyzeTrack(wav, track.summary)) {
+        std::cerr << track.path << ": shorter than one FFT block" << std::endl;
+        return;
+    }
+    track.ok = true;
+    if (!cache.Store(track.hash, track.summary)) {
+        std::cerr << "Failed to write " << cache.PathFor(track.hash) << std::endl;
+    }
+}
+
+std::vector<LibraryTrack> AnalyzeLibrary(const std::string& directory, const std::string& cacheDirectory,
+                                         int threads, LibraryStats* stats) {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
+    std::vector<LibraryTrack> tracks;
+    std::vector<uintmax_t> sizes;
+    std::error_code error;
+    for (fs::recursive_directory_iterator it(directory, fs::directory_options::skip_permission_denied, error), end;
+         !error && it != end; it.increment(error)) {
+        if (!it->is_regular_file(error) || !IsWav(it->path())) continue;
+        LibraryTrack track;
+        track.path = it->path().string();
+        tracks.push_back(track);
+    }
+    std::sort(tracks.begin(), tracks.end(), [](const LibraryTrack& a, const LibraryTrack& b) { return a.path < b.path; });
+
+    FeatureCache cache(cacheDirectory);
+    int threadCount = 0;
+    uint64_t steals = 0;
+    {
+        WorkStealingPool pool(threads);
+        threadCount = pool.GetThreadCount();
+
+        // Biggest files first, so one long track doesn't start last and
+        // leave the other workers idle at the end
+        std::vector<size_t> order(tracks.size());
+        for (size_t i = 0; i < tracks.size(); i++) {
+            order[i] = i;
+            sizes.push_back(fs::file_size(tracks[i].path, error));
+            if (error) sizes.back() = 0;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+        for (size_t i : order) {
+            LibraryTrack* track = &tracks[i];
+            pool.Submit([&cache, track] { AnalyzeOne(cache, *track); });
+        }
+        pool.Wait();
+        steals = pool.GetStealCount();
+    }
+
+    if (stats) {
+        *stats = LibraryStats();
+        for (const LibraryTrack& track : tracks) {
+            if (!track.ok) stats->failed++;
+            else if (track.cached) stats->cached++;
+            else stats->analyzed++;
+        }
+        stats->threads = threadCount;
+        stats->steals = steals;
+        stats->seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return tracks;
+}
+
+int RunLibraryAnalysis(int argc, char** argv) {
+    std::string directory, cacheDirectory = FeatureCache::DefaultDirectory();
+    int threads = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) cacheDirectory = argv[++i];
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--analyze") == 0) continue;
+        else directory = argv[i];
+    }
+    if (directory.empty()) {
+        std::cerr << "Usage: --analyze [--cache <dir>] [--threads <n>] <directory>" << std::endl;
+        return 1;
+    }
+
+    LibraryStats stats;
+    std::vector<LibraryTrack> tracks = AnalyzeLibrary(directory, cacheDirectory, threads, &stats);
+    if (tracks.empty()) {
+        std::cout << "No .wav files under " << directory << std::endl;
+        return 0;
+    }
+
+    std::cout << std::fixed << std::setprecision(1);
+    for (const LibraryTrack& track : tracks) {
+        if (!track.ok) {
+            std::cout << "  failed                                   " << track.path << std::endl;
+            continue;
+        }
+        const TrackSummary& s = track.summary;
+        int seconds = (int)s.durationSeconds;
+        std::cout << "  " << std::setw(5) << s.tempoBPM << " BPM " << std::setw(6) << s.loudnessLUFS << " LUFS  "
+                  << std::setw(5) << (int)s.bandLowHz[s.dominantBand] << "+ Hz  "
+                  << std::setw(3) << seconds / 60 << ":" << std::setw(2) << std::setfill('0') << seconds % 60
+                  << std::setfill(' ') << (track.cached ? "  cached  " : "          ") << track.path << std::endl;
+    }
+    std::cout << tracks.size() << " tracks: " << stats.analyzed << " analyzed, " << stats.cached << " cached, "
+              << stats.failed << " failed in " << std::setprecision(2) << stats.seconds << " s ("
+              << stats.threads << " threads, " << stats.steals << " steals)" << std::endl;
+    std::cout << "Cache: " << cacheDirectory << std::endl;
+    return stats.failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "WavReader.h"
+
+// Offline per-track summaries for a music library, so the app can pick a
+// visualization and background per song without analyzing it live.
+// Tracks are analyzed in parallel on a WorkStealingPool and stored in a
+// binary cache keyed by a hash of the file contents: a re-run only analyzes
+// files that are new or changed, wherever they have been moved or renamed.
+struct TrackSummary {
+    static const int NUM_BANDS = 8;  // Octave bands of the 256-bin spectrum
+
+    float durationSeconds = 0.0f;
+    float tempoBPM = 0.0f;           // 0 if no tempo was found
+    float tempoConfidence = 0.0f;
+    float loudnessLUFS = -70.0f;     // Power mean of the short-term loudness
+    float bandEnergy[NUM_BANDS] = {0};  // Share of spectral energy per band, sums to 1
+    float bandLowHz[NUM_BANDS] = {0};   // Lower edge of each band
+    int dominantBand = 0;
+    std::vector<float> energyCurve;  // RMS per second of audio
+};
+
+// Runs the track through SpectrumAnalyzer (spectrum + tempo) and a
+// LoudnessMeter one FFT block at a time, as the capture thread does.
+bool AnalyzeTrack(const WavData& wav, TrackSummary& out);
+
+// 64-bit FNV-1a
+uint64_t HashContent(const void* data, size_t size);
+
+class FeatureCache {
+public:
+    // Bump when the analysis or the file layout changes; older entries are ignored
+    static const uint32_t VERSION = 2;
+
+    explicit FeatureCache(const std::string& directory);  // Created if missing
+
+    bool Load(uint64_t hash, TrackSummary& out) const;
+    bool Store(uint64_t hash, const TrackSummary& summary) const;
+    std::string PathFor(uint64_t hash) const;
+
+    // %USERPROFILE%\.musicvibecode\library (or $HOME/.musicvibecode/library)
+    static std::string DefaultDirectory();
+
+private:
+    std::string m_directory;
+};
+
+struct LibraryTrack {
+    std::string path;
+    uint64_t hash = 0;
+    bool ok = false;      // False if the file couldn't be read or decoded
+    bool cached = false;  // Summary came from the cache
+    TrackSummary summary;
+};
+
+struct LibraryStats {
+    int analyzed = 0;
+    int cached = 0;
+    int failed = 0;
+    int threads = 0;
+    uint64_t steals = 0;
+    double seconds = 0.0;  // Wall time
+};
+
+// Every .wav file under directory (recursively), in path order.
+// threads = 0 uses one per hardware thread.
+std::vector<LibraryTrack> AnalyzeLibrary(const std::string& directory, const std::string& cacheDirectory,
+                                         int threads, LibraryStats* stats = nullptr);
+
+// Command line front end: [--cache <dir>] [--threads <n>] <directory>
+int RunLibraryAnalysis(int argc, char** argv);
@@ -0,0 +1,210 @@
+#include "LoudnessMeter.h"
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Mean square -> LUFS, with silence floored instead of -inf
+static float PowerToLUFS(double power) {
+    if (power <= 0.0) return LoudnessMeter::SILENCE_LUFS;
+    float lufs = (float)(-0.691 + 10.0 * log10(power));
+    return lufs < LoudnessMeter::SILENCE_LUFS ? LoudnessMeter::SILENCE_LUFS : lufs;
+}
+
+static float AmplitudeToDB(float amplitude) {
+    if (amplitude <= 0.0f) return LoudnessMeter::SILENCE_LUFS;
+    float db = 20.0f * log10f(amplitude);
+    return db < LoudnessMeter::SILENCE_LUFS ? LoudnessMeter::SILENCE_LUFS : db;
+}
+
+// BS.1770 channel weight for the usual WASAPI channel orders
+static float ChannelWeight(int channel, int channels) {
+    if (channels < 6) return 1.0f;
+    if (channel == 3) return 0.0f;          // LFE
+    if (channel >= 4) return 1.41f;         // Surrounds
+    return 1.0f;
+}
+
+LoudnessMeter::LoudnessMeter()
+    : m_subblockPower(SUBBLOCKS_SHORT_TERM, 0.0f), m_subblockPeak(SUBBLOCKS_MOMENTARY, 0.0f) {
+    Configure(48000.0, 2);
+}
+
+void LoudnessMeter::Configure(double sampleRate, int channels) {
+    m_stride = channels < 1 ? 1 : channels;
+    m_channels = m_stride > MAX_CHANNELS ? MAX_CHANNELS : m_stride;
+    m_groups = (m_channels + 3) / 4;
+    m_subblockFrames = (int)(sampleRate / 10.0);
+
+    // K-weighting filter coefficients for any sample rate (as derived in
+    // libebur128 from the 48 kHz values in BS.1770)
+    {
+        double f0 = 1681.974450955533, gain = 3.999843853973347, q = 0.7071752369554196;
+        double k = tan(M_PI * f0 / sampleRate);
+        double vh = pow(10.0, gain / 20.0);
+        double vb = pow(vh, 0.4996667741545416);
+        double a0 = 1.0 + k / q + k * k;
+        m_shelf.b0 = F4Set1((float)((vh + vb * k / q + k * k) / a0));
+        m_shelf.b1 = F4Set1((float)(2.0 * (k * k - vh) / a0));
+        m_shelf.b2 = F4Set1((float)((vh - vb * k / q + k * k) / a0));
+        m_shelf.a1 = F4Set1((float)(2.0 * (k * k - 1.0) / a0));
+        m_shelf.a2 = F4Set1((float)((1.0 - k / q + k * k) / a0));
+    }
+    {
+        double f0 = 38.13547087602444, q = 0.5003270373238773;
+        double k = tan(M_PI * f0 / sampleRate);
+        double a0 = 1.0 + k / q + k * k;
+        m_highpass.b0 = F4Set1(1.0f);
+        m_highpass.b1 = F4Set1(-2.0f);
+        m_highpass.b2 = F4Set1(1.0f);
+        m_highpass.a1 = F4Set1((float)(2.0 * (k * k - 1.0) / a0));
+        m_highpass.a2 = F4Set1((float)((1.0 - k / q + k * k) / a0));
+    }
+
+    // True-peak interpolator: 48-tap Blackman-windowed sinc at 4x, split
+    // into four 12-tap phases. Each phase has unity DC gain.
+    m_oversample = sampleRate < 176400.0;
+    const int taps = TP_PHASES * TP_TAPS;
+    double center = (taps - 1) / 2.0;
+    for (int p = 0; p < TP_PHASES; p++) {
+        double coeffs[TP_TAPS];
+        double sum = 0.0;
+        for (int k = 0; k < TP_TAPS; k++) {
+            int n = k * TP_PHASES + p;
+            double x = (n - center) / TP_PHASES;
+            double sinc = (x == 0.0) ? 1.0 : sin(M_PI * x) / (M_PI * x);
+            double window = 0.42 - 0.5 * cos(2.0 * M_PI * (n + 0.5) / taps) + 0.08 * cos(4.0 * M_PI * (n + 0.5) / taps);
+            coeffs[k] = sinc * window;
+            sum += coeffs[k];
+        }
+        for (int k = 0; k < TP_TAPS; k++) {
+            m_tpCoeffs[p][k] = F4Set1((float)(coeffs[k] / sum));
+        }
+    }
+
+    for (int g = 0; g < m_groups; g++) {
+        float weights[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (int lane = 0; lane < 4; lane++) {
+            int c = g * 4 + lane;
+            if (c < m_channels) weights[lane] = ChannelWeight(c, m_stride);
+        }
+        m_laneGroups[g].weight = F4Load(weights);
+    }
+
+    Reset();
+}
+
+void LoudnessMeter::Reset() {
+    for (int g = 0; g < m_groups; g++) {
+        LaneGroup& group = m_laneGroups[g];
+        group.shelfS1 = group.shelfS2 = F4Zero();
+        group.highpassS1 = group.highpassS2 = F4Zero();
+        group.sumSquares = F4Zero();
+        group.peak = F4Zero();
+        for (int i = 0; i < TP_TAPS * 2; i++) group.history[i] = F4Zero();
+        group.historyPos = 0;
+    }
+    for (float& v : m_subblockPower) v = 0.0f;
+    for (float& v : m_subblockPeak) v = 0.0f;
+    m_subblockPos = 0;
+    m_subblockHead = 0;
+    m_subblockCount = 0;
+    m_momentary = SILENCE_LUFS;
+    m_shortTerm = SILENCE_LUFS;
+    m_truePeak = SILENCE_LUFS;
+}
+
+void LoudnessMeter::Process(const float* interleaved, int frames) {
+    for (int f = 0; f < frames; f++) {
+        const float* frame = interleaved ? interleaved + (size_t)f * m_stride : nullptr;
+
+        for (int g = 0; g < m_groups; g++) {
+            // Gather this group's channels into lanes (unused lanes stay 0)
+            float lanes[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            if (frame) {
+                int count = m_channels - g * 4;
+                if (count > 4) count = 4;
+                for (int lane = 0; lane < count; lane++) lanes[lane] = frame[g * 4 + lane];
+            }
+            ProcessGroup(m_laneGroups[g], F4Load(lanes));
+        }
+
+        if (++m_subblockPos >= m_subblockFrames) FinishSubblock();
+    }
+}
+
+void LoudnessMeter::ProcessGroup(LaneGroup& group, Float4 x) {
+    // True peak, from the unweighted signal
+    int pos = group.historyPos;
+    group.history[pos] = x;
+    group.history[pos + TP_TAPS] = x;
+    group.historyPos = (pos + 1) % TP_TAPS;
+    if (m_oversample) {
+        // history[pos + TP_TAPS - k] is the sample k frames ago
+        const Float4* h = &group.history[pos + TP_TAPS];
+        for (int p = 0; p < TP_PHASES; p++) {
+            Float4 y = F4Zero();
+            for (int k = 0; k < TP_TAPS; k++) {
+                y = F4Add(y, F4Mul(m_tpCoeffs[p][k], *(h - k)));
+            }
+            group.peak = F4Max(group.peak, F4Abs(y));
+        }
+    } else {
+        group.peak = F4Max(group.peak, F4Abs(x));
+    }
+
+    // K-weighting: pre-filter shelf, then RLB high-pass
+    Float4 y = F4Add(F4Mul(m_shelf.b0, x), group.shelfS1);
+    group.shelfS1 = F4Add(F4Sub(F4Mul(m_shelf.b1, x), F4Mul(m_shelf.a1, y)), group.shelfS2);
+    group.shelfS2 = F4Sub(F4Mul(m_shelf.b2, x), F4Mul(m_shelf.a2, y));
+
+    Float4 z = F4Add(F4Mul(m_highpass.b0, y), group.highpassS1);
+    group.highpassS1 = F4Add(F4Sub(F4Mul(m_highpass.b1, y), F4Mul(m_highpass.a1, z)), group.highpassS2);
+    group.highpassS2 = F4Sub(F4Mul(m_highpass.b2, y), F4Mul(m_highpass.a2, z));
+
+    group.sumSquares = F4Add(group.sumSquares, F4Mul(z, z));
+}
+
+void LoudnessMeter::FinishSubblock() {
+    double power = 0.0;
+    float peak = 0.0f;
+    for (int g = 0; g < m_groups; g++) {
+        LaneGroup& group = m_laneGroups[g];
+        float sums[4], weights[4], peaks[4];
+        F4Store(sums, group.sumSquares);
+        F4Store(weights, group.weight);
+        F4Store(peaks, group.peak);
+        for (int lane = 0; lane < 4; lane++) {
+            power += (double)weights[lane] * sums[lane];
+            if (peaks[lane] > peak) peak = peaks[lane];
+        }
+        group.sumSquares = F4Zero();
+        group.peak = F4Zero();
+    }
+    power /= m_subblockPos;
+    m_subblockPos = 0;
+
+    m_subblockPower[m_subblockHead % SUBBLOCKS_SHORT_TERM] = (float)power;
+    m_subblockPeak[m_subblockHead % SUBBLOCKS_MOMENTARY] = peak;
+    m_subblockHead = (m_subblockHead + 1) % (SUBBLOCKS_SHORT_TERM * SUBBLOCKS_MOMENTARY);
+    if (m_subblockCount < SUBBLOCKS_SHORT_TERM) m_subblockCount++;
+
+    // Windows over the newest sub-blocks (shorter while the meter warms up)
+    double momentary = 0.0, shortTerm = 0.0;
+    float truePeak = 0.0f;
+    for (int i = 0; i < m_subblockCount; i++) {
+        int idx = (m_subblockHead - 1 - i + SUBBLOCKS_SHORT_TERM * SUBBLOCKS_MOMENTARY);
+        float p = m_subblockPower[idx % SUBBLOCKS_SHORT_TERM];
+        shortTerm += p;
+        if (i < SUBBLOCKS_MOMENTARY) {
+            momentary += p;
+            float pk = m_subblockPeak[idx % SUBBLOCKS_MOMENTARY];
+            if (pk > truePeak) truePeak = pk;
+        }
+    }
+    int momentaryCount = m_subblockCount < SUBBLOCKS_MOMENTARY ? m_subblockCount : SUBBLOCKS_MOMENTARY;
+    m_momentary = PowerToLUFS(momentary / momentaryCount);
+    m_shortTerm = PowerToLUFS(shortTerm / m_subblockCount);
+    m_truePeak = AmplitudeToDB(truePeak);
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include "VectorOps.h"
+
+// Streaming ITU-R BS.1770 loudness and true-peak meter.
+// Runs directly on the interleaved capture buffer: K-weighting (shelf +
+// high-pass biquads) and the 4x oversampling true-peak interpolator process
+// up to four channels at once, one channel per SIMD lane.
+//
+// Mean square is collected in 100 ms sub-blocks; momentary loudness covers
+// the last 400 ms and short-term the last 3 s. The true peak is the highest
+// interpolated sample over the momentary window.
+class LoudnessMeter {
+public:
+    static const int MAX_CHANNELS = 8;
+    static const int SUBBLOCKS_MOMENTARY = 4;   // 400 ms
+    static const int SUBBLOCKS_SHORT_TERM = 30; // 3 s
+    static constexpr float SILENCE_LUFS = -70.0f;
+
+    LoudnessMeter();
+
+    // Recomputes the filters for the stream and resets all state.
+    // Channels past MAX_CHANNELS are skipped but stay in the interleave.
+    void Configure(double sampleRate, int channels);
+    void Reset();
+
+    // interleaved holds frames * channels samples; nullptr means digital silence
+    void Process(const float* interleaved, int frames);
+
+    float GetMomentaryLUFS() const { return m_momentary; }
+    float GetShortTermLUFS() const { return m_shortTerm; }
+    float GetTruePeakDB() const { return m_truePeak; }  // dBTP
+
+private:
+    static const int TP_PHASES = 4;
+    static const int TP_TAPS = 12;   // Per phase
+
+    struct Biquad {
+        Float4 b0, b1, b2, a1, a2;
+    };
+
+    // Per group of four channels
+    struct LaneGroup {
+        Float4 shelfS1, shelfS2;          // Biquad state (transposed direct form II)
+        Float4 highpassS1, highpassS2;
+        Float4 sumSquares;                // Current sub-block
+        Float4 peak;                      // Current sub-block
+        Float4 history[TP_TAPS * 2];      // True-peak input, mirrored so taps are contiguous
+        int historyPos;
+        Float4 weight;                    // BS.1770 channel weights (0 for LFE/unused lanes)
+    };
+
+    void ProcessGroup(LaneGroup& group, Float4 x);
+    void FinishSubblock();
+
+    int m_stride = 2;                     // Channels in the stream
+    int m_channels = 2;                   // Channels measured
+    int m_groups = 1;
+    int m_subblockFrames = 4800;
+    int m_subblockPos = 0;
+
+    Biquad m_shelf;
+    Biquad m_highpass;
+    Float4 m_tpCoeffs[TP_PHASES][TP_TAPS];
+    bool m_oversample = true;             // No interpolation needed at >= 176.4 kHz
+    LaneGroup m_laneGroups[(MAX_CHANNELS + 3) / 4];
+
+    // Rings of finished sub-blocks
+    std::vector<float> m_subblockPower;   // Channel-weighted mean square
+    std::vector<float> m_subblockPeak;    // Linear
+    int m_subblockHead = 0;
+    int m_subblockCount = 0;
+
+    float m_momentary = SILENCE_LUFS;
+    float m_shortTerm = SILENCE_LUFS;
+    float m_truePeak = SILENCE_LUFS;
+};
@@ -0,0 +1,132 @@
+/*
+ * Live spectrum published by MusicVisVibeCode in shared memory.
+ * Plain C; include it from C or C++ consumers (lighting controllers, LED
+ * walls) to read the analysis the app already runs, without a second capture.
+ *
+ * The segment is one MusicVisShmSegment, written by the app's audio thread
+ * once per analysis block (~94 Hz at 48 kHz) and guarded by a seqlock:
+ * sequence is odd while a frame is being written. Read fields in place:
+ *
+ *     const MusicVisShmSegment* shm = musicvis_shm_open(MUSICVIS_SHM_NAME);
+ *     uint32_t seq;
+ *     do {
+ *         seq = musicvis_shm_read_begin(shm);
+ *         ... read shm->frame ...
+ *     } while (musicvis_shm_read_retry(shm, seq));
+ *     musicvis_shm_close(shm);
+ *
+ * Check magic and version before trusting the layout. Arrays are only
+ * filled for the analysis features set in frame.features (AnalysisFeature
+ * bits, see AudioData.h); the app always includes the spectrum, envelopes,
+ * tempo and loudness while publishing.
+ */
+#ifndef MUSICVIS_SHM_H
+#define MUSICVIS_SHM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef _WIN32
+#define MUSICVIS_SHM_NAME "Local\\MusicVisSpectrum"
+#else
+#define MUSICVIS_SHM_NAME "/musicvis_spectrum"
+#endif
+
+#define MUSICVIS_SHM_MAGIC 0x5356564Du  /* "MVVS" */
+#define MUSICVIS_SHM_VERSION 1u
+#define MUSICVIS_SHM_BINS 256
+#define MUSICVIS_SHM_CQT_BINS 84
+
+typedef struct MusicVisShmFrame {
+    double timestamp;          /* Capture time of the block's last sample, seconds */
+    uint32_t features;         /* AnalysisFeature bits computed for this frame */
+    uint32_t playing;          /* 0 while the capture is silent */
+    float scale;               /* AGC ceiling */
+    float tempoBPM;            /* 0 until a tempo is found */
+    float tempoConfidence;
+    float beatPhase;           /* 0 -> 1 between beats, 0 = on the beat */
+    float loudnessMomentary;   /* LUFS */
+    float loudnessShortTerm;
+    float truePeak;            /* dBTP */
+    float spectralCentroid;    /* Hz */
+    float spectralRolloff;     /* Hz */
+    float spectralFlatness;
+    float spectralFlux;
+    float reserved[5];
+    float spectrum[MUSICVIS_SHM_BINS];            /* Raw magnitudes */
+    float spectrumNormalized[MUSICVIS_SHM_BINS];  /* 0-1 */
+    float spectrumSmoothed[MUSICVIS_SHM_BINS];    /* 0-1, attack/release envelope */
+    float spectrumPeak[MUSICVIS_SHM_BINS];        /* 0-1, instant attack, slow release */
+    float spectrumCQT[MUSICVIS_SHM_CQT_BINS];     /* Semitones from A2, 0-1 */
+    float chroma[12];                             /* C..B, strongest = 1 */
+} MusicVisShmFrame;
+
+typedef struct MusicVisShmSegment {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t segmentSize;      /* sizeof(MusicVisShmSegment) as written */
+    uint32_t sequence;         /* Seqlock, odd while writing */
+    uint64_t frameCount;       /* Frames published since the app started */
+    MusicVisShmFrame frame;
+} MusicVisShmSegment;
+
+/* Seqlock helpers (acquire loads; x86/x64 MSVC volatile reads are acquire) */
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+static __inline uint32_t musicvis_shm_load_(const uint32_t* p) { return *(const volatile uint32_t*)p; }
+#define MUSICVIS_SHM_FENCE_() _ReadWriteBarrier()
+#else
+static inline uint32_t musicvis_shm_load_(const uint32_t* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+#define MUSICVIS_SHM_FENCE_() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#endif
+
+/* Waits out a write in progress; returns the sequence to pass to read_retry */
+static inline uint32_t musicvis_shm_read_begin(const MusicVisShmSegment* shm) {
+    uint32_t seq;
+    while ((seq = musicvis_shm_load_(&shm->sequence)) & 1u) {
+    }
+    return seq;
+}
+
+/* Non-zero if a frame was written while reading; read again */
+static inline int musicvis_shm_read_retry(const MusicVisShmSegment* shm, uint32_t seq) {
+    MUSICVIS_SHM_FENCE_();
+    return musicvis_shm_load_(&shm->sequence) != seq;
+}
+
+/* Read-only mapping of a published segment; NULL if the app isn't publishing */
+#ifdef _WIN32
+#include <windows.h>
+
+static inline const MusicVisShmSegment* musicvis_shm_open(const char* name) {
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+    const void* view;
+    if (!mapping) return NULL;
+    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(MusicVisShmSegment));
+    CloseHandle(mapping); /* The view keeps the mapping alive */
+    return (const MusicVisShmSegment*)view;
+}
+
+static inline void musicvis_shm_close(const MusicVisShmSegment* shm) {
+    if (shm) UnmapViewOfFile(shm);
+}
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static inline const MusicVisShmSegment* musicvis_shm_open(const char* name) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    void* view;
+    if (fd < 0) return NULL;
+    view = mmap(NULL, sizeof(MusicVisShmSegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); /* The mapping stays valid */
+    return view == MAP_FAILED ? NULL : (const MusicVisShmSegment*)view;
+}
+
+static inline void musicvis_shm_close(const MusicVisShmSegment* shm) {
+    if (shm) munmap((void*)shm, sizeof(MusicVisShmSegment));
+}
+#endif
+
+#endif /* MUSICVIS_SHM_H */
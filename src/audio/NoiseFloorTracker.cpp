@@ -0,0 +1,46 @@
+#include "NoiseFloorTracker.h"
+#include <algorithm>
+#include <cfloat>
+
+NoiseFloorTracker::NoiseFloorTracker(int numBins)
+    : m_numBins(numBins), m_smoothed(numBins, 0.0f), m_subwindowMin(numBins, FLT_MAX),
+      m_history(NUM_SUBWINDOWS * numBins, FLT_MAX), m_windowMin(numBins, FLT_MAX), m_floor(numBins, 0.0f) {
+    SetFrameRate(48000.0f / 512.0f);
+}
+
+void NoiseFloorTracker::SetFrameRate(float frameRate) {
+    m_subwindowFrames = std::max(1, (int)(WINDOW_SECONDS * frameRate / NUM_SUBWINDOWS + 0.5f));
+    Reset();
+}
+
+void NoiseFloorTracker::Reset() {
+    std::fill(m_smoothed.begin(), m_smoothed.end(), 0.0f);
+    std::fill(m_subwindowMin.begin(), m_subwindowMin.end(), FLT_MAX);
+    std::fill(m_history.begin(), m_history.end(), FLT_MAX);
+    std::fill(m_windowMin.begin(), m_windowMin.end(), FLT_MAX);
+    std::fill(m_floor.begin(), m_floor.end(), 0.0f);
+    m_frameInSubwindow = 0;
+    m_oldestSubwindow = 0;
+    m_primed = false;
+}
+
+void NoiseFloorTracker::EndFrame() {
+    m_primed = true;
+    if (++m_frameInSubwindow < m_subwindowFrames) return;
+    m_frameInSubwindow = 0;
+
+    // Retire the oldest subwindow, then rebuild the window minimum from the
+    // NUM_SUBWINDOWS stored ones (whole rows at a time)
+    float* slot = &m_history[m_oldestSubwindow * m_numBins];
+    std::copy(m_subwindowMin.begin(), m_subwindowMin.end(), slot);
+    m_oldestSubwindow = (m_oldestSubwindow + 1) % NUM_SUBWINDOWS;
+
+    std::copy(m_history.begin(), m_history.begin() + m_numBins, m_windowMin.begin());
+    for (int s = 1; s < NUM_SUBWINDOWS; s++) {
+        const float* row = &m_history[s * m_numBins];
+        for (int i = 0; i < m_numBins; i += 4) {
+            F4Store(&m_windowMin[i], F4Min(F4Load(&m_windowMin[i]), F4Load(row + i)));
+        }
+    }
+    std::fill(m_subwindowMin.begin(), m_subwindowMin.end(), FLT_MAX);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+#include "VectorOps.h"
+
+// Per-bin noise floor by minimum statistics (after R. Martin).
+// Each bin's magnitude is smoothed, and the floor is the minimum of the
+// smoothed value over the last WINDOW_SECONDS, scaled up for the bias of a
+// minimum. Steady hiss and hum sit at that minimum; music rarely stays
+// there for the whole window.
+//
+// The window is split into NUM_SUBWINDOWS. Each block only updates the
+// running minimum of the current subwindow; when a subwindow completes its
+// minimum replaces the oldest, and the window minimum is rebuilt from the
+// NUM_SUBWINDOWS stored ones. The work per block doesn't depend on the
+// window length.
+class NoiseFloorTracker {
+public:
+    static const int NUM_SUBWINDOWS = 8;
+    static constexpr float WINDOW_SECONDS = 2.0f;
+    static constexpr float SMOOTHING = 0.85f;  // Per-block smoothing of the magnitude
+    static constexpr float BIAS = 1.5f;        // Minimum of a smoothed noisy value reads low
+
+    explicit NoiseFloorTracker(int numBins);  // numBins must be a multiple of 4
+
+    void SetFrameRate(float frameRate);  // Analysis blocks per second; resets
+    void Reset();
+
+    // Feed one block's magnitudes for bins [bin, bin + 4); returns their
+    // current floor estimate. Call for every group of four bins, in any
+    // order, then EndFrame() once per block.
+    inline Float4 Update4(int bin, Float4 magnitude);
+    void EndFrame();
+
+    const float* GetFloor() const { return m_floor.data(); }
+    int GetSubwindowFrames() const { return m_subwindowFrames; }
+
+private:
+    int m_numBins;
+    int m_subwindowFrames = 1;
+    int m_frameInSubwindow = 0;
+    int m_oldestSubwindow = 0;
+    bool m_primed = false;              // Smoothed values seeded from the first block
+
+    std::vector<float> m_smoothed;
+    std::vector<float> m_subwindowMin;  // Running minimum of the current subwindow
+    std::vector<float> m_history;       // NUM_SUBWINDOWS completed minima per bin
+    std::vector<float> m_windowMin;     // Minimum over m_history
+    std::vector<float> m_floor;
+};
+
+inline Float4 NoiseFloorTracker::Update4(int bin, Float4 magnitude) {
+    Float4 smoothed = m_primed ? F4Add(F4Mul(F4Load(&m_smoothed[bin]), F4Set1(SMOOTHING)),
+                                       F4Mul(magnitude, F4Set1(1.0f - SMOOTHING)))
+                               : magnitude;
+    F4Store(&m_smoothed[bin], smoothed);
+
+    Float4 subwindowMin = F4Min(F4Load(&m_subwindowMin[bin]), smoothed);
+    F4Store(&m_subwindowMin[bin], subwindowMin);
+
+    Float4 floor = F4Mul(F4Min(subwindowMin, F4Load(&m_windowMin[bin])), F4Set1(BIAS));
+    F4Store(&m_floor[bin], floor);
+    return floor;
+}
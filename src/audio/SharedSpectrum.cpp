@@ -0,0 +1,125 @@
+#include "SharedSpectrum.h"
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// No implicit padding, so C and C++ consumers on any compiler agree on the layout
+static_assert(sizeof(MusicVisShmFrame) == offsetof(MusicVisShmFrame, chroma) + sizeof(float) * 12, "frame has tail padding");
+static_assert(offsetof(MusicVisShmSegment, frame) == 24, "segment header has padding");
+
+static void StoreSequence(uint32_t* sequence, uint32_t value, bool release) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    // Volatile stores are release on x86/x64 under MSVC
+    (void)release;
+    *(volatile uint32_t*)sequence = value;
+#else
+    __atomic_store_n(sequence, value, release ? __ATOMIC_RELEASE : __ATOMIC_RELAXED);
+#endif
+}
+
+bool SharedSpectrumWriter::Open(const std::string& name) {
+    Close();
+    const size_t size = sizeof(MusicVisShmSegment);
+
+#ifdef _WIN32
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)size, name.c_str());
+    if (!mapping) {
+        std::cerr << "Failed to create shared memory " << name << " (" << GetLastError() << ")" << std::endl;
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!view) {
+        CloseHandle(mapping);
+        std::cerr << "Failed to map shared memory " << name << std::endl;
+        return false;
+    }
+    m_mapping = mapping;
+#else
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to create shared memory " << name << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        std::cerr << "Failed to size shared memory " << name << std::endl;
+        return false;
+    }
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        std::cerr << "Failed to map shared memory " << name << std::endl;
+        return false;
+    }
+#endif
+
+    // A segment left by a previous run (or a crash mid-write) starts over
+    // from an even sequence with no frames
+    m_segment = (MusicVisShmSegment*)view;
+    m_name = name;
+    memset(m_segment, 0, size);
+    m_segment->magic = MUSICVIS_SHM_MAGIC;
+    m_segment->version = MUSICVIS_SHM_VERSION;
+    m_segment->segmentSize = (uint32_t)size;
+    std::atomic_thread_fence(std::memory_order_release);
+    return true;
+}
+
+void SharedSpectrumWriter::Close() {
+    if (!m_segment) return;
+#ifdef _WIN32
+    // The name goes away with the last handle; readers keep their views
+    UnmapViewOfFile(m_segment);
+    CloseHandle((HANDLE)m_mapping);
+    m_mapping = nullptr;
+#else
+    munmap(m_segment, sizeof(MusicVisShmSegment));
+    shm_unlink(m_name.c_str());
+#endif
+    m_segment = nullptr;
+}
+
+void SharedSpectrumWriter::Publish(const AudioData& data, double timestamp, uint32_t features) {
+    if (!m_segment) return;
+
+    // Same protocol as SpectrumPublisher: odd sequence while writing. The
+    // segment holds plain C fields, so the sequence goes through builtins
+    // rather than std::atomic.
+    uint32_t seq = m_segment->sequence;
+    StoreSequence(&m_segment->sequence, seq + 1, false);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    MusicVisShmFrame& frame = m_segment->frame;
+    frame.timestamp = timestamp;
+    frame.features = features;
+    frame.playing = data.playing ? 1 : 0;
+    frame.scale = data.Scale;
+    frame.tempoBPM = data.TempoBPM;
+    frame.tempoConfidence = data.TempoConfidence;
+    frame.beatPhase = data.BeatPhase;
+    frame.loudnessMomentary = data.LoudnessMomentary;
+    frame.loudnessShortTerm = data.LoudnessShortTerm;
+    frame.truePeak = data.TruePeak;
+    frame.spectralCentroid = data.SpectralCentroid;
+    frame.spectralRolloff = data.SpectralRolloff;
+    frame.spectralFlatness = data.SpectralFlatness;
+    frame.spectralFlux = data.SpectralFlux;
+    memcpy(frame.spectrum, data.Spectrum, sizeof(frame.spectrum));
+    memcpy(frame.spectrumNormalized, data.SpectrumNormalized, sizeof(frame.spectrumNormalized));
+    memcpy(frame.spectrumSmoothed, data.SpectrumSmoothed, sizeof(frame.spectrumSmoothed));
+    memcpy(frame.spectrumPeak, data.SpectrumPeak, sizeof(frame.spectrumPeak));
+    memcpy(frame.spectrumCQT, data.SpectrumCQT, sizeof(frame.spectrumCQT));
+    memcpy(frame.chroma, data.Chroma, sizeof(frame.chroma));
+    m_segment->frameCount++;
+
+    StoreSequence(&m_segment->sequence, seq + 2, true);
+}
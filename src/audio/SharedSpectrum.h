@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include "AudioData.h"
+#include "MusicVisShm.h"
+
+// Publishes each analysis frame into a named shared-memory segment
+// (POSIX shm on Linux, a file mapping on Windows) for external processes;
+// layout and the reader side are in MusicVisShm.h. The frame is written in
+// place under the segment's seqlock, so publishing costs one copy of the
+// arrays and no allocation. Single writer; owned by the audio thread.
+class SharedSpectrumWriter {
+public:
+    SharedSpectrumWriter() = default;
+    ~SharedSpectrumWriter() { Close(); }
+
+    // Creates the segment, or reuses one left by a previous run
+    bool Open(const std::string& name = MUSICVIS_SHM_NAME);
+    void Close();  // Unmaps and removes the name
+    bool IsOpen() const { return m_segment != nullptr; }
+
+    void Publish(const AudioData& data, double timestamp, uint32_t features);
+
+private:
+    MusicVisShmSegment* m_segment = nullptr;
+    std::string m_name;
+    void* m_mapping = nullptr;  // Windows file mapping handle
+};
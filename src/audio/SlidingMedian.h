@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+// Running median over a FIFO window of floats.
+// Keeps the window both in arrival order (ring) and sorted, so each push or
+// pop is a binary search plus a short memmove instead of re-sorting the
+// window. For the small windows used here (<= ~33) that beats heap-based
+// structures in practice.
+class SlidingMedian {
+public:
+    explicit SlidingMedian(int capacity = 1) { SetCapacity(capacity); }
+
+    void SetCapacity(int capacity) {
+        if (capacity < 1) capacity = 1;
+        m_ring.assign(capacity, 0.0f);
+        m_sorted.assign(capacity, 0.0f);
+        Reset();
+    }
+
+    void Reset() {
+        m_head = 0;
+        m_count = 0;
+    }
+
+    int Size() const { return m_count; }
+    int Capacity() const { return (int)m_ring.size(); }
+
+    // Add a value; evicts the oldest one first when the window is full
+    void Push(float value) {
+        if (m_count == Capacity()) PopOldest();
+
+        int tail = (m_head + m_count) % Capacity();
+        m_ring[tail] = value;
+
+        float* sorted = m_sorted.data();
+        int pos = (int)(std::upper_bound(sorted, sorted + m_count, value) - sorted);
+        memmove(sorted + pos + 1, sorted + pos, (m_count - pos) * sizeof(float));
+        sorted[pos] = value;
+        m_count++;
+    }
+
+    void PopOldest() {
+        if (m_count == 0) return;
+        float value = m_ring[m_head];
+        m_head = (m_head + 1) % Capacity();
+
+        float* sorted = m_sorted.data();
+        int pos = (int)(std::lower_bound(sorted, sorted + m_count, value) - sorted);
+        memmove(sorted + pos, sorted + pos + 1, (m_count - pos - 1) * sizeof(float));
+        m_count--;
+    }
+
+    // Upper median for even sizes; 0 when empty
+    float Median() const {
+        return m_count > 0 ? m_sorted[m_count / 2] : 0.0f;
+    }
+
+private:
+    std::vector<float> m_ring;    // Arrival order, oldest at m_head
+    std::vector<float> m_sorted;  // First m_count entries, ascending
+    int m_head = 0;
+    int m_count = 0;
+};
@@ -0,0 +1,73 @@
+#include "SpectralDescriptors.h"
+#include "ConstantQ.h"
+#include <algorithm>
+#include <cmath>
+
+SpectralDescriptors::SpectralDescriptors(int numBins, int fftSize)
+    : m_numBins(numBins), m_fftSize(fftSize), m_previous(numBins, 0.0f), m_cumulative(numBins, 0.0f) {
+}
+
+void SpectralDescriptors::SetSampleRate(float sampleRate) {
+    m_sampleRate = sampleRate;
+    Reset();
+}
+
+void SpectralDescriptors::Reset() {
+    std::fill(m_previous.begin(), m_previous.end(), 0.0f);
+}
+
+void SpectralDescriptors::Process(const float* spectrum, const float* cqt, AudioData& data) {
+    float binWidth = m_sampleRate / m_fftSize;
+    float total = 0.0f, weightedFrequency = 0.0f;
+    float powerSum = 0.0f, logPowerSum = 0.0f;
+    float flux = 0.0f, spectrumSum = 0.0f;
+
+    // One pass: every descriptor reads each bin once
+    for (int i = 0; i < m_numBins; i++) {
+        float s = spectrum[i];
+        float magnitude = s * s;  // Spectrum holds sqrt(|X|)
+        float power = magnitude * magnitude;
+
+        total += magnitude;
+        m_cumulative[i] = total;
+        weightedFrequency += magnitude * (i * binWidth);
+        powerSum += power;
+        logPowerSum += logf(power + 1e-12f);
+
+        float rise = s - m_previous[i];
+        if (rise > 0.0f) flux += rise;
+        spectrumSum += s;
+        m_previous[i] = s;
+    }
+
+    if (total <= 1e-9f) {
+        for (int c = 0; c < NUM_CHROMA; c++) data.Chroma[c] = 0.0f;
+        data.SpectralCentroid = 0.0f;
+        data.SpectralRolloff = 0.0f;
+        data.SpectralFlatness = 0.0f;
+        data.SpectralFlux = 0.0f;
+        return;
+    }
+
+    // CQ bin 0 is A2, so bin b is pitch class (A + b) mod 12
+    float chroma[NUM_CHROMA] = { 0 };
+    for (int b = 0; b < ConstantQ::NUM_BINS; b++) {
+        chroma[(9 + b) % NUM_CHROMA] += cqt[b];
+    }
+    float chromaPeak = *std::max_element(chroma, chroma + NUM_CHROMA);
+    for (int c = 0; c < NUM_CHROMA; c++) {
+        data.Chroma[c] = chromaPeak > 0.0f ? chroma[c] / chromaPeak : 0.0f;
+    }
+
+    data.SpectralCentroid = weightedFrequency / total;
+
+    int rolloffBin = (int)(std::lower_bound(m_cumulative.begin(), m_cumulative.end(), ROLLOFF_FRACTION * total) -
+                           m_cumulative.begin());
+    data.SpectralRolloff = std::min(rolloffBin, m_numBins - 1) * binWidth;
+
+    // Geometric over arithmetic mean of the power spectrum
+    float meanPower = powerSum / m_numBins;
+    data.SpectralFlatness = std::min(1.0f, expf(logPowerSum / m_numBins) / meanPower);
+
+    data.SpectralFlux = spectrumSum > 0.0f ? flux / spectrumSum : 0.0f;
+}
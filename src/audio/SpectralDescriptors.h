@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include "AudioData.h"
+
+// Chroma and spectral shape descriptors for one analysis block.
+//
+// Centroid, rolloff, flatness and flux come from a single fused pass over
+// the 256-bin magnitude spectrum. Chroma folds the constant-Q bins into 12
+// pitch classes instead: 512-point FFT bins are ~94 Hz wide, wider than a
+// semitone everywhere below ~1.6 kHz, so they can't tell notes apart.
+class SpectralDescriptors {
+public:
+    static const int NUM_CHROMA = 12;
+    static constexpr float ROLLOFF_FRACTION = 0.85f;
+
+    SpectralDescriptors(int numBins, int fftSize);
+
+    void SetSampleRate(float sampleRate);  // Resets
+    void Reset();
+
+    // spectrum: numBins values of sqrt(|X|), as in AudioData::Spectrum.
+    // cqt: ConstantQ::NUM_BINS magnitudes starting at A2.
+    // Fills Chroma, SpectralCentroid/Rolloff/Flatness/Flux.
+    void Process(const float* spectrum, const float* cqt, AudioData& data);
+
+private:
+    int m_numBins;
+    int m_fftSize;
+    float m_sampleRate = 48000.0f;
+
+    std::vector<float> m_previous;    // Last block's spectrum, for flux
+    std::vector<float> m_cumulative;  // Running magnitude sum, for rolloff
+};
@@ -0,0 +1,366 @@
+#include "SpectrumAnalyzer.h"
+#include "VectorOps.h"
+#include "../common/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Loudness AGC: expected peak bin magnitude for a 0 LUFS stream. Magnitudes
+// are sqrt(|X|), so they scale with amplitude^0.5, i.e. 10^(LUFS / 40).
+// Measured at 10-14 across tones and noise; 12 puts loud passages near the top.
+static const float LOUDNESS_CEILING_AT_0_LUFS = 12.0f;
+
+// Weighting_Tilt slope, pivoting at 1 kHz
+static const double TILT_DB_PER_OCTAVE = 3.0;
+
+// Noise gate: subtracts GATE_OVERSUBTRACT times the floor, since noise
+// fluctuates well above its average. What is subtracted is capped at
+// GATE_MAX_FLOOR of the AGC ceiling, so a sustained loud note that sits at
+// its own minimum for the whole tracking window isn't gated away with the hiss.
+static const float GATE_OVERSUBTRACT = 2.0f;
+static const float GATE_MAX_FLOOR = 0.3f;
+
+#define STAGE_BIT(s) (1u << SpectrumAnalyzer::s)
+
+// Stage table, in evaluation order (dependencies always come first)
+const SpectrumAnalyzer::StageNode SpectrumAnalyzer::s_stages[Stage_Count] = {
+    { "FFT",          Feature_None,               0,                                &SpectrumAnalyzer::RunFFT },
+    { "Spectrum",     Feature_Spectrum | Feature_SpectrumNormalized |
+                      Feature_History | Feature_HistoryNormalized | Feature_NoiseFloor, STAGE_BIT(Stage_FFT), &SpectrumAnalyzer::RunSpectrum },
+    { "PeakHold",     Feature_HighestSample,      STAGE_BIT(Stage_Spectrum),        &SpectrumAnalyzer::RunPeakHold },
+    { "HPSS",         Feature_HarmonicPercussive, STAGE_BIT(Stage_Spectrum),        &SpectrumAnalyzer::RunHPSS },
+    { "Tempo",        Feature_Tempo,              STAGE_BIT(Stage_Spectrum),        &SpectrumAnalyzer::RunTempo },
+    { "LongHistory",  Feature_LongHistory,        STAGE_BIT(Stage_Spectrum),        &SpectrumAnalyzer::RunLongHistory },
+    { "CQT",          Feature_ConstantQ,          0,                                &SpectrumAnalyzer::RunCQT },
+    { "Descriptors",  Feature_Descriptors,        STAGE_BIT(Stage_Spectrum) | STAGE_BIT(Stage_CQT), &SpectrumAnalyzer::RunDescriptors },
+    { "Envelope",     Feature_Envelope,           STAGE_BIT(Stage_Spectrum),        &SpectrumAnalyzer::RunEnvelope },
+};
+
+SpectrumAnalyzer::SpectrumAnalyzer()
+    : m_requiredFeatures(Feature_All), m_loudnessAgc(false), m_noiseGate(false), m_weighting(Weighting_Flat),
+      m_smoothAttack(DEFAULT_SMOOTH_ATTACK), m_smoothRelease(DEFAULT_SMOOTH_RELEASE), m_peakRelease(DEFAULT_PEAK_RELEASE),
+      m_fft(FFT_SIZE), m_noiseFloor(NUM_BINS), m_separator(NUM_BINS),
+      m_tempo(NUM_BINS, 48000.0f / FFT_SIZE), m_descriptors(NUM_BINS, FFT_SIZE),
+      m_smoothed(NUM_BINS), m_peaks(NUM_BINS), m_totalMicros(0.0f) {
+    // Hanning window, computed once instead of per block
+    m_window.resize(FFT_SIZE);
+    for (int i = 0; i < FFT_SIZE; i++) {
+        m_window[i] = 0.5f * (1.0f - cos(2.0f * M_PI * i / (FFT_SIZE - 1)));
+    }
+    m_complexSamples.resize(FFT_SIZE);
+    m_weights.assign(NUM_BINS, 1.0f);
+
+    for (int s = 0; s < Stage_Count; s++) {
+        m_stageActive[s] = false;
+        m_stageMicros[s] = 0.0f;
+    }
+}
+
+void SpectrumAnalyzer::SetSampleRate(double sampleRate) {
+    m_sampleRate = sampleRate;
+    m_tempo.SetFrameRate((float)(sampleRate / FFT_SIZE));
+    m_longHistory.SetFrameRate((float)(sampleRate / FFT_SIZE));
+    m_descriptors.SetSampleRate((float)sampleRate);
+    m_appliedWeighting = -1;  // Curves depend on bin frequencies
+    m_noiseFloor.SetFrameRate((float)(sampleRate / FFT_SIZE));
+}
+
+uint32_t SpectrumAnalyzer::ResolveStages(uint32_t features) const {
+    // Seed with the stages producing the requested features
+    uint32_t stages = 0;
+    for (int s = 0; s < Stage_Count; s++) {
+        if (s_stages[s].produces & features) stages |= (1u << s);
+    }
+
+    // Pull in dependencies. Walking backwards works because the table is
+    // ordered so every dependency has a lower index than its dependents.
+    for (int s = Stage_Count - 1; s >= 0; s--) {
+        if (stages & (1u << s)) stages |= s_stages[s].dependsOn;
+    }
+    return stages;
+}
+
+SpectrumAnalyzer::StageTiming SpectrumAnalyzer::GetStageTiming(int stage) const {
+    StageTiming timing;
+    if (stage < 0 || stage >= Stage_Count) return timing;
+    timing.name = s_stages[stage].name;
+    timing.active = m_stageActive[stage].load(std::memory_order_relaxed);
+    timing.avgMicros = m_stageMicros[stage].load(std::memory_order_relaxed);
+    return timing;
+}
+
+void SpectrumAnalyzer::Process(std::vector<float>& samples, float deltaTime, AudioData& data) {
+    if (samples.size() < FFT_SIZE) return;
+
+    uint32_t stages = ResolveStages(m_requiredFeatures.load(std::memory_order_relaxed));
+
+    // Buffers that were not being maintained hold stale frames; clear them
+    // when their stage comes back so old data doesn't flash on screen.
+    uint32_t newlyActive = stages & ~m_lastStages;
+    if (newlyActive & STAGE_BIT(Stage_Spectrum)) {
+        memset(data.History, 0, sizeof(data.History));
+        memset(data.HistoryNormalized, 0, sizeof(data.HistoryNormalized));
+    }
+    if (newlyActive & STAGE_BIT(Stage_HPSS)) {
+        m_separator.Reset();
+    }
+    if (newlyActive & STAGE_BIT(Stage_Tempo)) {
+        m_tempo.Reset();
+    }
+    if (newlyActive & STAGE_BIT(Stage_LongHistory)) {
+        m_longHistory.Reset();
+    }
+    if (newlyActive & STAGE_BIT(Stage_CQT)) {
+        m_cqt.Reset();
+        m_cqtPeak = 0.0f;
+    }
+    if (newlyActive & STAGE_BIT(Stage_Descriptors)) {
+        m_descriptors.Reset();
+    }
+    if (newlyActive & STAGE_BIT(Stage_Envelope)) {
+        m_smoothed.Reset();
+        m_peaks.Reset();
+    }
+    m_lastStages = stages;
+
+    int weighting = m_weighting.load(std::memory_order_relaxed);
+    if (weighting != m_appliedWeighting) BuildWeights((SpectrumWeighting)weighting);
+
+    m_samples = &samples;
+    m_deltaTime = deltaTime;
+
+    // Update History Index
+    data.historyIndex = (data.historyIndex + 1) % HISTORY_SIZE;
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point blockStart = Clock::now();
+
+    for (int s = 0; s < Stage_Count; s++) {
+        bool active = (stages & (1u << s)) != 0;
+        m_stageActive[s].store(active, std::memory_order_relaxed);
+        if (!active) {
+            // A skipped stage costs nothing; don't keep showing its old cost
+            m_stageMicros[s].store(0.0f, std::memory_order_relaxed);
+            continue;
+        }
+
+        PROFILE_ZONE(s_stages[s].name);
+        Clock::time_point start = Clock::now();
+        (this->*s_stages[s].run)(data);
+        float micros = std::chrono::duration<float, std::micro>(Clock::now() - start).count();
+
+        // Smooth over ~100 blocks (~1 second) so the OSD is readable; a
+        // stage that just came on starts from its first block
+        float avg = (newlyActive & (1u << s)) ? micros : m_stageMicros[s].load(std::memory_order_relaxed);
+        m_stageMicros[s].store(avg + (micros - avg) * 0.01f, std::memory_order_relaxed);
+    }
+
+    float total = std::chrono::duration<float, std::micro>(Clock::now() - blockStart).count();
+    float avgTotal = m_totalMicros.load(std::memory_order_relaxed);
+    m_totalMicros.store(avgTotal + (total - avgTotal) * 0.01f, std::memory_order_relaxed);
+
+    m_samples = nullptr;
+}
+
+// Windows the block into m_complexSamples; the stages after it fill data
+void SpectrumAnalyzer::RunFFT(AudioData& /*data*/) {
+    std::vector<float>& samples = *m_samples;
+
+    // DC Removal (High-pass filter)
+    float sum = 0.0f;
+    for (int i = 0; i < FFT_SIZE; i++) sum += samples[i];
+    float mean = sum / FFT_SIZE;
+
+    for (int i = 0; i < FFT_SIZE; i++) {
+        // Apply Hanning window
+        m_complexSamples[i] = (samples[i] - mean) * m_window[i];
+    }
+
+    m_fft.Forward(m_complexSamples.data());
+}
+
+void SpectrumAnalyzer::BuildWeights(SpectrumWeighting weighting) {
+    double binWidth = m_sampleRate / FFT_SIZE;
+    for (int i = 0; i < NUM_BINS; i++) {
+        double f = i * binWidth;
+        double gain = 1.0;
+        if (weighting == Weighting_A) {
+            // IEC 61672 A-weighting, normalized to 0 dB at 1 kHz
+            double f2 = f * f;
+            double ra = (12194.0 * 12194.0 * f2 * f2) /
+                        ((f2 + 20.6 * 20.6) * sqrt((f2 + 107.7 * 107.7) * (f2 + 737.9 * 737.9)) * (f2 + 12194.0 * 12194.0));
+            gain = ra * 1.2589;  // +2.0 dB
+        } else if (weighting == Weighting_Tilt) {
+            // DC has no octave; give it the lowest bin's gain
+            double octaves = log2((i > 0 ? f : binWidth) / 1000.0);
+            gain = pow(10.0, TILT_DB_PER_OCTAVE * octaves / 20.0);
+        }
+        m_weights[i] = (float)gain;
+    }
+    m_appliedWeighting = weighting;
+}
+
+void SpectrumAnalyzer::RunSpectrum(AudioData& data) {
+    // Auto-scale Logic
+    // Dynamic Scaling (AGC)
+    // Expansion: If maxVal > currentScale (Peak), snap to it immediately.
+    // Contraction: If maxVal < currentScale (Peak), decay by 50% per second.
+    //
+    // The block is normalized in the same pass that computes its magnitudes,
+    // so the scale is picked before this block's max is known: the loudness
+    // ceiling, or the decayed peak. Only when the block expands the peak are
+    // the normalized values redone, from the Spectrum just written.
+    //
+    // The noise floor is tracked in the same pass, on the weighted |X|; with
+    // the gate on it is subtracted before compression and normalization.
+
+    // m_data.Scale is the Multiplier (1.0 / Peak).
+    // We want to track the Peak.
+    float currentPeak = (data.Scale > 0.00001f) ? (1.0f / data.Scale) : 1.0f;
+    bool followLoudness = m_loudnessAgc && data.LoudnessShortTerm > -70.0f;
+
+    float peak;
+    if (followLoudness) {
+        // Follow perceived loudness. Short-term loudness is already a 3 s
+        // average, so bass hits don't make the ceiling jump.
+        peak = LOUDNESS_CEILING_AT_0_LUFS * powf(10.0f, data.LoudnessShortTerm / 40.0f);
+    } else {
+        // Contraction (Gradual)
+        // User wants it to "creep up" (Peak creep down) over 5 seconds.
+        // 50% decay per second.
+        peak = currentPeak - currentPeak * 0.50f * m_deltaTime;
+    }
+    // Safety clamp - Cap Scale at 1.5 (minimum peak of 0.667)
+    if (peak < 0.667f) peak = 0.667f;
+
+    bool gate = m_noiseGate.load(std::memory_order_relaxed);
+    bool trackNoise = gate || (m_requiredFeatures.load(std::memory_order_relaxed) & Feature_NoiseFloor);
+    if (trackNoise && !m_noiseTracking) m_noiseFloor.Reset();
+    m_noiseTracking = trackNoise;
+    // Floors are in |X| units; the ceiling is in sqrt(|X|) units
+    Float4 gateCap = F4Set1((GATE_MAX_FLOOR * currentPeak) * (GATE_MAX_FLOOR * currentPeak));
+    Float4 oversubtract = F4Set1(GATE_OVERSUBTRACT);
+
+    // One pass over the FFT output: |X|, weighting, sqrt compression,
+    // normalization and both history rows, four bins at a time
+    static_assert(NUM_BINS % 4 == 0, "fused spectrum pass handles four bins per step");
+    const float* fft = reinterpret_cast<const float*>(m_complexSamples.data());
+    float* history = data.History[data.historyIndex];
+    float* historyNormalized = data.HistoryNormalized[data.historyIndex];
+    Float4 scale = F4Set1(1.0f / peak);
+    Float4 one = F4Set1(1.0f);
+    Float4 maxVal = F4Zero();
+    for (int i = 0; i < NUM_BINS; i += 4) {
+        Float4 lo = F4Load(fft + 2 * i);
+        Float4 hi = F4Load(fft + 2 * i + 4);
+        Float4 magnitude = F4Mul(F4Sqrt(F4AddPairs(F4Mul(lo, lo), F4Mul(hi, hi))), F4Load(&m_weights[i]));
+        if (trackNoise) {
+            Float4 floor = m_noiseFloor.Update4(i, magnitude);
+            F4Store(data.NoiseFloor + i, F4Sqrt(floor));
+            if (gate) magnitude = F4Max(F4Sub(magnitude, F4Min(F4Mul(floor, oversubtract), gateCap)), F4Zero());
+        }
+        // Weighted magnitude, sqrt-compressed
+        Float4 value = F4Sqrt(magnitude);
+        Float4 normalized = F4Min(F4Mul(value, scale), one);
+
+        F4Store(data.Spectrum + i, value);
+        F4Store(history + i, value);
+        F4Store(data.SpectrumNormalized + i, normalized);
+        F4Store(historyNormalized + i, normalized);
+        maxVal = F4Max(maxVal, value);
+    }
+    if (trackNoise) m_noiseFloor.EndFrame();
+
+    float lanes[4];
+    F4Store(lanes, maxVal);
+    float blockMax = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+
+    if (!followLoudness && blockMax > currentPeak) {
+        // Expansion (Immediate)
+        peak = blockMax < 0.667f ? 0.667f : blockMax;
+        scale = F4Set1(1.0f / peak);
+        for (int i = 0; i < NUM_BINS; i += 4) {
+            Float4 normalized = F4Min(F4Mul(F4Load(data.Spectrum + i), scale), one);
+            F4Store(data.SpectrumNormalized + i, normalized);
+            F4Store(historyNormalized + i, normalized);
+        }
+    }
+
+    data.Scale = 1.0f / peak;
+}
+
+void SpectrumAnalyzer::RunPeakHold(AudioData& data) {
+    // Calculate Highest Sample over the last PEAK_HOLD_FRAMES normalized frames,
+    // a whole row at a time
+    memcpy(data.SpectrumHighestSample, data.HistoryNormalized[data.historyIndex], sizeof(data.SpectrumHighestSample));
+    for (int h = 1; h < PEAK_HOLD_FRAMES; h++) {
+        int idx = (data.historyIndex - h + HISTORY_SIZE) % HISTORY_SIZE;
+        MaxInPlace(data.SpectrumHighestSample, data.HistoryNormalized[idx], NUM_BINS);
+    }
+}
+
+void SpectrumAnalyzer::RunHPSS(AudioData& data) {
+    m_separator.Process(data.Spectrum, data.SpectrumNormalized, data.SpectrumHarmonic, data.SpectrumPercussive);
+}
+
+void SpectrumAnalyzer::RunTempo(AudioData& data) {
+    m_tempo.AddFrame(data.Spectrum);
+    data.TempoBPM = m_tempo.GetBPM();
+    data.TempoConfidence = m_tempo.GetConfidence();
+    data.BeatPhase = m_tempo.GetBeatPhase();
+}
+
+void SpectrumAnalyzer::RunLongHistory(AudioData& data) {
+    m_longHistory.Push(data.SpectrumNormalized);
+    data.LongHistory = &m_longHistory;
+}
+
+void SpectrumAnalyzer::RunCQT(AudioData& data) {
+    // Loads the cached kernel, or builds and caches it, the first time
+    if (m_cqt.GetSampleRate() != m_sampleRate) m_cqt.Configure(m_sampleRate, m_cacheDirectory);
+
+    m_cqt.Process(m_samples->data(), FFT_SIZE, m_cqtMagnitudes);
+
+    // Same AGC rules as the main spectrum, on the CQ magnitudes
+    float maxVal = 0.0f;
+    for (int i = 0; i < ConstantQ::NUM_BINS; i++) {
+        if (m_cqtMagnitudes[i] > maxVal) maxVal = m_cqtMagnitudes[i];
+    }
+    if (maxVal > m_cqtPeak) m_cqtPeak = maxVal;
+    else m_cqtPeak -= m_cqtPeak * 0.50f * m_deltaTime;
+    if (m_cqtPeak < 0.001f) m_cqtPeak = 0.001f;
+
+    ScaleArray(m_cqtMagnitudes, 1.0f / m_cqtPeak, data.SpectrumCQT, ConstantQ::NUM_BINS);
+}
+
+void SpectrumAnalyzer::RunDescriptors(AudioData& data) {
+    m_descriptors.Process(data.Spectrum, m_cqtMagnitudes, data);
+}
+
+void SpectrumAnalyzer::RunEnvelope(AudioData& data) {
+    float attack = m_smoothAttack.load(std::memory_order_relaxed);
+    float release = m_smoothRelease.load(std::memory_order_relaxed);
+    float peakRelease = m_peakRelease.load(std::memory_order_relaxed);
+    if (attack <= 0.0f) attack = DEFAULT_SMOOTH_ATTACK;
+    if (release <= 0.0f) release = DEFAULT_SMOOTH_RELEASE;
+    if (peakRelease <= 0.0f) peakRelease = DEFAULT_PEAK_RELEASE;
+    if (attack != m_appliedTimes[0] || release != m_appliedTimes[1]) {
+        m_smoothed.SetTimes(attack, release);
+        m_appliedTimes[0] = attack;
+        m_appliedTimes[1] = release;
+    }
+    if (peakRelease != m_appliedTimes[2]) {
+        m_peaks.SetTimes(0.0f, peakRelease);
+        m_appliedTimes[2] = peakRelease;
+    }
+
+    // m_deltaTime is the block interval, or the real gap when capture
+    // skipped, so the envelopes run in real time
+    m_smoothed.Process(data.SpectrumNormalized, m_deltaTime, data.SpectrumSmoothed);
+    m_peaks.Process(data.SpectrumNormalized, m_deltaTime, data.SpectrumPeak);
+}
@@ -0,0 +1,172 @@
+#pragma once
+#include <vector>
+#include <complex>
+#include <atomic>
+#include <cstdint>
+#include "AudioData.h"
+#include "Fft.h"
+#include "HarmonicPercussive.h"
+#include "TempoTracker.h"
+#include "SpectrumHistory.h"
+#include "ConstantQ.h"
+#include "SpectralDescriptors.h"
+#include "NoiseFloorTracker.h"
+#include "EnvelopeFollower.h"
+#include <filesystem>
+
+// Optional per-bin weighting applied to the magnitude spectrum
+enum SpectrumWeighting {
+    Weighting_Flat,
+    Weighting_A,      // IEC 61672 A-weighting: roughly how loud each band sounds
+    Weighting_Tilt,   // +3 dB/octave around 1 kHz, tames bass-heavy rooms
+    Weighting_Count
+};
+
+// Demand-driven spectrum analysis.
+// The analyzer is a small graph of stages. Each stage produces one AudioData
+// feature and depends on other stages; Process() only runs the stages needed
+// for the features the active visualization asked for.
+class SpectrumAnalyzer {
+public:
+    static const int FFT_SIZE = 512;
+    static const int NUM_BINS = 256;
+    static const int HISTORY_SIZE = 60;
+    static const int PEAK_HOLD_FRAMES = 6;
+    static constexpr float DEFAULT_SMOOTH_ATTACK = 0.015f;   // Seconds, SpectrumSmoothed
+    static constexpr float DEFAULT_SMOOTH_RELEASE = 0.12f;
+    static constexpr float DEFAULT_PEAK_RELEASE = 1.0f;      // SpectrumPeak (attack is instant)
+
+    enum Stage {
+        Stage_FFT,
+        Stage_Spectrum,    // Spectrum, SpectrumNormalized and both history rows in one pass
+        Stage_PeakHold,
+        Stage_HPSS,
+        Stage_Tempo,
+        Stage_LongHistory,
+        Stage_CQT,
+        Stage_Descriptors,
+        Stage_Envelope,
+        Stage_Count
+    };
+
+    struct StageTiming {
+        const char* name = "";
+        bool active = false;     // Ran on the last processed block
+        float avgMicros = 0.0f;  // Smoothed cost per block; 0 while skipped
+    };
+
+    SpectrumAnalyzer();
+
+    // Safe to call from any thread; takes effect on the next block.
+    void SetRequiredFeatures(uint32_t features) { m_requiredFeatures = features; }
+    uint32_t GetRequiredFeatures() const { return m_requiredFeatures; }
+
+    // Call before the first block (from the thread calling Process)
+    void SetSampleRate(double sampleRate);
+    // Where precomputed kernels (CQT) are cached between runs; empty = no cache
+    void SetCacheDirectory(const std::filesystem::path& directory) { m_cacheDirectory = directory; }
+
+    // When set, the AGC ceiling follows the short-term loudness in AudioData
+    // (filled by a LoudnessMeter) instead of the peak FFT magnitude.
+    // Safe to call from any thread.
+    void SetLoudnessAgc(bool enabled) { m_loudnessAgc = enabled; }
+    bool GetLoudnessAgc() const { return m_loudnessAgc; }
+
+    // Subtract the tracked noise floor from every bin before normalization,
+    // so hiss and hum don't fill the display in quiet passages.
+    // Safe to call from any thread.
+    void SetNoiseGate(bool enabled) { m_noiseGate = enabled; }
+    bool GetNoiseGate() const { return m_noiseGate; }
+
+    // Safe to call from any thread; takes effect on the next block.
+    void SetWeighting(SpectrumWeighting weighting) { m_weighting = weighting; }
+    SpectrumWeighting GetWeighting() const { return (SpectrumWeighting)m_weighting.load(); }
+
+    // Attack/release times (seconds) for every band of SpectrumSmoothed, and
+    // the release of SpectrumPeak; 0 or less restores the default.
+    // Safe to call from any thread; takes effect on the next block.
+    void SetSmoothingTimes(float attackSeconds, float releaseSeconds) {
+        m_smoothAttack = attackSeconds;
+        m_smoothRelease = releaseSeconds;
+    }
+    void SetPeakRelease(float releaseSeconds) { m_peakRelease = releaseSeconds; }
+
+    // Run the required stages on one FFT_SIZE block of mono samples.
+    // deltaTime is the time since the previous block (drives the AGC decay).
+    void Process(std::vector<float>& samples, float deltaTime, AudioData& data);
+
+    StageTiming GetStageTiming(int stage) const;
+    // Owned by the audio thread; only touch it from the thread calling Process()
+    HarmonicPercussiveSeparator& GetSeparator() { return m_separator; }
+    TempoTracker& GetTempoTracker() { return m_tempo; }
+    // Per-band times can be set here; SetSmoothingTimes/SetPeakRelease
+    // overwrite every band when they change
+    EnvelopeFollowerBank& GetSmoothedEnvelopes() { return m_smoothed; }
+    EnvelopeFollowerBank& GetPeakEnvelopes() { return m_peaks; }
+
+    // Readable from any thread
+    const SpectrumHistory& GetLongHistory() const { return m_longHistory; }
+    float GetTotalMicros() const { return m_totalMicros.load(std::memory_order_relaxed); }
+
+private:
+    typedef void (SpectrumAnalyzer::*StageFn)(AudioData& data);
+
+    struct StageNode {
+        const char* name;
+        uint32_t produces;   // AnalysisFeature bits
+        uint32_t dependsOn;  // Stage bits
+        StageFn run;
+    };
+
+    uint32_t ResolveStages(uint32_t features) const;
+    void BuildWeights(SpectrumWeighting weighting);
+
+    void RunFFT(AudioData& data);
+    void RunSpectrum(AudioData& data);
+    void RunPeakHold(AudioData& data);
+    void RunHPSS(AudioData& data);
+    void RunTempo(AudioData& data);
+    void RunLongHistory(AudioData& data);
+    void RunCQT(AudioData& data);
+    void RunDescriptors(AudioData& data);
+    void RunEnvelope(AudioData& data);
+
+    static const StageNode s_stages[Stage_Count];
+
+    std::atomic<uint32_t> m_requiredFeatures;
+    std::atomic<bool> m_loudnessAgc;
+    std::atomic<bool> m_noiseGate;
+    std::atomic<int> m_weighting;
+    int m_appliedWeighting = -1;       // Weighting m_weights was built for; -1 = rebuild
+    std::atomic<float> m_smoothAttack;
+    std::atomic<float> m_smoothRelease;
+    std::atomic<float> m_peakRelease;
+    float m_appliedTimes[3] = { -1.0f, -1.0f, -1.0f };  // Attack, release, peak release in the banks
+    uint32_t m_lastStages = 0;
+
+    // Per-block scratch shared between stages
+    std::vector<float>* m_samples = nullptr;
+    float m_deltaTime = 0.0f;
+    std::vector<float> m_window;
+    std::vector<float> m_weights;      // Per-bin amplitude weighting, NUM_BINS
+    std::vector<std::complex<float>> m_complexSamples;
+    FftPlan m_fft;
+    NoiseFloorTracker m_noiseFloor;
+    bool m_noiseTracking = false;
+    HarmonicPercussiveSeparator m_separator;
+    TempoTracker m_tempo;
+    SpectrumHistory m_longHistory;
+    ConstantQ m_cqt;                   // Kernel built on first use
+    float m_cqtMagnitudes[ConstantQ::NUM_BINS];
+    float m_cqtPeak = 0.0f;
+    SpectralDescriptors m_descriptors;
+    EnvelopeFollowerBank m_smoothed;
+    EnvelopeFollowerBank m_peaks;
+    double m_sampleRate = 48000.0;
+    std::filesystem::path m_cacheDirectory;
+
+    // Timing (written by the audio thread, read by the OSD)
+    std::atomic<bool> m_stageActive[Stage_Count];
+    std::atomic<float> m_stageMicros[Stage_Count];
+    std::atomic<float> m_totalMicros;
+};
@@ -0,0 +1,124 @@
+#include "SpectrumHistory.h"
+#include "VectorOps.h"
+#include <cstring>
+#include <thread>
+
+SpectrumHistory::SpectrumHistory() : m_sequence(0) {
+    for (int t = 0; t < TIER_COUNT; t++) {
+        Tier& tier = m_tiers[t];
+        tier.max.assign(TIER_LENGTH * NUM_BINS, 0.0f);
+        tier.mean.assign(TIER_LENGTH * NUM_BINS, 0.0f);
+        tier.accMax.assign(NUM_BINS, 0.0f);
+        tier.accSum.assign(NUM_BINS, 0.0f);
+    }
+}
+
+float SpectrumHistory::GetColumnSeconds(int tier) const {
+    float seconds = 1.0f / m_frameRate;
+    for (int t = 0; t < tier; t++) seconds *= TIER_FACTOR;
+    return seconds;
+}
+
+void SpectrumHistory::Reset() {
+    m_sequence.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int t = 0; t < TIER_COUNT; t++) {
+        Tier& tier = m_tiers[t];
+        tier.head = 0;
+        tier.count = 0;
+        tier.accCount = 0;
+    }
+    m_sequence.fetch_add(1, std::memory_order_release);
+}
+
+void SpectrumHistory::WriteColumn(int t, const float* max, const float* mean) {
+    Tier& tier = m_tiers[t];
+    memcpy(&tier.max[tier.head * NUM_BINS], max, NUM_BINS * sizeof(float));
+    memcpy(&tier.mean[tier.head * NUM_BINS], mean, NUM_BINS * sizeof(float));
+    tier.head = (tier.head + 1) % TIER_LENGTH;
+    if (tier.count < TIER_LENGTH) tier.count++;
+}
+
+void SpectrumHistory::Push(const float* spectrum) {
+    m_sequence.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // A frame is its own max and mean at tier 0
+    WriteColumn(0, spectrum, spectrum);
+
+    // Fold the column just written into the next tier up; when that fills,
+    // it writes a column and the carry continues upward
+    const float* max = spectrum;
+    const float* mean = spectrum;
+    for (int t = 1; t < TIER_COUNT; t++) {
+        Tier& tier = m_tiers[t];
+        if (tier.accCount == 0) {
+            memcpy(tier.accMax.data(), max, NUM_BINS * sizeof(float));
+            memcpy(tier.accSum.data(), mean, NUM_BINS * sizeof(float));
+        } else {
+            MaxInPlace(tier.accMax.data(), max, NUM_BINS);
+            AddInPlace(tier.accSum.data(), mean, NUM_BINS);
+        }
+        if (++tier.accCount < TIER_FACTOR) break;
+
+        // Full: emit the aggregate as a column
+        ScaleArray(tier.accSum.data(), 1.0f / TIER_FACTOR, tier.accSum.data(), NUM_BINS);
+        WriteColumn(t, tier.accMax.data(), tier.accSum.data());
+        tier.accCount = 0;
+
+        int written = (tier.head + TIER_LENGTH - 1) % TIER_LENGTH;
+        max = &tier.max[written * NUM_BINS];
+        mean = &tier.mean[written * NUM_BINS];
+    }
+
+    m_sequence.fetch_add(1, std::memory_order_release);
+}
+
+int SpectrumHistory::CopyColumns(int t, int columns, float* maxOut, float* meanOut) const {
+    const Tier& tier = m_tiers[t];
+    int written = 0;
+
+    // Partial aggregate first, so coarse views aren't up to a column stale
+    if (t > 0 && tier.accCount > 0 && written < columns) {
+        if (maxOut) memcpy(maxOut, tier.accMax.data(), NUM_BINS * sizeof(float));
+        if (meanOut) ScaleArray(tier.accSum.data(), 1.0f / tier.accCount, meanOut, NUM_BINS);
+        written++;
+    }
+
+    for (int i = 0; i < tier.count && written < columns; i++, written++) {
+        int col = (tier.head - 1 - i + TIER_LENGTH) % TIER_LENGTH;
+        if (maxOut) memcpy(maxOut + written * NUM_BINS, &tier.max[col * NUM_BINS], NUM_BINS * sizeof(float));
+        if (meanOut) memcpy(meanOut + written * NUM_BINS, &tier.mean[col * NUM_BINS], NUM_BINS * sizeof(float));
+    }
+    return written;
+}
+
+int SpectrumHistory::Read(float seconds, int maxColumns, float* maxOut, float* meanOut, int* tierOut) const {
+    if (maxColumns <= 0) return 0;
+
+    // Finest tier that spans 'seconds' in no more than maxColumns columns
+    int t = 0;
+    int columns = 0;
+    for (; t < TIER_COUNT; t++) {
+        columns = (int)(seconds / GetColumnSeconds(t) + 0.999f);
+        if (columns < 1) columns = 1;
+        if (columns <= maxColumns && columns <= TIER_LENGTH) break;
+    }
+    if (t == TIER_COUNT) {
+        t = TIER_COUNT - 1;
+        if (columns > TIER_LENGTH) columns = TIER_LENGTH;
+        if (columns > maxColumns) columns = maxColumns;
+    }
+    if (tierOut) *tierOut = t;
+
+    for (;;) {
+        uint32_t before = m_sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        int written = CopyColumns(t, columns, maxOut, meanOut);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_sequence.load(std::memory_order_relaxed) == before) return written;
+    }
+}
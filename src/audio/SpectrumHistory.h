@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Long spectral history as a time mipmap.
+// Tier 0 holds every analysis frame; each further tier holds one column per
+// TIER_FACTOR columns of the tier below, keeping both the per-bin max and
+// mean. Every tier is a ring of TIER_LENGTH columns, so at 48 kHz / 512 the
+// three tiers cover ~5.5 s, ~55 s and ~9 min.
+//
+// Push() is O(bins) per frame: it folds the frame into each tier's running
+// accumulator and only writes a column when an accumulator fills. Single
+// writer; readers on other threads use Read(), which retries around
+// concurrent writes.
+class SpectrumHistory {
+public:
+    static const int NUM_BINS = 256;
+    static const int TIER_COUNT = 3;
+    static const int TIER_LENGTH = 512;
+    static const int TIER_FACTOR = 10;
+
+    SpectrumHistory();
+
+    void SetFrameRate(float framesPerSecond) { m_frameRate = framesPerSecond; }
+    float GetFrameRate() const { return m_frameRate; }
+    float GetColumnSeconds(int tier) const;
+
+    void Reset();
+    void Push(const float* spectrum);
+
+    // Copy the last 'seconds' as newest-first columns of NUM_BINS floats.
+    // Uses the finest tier whose columns cover the span within maxColumns
+    // (falling back to the coarsest). The newest column of a coarse tier may
+    // be a partial aggregate. Either output may be nullptr.
+    // Returns the number of columns written; tierOut reports the tier used.
+    int Read(float seconds, int maxColumns, float* maxOut, float* meanOut, int* tierOut = nullptr) const;
+
+private:
+    struct Tier {
+        std::vector<float> max;    // TIER_LENGTH x NUM_BINS
+        std::vector<float> mean;
+        int head = 0;              // Next column to write
+        int count = 0;             // Valid columns
+
+        // Columns of the tier below folded in so far
+        std::vector<float> accMax;
+        std::vector<float> accSum;
+        int accCount = 0;
+    };
+
+    void WriteColumn(int tier, const float* max, const float* mean);
+    int CopyColumns(int tier, int columns, float* maxOut, float* meanOut) const;
+
+    Tier m_tiers[TIER_COUNT];
+    float m_frameRate = 48000.0f / 512.0f;
+    std::atomic<uint32_t> m_sequence;  // Odd while Push() is writing
+};
@@ -0,0 +1,125 @@
+#include "SpectrumPublisher.h"
+#include "VectorOps.h"
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+SpectrumPublisher::SpectrumPublisher() : m_sequence(0), m_frameCount(0) {
+}
+
+void SpectrumPublisher::Publish(const AudioData& data, double timestamp) {
+    // Overwrite the older of the two frames
+    int slot = m_newest ^ 1;
+
+    uint32_t seq = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    SpectrumFrame& frame = m_frames[slot];
+    frame.timestamp = timestamp;
+    frame.Scale = data.Scale;
+    memcpy(frame.Spectrum, data.Spectrum, sizeof(frame.Spectrum));
+    memcpy(frame.SpectrumNormalized, data.SpectrumNormalized, sizeof(frame.SpectrumNormalized));
+    memcpy(frame.SpectrumHighestSample, data.SpectrumHighestSample, sizeof(frame.SpectrumHighestSample));
+    memcpy(frame.SpectrumHarmonic, data.SpectrumHarmonic, sizeof(frame.SpectrumHarmonic));
+    memcpy(frame.SpectrumPercussive, data.SpectrumPercussive, sizeof(frame.SpectrumPercussive));
+    frame.TempoBPM = data.TempoBPM;
+    frame.TempoConfidence = data.TempoConfidence;
+    frame.BeatPhase = data.BeatPhase;
+    frame.LoudnessMomentary = data.LoudnessMomentary;
+    frame.LoudnessShortTerm = data.LoudnessShortTerm;
+    frame.TruePeak = data.TruePeak;
+    memcpy(frame.SpectrumCQT, data.SpectrumCQT, sizeof(frame.SpectrumCQT));
+    memcpy(frame.Chroma, data.Chroma, sizeof(frame.Chroma));
+    frame.SpectralCentroid = data.SpectralCentroid;
+    frame.SpectralRolloff = data.SpectralRolloff;
+    frame.SpectralFlatness = data.SpectralFlatness;
+    frame.SpectralFlux = data.SpectralFlux;
+    memcpy(frame.NoiseFloor, data.NoiseFloor, sizeof(frame.NoiseFloor));
+    memcpy(frame.SpectrumSmoothed, data.SpectrumSmoothed, sizeof(frame.SpectrumSmoothed));
+    memcpy(frame.SpectrumPeak, data.SpectrumPeak, sizeof(frame.SpectrumPeak));
+    m_newest = slot;
+
+    m_sequence.store(seq + 2, std::memory_order_release);
+    m_frameCount.fetch_add(1, std::memory_order_release);
+}
+
+int SpectrumPublisher::ReadLatest(SpectrumFrame& previous, SpectrumFrame& current) const {
+    uint64_t count = 0;
+    for (;;) {
+        uint32_t before = m_sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            // Producer mid-write; it only takes a few microseconds
+            std::this_thread::yield();
+            continue;
+        }
+
+        count = m_frameCount.load(std::memory_order_acquire);
+        int newest = m_newest;
+        current = m_frames[newest];
+        previous = m_frames[newest ^ 1];
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_sequence.load(std::memory_order_relaxed) == before) break;
+    }
+    return count >= 2 ? 2 : (int)count;
+}
+
+bool SpectrumPublisher::Interpolate(double time, double delay, AudioData& out) const {
+    SpectrumFrame previous, current;
+    int frames = ReadLatest(previous, current);
+    if (frames == 0) return false;
+
+    float t = 1.0f;
+    double interval = current.timestamp - previous.timestamp;
+    if (frames == 2 && interval > 0.0) {
+        t = (float)((time - delay - previous.timestamp) / interval);
+        // Never go back past the older frame, and cap extrapolation at half a
+        // frame so a stalled capture doesn't run the bars off the chart
+        if (t < 0.0f) t = 0.0f;
+        if (t > 1.5f) t = 1.5f;
+    } else {
+        previous = current;
+    }
+
+    LerpClampArray(previous.Spectrum, current.Spectrum, t, 0.0f, FLT_MAX, out.Spectrum, 256);
+    LerpClampArray(previous.SpectrumNormalized, current.SpectrumNormalized, t, 0.0f, 1.0f, out.SpectrumNormalized, 256);
+    LerpClampArray(previous.SpectrumHighestSample, current.SpectrumHighestSample, t, 0.0f, 1.0f, out.SpectrumHighestSample, 256);
+    LerpClampArray(previous.SpectrumHarmonic, current.SpectrumHarmonic, t, 0.0f, 1.0f, out.SpectrumHarmonic, 256);
+    LerpClampArray(previous.SpectrumPercussive, current.SpectrumPercussive, t, 0.0f, 1.0f, out.SpectrumPercussive, 256);
+    LerpClampArray(previous.SpectrumCQT, current.SpectrumCQT, t, 0.0f, 1.0f, out.SpectrumCQT, 84);
+    LerpClampArray(previous.Chroma, current.Chroma, t, 0.0f, 1.0f, out.Chroma, 12);
+    LerpClampArray(previous.SpectrumSmoothed, current.SpectrumSmoothed, t, 0.0f, 1.0f, out.SpectrumSmoothed, 256);
+    LerpClampArray(previous.SpectrumPeak, current.SpectrumPeak, t, 0.0f, 1.0f, out.SpectrumPeak, 256);
+    out.Scale = previous.Scale + (current.Scale - previous.Scale) * t;
+    if (out.Scale < 0.0001f) out.Scale = 0.0001f;
+
+    // Tempo is held; the beat phase runs on from the newest frame at the
+    // current tempo so it keeps advancing smoothly between blocks
+    out.TempoBPM = current.TempoBPM;
+    out.TempoConfidence = current.TempoConfidence;
+    out.BeatPhase = current.BeatPhase;
+    if (current.TempoBPM > 0.0f) {
+        float phase = current.BeatPhase + (float)((time - delay - current.timestamp) * current.TempoBPM / 60.0);
+        phase -= floorf(phase);
+        out.BeatPhase = phase;
+    }
+
+    // Loudness is already averaged over 400 ms+; interpolating adds nothing
+    out.LoudnessMomentary = current.LoudnessMomentary;
+    out.LoudnessShortTerm = current.LoudnessShortTerm;
+    out.TruePeak = current.TruePeak;
+
+    // Spectral shape is held too: flux is a per-block event, and lerping
+    // the others between two blocks would invent shapes neither had
+    out.SpectralCentroid = current.SpectralCentroid;
+    out.SpectralRolloff = current.SpectralRolloff;
+    out.SpectralFlatness = current.SpectralFlatness;
+    out.SpectralFlux = current.SpectralFlux;
+
+    // The floor moves over seconds
+    memcpy(out.NoiseFloor, current.NoiseFloor, sizeof(out.NoiseFloor));
+
+    return true;
+}
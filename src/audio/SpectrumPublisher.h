@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "AudioData.h"
+
+// Hands analysis frames from the audio thread to the render thread.
+// The two newest frames are kept with their timestamps so the renderer can
+// interpolate the spectrum to its own present time instead of redrawing the
+// same frame until the next FFT block lands.
+class SpectrumPublisher {
+public:
+    SpectrumPublisher();
+
+    // Producer (audio thread): copy the per-frame arrays out of data.
+    void Publish(const AudioData& data, double timestamp);
+
+    // Consumer: copy the two newest frames. Returns how many are valid (0-2).
+    int ReadLatest(SpectrumFrame& previous, SpectrumFrame& current) const;
+
+    // Consumer: write Spectrum, SpectrumNormalized, SpectrumHighestSample, the
+    // harmonic/percussive split, CQT, envelopes, tempo, loudness and Scale in
+    // out for the given time. The result lags by 'delay' seconds so
+    // it normally lies between the two newest frames; when frames arrive late
+    // it extrapolates by at most half a frame interval and then holds.
+    // Returns false if nothing has been published yet.
+    bool Interpolate(double time, double delay, AudioData& out) const;
+
+    uint64_t GetFrameCount() const { return m_frameCount.load(std::memory_order_acquire); }
+
+private:
+    // Seqlock: odd while the producer is writing
+    std::atomic<uint32_t> m_sequence;
+    std::atomic<uint64_t> m_frameCount;
+    SpectrumFrame m_frames[2];
+    int m_newest = 1;
+};
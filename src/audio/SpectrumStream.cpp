@@ -0,0 +1,393 @@
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include "SpectrumStream.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+using namespace SpectrumStream;
+
+static void PutU32(std::vector<uint8_t>& b, size_t at, uint32_t v) {
+    for (int i = 0; i < 4; i++) b[at + i] = (uint8_t)(v >> (8 * i));
+}
+static void PutU64(std::vector<uint8_t>& b, size_t at, uint64_t v) {
+    for (int i = 0; i < 8; i++) b[at + i] = (uint8_t)(v >> (8 * i));
+}
+static uint32_t GetU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+static uint64_t GetU64(const uint8_t* p) {
+    return (uint64_t)GetU32(p) | ((uint64_t)GetU32(p + 4) << 32);
+}
+
+// Changes wrap modulo 256, so every one fits a signed byte; zigzag makes
+// small changes of either sign small unsigned codes
+static uint8_t Zigzag(uint8_t value, uint8_t previous) {
+    int delta = (int8_t)(uint8_t)(value - previous);
+    return (uint8_t)(((unsigned)delta << 1) ^ (unsigned)(delta >> 31));
+}
+static int Unzigzag(uint8_t code) { return (int)(code >> 1) ^ -(int)(code & 1); }
+
+// ---- Encoder ----
+
+SpectrumStreamEncoder::SpectrumStreamEncoder(int bandCount)
+    : m_bandCount(std::max(1, std::min(bandCount, MAX_BANDS))), m_previous(m_bandCount, 0) {
+    m_buffer.reserve(MAX_DATAGRAM);
+    Begin();
+}
+
+void SpectrumStreamEncoder::Begin() {
+    m_buffer.assign(HEADER_SIZE, 0);
+    m_frames = 0;
+}
+
+bool SpectrumStreamEncoder::Add(const uint8_t* bands, uint64_t timestampMicros) {
+    // Worst case is a key or a full-byte delta: one byte per band
+    if (m_buffer.size() + FRAME_HEADER_SIZE + m_bandCount > MAX_DATAGRAM || m_frames == 255) return false;
+
+    if (m_frames == 0) {
+        PutU32(m_buffer, 0, MAGIC);
+        m_buffer[4] = VERSION;
+        m_buffer[5] = (uint8_t)m_bandCount;
+        PutU32(m_buffer, 8, m_sequence);
+        PutU64(m_buffer, 12, timestampMicros);
+        m_baseTimestamp = timestampMicros;
+    }
+
+    bool key = (m_sequence % KEYFRAME_INTERVAL) == 0;
+    uint8_t flags = key ? FRAME_KEY : 0;
+    if (!key) {
+        bool nibbles = true;
+        for (int i = 0; i < m_bandCount && nibbles; i++) {
+            nibbles = Zigzag(bands[i], m_previous[i]) < 16;
+        }
+        if (nibbles) flags |= FRAME_NIBBLES;
+    }
+
+    size_t at = m_buffer.size();
+    m_buffer.push_back(flags);
+    m_buffer.resize(at + FRAME_HEADER_SIZE);
+    uint64_t offset = timestampMicros > m_baseTimestamp ? timestampMicros - m_baseTimestamp : 0;
+    PutU32(m_buffer, at + 1, (uint32_t)std::min<uint64_t>(offset, 0xFFFFFFFFu));
+
+    if (key) {
+        m_buffer.insert(m_buffer.end(), bands, bands + m_bandCount);
+    } else if (flags & FRAME_NIBBLES) {
+        for (int i = 0; i < m_bandCount; i += 2) {
+            uint8_t lo = Zigzag(bands[i], m_previous[i]);
+            uint8_t hi = (i + 1 < m_bandCount) ? Zigzag(bands[i + 1], m_previous[i + 1]) : 0;
+            m_buffer.push_back((uint8_t)(lo | (hi << 4)));
+        }
+    } else {
+        for (int i = 0; i < m_bandCount; i++) m_buffer.push_back(Zigzag(bands[i], m_previous[i]));
+    }
+
+    std::copy(bands, bands + m_bandCount, m_previous.begin());
+    m_sequence++;
+    m_frames++;
+    m_buffer[6] = (uint8_t)m_frames;
+    return true;
+}
+
+const std::vector<uint8_t>& SpectrumStreamEncoder::Finish() {
+    return m_buffer;
+}
+
+// ---- Decoder ----
+
+bool SpectrumStreamDecoder::Decode(const uint8_t* data, size_t size, std::vector<StreamFrame>& out) {
+    if (size < (size_t)HEADER_SIZE || GetU32(data) != MAGIC || data[4] != VERSION || data[5] == 0) {
+        m_malformed++;
+        return false;
+    }
+    int bandCount = data[5];
+    int frameCount = data[6];
+    uint32_t sequence = GetU32(data + 8);
+    uint64_t base = GetU64(data + 12);
+    if ((int)m_values.size() != bandCount) {
+        m_values.assign(bandCount, 0);
+        m_synced = false;
+    }
+
+    // Whole datagrams arrive or don't; a gap before this one means lost
+    // frames, and the delta chain is broken until the next key
+    if (m_started) {
+        int32_t gap = (int32_t)(sequence - m_nextSequence);
+        if (gap < 0) {
+            m_late += frameCount;
+            return true;
+        }
+        if (gap > 0) {
+            m_lost += gap;
+            m_synced = false;
+        }
+    }
+    m_started = true;
+
+    const uint8_t* p = data + HEADER_SIZE;
+    const uint8_t* end = data + size;
+    for (int f = 0; f < frameCount; f++, sequence++) {
+        if (end - p < FRAME_HEADER_SIZE) {
+            m_malformed++;
+            m_synced = false;
+            return false;
+        }
+        uint8_t flags = p[0];
+        uint64_t timestamp = base + GetU32(p + 1);
+        p += FRAME_HEADER_SIZE;
+
+        size_t payload = (flags & FRAME_NIBBLES) ? (size_t)(bandCount + 1) / 2 : (size_t)bandCount;
+        if ((size_t)(end - p) < payload) {
+            m_malformed++;
+            m_synced = false;
+            return false;
+        }
+
+        if (flags & FRAME_KEY) {
+            std::copy(p, p + bandCount, m_values.begin());
+            m_synced = true;
+        } else if (m_synced) {
+            for (int i = 0; i < bandCount; i++) {
+                uint8_t code = (flags & FRAME_NIBBLES) ? (uint8_t)((p[i / 2] >> ((i & 1) * 4)) & 0x0F) : p[i];
+                m_values[i] = (uint8_t)(m_values[i] + Unzigzag(code));
+            }
+        }
+        p += payload;
+        m_nextSequence = sequence + 1;
+
+        if (!m_synced) {
+            m_skipped++;
+            continue;
+        }
+        StreamFrame frame;
+        frame.sequence = sequence;
+        frame.timestampMicros = timestamp;
+        frame.bands = m_values;
+        out.push_back(std::move(frame));
+        m_decoded++;
+    }
+    return true;
+}
+
+// ---- Socket ----
+
+#ifdef _WIN32
+typedef int SockLen;
+static SOCKET Native(intptr_t s) { return (SOCKET)s; }
+static bool InitSockets() {
+    static bool initialized = [] {
+        WSADATA wsa;
+        return WSAStartup(MAKEWORD(2, 2), &wsa) == 0;
+    }();
+    return initialized;
+}
+static void CloseSocketHandle(intptr_t s) { closesocket(Native(s)); }
+#else
+typedef socklen_t SockLen;
+static int Native(intptr_t s) { return (int)s; }
+static bool InitSockets() { return true; }
+static void CloseSocketHandle(intptr_t s) { close((int)s); }
+#endif
+
+bool UdpSocket::Create() {
+    Close();
+    if (!InitSockets()) return false;
+#ifdef _WIN32
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET) return false;
+    m_socket = (intptr_t)s;
+#else
+    int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s < 0) return false;
+    m_socket = s;
+#endif
+    return true;
+}
+
+bool UdpSocket::Connect(const std::string& host, int port) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    if (!InitSockets() || getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0 || !result) {
+        std::cerr << "Can't resolve " << host << std::endl;
+        return false;
+    }
+    bool ok = Create() && connect(Native(m_socket), result->ai_addr, (SockLen)result->ai_addrlen) == 0;
+    freeaddrinfo(result);
+    if (!ok) {
+        std::cerr << "Can't open UDP to " << host << ":" << port << std::endl;
+        Close();
+    }
+    return ok;
+}
+
+bool UdpSocket::Bind(int port) {
+    if (!Create()) return false;
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    if (bind(Native(m_socket), (sockaddr*)&addr, sizeof(addr)) != 0) {
+        std::cerr << "Can't bind UDP port " << port << std::endl;
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool UdpSocket::Send(const void* data, size_t size) {
+    if (!IsOpen()) return false;
+    return send(Native(m_socket), (const char*)data, (int)size, 0) == (int)size;
+}
+
+int UdpSocket::Receive(void* buffer, size_t size, int timeoutMs) {
+    if (!IsOpen()) return -1;
+#ifdef _WIN32
+    WSAPOLLFD fd = { (SOCKET)m_socket, POLLRDNORM, 0 };
+    int ready = WSAPoll(&fd, 1, timeoutMs);
+#else
+    pollfd fd = { (int)m_socket, POLLIN, 0 };
+    int ready = poll(&fd, 1, timeoutMs);
+#endif
+    if (ready < 0) return -1;
+    if (ready == 0) return 0;
+    int received = (int)recv(Native(m_socket), (char*)buffer, (int)size, 0);
+    return received < 0 ? -1 : received;
+}
+
+int UdpSocket::GetLocalPort() const {
+    sockaddr_in addr = {};
+    SockLen length = sizeof(addr);
+    if (!IsOpen() || getsockname(Native(m_socket), (sockaddr*)&addr, &length) != 0) return 0;
+    return ntohs(addr.sin_port);
+}
+
+void UdpSocket::Close() {
+    if (m_socket == INVALID) return;
+    CloseSocketHandle(m_socket);
+    m_socket = INVALID;
+}
+
+// ---- Streamer ----
+
+// Upper bound on how long a frame can wait if its wakeup raced the sender
+// going to sleep
+static const int SENDER_WAKE_TIMEOUT_MS = 5;
+
+bool SpectrumStreamer::Start(const std::string& address, int bandCount) {
+    Stop();
+    std::string host = address;
+    int port = DEFAULT_PORT;
+    size_t colon = address.rfind(':');
+    if (colon != std::string::npos) {
+        host = address.substr(0, colon);
+        port = atoi(address.c_str() + colon + 1);
+    }
+    if (host.empty() || port <= 0 || port > 65535) {
+        std::cerr << "Bad UDP output address " << address << " (expected host:port)" << std::endl;
+        return false;
+    }
+    if (!m_socket.Connect(host, port)) return false;
+
+    m_bandCount = std::max(1, std::min(bandCount, MAX_BANDS));
+    m_numBins = 0;
+    m_running = true;
+    m_thread = std::thread(&SpectrumStreamer::SenderThread, this);
+    return true;
+}
+
+void SpectrumStreamer::Stop() {
+    if (!m_running.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+    }
+    m_wake.notify_one();
+    m_thread.join();
+    m_socket.Close();
+}
+
+void SpectrumStreamer::Push(const float* spectrum, int numBins, double timestamp) {
+    if (!m_running.load(std::memory_order_relaxed) || numBins < 2) return;
+
+    // Log-spaced band edges from bin 1 up, at least one bin per band
+    if (numBins != m_numBins) {
+        m_numBins = numBins;
+        m_bandEdges.resize(m_bandCount + 1);
+        for (int b = 0; b <= m_bandCount; b++) {
+            int edge = (int)lround(pow((double)numBins, (double)b / m_bandCount));
+            int minimum = b == 0 ? 1 : m_bandEdges[b - 1] + 1;
+            m_bandEdges[b] = std::min(numBins, std::max(edge, minimum));
+        }
+    }
+
+    QueuedFrame frame;
+    frame.timestamp = timestamp;
+    for (int b = 0; b < m_bandCount; b++) {
+        float peak = 0.0f;
+        for (int i = m_bandEdges[b]; i < m_bandEdges[b + 1]; i++) peak = std::max(peak, spectrum[i]);
+        frame.bands[b] = peak;
+    }
+    if (!m_queue.TryPush(frame)) {
+        m_droppedFrames.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Wake the sender only if it said it is going to sleep. The fences pair
+    // with the ones in SenderThread: either it sees this frame before
+    // sleeping or we see its flag. No lock, so a sender preempted inside
+    // wait can't hold up capture; a notify that lands just before it blocks
+    // costs at most SENDER_WAKE_TIMEOUT_MS.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_senderWaiting.load(std::memory_order_relaxed)) m_wake.notify_one();
+}
+
+void SpectrumStreamer::SenderThread() {
+    SpectrumStreamEncoder encoder(m_bandCount);
+    QueuedFrame frame;
+    uint8_t quantized[MAX_BANDS];
+    bool pending = false;  // frame was popped but didn't fit the last datagram
+
+    while (m_running.load(std::memory_order_relaxed)) {
+        if (!pending) {
+            m_senderWaiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_wake.wait_for(lock, std::chrono::milliseconds(SENDER_WAKE_TIMEOUT_MS),
+                            [this] { return !m_queue.Empty() || !m_running.load(std::memory_order_relaxed); });
+            m_senderWaiting.store(false, std::memory_order_relaxed);
+        }
+
+        // Everything queued since the last send goes in as few datagrams as fit
+        encoder.Begin();
+        while (pending || m_queue.TryPop(frame)) {
+            for (int b = 0; b < m_bandCount; b++) {
+                float v = std::min(1.0f, std::max(0.0f, frame.bands[b]));
+                quantized[b] = (uint8_t)(v * 255.0f + 0.5f);
+            }
+            if (!encoder.Add(quantized, (uint64_t)(frame.timestamp * 1e6))) {
+                pending = true;
+                break;
+            }
+            pending = false;
+        }
+        if (encoder.GetFrameCount() == 0) continue;
+
+        const std::vector<uint8_t>& datagram = encoder.Finish();
+        if (m_socket.Send(datagram.data(), datagram.size())) {
+            m_sentFrames.fetch_add(encoder.GetFrameCount(), std::memory_order_relaxed);
+            m_sentDatagrams.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SpscQueue.h"
+
+// Compact spectrum streaming over UDP for remote consumers (DMX boxes).
+// The spectrum is reduced to log-spaced bands, quantized to 8 bits and sent
+// as delta-encoded frames, several per datagram when they queue up.
+//
+// Datagram (little-endian):
+//   u32 magic 'MVSB', u8 version, u8 bandCount, u8 frameCount, u8 0,
+//   u32 sequence of the first frame, u64 timestamp of the first frame (us)
+// then per frame:
+//   u8 flags, u32 timestamp offset from the first frame (us), payload
+// Payload: FRAME_KEY: one byte per band. Otherwise the change from the
+// previous frame per band, zigzag coded, two bands per byte when every
+// change fits in 4 bits (FRAME_NIBBLES), else one byte each.
+// Every KEYFRAME_INTERVAL-th frame is a key, so a receiver that lost a
+// datagram resynchronizes within a fraction of a second.
+namespace SpectrumStream {
+    const uint32_t MAGIC = 0x4253564Du;  // "MVSB"
+    const uint8_t VERSION = 1;
+    const int HEADER_SIZE = 20;
+    const int FRAME_HEADER_SIZE = 5;
+    const uint8_t FRAME_KEY = 1;
+    const uint8_t FRAME_NIBBLES = 2;
+    const int KEYFRAME_INTERVAL = 16;
+    const int MAX_BANDS = 128;
+    const size_t MAX_DATAGRAM = 1200;  // Stays under the usual MTU
+    const int DEFAULT_PORT = 7878;
+}
+
+class SpectrumStreamEncoder {
+public:
+    explicit SpectrumStreamEncoder(int bandCount);
+
+    void Begin();  // Start a datagram
+    // Appends a frame; false (and nothing changes) if it wouldn't fit
+    bool Add(const uint8_t* bands, uint64_t timestampMicros);
+    int GetFrameCount() const { return m_frames; }
+    const std::vector<uint8_t>& Finish();  // The datagram, valid until Begin()
+
+private:
+    int m_bandCount;
+    uint32_t m_sequence = 0;            // Of the next frame
+    uint64_t m_baseTimestamp = 0;
+    int m_frames = 0;
+    std::vector<uint8_t> m_previous;    // Last frame sent, quantized
+    std::vector<uint8_t> m_buffer;
+};
+
+struct StreamFrame {
+    uint32_t sequence = 0;
+    uint64_t timestampMicros = 0;
+    std::vector<uint8_t> bands;
+};
+
+class SpectrumStreamDecoder {
+public:
+    // Decodes one datagram, appending every frame it can reconstruct.
+    // Returns false if the datagram is malformed.
+    bool Decode(const uint8_t* data, size_t size, std::vector<StreamFrame>& out);
+
+    uint64_t GetDecoded() const { return m_decoded; }
+    uint64_t GetLost() const { return m_lost; }        // Sequence numbers never seen
+    uint64_t GetSkipped() const { return m_skipped; }  // Deltas dropped while waiting for a key
+    uint64_t GetLate() const { return m_late; }        // Arrived after a newer frame
+    uint64_t GetMalformed() const { return m_malformed; }
+
+private:
+    bool m_started = false;
+    bool m_synced = false;            // m_values holds the previous frame
+    uint32_t m_nextSequence = 0;
+    std::vector<uint8_t> m_values;
+    uint64_t m_decoded = 0, m_lost = 0, m_skipped = 0, m_late = 0, m_malformed = 0;
+};
+
+// Minimal UDP socket (Winsock or BSD)
+class UdpSocket {
+public:
+    UdpSocket() = default;
+    ~UdpSocket() { Close(); }
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    bool Connect(const std::string& host, int port);  // Sender
+    bool Bind(int port);                               // Receiver on every interface; 0 = any free port
+    bool Send(const void* data, size_t size);
+    int Receive(void* buffer, size_t size, int timeoutMs);  // Bytes, 0 on timeout, -1 on error
+    int GetLocalPort() const;
+    void Close();
+    bool IsOpen() const { return m_socket != INVALID; }
+
+private:
+    static const intptr_t INVALID = -1;
+    bool Create();
+    intptr_t m_socket = INVALID;
+};
+
+// Sends band frames from the audio thread. Push() reduces the spectrum to
+// bands and hands them to a sender thread through a lock-free queue;
+// quantizing, encoding and the socket calls all happen on the sender thread.
+class SpectrumStreamer {
+public:
+    SpectrumStreamer() = default;
+    ~SpectrumStreamer() { Stop(); }
+
+    // address is "host:port" (port defaults to SpectrumStream::DEFAULT_PORT)
+    bool Start(const std::string& address, int bandCount);
+    void Stop();
+    bool IsRunning() const { return m_running.load(std::memory_order_relaxed); }
+
+    // Audio thread. spectrum is 0-1 per bin; timestamp in seconds on the
+    // steady clock. Never blocks; drops the frame if the sender is behind.
+    void Push(const float* spectrum, int numBins, double timestamp);
+
+    uint64_t GetSentFrames() const { return m_sentFrames.load(std::memory_order_relaxed); }
+    uint64_t GetSentDatagrams() const { return m_sentDatagrams.load(std::memory_order_relaxed); }
+    uint64_t GetDroppedFrames() const { return m_droppedFrames.load(std::memory_order_relaxed); }
+
+private:
+    struct QueuedFrame {
+        double timestamp;
+        float bands[SpectrumStream::MAX_BANDS];
+    };
+
+    void SenderThread();
+
+    int m_bandCount = 0;
+    int m_numBins = 0;                 // m_bandEdges was built for this many bins
+    std::vector<int> m_bandEdges;      // bandCount + 1 bin indices
+    SpscQueue<QueuedFrame, 64> m_queue;
+    UdpSocket m_socket;
+    std::thread m_thread;
+    std::mutex m_wakeMutex;            // Sender side only
+    std::condition_variable m_wake;
+    std::atomic<bool> m_senderWaiting{false};
+    std::atomic<bool> m_running{false};
+    std::atomic<uint64_t> m_sentFrames{0};
+    std::atomic<uint64_t> m_sentDatagrams{0};
+    std::atomic<uint64_t> m_droppedFrames{0};
+};
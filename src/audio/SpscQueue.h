@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Capacity is a power of two; TryPush fails instead of blocking
+// when the queue is full, so a real-time producer never waits.
+// Head and tail sit on separate cache lines so the two threads don't
+// invalidate each other's line on every operation.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    // Producer
+    bool TryPush(const T& item) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead == Capacity) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead == Capacity) return false;
+        }
+        m_items[tail & (Capacity - 1)] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer
+    bool TryPop(T& item) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail) return false;
+        }
+        item = m_items[head & (Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate from any thread other than the consumer; exact from the consumer
+    bool Empty() const {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> m_head{0};  // Next slot to pop (consumer)
+    size_t m_cachedTail = 0;                     // Consumer's last view of m_tail
+    alignas(64) std::atomic<size_t> m_tail{0};  // Next slot to push (producer)
+    size_t m_cachedHead = 0;                     // Producer's last view of m_head
+    alignas(64) T m_items[Capacity];
+};
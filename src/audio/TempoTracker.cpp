@@ -0,0 +1,209 @@
+#include "TempoTracker.h"
+#include <chrono>
+#include <cmath>
+
+// Estimates within this ratio of the current tempo count as the same tempo
+static const float SAME_TEMPO = 0.04f;
+// Updates a different tempo must win in a row before we switch to it
+static const int SWITCH_VOTES = 3;
+// Prior favouring tempos near 120 BPM, width in octaves; resolves the
+// half/double tempo ambiguity the autocorrelation can't
+static const float PRIOR_CENTER_BPM = 120.0f;
+static const float PRIOR_WIDTH_OCTAVES = 1.0f;
+
+TempoTracker::TempoTracker(int numBins, float frameRate)
+    : m_numBins(numBins), m_frameRate(frameRate),
+      m_previousLog(numBins, 0.0f), m_acfSize(2 * ONSET_FRAMES), m_acfPlan(m_acfSize) {
+    SizeBuffers();
+}
+
+void TempoTracker::SetFrameRate(float frameRate) {
+    m_frameRate = frameRate;
+    SizeBuffers();
+    Reset();
+}
+
+void TempoTracker::SizeBuffers() {
+    // Whole multiples keep both sizes powers of two
+    int scale = (int)ceilf(m_frameRate / ONSET_FRAME_RATE - 0.01f);
+    if (scale < 1) scale = 1;
+    int frames = ONSET_FRAMES * scale;
+    if ((int)m_onsets.size() == frames) return;
+
+    m_onsets.assign(frames, 0.0f);
+    m_acfSize = 2 * frames;
+    m_acfPlan = FftPlan(m_acfSize);
+    m_acfBuffer.assign(m_acfSize, 0.0f);
+    m_acf.assign(m_acfSize / 2, 0.0f);
+}
+
+void TempoTracker::Reset() {
+    for (float& v : m_previousLog) v = 0.0f;
+    for (float& v : m_onsets) v = 0.0f;
+    m_onsetHead = 0;
+    m_onsetCount = 0;
+    m_hopsSinceUpdate = 0;
+    m_updateHops = BASE_UPDATE_HOPS;
+    m_coolUpdates = 0;
+    m_bpm = 0.0f;
+    m_confidence = 0.0f;
+    m_candidateBpm = 0.0f;
+    m_candidateVotes = 0;
+    m_period = 0.0f;
+    m_framesSinceBeat = 0.0f;
+}
+
+float TempoTracker::OnsetAt(int framesAgo) const {
+    int frames = (int)m_onsets.size();
+    int idx = (m_onsetHead - 1 - framesAgo) % frames;
+    if (idx < 0) idx += frames;
+    return m_onsets[idx];
+}
+
+float TempoTracker::GetBeatPhase() const {
+    if (m_period <= 0.0f) return 0.0f;
+    float phase = fmodf(m_framesSinceBeat, m_period) / m_period;
+    return phase < 0.0f ? phase + 1.0f : phase;
+}
+
+void TempoTracker::AddFrame(const float* magnitude) {
+    // Spectral flux of log magnitude: total rise in energy across bins
+    float flux = 0.0f;
+    for (int i = 0; i < m_numBins; i++) {
+        float logMag = logf(1.0f + 10.0f * magnitude[i]);
+        float rise = logMag - m_previousLog[i];
+        if (rise > 0.0f) flux += rise;
+        m_previousLog[i] = logMag;
+    }
+
+    m_onsets[m_onsetHead] = flux;
+    m_onsetHead = (m_onsetHead + 1) % (int)m_onsets.size();
+    if (m_onsetCount < (int)m_onsets.size()) m_onsetCount++;
+    m_framesSinceBeat += 1.0f;
+
+    if (++m_hopsSinceUpdate < m_updateHops) return;
+    m_hopsSinceUpdate = 0;
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    UpdateTempo();
+    m_lastUpdateMicros = std::chrono::duration<float, std::micro>(Clock::now() - start).count();
+
+    // Keep the amortized cost per block inside the budget
+    if (m_lastUpdateMicros > m_budgetMicros) {
+        if (m_updateHops < MAX_UPDATE_HOPS) m_updateHops *= 2;
+        m_coolUpdates = 0;
+    } else if (m_lastUpdateMicros < m_budgetMicros * 0.3f && m_updateHops > BASE_UPDATE_HOPS) {
+        if (++m_coolUpdates >= 10) {
+            m_updateHops /= 2;
+            m_coolUpdates = 0;
+        }
+    } else {
+        m_coolUpdates = 0;
+    }
+}
+
+void TempoTracker::UpdateTempo() {
+    int minLag = (int)floorf(60.0f * m_frameRate / MAX_BPM);
+    int maxLag = (int)ceilf(60.0f * m_frameRate / MIN_BPM);
+    // Need a few periods of the slowest tempo before the estimate means anything
+    if (m_onsetCount < maxLag * 3 || maxLag + 1 >= m_acfSize / 2) return;
+
+    // Mean-removed onset curve, oldest first, zero padded
+    int count = m_onsetCount;
+    float mean = 0.0f;
+    for (int i = 0; i < count; i++) mean += OnsetAt(i);
+    mean /= count;
+    for (int i = 0; i < m_acfSize; i++) {
+        m_acfBuffer[i] = (i < count) ? std::complex<float>(OnsetAt(count - 1 - i) - mean, 0.0f) : 0.0f;
+    }
+
+    // Autocorrelation = IFFT(|FFT|^2)
+    m_acfPlan.Forward(m_acfBuffer.data());
+    for (auto& v : m_acfBuffer) v = std::norm(v);
+    m_acfPlan.Inverse(m_acfBuffer.data());
+    for (int i = 0; i < m_acfSize / 2; i++) m_acf[i] = m_acfBuffer[i].real();
+
+    float energy = m_acf[0];
+    if (energy <= 1e-9f) {
+        // Silence: nothing to track
+        m_confidence = 0.0f;
+        return;
+    }
+
+    // Pick the best lag, counting its double as support for the same beat
+    int bestLag = -1;
+    float bestScore = 0.0f;
+    for (int lag = minLag; lag <= maxLag; lag++) {
+        float score = m_acf[lag];
+        if (lag * 2 < m_acfSize / 2) score += 0.5f * m_acf[lag * 2];
+        if (score <= 0.0f) continue;
+
+        float octaves = log2f(60.0f * m_frameRate / lag / PRIOR_CENTER_BPM) / PRIOR_WIDTH_OCTAVES;
+        score *= expf(-0.5f * octaves * octaves);
+        if (score > bestScore) {
+            bestScore = score;
+            bestLag = lag;
+        }
+    }
+    if (bestLag < 0) {
+        m_confidence = 0.0f;
+        return;
+    }
+
+    // Parabolic interpolation around the peak for sub-block resolution
+    float period = (float)bestLag;
+    float a = m_acf[bestLag - 1], b = m_acf[bestLag], c = m_acf[bestLag + 1];
+    float denom = a - 2.0f * b + c;
+    if (denom < 0.0f) {
+        float offset = 0.5f * (a - c) / denom;
+        if (offset > -1.0f && offset < 1.0f) period += offset;
+    }
+
+    float estimate = 60.0f * m_frameRate / period;
+    // Block quantization splits a fractional period between two lags, so
+    // count the stronger neighbour too
+    float confidence = (b + (a > c ? a : c)) / energy;
+    m_confidence = confidence < 0.0f ? 0.0f : (confidence > 1.0f ? 1.0f : confidence);
+
+    // Follow small drifts, but only jump to a different tempo once it has
+    // won a few updates in a row
+    if (m_bpm <= 0.0f || fabsf(estimate - m_bpm) <= m_bpm * SAME_TEMPO) {
+        m_bpm = (m_bpm <= 0.0f) ? estimate : m_bpm + (estimate - m_bpm) * 0.25f;
+        m_candidateVotes = 0;
+    } else if (m_candidateVotes > 0 && fabsf(estimate - m_candidateBpm) <= m_candidateBpm * SAME_TEMPO) {
+        if (++m_candidateVotes >= SWITCH_VOTES) {
+            m_bpm = estimate;
+            m_candidateVotes = 0;
+        }
+    } else {
+        m_candidateBpm = estimate;
+        m_candidateVotes = 1;
+    }
+
+    UpdatePhase(60.0f * m_frameRate / m_bpm);
+}
+
+void TempoTracker::UpdatePhase(float period) {
+    // Comb over the onset ring: the offset whose beat train lines up with the
+    // most onset energy is the time since the last beat
+    int beats = (int)((m_onsetCount - 1) / period);
+    if (beats < 1) return;
+    if (beats > 8) beats = 8;
+
+    int bestOffset = 0;
+    float bestScore = -1.0f;
+    for (int offset = 0; offset < (int)period; offset++) {
+        float score = 0.0f;
+        for (int k = 0; k < beats; k++) {
+            score += OnsetAt(offset + (int)(k * period + 0.5f));
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            bestOffset = offset;
+        }
+    }
+
+    m_period = period;
+    m_framesSinceBeat = (float)bestOffset;
+}
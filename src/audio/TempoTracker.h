@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <complex>
+#include <cstdint>
+#include "Fft.h"
+
+// Incremental tempo estimation from spectral flux.
+// Every analysis block adds one onset-strength value to a ring covering about
+// five seconds (ONSET_FRAMES blocks at 44.1/48 kHz, a multiple of it at
+// higher rates so the slowest beat still fits three times). Every few blocks
+// the ring's autocorrelation is recomputed with an FFT and the strongest beat
+// period between MIN_BPM and MAX_BPM is picked; in between, only the beat
+// phase advances.
+//
+// The autocorrelation update is held to a time budget: when it runs over,
+// updates are spaced further apart; when it is cheap again they return to
+// the base interval.
+class TempoTracker {
+public:
+    static const int ONSET_FRAMES = 512;    // ~5.5 s at 48 kHz / 512
+    static constexpr float ONSET_FRAME_RATE = 48000.0f / 512.0f;  // Rate ONSET_FRAMES is sized for
+    static const int BASE_UPDATE_HOPS = 8;
+    static const int MAX_UPDATE_HOPS = 64;
+    static constexpr float MIN_BPM = 60.0f;
+    static constexpr float MAX_BPM = 200.0f;
+    static constexpr float DEFAULT_BUDGET_MICROS = 300.0f;
+
+    TempoTracker(int numBins, float frameRate);
+
+    void SetFrameRate(float frameRate);  // Analysis blocks per second; resets
+    void Reset();
+
+    // Add one block's magnitude spectrum
+    void AddFrame(const float* magnitude);
+
+    float GetBPM() const { return m_bpm; }               // 0 until a tempo is found
+    float GetConfidence() const { return m_confidence; } // 0-1
+    float GetBeatPhase() const;                          // 0 on the beat, rising to 1
+
+    void SetBudgetMicros(float micros) { m_budgetMicros = micros; }
+    int GetUpdateInterval() const { return m_updateHops; }
+    float GetLastUpdateMicros() const { return m_lastUpdateMicros; }
+    int GetOnsetFrames() const { return (int)m_onsets.size(); }
+
+private:
+    void SizeBuffers();  // Onset ring and autocorrelation for m_frameRate
+    void UpdateTempo();
+    void UpdatePhase(float period);
+    float OnsetAt(int framesAgo) const;
+
+    int m_numBins;
+    float m_frameRate;
+
+    std::vector<float> m_previousLog;  // Log magnitude of the previous block
+    std::vector<float> m_onsets;       // Ring of onset strength
+    int m_onsetHead = 0;               // Next write position
+    int m_onsetCount = 0;
+
+    int m_acfSize;                     // FFT length, 2x the ring so the correlation doesn't wrap
+    FftPlan m_acfPlan;
+    std::vector<std::complex<float>> m_acfBuffer;
+    std::vector<float> m_acf;
+
+    int m_updateHops = BASE_UPDATE_HOPS;
+    int m_hopsSinceUpdate = 0;
+    int m_coolUpdates = 0;
+    float m_budgetMicros = DEFAULT_BUDGET_MICROS;
+    float m_lastUpdateMicros = 0.0f;
+
+    float m_bpm = 0.0f;
+    float m_confidence = 0.0f;
+    float m_candidateBpm = 0.0f;       // Competing estimate waiting to be confirmed
+    int m_candidateVotes = 0;
+    float m_period = 0.0f;             // Beat period in blocks
+    float m_framesSinceBeat = 0.0f;
+};
@@ -0,0 +1,113 @@
+#pragma once
+// Small SIMD helpers for the per-bin float arrays in AudioData.
+// SSE2 is baseline on every x64 target we build for; other targets use the
+// scalar loop, which compilers auto-vectorize reasonably well anyway.
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MUSICVIS_SSE2 1
+#endif
+
+// out[i] = clamp(a[i] + (b[i] - a[i]) * t, lo, hi)
+// t outside [0, 1] extrapolates. out may alias a or b.
+inline void LerpClampArray(const float* a, const float* b, float t, float lo, float hi, float* out, int count) {
+    int i = 0;
+#ifdef MUSICVIS_SSE2
+    __m128 vt = _mm_set1_ps(t);
+    __m128 vlo = _mm_set1_ps(lo);
+    __m128 vhi = _mm_set1_ps(hi);
+    for (; i + 4 <= count; i += 4) {
+        __m128 va = _mm_loadu_ps(a + i);
+        __m128 vb = _mm_loadu_ps(b + i);
+        __m128 v = _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), vt));
+        v = _mm_min_ps(_mm_max_ps(v, vlo), vhi);
+        _mm_storeu_ps(out + i, v);
+    }
+#endif
+    for (; i < count; i++) {
+        float v = a[i] + (b[i] - a[i]) * t;
+        if (v < lo) v = lo;
+        if (v > hi) v = hi;
+        out[i] = v;
+    }
+}
+
+// acc[i] = max(acc[i], x[i])
+inline void MaxInPlace(float* acc, const float* x, int count) {
+    int i = 0;
+#ifdef MUSICVIS_SSE2
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(acc + i, _mm_max_ps(_mm_loadu_ps(acc + i), _mm_loadu_ps(x + i)));
+    }
+#endif
+    for (; i < count; i++) {
+        if (x[i] > acc[i]) acc[i] = x[i];
+    }
+}
+
+// acc[i] += x[i]
+inline void AddInPlace(float* acc, const float* x, int count) {
+    int i = 0;
+#ifdef MUSICVIS_SSE2
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_loadu_ps(x + i)));
+    }
+#endif
+    for (; i < count; i++) {
+        acc[i] += x[i];
+    }
+}
+
+// out[i] = x[i] * s
+inline void ScaleArray(const float* x, float s, float* out, int count) {
+    int i = 0;
+#ifdef MUSICVIS_SSE2
+    __m128 vs = _mm_set1_ps(s);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(x + i), vs));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = x[i] * s;
+    }
+}
+
+// Four float lanes, for filters that run one channel per lane.
+// SSE2 when available, otherwise a plain array the compiler can unroll.
+#ifdef MUSICVIS_SSE2
+typedef __m128 Float4;
+inline Float4 F4Zero() { return _mm_setzero_ps(); }
+inline Float4 F4Set1(float v) { return _mm_set1_ps(v); }
+inline Float4 F4Load(const float* p) { return _mm_loadu_ps(p); }
+inline void F4Store(float* p, Float4 v) { _mm_storeu_ps(p, v); }
+inline Float4 F4Add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+inline Float4 F4Sub(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+inline Float4 F4Mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+inline Float4 F4Max(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+inline Float4 F4Min(Float4 a, Float4 b) { return _mm_min_ps(a, b); }
+inline Float4 F4Sqrt(Float4 a) { return _mm_sqrt_ps(a); }
+inline Float4 F4Abs(Float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+// (a, b, c, d) -> (b, a, d, c): swaps real and imaginary parts of two complex values
+inline Float4 F4SwapPairs(Float4 a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)); }
+// (a0 + a1, a2 + a3, b0 + b1, b2 + b3): e.g. |z|^2 of four interleaved complex values
+inline Float4 F4AddPairs(Float4 a, Float4 b) {
+    return _mm_add_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+#else
+struct Float4 { float v[4]; };
+inline Float4 F4Zero() { return Float4{ { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+inline Float4 F4Set1(float x) { return Float4{ { x, x, x, x } }; }
+inline Float4 F4Load(const float* p) { return Float4{ { p[0], p[1], p[2], p[3] } }; }
+inline void F4Store(float* p, Float4 a) { for (int i = 0; i < 4; i++) p[i] = a.v[i]; }
+inline Float4 F4Add(Float4 a, Float4 b) { for (int i = 0; i < 4; i++) a.v[i] += b.v[i]; return a; }
+inline Float4 F4Sub(Float4 a, Float4 b) { for (int i = 0; i < 4; i++) a.v[i] -= b.v[i]; return a; }
+inline Float4 F4Mul(Float4 a, Float4 b) { for (int i = 0; i < 4; i++) a.v[i] *= b.v[i]; return a; }
+inline Float4 F4Max(Float4 a, Float4 b) { for (int i = 0; i < 4; i++) a.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return a; }
+inline Float4 F4Min(Float4 a, Float4 b) { for (int i = 0; i < 4; i++) a.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return a; }
+inline Float4 F4Sqrt(Float4 a) { for (int i = 0; i < 4; i++) a.v[i] = sqrtf(a.v[i]); return a; }
+inline Float4 F4Abs(Float4 a) { for (int i = 0; i < 4; i++) a.v[i] = a.v[i] < 0.0f ? -a.v[i] : a.v[i]; return a; }
+inline Float4 F4SwapPairs(Float4 a) { return Float4{ { a.v[1], a.v[0], a.v[3], a.v[2] } }; }
+inline Float4 F4AddPairs(Float4 a, Float4 b) { return Float4{ { a.v[0] + a.v[1], a.v[2] + a.v[3], b.v[0] + b.v[1], b.v[2] + b.v[3] } }; }
+#endif
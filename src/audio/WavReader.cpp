@@ -0,0 +1,107 @@
+#include "WavReader.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static uint32_t ReadU32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t ReadU16(const unsigned char* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// One sample in the file's format, as a float in [-1, 1]
+static float DecodeSample(const unsigned char* p, int bits, bool isFloat) {
+    if (isFloat) {
+        float v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    switch (bits) {
+    case 8:  return ((int)p[0] - 128) / 128.0f;
+    case 16: return (int16_t)ReadU16(p) / 32768.0f;
+    case 24: {
+        int32_t v = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8;
+        return v / 8388608.0f;
+    }
+    case 32: return (int32_t)ReadU32(p) / 2147483648.0f;
+    }
+    return 0.0f;
+}
+
+bool ReadWavFile(const std::string& path, WavData& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+
+    std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return ParseWav(bytes, path, out);
+}
+
+bool ParseWav(const std::vector<unsigned char>& bytes, const std::string& path, WavData& out) {
+    if (bytes.size() < 12 || memcmp(bytes.data(), "RIFF", 4) != 0 || memcmp(bytes.data() + 8, "WAVE", 4) != 0) {
+        std::cerr << path << " is not a WAVE file" << std::endl;
+        return false;
+    }
+
+    int format = 0, channels = 0, sampleRate = 0, bits = 0;
+    const unsigned char* data = nullptr;
+    size_t dataSize = 0;
+
+    // Walk the chunks; only fmt and data matter
+    size_t pos = 12;
+    while (pos + 8 <= bytes.size()) {
+        const unsigned char* chunk = bytes.data() + pos;
+        size_t size = ReadU32(chunk + 4);
+        size_t available = bytes.size() - pos - 8;
+        if (size > available) size = available;  // Truncated file: use what's there
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            format = ReadU16(chunk + 8);
+            channels = ReadU16(chunk + 10);
+            sampleRate = (int)ReadU32(chunk + 12);
+            bits = ReadU16(chunk + 22);
+            // WAVE_FORMAT_EXTENSIBLE: the real format is the first word of the sub-format GUID
+            if (format == 0xFFFE && size >= 26) format = ReadU16(chunk + 32);
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            data = chunk + 8;
+            dataSize = size;
+        }
+        pos += 8 + size + (size & 1);
+    }
+
+    bool isFloat = (format == 3);
+    if ((format != 1 && !isFloat) || (isFloat && bits != 32) ||
+        (bits != 8 && bits != 16 && bits != 24 && bits != 32) || channels <= 0 || sampleRate <= 0) {
+        std::cerr << path << ": unsupported format (format " << format << ", " << bits << " bits)" << std::endl;
+        return false;
+    }
+    if (!data) {
+        std::cerr << path << ": no data chunk" << std::endl;
+        return false;
+    }
+
+    int bytesPerSample = bits / 8;
+    size_t frameBytes = (size_t)bytesPerSample * channels;
+    size_t frames = dataSize / frameBytes;
+
+    out.sampleRate = sampleRate;
+    out.channels = channels;
+    out.samples.resize(frames);
+    out.interleaved.resize(channels > 1 ? frames * channels : 0);
+    for (size_t f = 0; f < frames; f++) {
+        const unsigned char* p = data + f * frameBytes;
+        float sum = 0.0f;
+        for (int c = 0; c < channels; c++) {
+            float v = DecodeSample(p + c * bytesPerSample, bits, isFloat);
+            if (channels > 1) out.interleaved[f * channels + c] = v;
+            sum += v;
+        }
+        out.samples[f] = sum / channels;
+    }
+    return true;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Minimal RIFF/WAVE loader for offline analysis (benchmarks, tests).
+// Supports 8/16/24/32-bit integer PCM and 32-bit float, any channel count.
+struct WavData {
+    int sampleRate = 0;
+    int channels = 0;
+    std::vector<float> samples;  // Mono mix-down in [-1, 1]
+    std::vector<float> interleaved;  // Every channel, frame by frame; empty for mono files
+};
+
+// Returns false and prints the reason to cerr if the file can't be used.
+bool ReadWavFile(const std::string& path, WavData& out);
+// Same, for a file already in memory; path is only used in messages.
+bool ParseWav(const std::vector<unsigned char>& bytes, const std::string& path, WavData& out);
@@ -0,0 +1,94 @@
+#include "WorkStealingPool.h"
+
+// Which pool and worker the current thread belongs to, so tasks submitted
+// from inside a task land on the local deque
+static thread_local const WorkStealingPool* s_currentPool = nullptr;
+static thread_local int s_currentWorker = -1;
+
+WorkStealingPool::WorkStealingPool(int threads)
+    : m_queued(0), m_pending(0), m_nextWorker(0), m_steals(0) {
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+
+    for (int i = 0; i < threads; i++) m_workers.emplace_back(new Worker());
+    for (int i = 0; i < threads; i++) m_threads.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    Wait();
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads) thread.join();
+}
+
+void WorkStealingPool::Submit(Task task) {
+    int index = (s_currentPool == this) ? s_currentWorker
+                                        : (int)(m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_workers.size());
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+        m_workers[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_queued.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_wake.notify_one();
+}
+
+void WorkStealingPool::Wait() {
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_idle.wait(lock, [this] { return m_pending.load(std::memory_order_relaxed) == 0; });
+}
+
+bool WorkStealingPool::TakeTask(int index, Task& task) {
+    // Own deque: newest first
+    {
+        Worker& own = *m_workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal the oldest task from the next busy worker
+    int count = (int)m_workers.size();
+    for (int i = 1; i < count; i++) {
+        Worker& victim = *m_workers[(index + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::WorkerLoop(int index) {
+    s_currentPool = this;
+    s_currentWorker = index;
+
+    for (;;) {
+        Task task;
+        if (TakeTask(index, task)) {
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(m_sleepMutex);
+                m_idle.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this] { return m_stopping || m_queued.load(std::memory_order_relaxed) > 0; });
+        if (m_stopping && m_queued.load(std::memory_order_relaxed) == 0) return;
+    }
+}
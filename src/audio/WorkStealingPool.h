@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size thread pool with one task deque per worker.
+// A worker takes its newest task first (its data is still warm) and, when
+// its own deque is empty, steals the oldest task from another worker, so a
+// few long tasks don't leave the other cores idle. Tasks may submit more
+// tasks; those go on the submitting worker's own deque.
+class WorkStealingPool {
+public:
+    typedef std::function<void()> Task;
+
+    explicit WorkStealingPool(int threads = 0);  // 0 = one per hardware thread
+    ~WorkStealingPool();                         // Runs what is queued, then joins
+
+    void Submit(Task task);  // Any thread
+    void Wait();             // Until every submitted task has finished
+
+    int GetThreadCount() const { return (int)m_threads.size(); }
+    uint64_t GetStealCount() const { return m_steals.load(std::memory_order_relaxed); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void WorkerLoop(int index);
+    bool TakeTask(int index, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+
+    // Idle workers sleep on m_wake until m_queued > 0; Wait() sleeps on
+    // m_idle until m_pending reaches 0. Both are changed and checked under
+    // m_sleepMutex so no wakeup is lost.
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::atomic<int> m_queued;   // Tasks sitting in a deque
+    std::atomic<int> m_pending;  // Submitted and not yet finished
+    std::atomic<uint32_t> m_nextWorker;
+    std::atomic<uint64_t> m_steals;
+    bool m_stopping = false;
+};
@@ -0,0 +1,143 @@
+#include "Profiler.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+thread_local Profiler::ThreadBuffer* Profiler::s_threadBuffer = nullptr;
+
+Profiler& Profiler::Get() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler() : m_origin(Now()) {}
+
+int64_t Profiler::Now() {
+#ifdef _WIN32
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+int64_t Profiler::TicksPerSecond() {
+#ifdef _WIN32
+    static const int64_t frequency = [] {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        return f.QuadPart;
+    }();
+    return frequency;
+#else
+    return 1000000000;
+#endif
+}
+
+void Profiler::SetEnabled(bool enabled) {
+    if (enabled && !IsEnabled()) m_captureStart.store(Now(), std::memory_order_relaxed);
+    m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+Profiler::ThreadBuffer* Profiler::Register() {
+    if (s_threadBuffer) return s_threadBuffer;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_buffers.push_back(std::make_unique<ThreadBuffer>());
+    ThreadBuffer* buffer = m_buffers.back().get();
+    buffer->id = (int)m_buffers.size();
+    s_threadBuffer = buffer;
+    return buffer;
+}
+
+void Profiler::SetThreadName(const char* name) {
+    ThreadBuffer* buffer = Register();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    buffer->name = name;
+}
+
+void Profiler::Record(const char* name, int64_t start, int64_t end) {
+    ThreadBuffer* buffer = Register();
+    uint64_t n = buffer->written.load(std::memory_order_relaxed);
+    buffer->events[n & (RING_EVENTS - 1)] = { name, start, end };
+    buffer->written.store(n + 1, std::memory_order_release);
+}
+
+// Zone and thread names as JSON strings
+static void WriteString(std::ostream& out, const char* s) {
+    out << '"';
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') out << '\\' << *s;
+        else if ((unsigned char)*s < 0x20) out << ' ';
+        else out << *s;
+    }
+    out << '"';
+}
+
+int Profiler::WriteTrace(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int64_t captureStart = m_captureStart.load(std::memory_order_relaxed);
+    double microsPerTick = 1e6 / (double)TicksPerSecond();
+
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"MusicVisVibeCode\"}}";
+
+    int count = 0;
+    std::vector<Event> events;
+    for (const std::unique_ptr<ThreadBuffer>& buffer : m_buffers) {
+        std::string name = buffer->name.empty() ? "Thread " + std::to_string(buffer->id) : buffer->name;
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":";
+        WriteString(out, name.c_str());
+        out << "}}";
+
+        // Copy the ring, then drop the slots its thread may have reused meanwhile
+        uint64_t written = buffer->written.load(std::memory_order_acquire);
+        uint64_t first = written > (uint64_t)RING_EVENTS ? written - RING_EVENTS : 0;
+        events.clear();
+        for (uint64_t i = first; i < written; i++) events.push_back(buffer->events[i & (RING_EVENTS - 1)]);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = buffer->written.load(std::memory_order_relaxed);
+        uint64_t valid = after > (uint64_t)RING_EVENTS ? after - RING_EVENTS : 0;
+
+        for (uint64_t i = valid > first ? valid : first; i < written; i++) {
+            const Event& e = events[(size_t)(i - first)];
+            if (e.start < captureStart) continue;
+            out << ",\n{\"name\":";
+            WriteString(out, e.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+                << ",\"ts\":" << (e.start - m_origin) * microsPerTick
+                << ",\"dur\":" << (e.end - e.start) * microsPerTick << "}";
+            count++;
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    out.flags(flags);
+    out.precision(precision);
+    return count;
+}
+
+bool Profiler::WriteTrace(const std::string& path) {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open " << path << " for the trace" << std::endl;
+        return false;
+    }
+    int zones = WriteTrace(file);
+    if (!file) {
+        std::cerr << "Failed to write the trace to " << path << std::endl;
+        return false;
+    }
+    std::cout << "Wrote " << zones << " profiler zones to " << path << std::endl;
+    return true;
+}
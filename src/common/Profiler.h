@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Scoped-zone CPU profiler. PROFILE_ZONE("name") times the enclosing scope;
+// while capturing, the zone is appended to the calling thread's ring of the
+// last RING_EVENTS zones. Recording takes no lock: each ring has a single
+// writer (its thread), and WriteTrace copies rings while they are written,
+// dropping anything that may have been overwritten during the copy.
+// Traces are Chrome trace_event JSON (chrome://tracing, ui.perfetto.dev).
+//
+// The markers compile to nothing unless MUSICVIS_PROFILER is defined (CMake
+// option MUSICVIS_PROFILER); the class itself is always built, so it can be
+// tested, but nothing references it in a normal build.
+class Profiler {
+public:
+    static const int RING_EVENTS = 1 << 16;  // Per thread; about 100 s of render frames
+
+    static Profiler& Get();
+
+    // Timestamps in ticks: QueryPerformanceCounter on Windows, steady_clock
+    // nanoseconds elsewhere
+    static int64_t Now();
+    static int64_t TicksPerSecond();
+
+    // Starting a capture discards the zones of earlier ones. Zones already
+    // open when it stops are still recorded when they close.
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    // Name shown for the calling thread's track
+    void SetThreadName(const char* name);
+
+    // Appends a zone to the calling thread's ring. name must outlive the
+    // profiler (a string literal).
+    void Record(const char* name, int64_t start, int64_t end);
+
+    // Writes the current capture; returns the number of zones written
+    int WriteTrace(std::ostream& out);
+    bool WriteTrace(const std::string& path);
+
+private:
+    struct Event {
+        const char* name;
+        int64_t start;
+        int64_t end;
+    };
+
+    struct ThreadBuffer {
+        int id = 0;
+        std::string name;
+        std::atomic<uint64_t> written{0};  // Zones ever recorded; the ring holds the last RING_EVENTS
+        Event events[RING_EVENTS];
+    };
+
+    Profiler();
+    // The calling thread's ring, created on first use
+    ThreadBuffer* Register();
+    static thread_local ThreadBuffer* s_threadBuffer;
+
+    std::atomic<bool> m_enabled{false};
+    std::atomic<int64_t> m_captureStart{0};
+    int64_t m_origin;
+
+    // Buffers live as long as the profiler, so a trace still has the
+    // zones of threads that have exited
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+};
+
+// Records its scope as one zone, if a capture was running when it opened
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name)
+        : m_name(Profiler::Get().IsEnabled() ? name : nullptr), m_start(m_name ? Profiler::Now() : 0) {}
+    ~ProfileZone() {
+        if (m_name) Profiler::Get().Record(m_name, m_start, Profiler::Now());
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* m_name;
+    int64_t m_start;
+};
+
+#ifdef MUSICVIS_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::Get().SetThreadName(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
@@ -1,7 +1,11 @@
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include "audio/AudioEngine.h"
 #include "rendering/Renderer.h"
+#include "audio/LibraryAnalyzer.h"
+#include "rendering/HeadlessRenderer.h"
+#include "common/Profiler.h"
 
 int main(int argc, char* argv[]) {
     std::cout << "MusicVisVibeCode Starting..." << std::endl;
@@ -10,10 +14,18 @@ int main(int argc, char* argv[]) {
     int startVis = -1; // -1 = default (Spectrum)
     float timeoutSeconds = 0.0f; // 0 = no timeout
     float snapshotSeconds = 0.0f; // 0 = no snapshot
+    FrameScheduler::Mode pacingMode = FrameScheduler::Mode::VSync;
+    float targetFps = 60.0f;
 
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
-        if (arg == "--timeout" || arg == "-t") {
+        if (arg == "--analyze") {
+            // Batch mode: summarize a music library and exit, no window or capture
+            return RunLibraryAnalysis(argc, argv);
+        } else if (arg == "--headless") {
+            // Software rendering to BMP files, no window, GPU or capture
+            return RunHeadless(argc, argv);
+        } else if (arg == "--timeout" || arg == "-t") {
             if (i + 1 < argc) {
                 timeoutSeconds = std::stof(argv[i + 1]);
                 std::cout << "Will exit after " << timeoutSeconds << " seconds" << std::endl;
@@ -25,6 +37,23 @@ int main(int argc, char* argv[]) {
                 std::cout << "Will take snapshot after " << snapshotSeconds << " seconds" << std::endl;
                 i++; // Skip next arg
             }
+        } else if (arg == "--pacing" || arg == "-p") {
+            if (i + 1 < argc) {
+                std::string pacing = argv[i + 1];
+                if (pacing == "vsync") {
+                    pacingMode = FrameScheduler::Mode::VSync;
+                } else if (pacing == "uncapped") {
+                    pacingMode = FrameScheduler::Mode::Uncapped;
+                    std::cout << "Uncapped frame rate (benchmark)" << std::endl;
+                } else if (std::atof(pacing.c_str()) > 0.0) {
+                    pacingMode = FrameScheduler::Mode::Fixed;
+                    targetFps = (float)std::atof(pacing.c_str());
+                    std::cout << "Fixed frame rate: " << targetFps << " FPS" << std::endl;
+                } else {
+                    std::cout << "Unknown pacing: " << pacing << " (vsync, uncapped or an FPS)" << std::endl;
+                }
+                i++; // Skip next arg
+            }
         } else if (arg == "--vis" || arg == "-v") {
             if (i + 1 < argc) {
                 std::string visName = argv[i + 1];
@@ -49,15 +78,35 @@ int main(int argc, char* argv[]) {
                 }
                 i++; // Skip next arg
             }
+#ifdef MUSICVIS_PROFILER
+        } else if (arg == "--profile") {
+            // From startup; written to trace1.json by T or at exit
+            Profiler::Get().SetEnabled(true);
+            std::cout << "Profiler capture started" << std::endl;
+#endif
         } else if (arg == "--help" || arg == "-h") {
             std::cout << "Usage: MusicVisVibeCode [options]" << std::endl;
             std::cout << "  --vis, -v <name>      Start with specific visualization" << std::endl;
             std::cout << "                        Options: spectrum (0), cybervalley2/cv2 (1), linefader/lf (2), spectrum2/s2 (3), circle (4)" << std::endl;
             std::cout << "  --timeout, -t <sec>   Exit after N seconds (for testing)" << std::endl;
             std::cout << "  --snapshot, -s <sec>  Take screenshot after N seconds (saved to snapshot.png)" << std::endl;
+            std::cout << "  --pacing, -p <mode>   vsync (default), <fps> for a fixed rate, or uncapped" << std::endl;
+            std::cout << "                        (uncapped prints average FPS on exit)" << std::endl;
+            std::cout << "  --analyze <dir>       Analyze every WAV under dir into the library cache and exit" << std::endl;
+            std::cout << "                        [--cache <dir>] [--threads <n>]" << std::endl;
+            std::cout << "  --headless            Render without a window to <vis>.bmp and exit" << std::endl;
+            std::cout << "                        [--wav <file>] [--frames <n>] [--fps <n>] [--size <w>x<h>]" << std::endl;
+            std::cout << "                        [--vis <name>] [--out <dir>] [--threads <n>]" << std::endl;
+            std::cout << "                        [--scale <0.5-1>] (feedback render scale)" << std::endl;
+#ifdef MUSICVIS_PROFILER
+            std::cout << "  --profile             Capture a profiler trace from startup (T writes it)" << std::endl;
+#endif
             std::cout << "\nControls:" << std::endl;
             std::cout << "  H: Toggle Help" << std::endl;
             std::cout << "  Left/Right: Switch visualization" << std::endl;
+#ifdef MUSICVIS_PROFILER
+            std::cout << "  T: Start/write profiler trace" << std::endl;
+#endif
             std::cout << "  ESC: Quit" << std::endl;
             return 0;
         }
@@ -75,6 +124,7 @@ int main(int argc, char* argv[]) {
         return -1;
     }
 
+    renderer.SetFramePacing(pacingMode, targetFps);
     renderer.Run(timeoutSeconds, snapshotSeconds);
 
     return 0;
@@ -0,0 +1,377 @@
+#include "CpuRenderDevice.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+// Sub-pixel precision of the rasterizer, as in D3D11 (8 bits)
+static const int SUBPIXEL_BITS = 8;
+static const int SUBPIXEL = 1 << SUBPIXEL_BITS;
+// Triangles reaching beyond this many pixels outside the target are
+// clipped first, which keeps the fixed-point edge functions in 64 bits
+static const float GUARD_BAND = 16384.0f;
+
+class CpuRenderDevice::Texture : public RenderTexture {
+public:
+    Texture(int width, int height) : pixels((size_t)width * height * 4, 0) {
+        m_width = width;
+        m_height = height;
+    }
+    std::vector<uint8_t> pixels;  // RGBA8, top row first
+};
+
+// Vertex after the viewport transform, in pixels
+struct CpuRenderDevice::ClipVertex {
+    float x, y;
+    Vec4 color;
+    Vec2 uv;
+};
+
+static inline uint8_t ToUnorm8(float v) {
+    v = std::min(1.0f, std::max(0.0f, v));
+    return (uint8_t)(v * 255.0f + 0.5f);
+}
+
+CpuRenderDevice::CpuRenderDevice(int width, int height, int threads)
+    : m_backBuffer(new Texture(width, height)), m_target(m_backBuffer.get()),
+      m_vertices(MAX_VERTICES), m_packed(MAX_VERTICES),
+      m_segments(MAX_VERTICES / 6), m_packedSegments(MAX_VERTICES / 6) {
+    if (threads <= 0) threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    if (threads > 1) m_pool.reset(new WorkStealingPool(threads));
+}
+
+CpuRenderDevice::~CpuRenderDevice() = default;
+
+int CpuRenderDevice::GetWidth() const {
+    return m_backBuffer->GetWidth();
+}
+
+int CpuRenderDevice::GetHeight() const {
+    return m_backBuffer->GetHeight();
+}
+
+int CpuRenderDevice::GetThreadCount() const {
+    return m_pool ? m_pool->GetThreadCount() : 1;
+}
+
+CpuRenderDevice::Texture* CpuRenderDevice::Resolve(RenderTexture* texture) const {
+    return texture ? static_cast<Texture*>(texture) : m_backBuffer.get();
+}
+
+RenderTexture* CpuRenderDevice::CreateRenderTexture(int width, int height) {
+    if (width <= 0 || height <= 0) return nullptr;
+    return new Texture(width, height);
+}
+
+void CpuRenderDevice::DestroyTexture(RenderTexture* texture) {
+    if (!texture) return;
+    Flush();  // Queued draws may sample it
+    if (m_target == texture) m_target = m_backBuffer.get();
+    if (m_boundTexture == texture) m_boundTexture = nullptr;
+    delete texture;
+}
+
+Vertex* CpuRenderDevice::MapVertices(int count) {
+    return (count >= 0 && count <= MAX_VERTICES) ? m_vertices.data() : nullptr;
+}
+
+void CpuRenderDevice::SetRenderTarget(RenderTexture* target) {
+    Texture* texture = Resolve(target);
+    if (texture == m_target) return;
+    Flush();
+    m_target = texture;
+}
+
+RenderTexture* CpuRenderDevice::GetRenderTarget() const {
+    return m_target == m_backBuffer.get() ? nullptr : m_target;
+}
+
+void CpuRenderDevice::Clear(const float color[4]) {
+    Flush();
+    uint8_t rgba[4] = { ToUnorm8(color[0]), ToUnorm8(color[1]), ToUnorm8(color[2]), ToUnorm8(color[3]) };
+    uint8_t* p = m_target->pixels.data();
+    size_t count = m_target->pixels.size() / 4;
+    for (size_t i = 0; i < count; i++, p += 4) memcpy(p, rgba, 4);
+}
+
+void CpuRenderDevice::Copy(RenderTexture* dest, RenderTexture* source) {
+    Texture* d = Resolve(dest);
+    Texture* s = Resolve(source);
+    if (d == s || d->pixels.size() != s->pixels.size()) return;
+    Flush();
+    d->pixels = s->pixels;
+}
+
+void CpuRenderDevice::BindTexture(RenderTexture* texture) {
+    m_boundTexture = static_cast<Texture*>(texture);
+}
+
+const uint8_t* CpuRenderDevice::ReadPixels(RenderTexture* texture) {
+    Flush();
+    return Resolve(texture)->pixels.data();
+}
+
+// ---- Triangle setup ----
+
+void CpuRenderDevice::Draw(int vertexCount) {
+    if (vertexCount > MAX_VERTICES) vertexCount = MAX_VERTICES;
+    if (vertexCount < 0) vertexCount = 0;
+    // Round-trip through the GPU's vertex format, so positions and colours
+    // are quantized exactly as D3D11RenderDevice uploads them
+    PackVertices(m_vertices.data(), m_packed.data(), vertexCount);
+    for (int i = 0; i < vertexCount; i++) m_vertices[i] = UnpackVertex(m_packed[i]);
+    m_verticesDrawn += vertexCount;
+    AddTriangles(vertexCount);
+}
+
+void CpuRenderDevice::DrawSegments(const Segment* segments, int count) {
+    // As the GPU does it: endpoints and colour quantized as instance data,
+    // then expanded in float like the segment vertex shader
+    const int perPass = MAX_VERTICES / 6;
+    for (int start = 0; start < count; start += perPass) {
+        int n = std::min(perPass, count - start);
+        PackSegments(segments + start, m_packedSegments.data(), n);
+        for (int i = 0; i < n; i++) m_segments[i] = UnpackSegment(m_packedSegments[i]);
+        AddTriangles(ExpandSegments(m_segments.data(), n, m_vertices.data()));
+    }
+    m_segmentsDrawn += std::max(0, count);
+}
+
+void CpuRenderDevice::AddTriangles(int vertexCount) {
+    float halfWidth = m_target->GetWidth() * 0.5f;
+    float halfHeight = m_target->GetHeight() * 0.5f;
+    for (int i = 0; i + 2 < vertexCount; i += 3) {
+        ClipVertex v[3];
+        bool inGuardBand = true;
+        for (int k = 0; k < 3; k++) {
+            const Vertex& src = m_vertices[i + k];
+            v[k].x = (src.position.x + 1.0f) * halfWidth;
+            v[k].y = (1.0f - src.position.y) * halfHeight;
+            v[k].color = src.color;
+            v[k].uv = src.texCoord;
+            inGuardBand = inGuardBand && std::fabs(v[k].x) < GUARD_BAND && std::fabs(v[k].y) < GUARD_BAND;
+        }
+        if (inGuardBand) AddTriangle(v);
+        else AddClipped(v);
+    }
+}
+
+// Sutherland-Hodgman against the guard band, then a fan
+void CpuRenderDevice::AddClipped(const ClipVertex* v) {
+    std::vector<ClipVertex> polygon(v, v + 3), next;
+    auto lerp = [](const ClipVertex& a, const ClipVertex& b, float t) {
+        ClipVertex r;
+        r.x = a.x + (b.x - a.x) * t;
+        r.y = a.y + (b.y - a.y) * t;
+        r.color = { a.color.x + (b.color.x - a.color.x) * t, a.color.y + (b.color.y - a.color.y) * t,
+                    a.color.z + (b.color.z - a.color.z) * t, a.color.w + (b.color.w - a.color.w) * t };
+        r.uv = { a.uv.x + (b.uv.x - a.uv.x) * t, a.uv.y + (b.uv.y - a.uv.y) * t };
+        return r;
+    };
+    const float limit = GUARD_BAND;
+    for (int plane = 0; plane < 4 && !polygon.empty(); plane++) {
+        // Signed distance inside each of x > -limit, x < limit, y > -limit, y < limit
+        auto inside = [&](const ClipVertex& p) {
+            float c = (plane < 2) ? p.x : p.y;
+            return (plane & 1) ? limit - c : c + limit;
+        };
+        next.clear();
+        for (size_t k = 0; k < polygon.size(); k++) {
+            const ClipVertex& a = polygon[k];
+            const ClipVertex& b = polygon[(k + 1) % polygon.size()];
+            float da = inside(a), db = inside(b);
+            if (da >= 0.0f) next.push_back(a);
+            if ((da >= 0.0f) != (db >= 0.0f)) next.push_back(lerp(a, b, da / (da - db)));
+        }
+        polygon.swap(next);
+    }
+    for (size_t k = 1; k + 1 < polygon.size(); k++) {
+        ClipVertex tri[3] = { polygon[0], polygon[k], polygon[k + 1] };
+        AddTriangle(tri);
+    }
+}
+
+void CpuRenderDevice::AddTriangle(const ClipVertex* v) {
+    Triangle tri;
+    for (int k = 0; k < 3; k++) {
+        tri.x[k] = (int32_t)lroundf(v[k].x * SUBPIXEL);
+        tri.y[k] = (int32_t)lroundf(v[k].y * SUBPIXEL);
+        tri.color[k] = v[k].color;
+        tri.uv[k] = v[k].uv;
+    }
+
+    // Culling is off: wind every triangle the same way
+    int64_t area = (int64_t)(tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) -
+                   (int64_t)(tri.y[1] - tri.y[0]) * (tri.x[2] - tri.x[0]);
+    if (area == 0) return;
+    if (area < 0) {
+        std::swap(tri.x[1], tri.x[2]);
+        std::swap(tri.y[1], tri.y[2]);
+        std::swap(tri.color[1], tri.color[2]);
+        std::swap(tri.uv[1], tri.uv[2]);
+        area = -area;
+    }
+    tri.invArea = (float)(1.0 / (double)area);
+
+    // Pixels whose centres may be covered, clamped to the target
+    int32_t minX = std::min({ tri.x[0], tri.x[1], tri.x[2] });
+    int32_t maxX = std::max({ tri.x[0], tri.x[1], tri.x[2] });
+    int32_t minY = std::min({ tri.y[0], tri.y[1], tri.y[2] });
+    int32_t maxY = std::max({ tri.y[0], tri.y[1], tri.y[2] });
+    const int32_t half = SUBPIXEL / 2;
+    tri.minX = std::max(0, (int)((minX - half + SUBPIXEL - 1) >> SUBPIXEL_BITS));
+    tri.minY = std::max(0, (int)((minY - half + SUBPIXEL - 1) >> SUBPIXEL_BITS));
+    tri.maxX = std::min(m_target->GetWidth() - 1, (int)((maxX - half) >> SUBPIXEL_BITS));
+    tri.maxY = std::min(m_target->GetHeight() - 1, (int)((maxY - half) >> SUBPIXEL_BITS));
+    if (tri.minX > tri.maxX || tri.minY > tri.maxY) return;
+
+    tri.solid = tri.uv[0].x < 0.0f && tri.uv[1].x < 0.0f && tri.uv[2].x < 0.0f;
+    tri.flat = memcmp(&tri.color[0], &tri.color[1], sizeof(Vec4)) == 0 &&
+               memcmp(&tri.color[0], &tri.color[2], sizeof(Vec4)) == 0;
+    tri.texture = m_boundTexture;
+    m_triangles.push_back(tri);
+    m_trianglesDrawn++;
+}
+
+// ---- Rasterization ----
+
+void CpuRenderDevice::Flush() {
+    if (m_triangles.empty()) return;
+
+    // Bin every triangle to the tiles its bounds touch, in submission order
+    m_tilesX = (m_target->GetWidth() + TILE_SIZE - 1) / TILE_SIZE;
+    m_tilesY = (m_target->GetHeight() + TILE_SIZE - 1) / TILE_SIZE;
+    int tileCount = m_tilesX * m_tilesY;
+    if ((int)m_tileBins.size() < tileCount) m_tileBins.resize(tileCount);
+    for (int t = 0; t < tileCount; t++) m_tileBins[t].clear();
+    for (int i = 0; i < (int)m_triangles.size(); i++) {
+        const Triangle& tri = m_triangles[i];
+        for (int ty = tri.minY / TILE_SIZE; ty <= tri.maxY / TILE_SIZE; ty++) {
+            for (int tx = tri.minX / TILE_SIZE; tx <= tri.maxX / TILE_SIZE; tx++) {
+                m_tileBins[ty * m_tilesX + tx].push_back(i);
+            }
+        }
+    }
+
+    // Each tile is owned by one worker, so its pixels blend in order
+    if (m_pool) {
+        std::atomic<int> nextTile(0);
+        for (int w = 0; w < m_pool->GetThreadCount(); w++) {
+            m_pool->Submit([this, &nextTile, tileCount] {
+                for (int t; (t = nextTile.fetch_add(1, std::memory_order_relaxed)) < tileCount;) RasterizeTile(t);
+            });
+        }
+        m_pool->Wait();
+    } else {
+        for (int t = 0; t < tileCount; t++) RasterizeTile(t);
+    }
+    m_triangles.clear();
+}
+
+void CpuRenderDevice::RasterizeTile(int tile) {
+    const std::vector<int>& bin = m_tileBins[tile];
+    if (bin.empty()) return;
+    int x0 = (tile % m_tilesX) * TILE_SIZE;
+    int y0 = (tile / m_tilesX) * TILE_SIZE;
+    int x1 = std::min(x0 + TILE_SIZE, m_target->GetWidth()) - 1;
+    int y1 = std::min(y0 + TILE_SIZE, m_target->GetHeight()) - 1;
+    for (int index : bin) ShadeTriangle(m_triangles[index], x0, y0, x1, y1);
+}
+
+// Bilinear, wrap addressing, texel centres at half-integers (D3D11 sampling)
+static void SampleBilinear(const uint8_t* pixels, int width, int height, float u, float v, float out[4]) {
+    float tx = u * width - 0.5f;
+    float ty = v * height - 0.5f;
+    float fx = floorf(tx), fy = floorf(ty);
+    float ax = tx - fx, ay = ty - fy;
+    int ix = (int)fx % width, iy = (int)fy % height;
+    if (ix < 0) ix += width;
+    if (iy < 0) iy += height;
+    int ix1 = ix + 1 == width ? 0 : ix + 1;
+    int iy1 = iy + 1 == height ? 0 : iy + 1;
+    const uint8_t* p00 = pixels + ((size_t)iy * width + ix) * 4;
+    const uint8_t* p10 = pixels + ((size_t)iy * width + ix1) * 4;
+    const uint8_t* p01 = pixels + ((size_t)iy1 * width + ix) * 4;
+    const uint8_t* p11 = pixels + ((size_t)iy1 * width + ix1) * 4;
+    for (int c = 0; c < 4; c++) {
+        float top = p00[c] + (p10[c] - p00[c]) * ax;
+        float bottom = p01[c] + (p11[c] - p01[c]) * ax;
+        out[c] = (top + (bottom - top) * ay) * (1.0f / 255.0f);
+    }
+}
+
+void CpuRenderDevice::ShadeTriangle(const Triangle& tri, int x0, int y0, int x1, int y1) {
+    x0 = std::max(x0, tri.minX);
+    y0 = std::max(y0, tri.minY);
+    x1 = std::min(x1, tri.maxX);
+    y1 = std::min(y1, tri.maxY);
+    if (x0 > x1 || y0 > y1) return;
+
+    // Edge k runs from vertex k to k+1 and is >= 0 inside. Top-left rule:
+    // a pixel centre exactly on an edge belongs to the triangle only if the
+    // edge is a top edge (horizontal, interior below) or a left edge.
+    int64_t a[3], b[3], e[3];
+    const int64_t px = ((int64_t)x0 << SUBPIXEL_BITS) + SUBPIXEL / 2;
+    const int64_t py = ((int64_t)y0 << SUBPIXEL_BITS) + SUBPIXEL / 2;
+    for (int k = 0; k < 3; k++) {
+        int n = (k + 1) % 3;
+        int64_t dx = tri.x[n] - tri.x[k];
+        int64_t dy = tri.y[n] - tri.y[k];
+        bool topLeft = (dy == 0 && dx > 0) || dy < 0;
+        a[k] = -dy * SUBPIXEL;  // Change per pixel step in x
+        b[k] = dx * SUBPIXEL;   // Change per pixel step in y
+        e[k] = dx * (py - tri.y[k]) - dy * (px - tri.x[k]) - (topLeft ? 0 : 1);
+    }
+
+    const Texture* texture = tri.texture;
+    const int width = m_target->GetWidth();
+    uint8_t* rowBase = m_target->pixels.data();
+    for (int y = y0; y <= y1; y++) {
+        int64_t e0 = e[0], e1 = e[1], e2 = e[2];
+        uint8_t* dst = rowBase + ((size_t)y * width + x0) * 4;
+        for (int x = x0; x <= x1; x++, dst += 4, e0 += a[0], e1 += a[1], e2 += a[2]) {
+            if ((e0 | e1 | e2) < 0) continue;
+
+            // Barycentric weights: edge k is opposite vertex (k + 2) % 3
+            float w1 = (float)e2 * tri.invArea;
+            float w2 = (float)e0 * tri.invArea;
+            float w0 = 1.0f - w1 - w2;
+            float src[4] = { tri.color[0].x, tri.color[0].y, tri.color[0].z, tri.color[0].w };
+            if (!tri.flat) {
+                src[0] = tri.color[0].x * w0 + tri.color[1].x * w1 + tri.color[2].x * w2;
+                src[1] = tri.color[0].y * w0 + tri.color[1].y * w1 + tri.color[2].y * w2;
+                src[2] = tri.color[0].z * w0 + tri.color[1].z * w1 + tri.color[2].z * w2;
+                src[3] = tri.color[0].w * w0 + tri.color[1].w * w1 + tri.color[2].w * w2;
+            }
+            float u = tri.solid ? -1.0f : tri.uv[0].x * w0 + tri.uv[1].x * w1 + tri.uv[2].x * w2;
+            if (u >= 0.0f) {
+                // Texture mode: luminance as alpha, tinted by the vertex colour.
+                // An unbound texture samples as zero, like D3D11.
+                float texel[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                if (texture) {
+                    float v = tri.uv[0].y * w0 + tri.uv[1].y * w1 + tri.uv[2].y * w2;
+                    SampleBilinear(texture->pixels.data(), texture->GetWidth(), texture->GetHeight(), u, v, texel);
+                }
+                float alpha = texel[0] * 0.299f + texel[1] * 0.587f + texel[2] * 0.114f;
+                src[0] *= texel[0];
+                src[1] *= texel[1];
+                src[2] *= texel[2];
+                src[3] *= alpha;
+            }
+
+            // SRC_ALPHA / INV_SRC_ALPHA on colour, alpha replaced; UNORM
+            // targets clamp the shader output before blending
+            float sa = std::min(1.0f, std::max(0.0f, src[3]));
+            for (int c = 0; c < 3; c++) {
+                float s = std::min(1.0f, std::max(0.0f, src[c]));
+                dst[c] = ToUnorm8(s * sa + dst[c] * (1.0f / 255.0f) * (1.0f - sa));
+            }
+            dst[3] = ToUnorm8(sa);
+        }
+        e[0] += b[0];
+        e[1] += b[1];
+        e[2] += b[2];
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "RenderDevice.h"
+#include "VertexPacking.h"
+
+class WorkStealingPool;
+
+// Software RenderDevice for headless rendering (no GPU, any platform).
+// Draws are queued per render target and rasterized when something needs
+// the pixels (target switch, clear, copy, readback): the target is split
+// into tiles, triangles are binned to the tiles they touch, and worker
+// threads shade whole tiles in submission order, so blending matches a
+// single-threaded pass exactly. Pixel centres, the top-left fill rule and
+// 8-bit storage follow D3D11, so feedback effects decay the same way.
+class CpuRenderDevice : public RenderDevice {
+public:
+    static const int TILE_SIZE = 64;
+
+    CpuRenderDevice(int width, int height, int threads = 0);  // 0 = one per hardware thread
+    ~CpuRenderDevice() override;
+
+    int GetWidth() const override;
+    int GetHeight() const override;
+
+    RenderTexture* CreateRenderTexture(int width, int height) override;
+    void DestroyTexture(RenderTexture* texture) override;
+
+    Vertex* MapVertices(int count) override;
+    void UnmapVertices() override {}
+    void Draw(int vertexCount) override;
+    using RenderDevice::DrawSegments;
+    void DrawSegments(const Segment* segments, int count) override;
+
+    void SetRenderTarget(RenderTexture* target) override;
+    RenderTexture* GetRenderTarget() const override;
+    void Clear(const float color[4]) override;
+    void Copy(RenderTexture* dest, RenderTexture* source) override;
+    void BindTexture(RenderTexture* texture) override;
+
+    // Rasterizes queued draws and returns the texture's RGBA8 pixels, top row first
+    const uint8_t* ReadPixels(RenderTexture* texture = nullptr);
+    int GetThreadCount() const;
+    uint64_t GetTrianglesDrawn() const { return m_trianglesDrawn; }
+    uint64_t GetVerticesDrawn() const { return m_verticesDrawn; }
+    uint64_t GetSegmentsDrawn() const { return m_segmentsDrawn; }
+    // What D3D11RenderDevice would upload for the same draws
+    uint64_t GetUploadBytes() const {
+        return m_verticesDrawn * sizeof(PackedVertex) + m_segmentsDrawn * sizeof(PackedSegment);
+    }
+
+private:
+    class Texture;
+
+    // A queued triangle in target pixel space (1/256 pixel fixed point,
+    // wound so its edge functions are positive inside) with the texture it samples
+    struct Triangle {
+        int32_t x[3], y[3];
+        Vec4 color[3];
+        Vec2 uv[3];
+        float invArea;
+        bool solid;               // Every vertex solid: skip the per-pixel texCoord test
+        bool flat;                // One colour: skip interpolating it (exact, and cheaper)
+        const Texture* texture;
+        int minX, minY, maxX, maxY;  // Pixel bounds within the target, inclusive
+    };
+    struct ClipVertex;
+
+    Texture* Resolve(RenderTexture* texture) const;
+    void AddTriangles(int vertexCount);  // From m_vertices, already quantized
+    void AddTriangle(const ClipVertex* v);
+    void AddClipped(const ClipVertex* v);
+    void Flush();
+    void RasterizeTile(int tile);
+    void ShadeTriangle(const Triangle& tri, int x0, int y0, int x1, int y1);
+
+    std::unique_ptr<Texture> m_backBuffer;
+    Texture* m_target;
+    Texture* m_boundTexture = nullptr;
+    std::vector<Vertex> m_vertices;
+    std::vector<PackedVertex> m_packed;
+    std::vector<Segment> m_segments;
+    std::vector<PackedSegment> m_packedSegments;
+
+    std::vector<Triangle> m_triangles;           // Queued for m_target
+    std::vector<std::vector<int>> m_tileBins;    // Triangle indices per tile
+    int m_tilesX = 0, m_tilesY = 0;
+    std::unique_ptr<WorkStealingPool> m_pool;    // nullptr when single-threaded
+    uint64_t m_trianglesDrawn = 0;
+    uint64_t m_verticesDrawn = 0;
+    uint64_t m_segmentsDrawn = 0;
+};
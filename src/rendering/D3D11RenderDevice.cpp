@@ -0,0 +1,460 @@
+#include "D3D11RenderDevice.h"
+#include <d3dcompiler.h>
+#include <algorithm>
+#include <iostream>
+
+// Simple Shaders
+static const char* VS_SRC = R"(
+// PackedVertex: fixed-point position, SNORM16 texCoord, UNORM16 colour
+struct VS_INPUT {
+    int2 pos : POSITION;
+    float2 tex : TEXCOORD;
+    float4 col : COLOR;
+};
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float4 col : COLOR;
+    float2 tex : TEXCOORD;
+};
+PS_INPUT main(VS_INPUT input) {
+    PS_INPUT output;
+    output.pos = float4(float2(input.pos) * (1.0 / 8192.0), 0.0, 1.0);
+    output.col = input.col;
+    output.tex = input.tex;
+    return output;
+}
+)";
+
+// PackedSegment instances: each is drawn as 6 vertices, expanded into the
+// two triangles ExpandSegments makes (SV_VertexID picks the corner)
+static const char* SEGMENT_VS_SRC = R"(
+struct VS_INPUT {
+    int4 ends : ENDPOINTS;
+    float4 col : COLOR;
+    float thickness : THICKNESS;
+    uint corner : SV_VertexID;
+};
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float4 col : COLOR;
+    float2 tex : TEXCOORD;
+};
+// x: 0 = p0, 1 = p1; y: side of the line
+static const float2 CORNERS[6] = {
+    float2(0, 1), float2(1, 1), float2(0, -1), float2(1, 1), float2(1, -1), float2(0, -1)
+};
+PS_INPUT main(VS_INPUT input) {
+    float2 p0 = float2(input.ends.xy) * (1.0 / 8192.0);
+    float2 p1 = float2(input.ends.zw) * (1.0 / 8192.0);
+    float2 d = p1 - p0;
+    float len = length(d);
+    // Too short: zero width, so nothing is rasterized
+    float2 perp = len >= 0.0001 ? float2(-d.y, d.x) / len * input.thickness : float2(0, 0);
+    float2 corner = CORNERS[input.corner];
+    PS_INPUT output;
+    output.pos = float4((corner.x > 0.5 ? p1 : p0) + perp * corner.y, 0.0, 1.0);
+    output.col = input.col;
+    output.tex = float2(-1.0, -1.0);
+    return output;
+}
+)";
+
+static const char* PS_SRC = R"(
+Texture2D tex : register(t0);
+SamplerState sam : register(s0);
+
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float4 col : COLOR;
+    float2 tex : TEXCOORD;
+};
+float4 main(PS_INPUT input) : SV_Target {
+    if (input.tex.x < 0) return input.col; // Solid color mode
+
+    // Texture mode (OSD)
+    float4 texColor = tex.Sample(sam, input.tex);
+    // GDI doesn't write alpha correctly, so we use luminance as alpha
+    // This assumes white text on black background
+    float alpha = dot(texColor.rgb, float3(0.299, 0.587, 0.114));
+    return float4(texColor.rgb, alpha) * input.col;
+}
+)";
+
+class D3D11RenderDevice::Texture : public RenderTexture {
+public:
+    Texture(int width, int height) {
+        m_width = width;
+        m_height = height;
+    }
+    ~Texture() override {
+        if (srv) srv->Release();
+        if (rtv) rtv->Release();
+        if (texture) texture->Release();
+    }
+    ID3D11Texture2D* texture = nullptr;
+    ID3D11ShaderResourceView* srv = nullptr;
+    ID3D11RenderTargetView* rtv = nullptr;
+};
+
+// Forwards the state calls the cache lets through to the context
+class D3D11RenderDevice::ContextState : public StateContext {
+public:
+    explicit ContextState(ID3D11DeviceContext* context) : m_context(context) {}
+
+    void SetVertexBuffer(ID3D11Buffer* buffer, unsigned stride) override {
+        UINT offset = 0;
+        m_context->IASetVertexBuffers(0, 1, &buffer, &stride, &offset);
+    }
+    void SetInputLayout(ID3D11InputLayout* layout) override { m_context->IASetInputLayout(layout); }
+    void SetTopology(int topology) override { m_context->IASetPrimitiveTopology((D3D11_PRIMITIVE_TOPOLOGY)topology); }
+    void SetVertexShader(ID3D11VertexShader* shader) override { m_context->VSSetShader(shader, NULL, 0); }
+    void SetPixelShader(ID3D11PixelShader* shader) override { m_context->PSSetShader(shader, NULL, 0); }
+    void SetRenderTarget(ID3D11RenderTargetView* rtv, int width, int height) override {
+        m_context->OMSetRenderTargets(1, &rtv, NULL);
+        D3D11_VIEWPORT viewport = {};
+        viewport.Width = (float)width;
+        viewport.Height = (float)height;
+        viewport.MaxDepth = 1.0f;
+        m_context->RSSetViewports(1, &viewport);
+    }
+    void SetShaderResource(ID3D11ShaderResourceView* srv) override { m_context->PSSetShaderResources(0, 1, &srv); }
+    void SetBlendState(ID3D11BlendState* state) override { m_context->OMSetBlendState(state, NULL, 0xffffffff); }
+    void SetSampler(ID3D11SamplerState* sampler) override { m_context->PSSetSamplers(0, 1, &sampler); }
+    void SetRasterizerState(ID3D11RasterizerState* state) override { m_context->RSSetState(state); }
+
+private:
+    ID3D11DeviceContext* m_context;
+};
+
+D3D11RenderDevice::~D3D11RenderDevice() {
+    if (m_mapped) m_context->Unmap(m_vertexBuffer, 0);
+    if (m_mappedSegments) m_context->Unmap(m_segmentBuffer, 0);
+    if (m_rasterizerState) m_rasterizerState->Release();
+    if (m_samplerState) m_samplerState->Release();
+    if (m_blendState) m_blendState->Release();
+    if (m_vertexBuffer) m_vertexBuffer->Release();
+    if (m_inputLayout) m_inputLayout->Release();
+    if (m_vertexShader) m_vertexShader->Release();
+    if (m_segmentBuffer) m_segmentBuffer->Release();
+    if (m_segmentLayout) m_segmentLayout->Release();
+    if (m_segmentShader) m_segmentShader->Release();
+    if (m_pixelShader) m_pixelShader->Release();
+}
+
+bool D3D11RenderDevice::Initialize(ID3D11Device* device, ID3D11DeviceContext* context,
+                                   ID3D11RenderTargetView* backBuffer, int width, int height) {
+    m_device = device;
+    m_context = context;
+    m_backBuffer = backBuffer;
+    m_width = width;
+    m_height = height;
+    m_contextState = std::make_unique<ContextState>(context);
+    m_stateCache.SetContext(m_contextState.get());
+
+    // Create Rasterizer State (Disable Culling)
+    D3D11_RASTERIZER_DESC rasterDesc = {};
+    rasterDesc.AntialiasedLineEnable = FALSE;
+    rasterDesc.CullMode = D3D11_CULL_NONE;
+    rasterDesc.DepthBias = 0;
+    rasterDesc.DepthBiasClamp = 0.0f;
+    rasterDesc.DepthClipEnable = TRUE;
+    rasterDesc.FillMode = D3D11_FILL_SOLID;
+    rasterDesc.FrontCounterClockwise = FALSE;
+    rasterDesc.MultisampleEnable = FALSE;
+    rasterDesc.ScissorEnable = FALSE;
+    rasterDesc.SlopeScaledDepthBias = 0.0f;
+
+    m_device->CreateRasterizerState(&rasterDesc, &m_rasterizerState);
+    m_stateCache.SetRasterizerState(m_rasterizerState);
+
+    // Compile Shaders
+    ID3DBlob* vsBlob = nullptr;
+    ID3DBlob* psBlob = nullptr;
+    D3DCompile(VS_SRC, strlen(VS_SRC), NULL, NULL, NULL, "main", "vs_4_0", 0, 0, &vsBlob, NULL);
+    D3DCompile(PS_SRC, strlen(PS_SRC), NULL, NULL, NULL, "main", "ps_4_0", 0, 0, &psBlob, NULL);
+    if (!vsBlob || !psBlob) {
+        std::cerr << "Failed to compile shaders" << std::endl;
+        if (vsBlob) vsBlob->Release();
+        if (psBlob) psBlob->Release();
+        return false;
+    }
+
+    m_device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), NULL, &m_vertexShader);
+    m_device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), NULL, &m_pixelShader);
+
+    D3D11_INPUT_ELEMENT_DESC ied[] = {
+        {"POSITION", 0, DXGI_FORMAT_R16G16_SINT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TEXCOORD", 0, DXGI_FORMAT_R16G16_SNORM, 0, 4, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"COLOR", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0},
+    };
+    m_device->CreateInputLayout(ied, 3, vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &m_inputLayout);
+    vsBlob->Release();
+    psBlob->Release();
+
+    // Segment shader and its per-instance layout
+    ID3DBlob* segmentBlob = nullptr;
+    D3DCompile(SEGMENT_VS_SRC, strlen(SEGMENT_VS_SRC), NULL, NULL, NULL, "main", "vs_4_0", 0, 0, &segmentBlob, NULL);
+    if (!segmentBlob) {
+        std::cerr << "Failed to compile segment shader" << std::endl;
+        return false;
+    }
+    m_device->CreateVertexShader(segmentBlob->GetBufferPointer(), segmentBlob->GetBufferSize(), NULL, &m_segmentShader);
+    D3D11_INPUT_ELEMENT_DESC segmentIed[] = {
+        {"ENDPOINTS", 0, DXGI_FORMAT_R16G16B16A16_SINT, 0, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+        {"COLOR", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 8, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+        {"THICKNESS", 0, DXGI_FORMAT_R32_FLOAT, 0, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+    };
+    m_device->CreateInputLayout(segmentIed, 3, segmentBlob->GetBufferPointer(), segmentBlob->GetBufferSize(), &m_segmentLayout);
+    segmentBlob->Release();
+
+    // Create Dynamic Vertex Buffer
+    D3D11_BUFFER_DESC bd = {0};
+    bd.Usage = D3D11_USAGE_DYNAMIC;
+    bd.ByteWidth = sizeof(PackedVertex) * MAX_VERTICES; // Enough for complex visualizations
+    bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    m_device->CreateBuffer(&bd, NULL, &m_vertexBuffer);
+    bd.ByteWidth = sizeof(PackedSegment) * MAX_SEGMENTS;
+    m_device->CreateBuffer(&bd, NULL, &m_segmentBuffer);
+
+    // Create Blend State for Alpha Blending (Text)
+    D3D11_BLEND_DESC blendDesc = {0};
+    blendDesc.RenderTarget[0].BlendEnable = TRUE;
+    blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+    blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
+    blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+    m_device->CreateBlendState(&blendDesc, &m_blendState);
+
+    // Create Sampler State
+    D3D11_SAMPLER_DESC sampDesc;
+    ZeroMemory(&sampDesc, sizeof(sampDesc));
+    sampDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    sampDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
+    sampDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
+    sampDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+    sampDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+    sampDesc.MinLOD = 0;
+    sampDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    m_device->CreateSamplerState(&sampDesc, &m_samplerState);
+
+    return m_vertexShader && m_pixelShader && m_inputLayout && m_vertexBuffer && m_segmentShader &&
+           m_segmentLayout && m_segmentBuffer && m_blendState && m_samplerState;
+}
+
+void D3D11RenderDevice::SetBackBuffer(ID3D11RenderTargetView* backBuffer, int width, int height) {
+    m_backBuffer = backBuffer;
+    m_width = width;
+    m_height = height;
+    m_stateCache.Invalidate();
+}
+
+void D3D11RenderDevice::BeginFrame() {
+    StateCache::Counters state = m_stateCache.GetTotals();
+    m_stats.stateCalls = state.issued;
+    m_stats.stateElided = state.elided;
+    m_lastStats = m_stats;
+    m_stats = FrameStats();
+    m_stateCache.ResetCounters();
+
+    SetRenderTarget(nullptr);
+    BindShaderResource(nullptr);
+    m_stateCache.SetBlendState(m_blendState);
+    m_stateCache.SetSampler(m_samplerState);
+}
+
+void D3D11RenderDevice::EndFrame() {
+    Flush();
+    // The OSD textures are drawn into with GDI next frame; leave them unbound
+    ApplyShaderResource(nullptr);
+}
+
+void D3D11RenderDevice::BindShaderResource(ID3D11ShaderResourceView* srv) {
+    m_srv = srv;
+}
+
+RenderTexture* D3D11RenderDevice::CreateRenderTexture(int width, int height) {
+    D3D11_TEXTURE2D_DESC desc = {0};
+    desc.Width = width;
+    desc.Height = height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+
+    Texture* texture = new Texture(width, height);
+    if (FAILED(m_device->CreateTexture2D(&desc, NULL, &texture->texture)) ||
+        FAILED(m_device->CreateShaderResourceView(texture->texture, NULL, &texture->srv)) ||
+        FAILED(m_device->CreateRenderTargetView(texture->texture, NULL, &texture->rtv))) {
+        std::cerr << "Failed to create " << width << "x" << height << " render texture" << std::endl;
+        delete texture;
+        return nullptr;
+    }
+    return texture;
+}
+
+void D3D11RenderDevice::DestroyTexture(RenderTexture* texture) {
+    if (!texture) return;
+    Flush();  // Recorded draws may use it
+    Texture* t = static_cast<Texture*>(texture);
+    if (m_target == texture) SetRenderTarget(nullptr);
+    if (m_srv == t->srv) m_srv = nullptr;
+    if (m_stateCache.GetShaderResource() == t->srv) ApplyShaderResource(nullptr);
+    // A texture created later may get the same view addresses
+    m_stateCache.Forget(t->rtv);
+    m_stateCache.Forget(t->srv);
+    delete t;
+}
+
+Vertex* D3D11RenderDevice::MapVertices(int count) {
+    if (count < 0 || count > MAX_VERTICES) return nullptr;
+    if (m_ringPosition + count > MAX_VERTICES) {
+        // Wrap: the recorded draws still need the old contents, so submit
+        // them before the discard hands us a fresh buffer
+        Flush();
+        D3D11_MAPPED_SUBRESOURCE ms;
+        if (FAILED(m_context->Map(m_vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &ms))) return nullptr;
+        m_mapped = (PackedVertex*)ms.pData;
+        m_ringPosition = 0;
+        m_stats.maps++;
+        m_stats.discards++;
+    } else if (!m_mapped) {
+        // Append; the GPU may still be reading the vertices before m_ringPosition
+        D3D11_MAPPED_SUBRESOURCE ms;
+        if (FAILED(m_context->Map(m_vertexBuffer, 0, D3D11_MAP_WRITE_NO_OVERWRITE, 0, &ms))) return nullptr;
+        m_mapped = (PackedVertex*)ms.pData;
+        m_stats.maps++;
+    }
+    m_rangeStart = m_ringPosition;
+    m_rangeCount = count;
+    return m_staging.data();
+}
+
+void D3D11RenderDevice::UnmapVertices() {
+    // Pack into the ring, which stays mapped until the batch is submitted
+    if (!m_mapped) return;
+    PackVertices(m_staging.data(), m_mapped + m_rangeStart, m_rangeCount);
+    m_ringPosition = m_rangeStart + m_rangeCount;
+    m_stats.bytes += m_rangeCount * (int)sizeof(PackedVertex);
+}
+
+void D3D11RenderDevice::Draw(int vertexCount) {
+    int count = std::min(vertexCount, m_rangeCount);
+    if (count <= 0) return;
+    m_batch.push_back({ m_target, m_srv, Pipeline_Vertices, m_rangeStart, count });
+    m_stats.draws++;
+    m_stats.vertices += count;
+}
+
+void D3D11RenderDevice::DrawSegments(const Segment* segments, int count) {
+    while (count > 0) {
+        int n = std::min(count, MAX_SEGMENTS);
+        if (m_segmentPosition + n > MAX_SEGMENTS) {
+            // Wrap, as in MapVertices
+            Flush();
+            D3D11_MAPPED_SUBRESOURCE ms;
+            if (FAILED(m_context->Map(m_segmentBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &ms))) return;
+            m_mappedSegments = (PackedSegment*)ms.pData;
+            m_segmentPosition = 0;
+            m_stats.maps++;
+            m_stats.discards++;
+        } else if (!m_mappedSegments) {
+            D3D11_MAPPED_SUBRESOURCE ms;
+            if (FAILED(m_context->Map(m_segmentBuffer, 0, D3D11_MAP_WRITE_NO_OVERWRITE, 0, &ms))) return;
+            m_mappedSegments = (PackedSegment*)ms.pData;
+            m_stats.maps++;
+        }
+        // Packed straight into the ring; the instances need no staging
+        PackSegments(segments, m_mappedSegments + m_segmentPosition, n);
+        m_batch.push_back({ m_target, m_srv, Pipeline_Segments, m_segmentPosition, n });
+        m_segmentPosition += n;
+        m_stats.draws++;
+        m_stats.segments += n;
+        m_stats.bytes += n * (int)sizeof(PackedSegment);
+        segments += n;
+        count -= n;
+    }
+}
+
+void D3D11RenderDevice::SetRenderTarget(RenderTexture* target) {
+    m_target = target;
+}
+
+void D3D11RenderDevice::Clear(const float color[4]) {
+    Flush();
+    m_context->ClearRenderTargetView(TargetView(m_target), color);
+}
+
+void D3D11RenderDevice::Copy(RenderTexture* dest, RenderTexture* source) {
+    if (!dest || !source) return;  // The back buffer is never copied
+    Flush();
+    m_context->CopyResource(static_cast<Texture*>(dest)->texture, static_cast<Texture*>(source)->texture);
+}
+
+void D3D11RenderDevice::BindTexture(RenderTexture* texture) {
+    BindShaderResource(texture ? static_cast<Texture*>(texture)->srv : nullptr);
+}
+
+ID3D11RenderTargetView* D3D11RenderDevice::TargetView(RenderTexture* target) const {
+    return target ? static_cast<Texture*>(target)->rtv : m_backBuffer;
+}
+
+void D3D11RenderDevice::ApplyTarget(RenderTexture* target) {
+    // A texture can't be read and written at once; D3D11 would silently
+    // unbind the input, so do it here and keep the cache honest
+    if (target && m_stateCache.GetShaderResource() == static_cast<Texture*>(target)->srv) {
+        ApplyShaderResource(nullptr);
+    }
+    m_stateCache.SetRenderTarget(TargetView(target), target ? target->GetWidth() : m_width,
+                                 target ? target->GetHeight() : m_height);
+}
+
+void D3D11RenderDevice::ApplyShaderResource(ID3D11ShaderResourceView* srv) {
+    m_stateCache.SetShaderResource(srv);
+}
+
+void D3D11RenderDevice::ApplyPipeline(Pipeline pipeline) {
+    bool segments = pipeline == Pipeline_Segments;
+    m_stateCache.SetTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    m_stateCache.SetVertexBuffer(segments ? m_segmentBuffer : m_vertexBuffer,
+                                 segments ? sizeof(PackedSegment) : sizeof(PackedVertex));
+    m_stateCache.SetInputLayout(segments ? m_segmentLayout : m_inputLayout);
+    m_stateCache.SetVertexShader(segments ? m_segmentShader : m_vertexShader);
+    m_stateCache.SetPixelShader(m_pixelShader);
+}
+
+void D3D11RenderDevice::Flush() {
+    if (m_mapped) {
+        m_context->Unmap(m_vertexBuffer, 0);
+        m_mapped = nullptr;
+    }
+    if (m_mappedSegments) {
+        m_context->Unmap(m_segmentBuffer, 0);
+        m_mappedSegments = nullptr;
+    }
+    if (m_batch.empty()) return;
+
+    for (size_t i = 0; i < m_batch.size();) {
+        // Merge the run of draws with the same state over adjacent vertices
+        DrawCommand run = m_batch[i++];
+        while (i < m_batch.size() && m_batch[i].target == run.target && m_batch[i].srv == run.srv &&
+               m_batch[i].pipeline == run.pipeline && m_batch[i].start == run.start + run.count) {
+            run.count += m_batch[i++].count;
+        }
+        ApplyTarget(run.target);
+        ApplyShaderResource(run.srv);
+        ApplyPipeline(run.pipeline);
+        if (run.pipeline == Pipeline_Segments) {
+            m_context->DrawInstanced(6, (UINT)run.count, 0, (UINT)run.start);
+        } else {
+            m_context->Draw((UINT)run.count, (UINT)run.start);
+        }
+        m_stats.drawCalls++;
+    }
+    m_batch.clear();
+}
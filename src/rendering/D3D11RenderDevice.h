@@ -0,0 +1,143 @@
+#pragma once
+#include <d3d11.h>
+#include <memory>
+#include <vector>
+#include "RenderDevice.h"
+#include "StateCache.h"
+#include "VertexPacking.h"
+
+// RenderDevice on the app's D3D11 context. Owns the shared pipeline: the
+// dynamic vertex buffer, input layout, shaders, blend, sampler and
+// rasterizer state. The device, context and back buffer belong to the
+// Renderer.
+//
+// Vertices are packed to 16 bytes (VertexPacking.h) as they are unmapped.
+// The vertex buffer is a ring: MapVertices appends behind the previous
+// vertices with MAP_WRITE_NO_OVERWRITE and only discards when the ring
+// wraps. The buffer stays mapped while a batch is recorded; Draw records
+// the range with the current target and texture, and Flush unmaps once
+// and submits the batch, merging consecutive draws that share state and
+// setting only state that changed. Draws keep their order, since each one
+// blends over the ones before it.
+//
+// Segments take a second ring of 20-byte instances (PackedSegment) and a
+// second vertex shader that expands each one from SV_VertexID into the
+// quad ExpandSegments builds, one DrawInstanced per run. They go into the
+// same batch as vertex draws, so order is kept across both.
+//
+// All pipeline state goes through a StateCache, which drops calls that
+// would bind what is already bound and counts both kinds per frame.
+class D3D11RenderDevice : public RenderDevice {
+public:
+    // Per-frame counters for the Info OSD
+    struct FrameStats {
+        int maps = 0;       // Map calls on the vertex buffer
+        int discards = 0;   // Of those, ring wraps (MAP_WRITE_DISCARD)
+        int draws = 0;      // Draw() calls recorded
+        int drawCalls = 0;  // Draw calls submitted to the context after merging
+        int vertices = 0;
+        int segments = 0;   // Segment instances
+        int bytes = 0;      // Vertex and instance data uploaded
+        int stateCalls = 0;   // Pipeline state set on the context
+        int stateElided = 0;  // State calls the cache dropped as redundant
+    };
+
+    // Segment instances per ring
+    static const int MAX_SEGMENTS = MAX_VERTICES / 6;
+
+    D3D11RenderDevice() : m_staging(MAX_VERTICES) {}
+    ~D3D11RenderDevice() override;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context,
+                    ID3D11RenderTargetView* backBuffer, int width, int height);
+
+    // The swap chain was resized; call between frames, after the old view
+    // is released and before the new one is used. The cached state is
+    // dropped, since the caller unbound the old view on the context.
+    void SetBackBuffer(ID3D11RenderTargetView* backBuffer, int width, int height);
+
+    // Binds the back buffer and the blend and sampler state
+    void BeginFrame();
+    // Submits the frame's batch; call before Present
+    void EndFrame();
+    // Binds a texture the Renderer owns (background, OSD text)
+    void BindShaderResource(ID3D11ShaderResourceView* srv);
+    // Counters of the last completed frame
+    const FrameStats& GetFrameStats() const { return m_lastStats; }
+
+    int GetWidth() const override { return m_width; }
+    int GetHeight() const override { return m_height; }
+
+    RenderTexture* CreateRenderTexture(int width, int height) override;
+    void DestroyTexture(RenderTexture* texture) override;
+
+    Vertex* MapVertices(int count) override;
+    void UnmapVertices() override;
+    void Draw(int vertexCount) override;
+    using RenderDevice::DrawSegments;
+    void DrawSegments(const Segment* segments, int count) override;
+
+    void SetRenderTarget(RenderTexture* target) override;
+    RenderTexture* GetRenderTarget() const override { return m_target; }
+    void Clear(const float color[4]) override;
+    void Copy(RenderTexture* dest, RenderTexture* source) override;
+    void BindTexture(RenderTexture* texture) override;
+
+private:
+    class Texture;
+    class ContextState;
+
+    enum Pipeline { Pipeline_Vertices, Pipeline_Segments };
+
+    // A recorded draw: vertex or instance range plus the state it needs
+    struct DrawCommand {
+        RenderTexture* target;           // nullptr = back buffer
+        ID3D11ShaderResourceView* srv;
+        Pipeline pipeline;
+        int start;
+        int count;
+    };
+
+    void Flush();
+    void ApplyPipeline(Pipeline pipeline);
+    ID3D11RenderTargetView* TargetView(RenderTexture* target) const;
+    void ApplyTarget(RenderTexture* target);
+    void ApplyShaderResource(ID3D11ShaderResourceView* srv);
+
+    ID3D11Device* m_device = nullptr;
+    ID3D11DeviceContext* m_context = nullptr;
+    ID3D11RenderTargetView* m_backBuffer = nullptr;
+    int m_width = 0;
+    int m_height = 0;
+    RenderTexture* m_target = nullptr;  // nullptr = back buffer
+    ID3D11ShaderResourceView* m_srv = nullptr;
+
+    // Vertex ring and the batch recorded into it
+    std::vector<Vertex> m_staging;      // Filled by the caller, packed on unmap
+    PackedVertex* m_mapped = nullptr;   // Whole ring while mapped
+    int m_ringPosition = MAX_VERTICES;  // First free vertex; full until the first discard
+    int m_rangeStart = 0;               // Last range handed out by MapVertices
+    int m_rangeCount = 0;
+    // Segment instance ring, mapped alongside
+    PackedSegment* m_mappedSegments = nullptr;
+    int m_segmentPosition = MAX_SEGMENTS;
+    std::vector<DrawCommand> m_batch;
+
+    // What the context has bound, so unchanged state is not set again
+    std::unique_ptr<ContextState> m_contextState;
+    StateCache m_stateCache;
+
+    FrameStats m_stats;
+    FrameStats m_lastStats;
+
+    ID3D11VertexShader* m_vertexShader = nullptr;
+    ID3D11PixelShader* m_pixelShader = nullptr;
+    ID3D11InputLayout* m_inputLayout = nullptr;
+    ID3D11Buffer* m_vertexBuffer = nullptr;
+    ID3D11VertexShader* m_segmentShader = nullptr;
+    ID3D11InputLayout* m_segmentLayout = nullptr;
+    ID3D11Buffer* m_segmentBuffer = nullptr;
+    ID3D11BlendState* m_blendState = nullptr;
+    ID3D11SamplerState* m_samplerState = nullptr;
+    ID3D11RasterizerState* m_rasterizerState = nullptr;
+};
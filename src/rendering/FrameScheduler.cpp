@@ -0,0 +1,80 @@
+#include "FrameScheduler.h"
+#include <chrono>
+#include <thread>
+
+double SystemFrameClock::Now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SystemFrameClock::Sleep(double seconds) {
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+}
+
+FrameScheduler::FrameScheduler(FrameClock* clock)
+    : m_clock(clock ? clock : &m_systemClock) {
+}
+
+void FrameScheduler::SetMode(Mode mode, float targetFps) {
+    m_mode = mode;
+    if (targetFps > 0.0f) m_targetFps = targetFps;
+    m_nextSlot = -1.0;  // Start a new grid from the next frame
+}
+
+float FrameScheduler::BeginFrame() {
+    double now = m_clock->Now();
+    if (m_mode == Mode::Fixed && m_nextSlot >= 0.0 && now < m_nextSlot) {
+        WaitUntil(m_nextSlot);
+        double woke = m_clock->Now();
+        m_waitSum += woke - now;
+        now = woke;
+    }
+
+    if (m_mode == Mode::Fixed) {
+        // Stay on the grid unless this frame is more than half a slot late
+        double period = 1.0 / m_targetFps;
+        bool onGrid = m_nextSlot >= 0.0 && now - m_nextSlot < period * 0.5;
+        m_nextSlot = onGrid ? m_nextSlot + period : now + period;
+    }
+
+    // Close the stats window
+    if (m_windowStart < 0.0) {
+        m_windowStart = now;
+    } else if (now - m_windowStart >= 1.0 && m_windowFrames > 0) {
+        double n = m_windowFrames;
+        m_stats.fps = (float)(n / (now - m_windowStart));
+        m_stats.cpuMs = (float)(m_cpuSum / n * 1000.0);
+        m_stats.presentMs = (float)(m_presentSum / n * 1000.0);
+        m_stats.waitMs = (float)(m_waitSum / n * 1000.0);
+        m_windowStart = now;
+        m_windowFrames = 0;
+        m_cpuSum = m_presentSum = m_waitSum = 0.0;
+    }
+
+    float delta = m_frameStart < 0.0 ? 0.0f : (float)(now - m_frameStart);
+    if (m_firstFrameStart < 0.0) m_firstFrameStart = now;
+    m_frameStart = now;
+    m_frameCount++;
+    return delta;
+}
+
+void FrameScheduler::BeginPresent() {
+    m_presentStart = m_clock->Now();
+    m_cpuSum += m_presentStart - m_frameStart;
+}
+
+void FrameScheduler::EndPresent() {
+    m_presentSum += m_clock->Now() - m_presentStart;
+    m_windowFrames++;
+}
+
+double FrameScheduler::GetElapsed() const {
+    return m_firstFrameStart < 0.0 ? 0.0 : m_clock->Now() - m_firstFrameStart;
+}
+
+void FrameScheduler::WaitUntil(double deadline) {
+    double remaining = deadline - m_clock->Now();
+    if (remaining > SPIN_MARGIN) m_clock->Sleep(remaining - SPIN_MARGIN);
+    while (m_clock->Now() < deadline) {
+        // Spin the last stretch; sleeps can't be trusted below the timer granularity
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+// Time source for FrameScheduler. The system clock reads steady_clock and
+// sleeps the thread; tests substitute a fake one.
+class FrameClock {
+public:
+    virtual ~FrameClock() = default;
+    virtual double Now() = 0;                // Seconds, monotonic
+    virtual void Sleep(double seconds) = 0;  // May oversleep by the OS timer granularity
+};
+
+class SystemFrameClock : public FrameClock {
+public:
+    double Now() override;
+    void Sleep(double seconds) override;
+};
+
+// Paces the render loop and measures where each frame's time goes.
+//  VSync:    Present waits for the display (sync interval 1); no sleeping.
+//  Fixed:    frames start on a fixed grid at the target rate. The thread
+//            sleeps until SPIN_MARGIN before the slot, then spins, so OS
+//            timer granularity doesn't show as jitter. A frame that misses
+//            its slot starts at once and the grid restarts from it, rather
+//            than rushing to catch up.
+//  Uncapped: no waiting at all (sync interval 0); for benchmarking.
+// CPU time (frame start to Present) and present time (blocked in Present)
+// are measured separately and averaged over about a second.
+class FrameScheduler {
+public:
+    enum class Mode { VSync, Fixed, Uncapped };
+
+    // Sleeping stops this far before a fixed-mode slot; the rest is spun
+    static constexpr double SPIN_MARGIN = 0.002;
+
+    struct Stats {
+        float fps = 0.0f;
+        float cpuMs = 0.0f;      // Frame start to Present
+        float presentMs = 0.0f;  // Blocked in Present
+        float waitMs = 0.0f;     // Sleeping and spinning for the next slot
+    };
+
+    explicit FrameScheduler(FrameClock* clock = nullptr);  // nullptr = SystemFrameClock
+
+    void SetMode(Mode mode, float targetFps = 60.0f);
+    Mode GetMode() const { return m_mode; }
+    float GetTargetFps() const { return m_targetFps; }
+    // For IDXGISwapChain::Present
+    int GetSyncInterval() const { return m_mode == Mode::VSync ? 1 : 0; }
+
+    // Waits for the next frame slot (Fixed mode) and returns the real time
+    // since the previous frame started; 0 on the first frame
+    float BeginFrame();
+    // Bracket the Present call
+    void BeginPresent();
+    void EndPresent();
+
+    // Averages over the last completed window (about a second)
+    const Stats& GetStats() const { return m_stats; }
+    // Frames begun since construction, and seconds since the first one
+    long long GetFrameCount() const { return m_frameCount; }
+    double GetElapsed() const;
+
+private:
+    void WaitUntil(double deadline);
+
+    SystemFrameClock m_systemClock;
+    FrameClock* m_clock;
+    Mode m_mode = Mode::VSync;
+    float m_targetFps = 60.0f;
+
+    double m_firstFrameStart = -1.0;
+    double m_frameStart = -1.0;   // Current frame, after any wait
+    double m_nextSlot = -1.0;     // Fixed mode
+    double m_presentStart = 0.0;
+    long long m_frameCount = 0;
+
+    // Running sums for the current window
+    double m_windowStart = -1.0;
+    int m_windowFrames = 0;
+    double m_cpuSum = 0.0;
+    double m_presentSum = 0.0;
+    double m_waitSum = 0.0;
+    Stats m_stats;
+};
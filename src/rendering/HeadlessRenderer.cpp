@@ -0,0 +1,205 @@
+#include "HeadlessRenderer.h"
+#include "CpuRenderDevice.h"
+#include "RenderScale.h"
+#include "SpectrumAnalyzer.h"
+#include "WavReader.h"
+#include "../visualizations/SpectrumVis.h"
+#include "../visualizations/CyberValley2Vis.h"
+#include "../visualizations/LineFaderVis.h"
+#include "../visualizations/Spectrum2Vis.h"
+#include "../visualizations/CircleVis.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+bool WriteBmp(const std::string& path, const uint8_t* rgba, int width, int height) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+
+    // Rows are BGR, bottom-up and padded to 4 bytes
+    int rowSize = (width * 3 + 3) & ~3;
+    uint32_t imageSize = (uint32_t)rowSize * height;
+    uint8_t header[54] = { 'B', 'M' };
+    auto put32 = [&](int offset, uint32_t value) {
+        for (int i = 0; i < 4; i++) header[offset + i] = (uint8_t)(value >> (8 * i));
+    };
+    put32(2, 54 + imageSize);
+    put32(10, 54);
+    put32(14, 40);
+    put32(18, (uint32_t)width);
+    put32(22, (uint32_t)height);
+    header[26] = 1;   // Planes
+    header[28] = 24;  // Bits per pixel
+    put32(34, imageSize);
+    file.write((const char*)header, sizeof(header));
+
+    std::vector<uint8_t> row(rowSize, 0);
+    for (int y = height - 1; y >= 0; y--) {
+        const uint8_t* src = rgba + (size_t)y * width * 4;
+        for (int x = 0; x < width; x++) {
+            row[x * 3 + 0] = src[x * 4 + 2];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 0];
+        }
+        file.write((const char*)row.data(), rowSize);
+    }
+    return (bool)file;
+}
+
+// Two seconds of a bass pulse at 120 BPM over a chord and a hi-hat, looped
+static void SynthesizeTestSignal(WavData& out) {
+    out.sampleRate = 48000;
+    out.channels = 1;
+    out.samples.resize(out.sampleRate * 2);
+    uint32_t noise = 12345;
+    for (size_t i = 0; i < out.samples.size(); i++) {
+        double t = (double)i / out.sampleRate;
+        double beat = fmod(t, 0.5);
+        double kick = sin(2.0 * M_PI * 55.0 * t) * exp(-beat * 12.0);
+        double chord = 0.15 * (sin(2.0 * M_PI * 220.0 * t) + sin(2.0 * M_PI * 277.2 * t) + sin(2.0 * M_PI * 329.6 * t));
+        noise = noise * 1664525u + 1013904223u;
+        double hat = fmod(t + 0.25, 0.5) < 0.03 ? 0.2 * ((noise >> 8) / 8388608.0 - 1.0) : 0.0;
+        out.samples[i] = (float)(0.5 * kick + chord + hat);
+    }
+}
+
+static const char* VIS_NAMES[5] = { "spectrum", "cybervalley2", "linefader", "spectrum2", "circle" };
+
+static std::unique_ptr<BaseVisualization> CreateVisualization(int index) {
+    switch (index) {
+    case 0: return std::make_unique<SpectrumVis>();
+    case 1: return std::make_unique<CyberValley2Vis>();
+    case 2: return std::make_unique<LineFaderVis>();
+    case 3: return std::make_unique<Spectrum2Vis>();
+    case 4: return std::make_unique<CircleVis>();
+    }
+    return nullptr;
+}
+
+// Same names and numbers as the app's --vis
+static int ParseVisualization(const std::string& name) {
+    if (name == "spectrum" || name == "0") return 0;
+    if (name == "cybervalley2" || name == "cv2" || name == "1") return 1;
+    if (name == "linefader" || name == "lf" || name == "2") return 2;
+    if (name == "spectrum2" || name == "s2" || name == "3") return 3;
+    if (name == "circle" || name == "4") return 4;
+    return -1;
+}
+
+int RunHeadless(int argc, char** argv) {
+    std::string wavPath, outDir = ".";
+    int frames = 120, fps = 60, width = 1280, height = 720, threads = 0;
+    float renderScale = 1.0f;
+    std::vector<int> visList;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--wav") == 0 && i + 1 < argc) wavPath = argv[++i];
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) frames = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) fps = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                std::cerr << "Bad --size, expected <w>x<h>" << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--vis") == 0 && i + 1 < argc) {
+            int index = ParseVisualization(argv[++i]);
+            if (index < 0) {
+                std::cerr << "Unknown visualization: " << argv[i] << std::endl;
+                return 1;
+            }
+            visList.push_back(index);
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) outDir = argv[++i];
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            renderScale = (float)atof(argv[++i]);
+            if (renderScale < RenderScaleController::MIN_SCALE || renderScale > RenderScaleController::MAX_SCALE) {
+                std::cerr << "Bad --scale, expected " << RenderScaleController::MIN_SCALE << " to "
+                          << RenderScaleController::MAX_SCALE << std::endl;
+                return 1;
+            }
+        }
+    }
+    if (visList.empty()) visList = { 0, 1, 2, 3, 4 };
+
+    WavData wav;
+    if (wavPath.empty()) SynthesizeTestSignal(wav);
+    else if (!ReadWavFile(wavPath, wav)) return 1;
+    if (wav.samples.size() < (size_t)SpectrumAnalyzer::FFT_SIZE) {
+        std::cerr << "Not enough audio in " << wavPath << std::endl;
+        return 1;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(outDir, ec);
+
+    const int blockSize = SpectrumAnalyzer::FFT_SIZE;
+    const float frameTime = 1.0f / fps;
+    const double blocksPerFrame = (double)wav.sampleRate / blockSize / fps;
+    int failed = 0;
+
+    for (int visIndex : visList) {
+        CpuRenderDevice device(width, height, threads);
+        std::unique_ptr<BaseVisualization> vis = CreateVisualization(visIndex);
+        vis->SetRenderScale(renderScale);
+        if (!vis->Initialize(&device, width, height)) {
+            std::cerr << "Failed to initialize " << VIS_NAMES[visIndex] << std::endl;
+            failed++;
+            continue;
+        }
+
+        // AudioData is ~130 KB; keep it off the stack
+        std::unique_ptr<SpectrumAnalyzer> analyzer(new SpectrumAnalyzer());
+        std::unique_ptr<AudioData> data(new AudioData());
+        analyzer->SetSampleRate(wav.sampleRate);
+        analyzer->SetRequiredFeatures(vis->GetRequiredFeatures(true));
+        if (vis->GetPeakRelease() > 0.0f) analyzer->SetPeakRelease(vis->GetPeakRelease());
+        data->playing = true;
+
+        std::vector<float> block(blockSize);
+        size_t position = 0;
+        double blockBudget = 0.0;
+        double renderSeconds = 0.0;
+        for (int frame = 0; frame < frames; frame++) {
+            // The blocks captured during this frame, looping the audio
+            for (blockBudget += blocksPerFrame; blockBudget >= 1.0; blockBudget -= 1.0) {
+                for (int i = 0; i < blockSize; i++) {
+                    block[i] = wav.samples[position];
+                    if (++position == wav.samples.size()) position = 0;
+                }
+                analyzer->Process(block, (float)blockSize / wav.sampleRate, *data);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            float clearColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            device.SetRenderTarget(nullptr);
+            device.Clear(clearColor);
+            vis->Update(frameTime, *data, true);
+            device.ReadPixels();  // Rasterize everything queued for the frame
+            renderSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        std::string path = (std::filesystem::path(outDir) / (std::string(VIS_NAMES[visIndex]) + ".bmp")).string();
+        if (!WriteBmp(path, device.ReadPixels(), width, height)) failed++;
+        std::cout << std::left << std::setw(14) << VIS_NAMES[visIndex] << std::right << std::fixed
+                  << std::setprecision(2) << std::setw(8) << renderSeconds * 1000.0 / frames << " ms/frame  "
+                  << std::setw(8) << device.GetTrianglesDrawn() / frames << " triangles/frame  "
+                  << std::setw(6) << device.GetUploadBytes() / frames / 1024 << " KB/frame  "
+                  << std::setw(6) << device.GetVertexHighWater() << " peak batch  "
+                  << device.GetThreadCount() << " threads  " << path << std::endl;
+        vis->Cleanup();
+    }
+    return failed == 0 ? 0 : 1;
+}
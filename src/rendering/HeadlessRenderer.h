@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Renders the visualizations without a window, GPU or audio device: a WAV
+// file (or a synthesized test signal) runs through SpectrumAnalyzer at the
+// frame rate and each visualization draws into a CpuRenderDevice. Used for
+// CI snapshots and for benchmarking the draw path on any platform.
+
+// Writes RGBA8 pixels (top row first) as a 24-bit BMP
+bool WriteBmp(const std::string& path, const uint8_t* rgba, int width, int height);
+
+// Command line front end:
+// [--wav <file>] [--frames <n>] [--fps <n>] [--size <w>x<h>] [--vis <name>]
+// [--out <dir>] [--threads <n>] [--scale <0.5-1>]
+int RunHeadless(int argc, char** argv);
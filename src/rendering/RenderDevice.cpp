@@ -0,0 +1,72 @@
+#include "RenderDevice.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// Largest whole-triangle draw that fits the buffer
+static const int VERTICES_PER_DRAW = RenderDevice::MAX_VERTICES - RenderDevice::MAX_VERTICES % 3;
+
+int ExpandSegments(const Segment* segments, int count, Vertex* out) {
+    Vertex* first = out;
+    for (int i = 0; i < count; i++) {
+        const Segment& s = segments[i];
+        float dx = s.p1.x - s.p0.x;
+        float dy = s.p1.y - s.p0.y;
+        float len = sqrtf(dx * dx + dy * dy);
+        if (len < MIN_SEGMENT_LENGTH) continue;
+        // Perpendicular offset, same corner order as the segment vertex shader
+        float nx = -dy / len * s.thickness;
+        float ny = dx / len * s.thickness;
+        Vertex a = { { s.p0.x + nx, s.p0.y + ny, 0.0f }, s.color, { -1.0f, -1.0f } };
+        Vertex b = { { s.p1.x + nx, s.p1.y + ny, 0.0f }, s.color, { -1.0f, -1.0f } };
+        Vertex c = { { s.p0.x - nx, s.p0.y - ny, 0.0f }, s.color, { -1.0f, -1.0f } };
+        Vertex d = { { s.p1.x - nx, s.p1.y - ny, 0.0f }, s.color, { -1.0f, -1.0f } };
+        *out++ = a;
+        *out++ = b;
+        *out++ = c;
+        *out++ = b;
+        *out++ = d;
+        *out++ = c;
+    }
+    return (int)(out - first);
+}
+
+void RenderDevice::DrawVertices(const Vertex* vertices, int count) {
+    if (count <= 0) return;
+    NoteBatchSize(count);
+    for (int start = 0; start < count; start += VERTICES_PER_DRAW) {
+        int n = std::min(VERTICES_PER_DRAW, count - start);
+        Vertex* mapped = MapVertices(n);
+        if (!mapped) return;
+        memcpy(mapped, vertices + start, n * sizeof(Vertex));
+        UnmapVertices();
+        Draw(n);
+    }
+}
+
+void RenderDevice::NoteBatchSize(int count) {
+    if (count <= m_vertexHighWater) return;
+    m_vertexHighWater = count;
+    // Log at 3/4 of the buffer, then each further 1/8
+    int threshold = std::max(MAX_VERTICES * 3 / 4, m_loggedHighWater + MAX_VERTICES / 8);
+    if (count < threshold) return;
+    m_loggedHighWater = count;
+    std::cerr << "Vertex batch high-water: " << count << " of " << MAX_VERTICES;
+    if (count > MAX_VERTICES) {
+        std::cerr << " (" << (count + VERTICES_PER_DRAW - 1) / VERTICES_PER_DRAW << " draws)";
+    }
+    std::cerr << std::endl;
+}
+
+void RenderDevice::DrawSegments(const Segment* segments, int count) {
+    const int perDraw = MAX_VERTICES / 6;
+    for (int start = 0; start < count; start += perDraw) {
+        int n = std::min(perDraw, count - start);
+        Vertex* mapped = MapVertices(n * 6);
+        if (!mapped) return;
+        int vertexCount = ExpandSegments(segments + start, n, mapped);
+        UnmapVertices();
+        Draw(vertexCount);
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <vector>
+
+// Plain vector types for vertex data (same layout as DirectXMath's XMFLOATn)
+struct Vec2 { float x, y; };
+struct Vec3 { float x, y, z; };
+struct Vec4 { float x, y, z, w; };
+
+struct Vertex {
+    Vec3 position;   // Clip space, already projected (x, y in -1..1)
+    Vec4 color;
+    Vec2 texCoord;   // x < 0: solid colour, otherwise sample the bound texture
+};
+
+// A solid bar or line: the quad p0 -> p1, extended thickness to each side
+// (so 2 * thickness wide). Bars are vertical segments along their centre.
+struct Segment {
+    Vec2 p0, p1;
+    float thickness;
+    Vec4 color;
+};
+
+// Segments shorter than this draw nothing
+static const float MIN_SEGMENT_LENGTH = 0.0001f;
+
+// Axis-aligned bar (left, bottom)-(right, top) as a segment
+inline Segment MakeBar(float left, float bottom, float right, float top, Vec4 color) {
+    float x = (left + right) * 0.5f;
+    return { { x, bottom }, { x, top }, (right - left) * 0.5f, color };
+}
+
+// CPU reference of the instanced segment path: writes each segment as two
+// triangles (6 vertices) and returns the number of vertices written
+int ExpandSegments(const Segment* segments, int count, Vertex* out);
+
+// Offscreen colour target that can also be bound as a texture.
+// Created and owned by a RenderDevice.
+class RenderTexture {
+public:
+    virtual ~RenderTexture() = default;
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+
+protected:
+    int m_width = 0;
+    int m_height = 0;
+};
+
+// What the visualizations draw through: one dynamic vertex buffer, triangle
+// lists, render-target switches, copies and one texture slot. Every draw is
+// alpha blended (src alpha, inverse src alpha; alpha is written as-is) and
+// shaded like the app's pixel shader: solid vertices output their colour;
+// textured ones output the sampled colour with its luminance as alpha,
+// times the vertex colour. Textures sample bilinearly with wrap addressing.
+// Implemented by D3D11RenderDevice (the app) and CpuRenderDevice (headless).
+class RenderDevice {
+public:
+    static const int MAX_VERTICES = 50000;
+
+    virtual ~RenderDevice() = default;
+
+    // Back buffer size
+    virtual int GetWidth() const = 0;
+    virtual int GetHeight() const = 0;
+
+    // RGBA8 texture usable as render target and shader input; nullptr on failure
+    virtual RenderTexture* CreateRenderTexture(int width, int height) = 0;
+    virtual void DestroyTexture(RenderTexture* texture) = 0;
+
+    // Returns room for count vertices (nullptr if count exceeds
+    // MAX_VERTICES). Vertices written earlier stay valid until drawn.
+    // Unmap before drawing.
+    virtual Vertex* MapVertices(int count) = 0;
+    virtual void UnmapVertices() = 0;
+    // Triangle list from the start of the last mapped range. May be
+    // deferred, but executes in order with Clear, Copy and readback.
+    virtual void Draw(int vertexCount) = 0;
+
+    virtual void SetRenderTarget(RenderTexture* target) = 0;  // nullptr = back buffer
+    virtual RenderTexture* GetRenderTarget() const = 0;
+    virtual void Clear(const float color[4]) = 0;             // Current render target
+    virtual void Copy(RenderTexture* dest, RenderTexture* source) = 0;  // Same size
+    virtual void BindTexture(RenderTexture* texture) = 0;     // nullptr unbinds
+
+    // Map, copy, unmap and draw. Batches larger than MAX_VERTICES are
+    // split into several whole-triangle draws, in order.
+    void DrawVertices(const Vertex* vertices, int count);
+    void DrawVertices(const std::vector<Vertex>& vertices) { DrawVertices(vertices.data(), (int)vertices.size()); }
+
+    // Draws segments in order, like the triangles ExpandSegments makes of
+    // them. The default expands on the CPU and draws the vertices.
+    virtual void DrawSegments(const Segment* segments, int count);
+    void DrawSegments(const std::vector<Segment>& segments) { DrawSegments(segments.data(), (int)segments.size()); }
+
+    // Largest DrawVertices batch so far, in vertices. New highs past 3/4
+    // of the buffer are logged, so detail creeping up on it shows up
+    // before it costs extra draws.
+    int GetVertexHighWater() const { return m_vertexHighWater; }
+
+private:
+    void NoteBatchSize(int count);
+
+    int m_vertexHighWater = 0;
+    int m_loggedHighWater = 0;
+};
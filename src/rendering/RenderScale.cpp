@@ -0,0 +1,56 @@
+#include "RenderScale.h"
+#include <algorithm>
+
+void RenderScaleController::SetBudget(float frameMs) {
+    m_budget = std::max(0.0f, frameMs);
+    if (m_budget == 0.0f) m_scale = MAX_SCALE;
+    m_cleanWindows = 0;
+    m_probeWait = CLEAN_WINDOWS;
+    m_probing = false;
+    Restart();
+}
+
+void RenderScaleController::Restart() {
+    m_frames = 0;
+    m_misses = 0;
+    m_skipFrames = 1;  // The first frame back carries the switch or resize
+}
+
+bool RenderScaleController::AddFrame(float frameMs) {
+    if (m_budget <= 0.0f || frameMs <= 0.0f) return false;
+    if (m_skipFrames > 0) {
+        m_skipFrames--;
+        return false;
+    }
+    if (frameMs > m_budget * MISS_FACTOR) m_misses++;
+    if (++m_frames < WINDOW_FRAMES) return false;
+
+    int misses = m_misses;
+    m_frames = 0;
+    m_misses = 0;
+
+    float previous = m_scale;
+    if (misses >= MISSES_TO_DROP) {
+        if (m_probing && m_probeWait < MAX_CLEAN_WINDOWS) m_probeWait *= 2;
+        m_probing = false;
+        m_cleanWindows = 0;
+        m_scale = std::max(MIN_SCALE, m_scale - STEP);
+    } else if (misses == 0) {
+        if (m_probing) {
+            // The step up held; keep climbing at the normal pace
+            m_probing = false;
+            m_probeWait = CLEAN_WINDOWS;
+        }
+        if (++m_cleanWindows >= m_probeWait && m_scale < MAX_SCALE) {
+            m_scale = std::min(MAX_SCALE, m_scale + STEP);
+            m_probing = true;
+            m_cleanWindows = 0;
+        }
+    } else {
+        m_cleanWindows = 0;  // A stray miss: hold
+    }
+
+    if (m_scale == previous) return false;
+    m_skipFrames = 1;
+    return true;
+}
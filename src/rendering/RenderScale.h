@@ -0,0 +1,46 @@
+#pragma once
+
+// Picks the internal resolution of a visualization's offscreen passes, as a
+// fraction of the output size, from measured frame times. Frames are judged
+// in windows of WINDOW_FRAMES against the frame budget (one refresh, or one
+// fixed-rate slot). A frame over MISS_FACTOR budgets missed its refresh.
+//  - A window with MISSES_TO_DROP or more misses steps the scale down.
+//  - After a run of clean windows the scale steps back up, to probe for
+//    headroom. A probe that misses steps down again and doubles the clean
+//    run needed before the next one, so a scale that doesn't fit is not
+//    retried every few seconds.
+// Under vsync a frame that fits always takes one refresh, so missed frames
+// are the only signal there is; probing is how headroom is found.
+class RenderScaleController {
+public:
+    static constexpr float MIN_SCALE = 0.5f;
+    static constexpr float MAX_SCALE = 1.0f;
+    static constexpr float STEP = 0.125f;
+    static constexpr float MISS_FACTOR = 1.5f;
+    static const int WINDOW_FRAMES = 30;
+    static const int MISSES_TO_DROP = 3;      // Per window
+    static const int CLEAN_WINDOWS = 4;       // Before probing up
+    static const int MAX_CLEAN_WINDOWS = 64;  // After failed probes
+
+    // Frame budget in ms; 0 turns adjustment off and returns to full scale
+    void SetBudget(float frameMs);
+    float GetBudget() const { return m_budget; }
+
+    // Adds one frame's time (ms); true when the scale changed
+    bool AddFrame(float frameMs);
+    float GetScale() const { return m_scale; }
+
+    // Starts a new window, dropping the frames counted so far (after the
+    // output was resized, or when the visualization becomes active again)
+    void Restart();
+
+private:
+    float m_budget = 0.0f;
+    float m_scale = MAX_SCALE;
+    int m_frames = 0;
+    int m_misses = 0;
+    int m_skipFrames = 0;      // Reallocation hitch after a change
+    int m_cleanWindows = 0;
+    int m_probeWait = CLEAN_WINDOWS;
+    bool m_probing = false;    // Last change was a step up, not yet judged
+};
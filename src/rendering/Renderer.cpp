@@ -1,9 +1,11 @@
 #include "Renderer.h"
+#include "D3D11RenderDevice.h"
 #include "../visualizations/SpectrumVis.h"
 #include "../visualizations/CyberValley2Vis.h"
 #include "../visualizations/LineFaderVis.h"
 #include "../visualizations/Spectrum2Vis.h"
 #include "../visualizations/CircleVis.h"
+#include "../common/Profiler.h"
 #include <vector>
 #include <algorithm>
 #include <string>
@@ -13,49 +15,7 @@
 #include <filesystem>
 #include <random>
 
-// Simple Shaders
-const char* VS_SRC = R"(
-struct VS_INPUT {
-    float3 pos : POSITION;
-    float4 col : COLOR;
-    float2 tex : TEXCOORD;
-};
-struct PS_INPUT {
-    float4 pos : SV_POSITION;
-    float4 col : COLOR;
-    float2 tex : TEXCOORD;
-};
-PS_INPUT main(VS_INPUT input) {
-    PS_INPUT output;
-    output.pos = float4(input.pos, 1.0);
-    output.col = input.col;
-    output.tex = input.tex;
-    return output;
-}
-)";
-
-const char* PS_SRC = R"(
-Texture2D tex : register(t0);
-SamplerState sam : register(s0);
-
-struct PS_INPUT {
-    float4 pos : SV_POSITION;
-    float4 col : COLOR;
-    float2 tex : TEXCOORD;
-};
-float4 main(PS_INPUT input) : SV_Target {
-    if (input.tex.x < 0) return input.col; // Solid color mode
-    
-    // Texture mode (OSD)
-    float4 texColor = tex.Sample(sam, input.tex);
-    // GDI doesn't write alpha correctly, so we use luminance as alpha
-    // This assumes white text on black background
-    float alpha = dot(texColor.rgb, float3(0.299, 0.587, 0.114));
-    return float4(texColor.rgb, alpha) * input.col;
-}
-)";
-
-Renderer::Renderer(AudioEngine& audioEngine) : m_audioEngine(audioEngine) {
+Renderer::Renderer(AudioEngine& audioEngine) : m_audioEngine(audioEngine), m_frameData(std::make_unique<AudioData>()) {
     Gdiplus::GdiplusStartupInput gdiplusStartupInput;
     Gdiplus::GdiplusStartup(&m_gdiplusToken, &gdiplusStartupInput, NULL);
 }
@@ -72,12 +32,7 @@ Renderer::~Renderer() {
     if (m_backgroundTexture) m_backgroundTexture->Release();
     if (m_textSRV) m_textSRV->Release();
     if (m_textTexture) m_textTexture->Release();
-    if (m_samplerState) m_samplerState->Release();
-    if (m_blendState) m_blendState->Release();
-    if (m_vertexBuffer) m_vertexBuffer->Release();
-    if (m_inputLayout) m_inputLayout->Release();
-    if (m_vertexShader) m_vertexShader->Release();
-    if (m_pixelShader) m_pixelShader->Release();
+    m_renderDevice.reset();
     if (m_renderTargetView) m_renderTargetView->Release();
     if (m_swapChain) m_swapChain->Release();
     if (m_context) m_context->Release();
@@ -90,12 +45,27 @@ LRESULT CALLBACK Renderer::WindowProc(HWND hWnd, UINT message, WPARAM wParam, LP
     Renderer* pRenderer = reinterpret_cast<Renderer*>(GetWindowLongPtr(hWnd, GWLP_USERDATA));
 
     switch (message) {
+        case WM_CLOSE:
+            // Stop drawing before the window (and the swap chain's target) goes
+            if (pRenderer) {
+                pRenderer->StopRenderThread();
+            }
+            DestroyWindow(hWnd);
+            return 0;
         case WM_DESTROY:
             PostQuitMessage(0);
             return 0;
+        case WM_SIZE:
+            // Also sent by fullscreen toggles. Minimizing reports 0 x 0; keep the last real size.
+            if (pRenderer && wParam != SIZE_MINIMIZED && LOWORD(lParam) > 0 && HIWORD(lParam) > 0) {
+                pRenderer->m_pendingSize.store(((uint32_t)LOWORD(lParam) << 16) | HIWORD(lParam),
+                                               std::memory_order_release);
+            }
+            return 0;
         case WM_KEYDOWN:
+            // Applied by the render thread at its next frame; a full queue drops the key
             if (pRenderer) {
-                pRenderer->HandleInput(wParam);
+                pRenderer->m_input.TryPush({ wParam });
             }
             return 0;
     }
@@ -105,8 +75,6 @@ LRESULT CALLBACK Renderer::WindowProc(HWND hWnd, UINT message, WPARAM wParam, LP
 bool Renderer::Initialize(HINSTANCE hInstance, int width, int height, int startVis) {
     m_width = width;
     m_height = height;
-    QueryPerformanceFrequency(&m_frequency);
-    QueryPerformanceCounter(&m_lastTime);
 
     WNDCLASSEX wc = { sizeof(WNDCLASSEX), CS_CLASSDC, WindowProc, 0L, 0L, GetModuleHandle(NULL), NULL, NULL, NULL, NULL, "MusicVisVibeCode", NULL };
     RegisterClassEx(&wc);
@@ -136,71 +104,11 @@ bool Renderer::Initialize(HINSTANCE hInstance, int width, int height, int startV
     D3D11_VIEWPORT viewport = { 0, 0, (float)width, (float)height, 0.0f, 1.0f };
     m_context->RSSetViewports(1, &viewport);
     
-    // Create Rasterizer State (Disable Culling)
-    D3D11_RASTERIZER_DESC rasterDesc = {};
-    rasterDesc.AntialiasedLineEnable = FALSE;
-    rasterDesc.CullMode = D3D11_CULL_NONE;
-    rasterDesc.DepthBias = 0;
-    rasterDesc.DepthBiasClamp = 0.0f;
-    rasterDesc.DepthClipEnable = TRUE;
-    rasterDesc.FillMode = D3D11_FILL_SOLID;
-    rasterDesc.FrontCounterClockwise = FALSE;
-    rasterDesc.MultisampleEnable = FALSE;
-    rasterDesc.ScissorEnable = FALSE;
-    rasterDesc.SlopeScaledDepthBias = 0.0f;
-
-    ID3D11RasterizerState* pRasterState = nullptr;
-    m_device->CreateRasterizerState(&rasterDesc, &pRasterState);
-    m_context->RSSetState(pRasterState);
-    if(pRasterState) pRasterState->Release();
-
-    // Compile Shaders
-    ID3DBlob* vsBlob = nullptr;
-    ID3DBlob* psBlob = nullptr;
-    D3DCompile(VS_SRC, strlen(VS_SRC), NULL, NULL, NULL, "main", "vs_4_0", 0, 0, &vsBlob, NULL);
-    D3DCompile(PS_SRC, strlen(PS_SRC), NULL, NULL, NULL, "main", "ps_4_0", 0, 0, &psBlob, NULL);
-
-    m_device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), NULL, &m_vertexShader);
-    m_device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), NULL, &m_pixelShader);
-
-    D3D11_INPUT_ELEMENT_DESC ied[] = {
-        {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 28, D3D11_INPUT_PER_VERTEX_DATA, 0},
-    };
-    m_device->CreateInputLayout(ied, 3, vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &m_inputLayout);
-
-    // Create Dynamic Vertex Buffer
-    D3D11_BUFFER_DESC bd = {0};
-    bd.Usage = D3D11_USAGE_DYNAMIC;
-    bd.ByteWidth = sizeof(Vertex) * 50000; // Enough for complex visualizations
-    bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-    bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-    m_device->CreateBuffer(&bd, NULL, &m_vertexBuffer);
-
-    // Create Blend State for Alpha Blending (Text)
-    D3D11_BLEND_DESC blendDesc = {0};
-    blendDesc.RenderTarget[0].BlendEnable = TRUE;
-    blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
-    blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
-    blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
-    blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
-    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
-    blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
-    blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
-    m_device->CreateBlendState(&blendDesc, &m_blendState);
-
-    // Create Sampler State
-    D3D11_SAMPLER_DESC sampDesc;
-    ZeroMemory(&sampDesc, sizeof(sampDesc));
-    sampDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
-    sampDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-    sampDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-    sampDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-    sampDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
-    sampDesc.MinLOD = 0;
-    sampDesc.MaxLOD = D3D11_FLOAT32_MAX;
-    m_device->CreateSamplerState(&sampDesc, &m_samplerState);
+    m_renderDevice = std::make_unique<D3D11RenderDevice>();
+    if (!m_renderDevice->Initialize(m_device, m_context, m_renderTargetView, width, height)) {
+        std::cerr << "Failed to create render pipeline" << std::endl;
+        return false;
+    }
 
     CreateTextResources();
     CreateClockResources();
@@ -214,9 +122,12 @@ bool Renderer::Initialize(HINSTANCE hInstance, int width, int height, int startV
     
     // Initialize all visualizations
     for (int i = 0; i < 5; i++) {
-        m_visualizations[i]->Initialize(m_device, m_context, width, height);
+        m_visualizations[i]->Initialize(m_renderDevice.get(), width, height);
     }
 
+    // Render scale budgets follow the pacing
+    SetFramePacing(m_scheduler.GetMode(), m_scheduler.GetTargetFps());
+
     // Load config and apply settings
     m_config.Load();
     LoadConfigIntoState();
@@ -239,45 +150,83 @@ bool Renderer::Initialize(HINSTANCE hInstance, int width, int height, int startV
     return true;
 }
 
+void Renderer::SetFramePacing(FrameScheduler::Mode mode, float targetFps) {
+    m_scheduler.SetMode(mode, targetFps);
+    float budget = GetFrameBudgetMs();
+    for (int i = 0; i < 5; i++) {
+        m_renderScale[i].SetBudget(budget);
+        if (m_visualizations[i]) m_visualizations[i]->SetRenderScale(m_renderScale[i].GetScale());
+    }
+}
+
+// One refresh under vsync, one slot at a fixed rate. Uncapped has no
+// budget, so benchmarks always run at full scale.
+float Renderer::GetFrameBudgetMs() const {
+    if (m_scheduler.GetMode() == FrameScheduler::Mode::Fixed) return 1000.0f / m_scheduler.GetTargetFps();
+    if (m_scheduler.GetMode() == FrameScheduler::Mode::Uncapped) return 0.0f;
+
+    MONITORINFOEX monitor = {};
+    monitor.cbSize = sizeof(monitor);
+    DEVMODE mode = {};
+    mode.dmSize = sizeof(mode);
+    if (GetMonitorInfo(MonitorFromWindow(m_hwnd, MONITOR_DEFAULTTOPRIMARY), (MONITORINFO*)&monitor) &&
+        EnumDisplaySettings(monitor.szDevice, ENUM_CURRENT_SETTINGS, &mode) && mode.dmDisplayFrequency > 1) {
+        return 1000.0f / mode.dmDisplayFrequency;
+    }
+    return 1000.0f / 60.0f;  // 0 and 1 mean "hardware default"
+}
+
+void Renderer::UpdateRenderScale(float deltaTime) {
+    int visIndex = (int)m_currentVis;
+    BaseVisualization* vis = visIndex >= 0 && visIndex < 5 ? m_visualizations[visIndex].get() : nullptr;
+    if (!vis || !vis->HasScaledPasses()) {
+        m_scaledVis = -1;
+        return;
+    }
+
+    RenderScaleController& controller = m_renderScale[visIndex];
+    if (visIndex != m_scaledVis) {
+        // Frames drawn for another visualization say nothing about this one
+        controller.Restart();
+        m_scaledVis = visIndex;
+    }
+    if (controller.AddFrame(deltaTime * 1000.0f)) vis->SetRenderScale(controller.GetScale());
+}
+
 void Renderer::Run(float timeoutSeconds, float snapshotSeconds) {
     m_timeoutSeconds = timeoutSeconds;
     m_snapshotSeconds = snapshotSeconds;
     m_snapshotTaken = false;
     m_runningTime = 0.0f;
 
-    MSG msg = {0};
-    while (msg.message != WM_QUIT) {
-        if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
-            TranslateMessage(&msg);
-            DispatchMessage(&msg);
-        } else {
-            Render();
+    // Fixed pacing sleeps to within FrameScheduler::SPIN_MARGIN of each
+    // slot; the default 15.6 ms timer would overshoot it
+    bool fineTimer = m_scheduler.GetMode() == FrameScheduler::Mode::Fixed;
+    if (fineTimer) timeBeginPeriod(1);
+    long long startFrames = m_scheduler.GetFrameCount();
 
-            // Periodically save config if dirty (every 5 seconds)
-            m_config.timeSinceLastSave += 0.016f; // Approximate frame time
-            if (m_config.isDirty && m_config.timeSinceLastSave >= 5.0f) {
-                m_config.Save();
-                m_config.timeSinceLastSave = 0.0f;
-            }
-
-            // Check snapshot
-            if (m_snapshotSeconds > 0.0f && !m_snapshotTaken && m_runningTime >= m_snapshotSeconds) {
-                std::cout << "Taking snapshot at " << m_snapshotSeconds << "s..." << std::endl;
-                SaveSnapshot("snapshot.png");
-                m_snapshotTaken = true;
-            }
+    m_closeRequested = false;
+    m_renderRunning = true;
+    m_renderFinished = false;
+    m_renderThread = std::thread(&Renderer::RenderLoop, this);
 
-            // Check timeout
-            if (m_timeoutSeconds > 0.0f && m_runningTime >= m_timeoutSeconds) {
-                std::cout << "Timeout reached (" << m_timeoutSeconds << "s), exiting..." << std::endl;
-                // Save config before exit
-                if (m_config.isDirty) {
-                    SaveStateToConfig();
-                    m_config.Save();
-                }
-                PostQuitMessage(0);
-            }
-        }
+    MSG msg = {0};
+    while (GetMessage(&msg, NULL, 0, 0) > 0) {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+    StopRenderThread();  // Normally already stopped by WM_CLOSE
+    if (fineTimer) timeEndPeriod(1);
+#ifdef MUSICVIS_PROFILER
+    if (Profiler::Get().IsEnabled()) ToggleProfiling();
+#endif
+
+    if (m_scheduler.GetMode() == FrameScheduler::Mode::Uncapped && m_runningTime > 0.0f) {
+        const FrameScheduler::Stats& stats = m_scheduler.GetStats();
+        long long frames = m_scheduler.GetFrameCount() - startFrames;
+        std::cout << "Benchmark: " << frames << " frames in " << m_runningTime << " s, "
+                  << frames / m_runningTime << " FPS (last second: CPU " << stats.cpuMs
+                  << " ms, Present " << stats.presentMs << " ms)" << std::endl;
     }
     
     // Save config on exit
@@ -287,21 +236,112 @@ void Renderer::Run(float timeoutSeconds, float snapshotSeconds) {
     }
 }
 
-void Renderer::Render() {
-    LARGE_INTEGER currentTime;
-    QueryPerformanceCounter(&currentTime);
-    float deltaTime = (float)(currentTime.QuadPart - m_lastTime.QuadPart) / m_frequency.QuadPart;
-    m_lastTime = currentTime;
+void Renderer::RenderLoop() {
+    PROFILE_THREAD("Render");
+    while (m_renderRunning.load(std::memory_order_acquire)) {
+        // Input first, so a key pressed before this frame shows in it
+        InputEvent event;
+        while (m_input.TryPop(event)) HandleInput(event.key);
+
+        uint32_t size = m_pendingSize.load(std::memory_order_acquire);
+        if (size != 0 && size != m_appliedSize) {
+            m_appliedSize = size;
+            ResizeOutput((int)(size >> 16), (int)(size & 0xffff));
+        }
+
+        float deltaTime = m_scheduler.BeginFrame();
+        UpdateRenderScale(deltaTime);
+        Render(deltaTime);
+
+        // Periodically save config if dirty (every 5 seconds)
+        m_config.timeSinceLastSave += deltaTime;
+        if (m_config.isDirty && m_config.timeSinceLastSave >= 5.0f) {
+            m_config.Save();
+            m_config.timeSinceLastSave = 0.0f;
+        }
+
+        // Check snapshot
+        if (m_snapshotSeconds > 0.0f && !m_snapshotTaken && m_runningTime >= m_snapshotSeconds) {
+            std::cout << "Taking snapshot at " << m_snapshotSeconds << "s..." << std::endl;
+            SaveSnapshot("snapshot.png");
+            m_snapshotTaken = true;
+        }
+
+        // Check timeout
+        if (m_timeoutSeconds > 0.0f && m_runningTime >= m_timeoutSeconds && !m_closeRequested) {
+            std::cout << "Timeout reached (" << m_timeoutSeconds << "s), exiting..." << std::endl;
+            // The window thread closes the window; Run saves the config
+            PostMessage(m_hwnd, WM_CLOSE, 0, 0);
+            m_closeRequested = true;
+        }
+    }
+    m_renderFinished.store(true, std::memory_order_release);
+}
+
+void Renderer::ResizeOutput(int width, int height) {
+    if (width == m_width && height == m_height) return;
+    PROFILE_ZONE("ResizeOutput");
+
+    // ResizeBuffers fails while anything still references the old buffers
+    m_context->OMSetRenderTargets(0, NULL, NULL);
+    m_renderTargetView->Release();
+    m_renderTargetView = nullptr;
+    if (FAILED(m_swapChain->ResizeBuffers(0, width, height, DXGI_FORMAT_UNKNOWN, 0))) {
+        std::cerr << "Failed to resize the swap chain to " << width << "x" << height << std::endl;
+    }
+
+    // Size from the buffer itself, in case the resize failed
+    ID3D11Texture2D* pBackBuffer;
+    m_swapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (LPVOID*)&pBackBuffer);
+    D3D11_TEXTURE2D_DESC desc;
+    pBackBuffer->GetDesc(&desc);
+    m_device->CreateRenderTargetView(pBackBuffer, NULL, &m_renderTargetView);
+    pBackBuffer->Release();
+
+    m_width = (int)desc.Width;
+    m_height = (int)desc.Height;
+    m_renderDevice->SetBackBuffer(m_renderTargetView, m_width, m_height);
+    // Feedback textures are reallocated at the visualization's next Update
+    for (int i = 0; i < 5; i++) {
+        if (m_visualizations[i]) m_visualizations[i]->Resize(m_width, m_height);
+    }
+    // The frames around a resize stall; don't let them count as load
+    for (RenderScaleController& controller : m_renderScale) controller.Restart();
+}
+
+void Renderer::StopRenderThread() {
+    if (!m_renderThread.joinable()) return;
+    m_renderRunning.store(false, std::memory_order_release);
+    // The render thread may be inside a call that waits on this thread's
+    // messages (SetFullscreenState, a present during a mode change), so
+    // keep pumping rather than block in join
+    while (!m_renderFinished.load(std::memory_order_acquire)) {
+        MSG msg;
+        while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+            if (msg.message == WM_QUIT) {
+                PostQuitMessage((int)msg.wParam);  // Leave it for Run's loop
+                break;
+            }
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        }
+        Sleep(1);
+    }
+    // A WM_CLOSE dispatched above may have joined it already
+    if (m_renderThread.joinable()) m_renderThread.join();
+}
+
+void Renderer::Render(float deltaTime) {
+    PROFILE_ZONE("Render");
     m_runningTime += deltaTime;
+    // Back buffer and common states
+    m_renderDevice->BeginFrame();
     float clearColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
-    m_context->ClearRenderTargetView(m_renderTargetView, clearColor);
-
-    // Set Common States
-    m_context->OMSetBlendState(m_blendState, NULL, 0xffffffff);
-    m_context->PSSetSamplers(0, 1, &m_samplerState);
+    m_renderDevice->Clear(clearColor);
 
     // Draw Background
     if (m_showBackground && m_backgroundSRV && (m_currentVis == Visualization::Spectrum || m_currentVis == Visualization::LineFader || m_currentVis == Visualization::Spectrum2 || m_currentVis == Visualization::Circle)) {
+        PROFILE_ZONE("Background");
         float screenAR = (float)m_width / (float)m_height;
         float imageAR = m_bgAspectRatio;
         
@@ -330,48 +370,45 @@ void Renderer::Render() {
             { {-1.0f, -1.0f, 0.5f}, {1.0f, 1.0f, 1.0f, 1.0f}, {uMin, vMax} }
         };
 
-        D3D11_MAPPED_SUBRESOURCE ms;
-        m_context->Map(m_vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
-        memcpy(ms.pData, bgVertices.data(), bgVertices.size() * sizeof(Vertex));
-        m_context->Unmap(m_vertexBuffer, 0);
-
-        UINT stride = sizeof(Vertex);
-        UINT offset = 0;
-        m_context->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
-        m_context->IASetInputLayout(m_inputLayout);
-        m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        m_context->VSSetShader(m_vertexShader, NULL, 0);
-        m_context->PSSetShader(m_pixelShader, NULL, 0);
-        m_context->PSSetShaderResources(0, 1, &m_backgroundSRV);
-
-        m_context->Draw(bgVertices.size(), 0);
+        m_renderDevice->BindShaderResource(m_backgroundSRV);
+        m_renderDevice->DrawVertices(bgVertices);
         
         // Unbind SRV
-        ID3D11ShaderResourceView* nullSRV = nullptr;
-        m_context->PSSetShaderResources(0, 1, &nullSRV);
-    }
-
-    // FPS Calculation
-    m_frameCount++;
-    m_timeElapsed += deltaTime;
-    if (m_timeElapsed >= 1.0f) {
-        m_fps = (float)m_frameCount / m_timeElapsed;
-        m_frameCount = 0;
-        m_timeElapsed = 0.0f;
+        m_renderDevice->BindShaderResource(nullptr);
     }
 
     // Update current visualization
-    const AudioData& audioData = m_audioEngine.GetData();
+    // The frame is shown at the next present, roughly one frame from now;
+    // sample the spectrum for that moment rather than reusing the last FFT block
+    double presentTime = m_audioEngine.GetTime() + deltaTime;
+    const AudioData& audioData = m_audioEngine.GetInterpolatedData(presentTime, *m_frameData)
+        ? *m_frameData : m_audioEngine.GetData();
     int visIndex = (int)m_currentVis;
     if (visIndex >= 0 && visIndex < 5 && m_visualizations[visIndex]) {
-        m_visualizations[visIndex]->Update(deltaTime, audioData, m_useNormalized,
-                                          m_vertexBuffer, m_inputLayout,
-                                          m_vertexShader, m_pixelShader);
+        // Only analyze what the active visualization reads (plus tempo for the Info OSD)
+        uint32_t features = m_visualizations[visIndex]->GetRequiredFeatures(m_useNormalized);
+        if (m_showInfo) features |= Feature_Tempo | Feature_Loudness;
+        m_audioEngine.SetRequiredFeatures(features);
+        m_audioEngine.SetPeakRelease(m_visualizations[visIndex]->GetPeakRelease());
+#ifdef MUSICVIS_PROFILER
+        static const char* UPDATE_ZONES[5] = {
+            "Spectrum::Update", "CyberValley2::Update", "LineFader::Update", "Spectrum2::Update", "Circle::Update"
+        };
+#endif
+        PROFILE_ZONE(UPDATE_ZONES[visIndex]);
+        m_visualizations[visIndex]->Update(deltaTime, audioData, m_useNormalized);
     }
     
     RenderOSD();
 
-    m_swapChain->Present(1, 0);
+    {
+        PROFILE_ZONE("EndFrame");
+        m_renderDevice->EndFrame();
+    }
+    PROFILE_ZONE("Present");
+    m_scheduler.BeginPresent();
+    m_swapChain->Present(m_scheduler.GetSyncInterval(), 0);
+    m_scheduler.EndPresent();
 }
 
 void Renderer::CreateTextResources() {
@@ -413,6 +450,7 @@ void Renderer::CreateClockResources() {
 
 void Renderer::UpdateClockTexture(const std::string& text) {
     if (!m_clockTexture) return;
+    PROFILE_ZONE("UpdateClockTexture");
 
     // Get texture from D3D11 (use IDXGISurface1 for GetDC support)
     IDXGISurface1* pSurface = nullptr;
@@ -460,6 +498,7 @@ void Renderer::UpdateClockTexture(const std::string& text) {
 
 void Renderer::UpdateTextTexture(const std::string& text, bool rightAlign) {
     if (!m_textTexture) return;
+    PROFILE_ZONE("UpdateTextTexture");
 
     IDXGISurface1* pSurface = nullptr;
     m_textTexture->QueryInterface(__uuidof(IDXGISurface1), (void**)&pSurface);
@@ -531,6 +570,7 @@ void Renderer::UpdateTextTexture(const std::string& text, bool rightAlign) {
 }
 
 void Renderer::RenderOSD() {
+    PROFILE_ZONE("RenderOSD");
     // Render clock first if enabled (independent of other overlays)
     if (m_showClock) {
         RenderClock();
@@ -565,6 +605,12 @@ void Renderer::RenderOSD() {
                   "1-5: Jump to Vis\n"
                   "Left/Right: Change Vis\n"
                   "R: Random Vis\n"
+                  "A: Toggle Loudness AGC\n"
+                  "W: Cycle Spectrum Weighting\n"
+                  "Q: Toggle Noise Gate\n"
+#ifdef MUSICVIS_PROFILER
+                  "T: Start/Write Profile Trace\n"
+#endif
                   "ESC: Quit\n\n"
                   "Press I to see current\n"
                   "visualization settings";
@@ -572,9 +618,48 @@ void Renderer::RenderOSD() {
         std::stringstream ss;
         ss << std::fixed << std::setprecision(2);
         ss << "INFO: " << GetVisualizationName((int)m_currentVis) << "\n\n";
-        ss << "FPS: " << m_fps << "\n";
+        const FrameScheduler::Stats& frame = m_scheduler.GetStats();
+        static const char* PACING_NAMES[] = { "VSync", "Fixed", "Uncapped" };
+        ss << "FPS: " << frame.fps << " (" << PACING_NAMES[(int)m_scheduler.GetMode()];
+        if (m_scheduler.GetMode() == FrameScheduler::Mode::Fixed) ss << " " << m_scheduler.GetTargetFps();
+        ss << "), CPU " << frame.cpuMs << " ms, Present " << frame.presentMs << " ms, Wait " << frame.waitMs << " ms\n";
+        ss << "Output: " << m_width << "x" << m_height;
+        BaseVisualization* activeVis = m_visualizations[(int)m_currentVis].get();
+        if (activeVis && activeVis->HasScaledPasses()) {
+            ss << ", feedback at " << (int)(activeVis->GetRenderScale() * 100.0f + 0.5f) << "%";
+            if (m_renderScale[(int)m_currentVis].GetBudget() > 0.0f) ss << " (auto)";
+        }
+        ss << "\n";
         ss << "Audio Scale: " << m_audioEngine.GetData().Scale << "\n";
-        ss << "Playing: " << (m_audioEngine.GetData().playing ? "Yes" : "No") << "\n\n";
+        ss << "Playing: " << (m_audioEngine.GetData().playing ? "Yes" : "No") << "\n";
+        
+        // Analysis cost: active stages out of the full graph
+        const SpectrumAnalyzer& analyzer = m_audioEngine.GetAnalyzer();
+        int activeStages = 0;
+        for (int i = 0; i < SpectrumAnalyzer::Stage_Count; i++) {
+            if (analyzer.GetStageTiming(i).active) activeStages++;
+        }
+        ss << std::setprecision(0);
+        ss << "Analysis: " << analyzer.GetTotalMicros() << "us (" << activeStages << "/" << SpectrumAnalyzer::Stage_Count << " stages)\n";
+        const D3D11RenderDevice::FrameStats& gpu = m_renderDevice->GetFrameStats();
+        ss << "Vertex Maps: " << gpu.maps << " (" << gpu.discards << " wrap), Draws: " << gpu.draws
+           << " -> " << gpu.drawCalls << " calls, " << gpu.vertices << " verts, " << gpu.segments << " segs, " << gpu.bytes / 1024 << " KB\n";
+        ss << "State: " << gpu.stateCalls << " set, " << gpu.stateElided << " elided\n";
+#ifdef MUSICVIS_PROFILER
+        ss << "Profiler: " << (Profiler::Get().IsEnabled() ? "Capturing" : "Off") << " (T)\n";
+#endif
+        ss << std::setprecision(1);
+        if (m_frameData->TempoBPM > 0.0f) {
+            ss << "Tempo: " << m_frameData->TempoBPM << " BPM (" << (int)(m_frameData->TempoConfidence * 100.0f) << "%)\n";
+        } else {
+            ss << "Tempo: --\n";
+        }
+        ss << "Loudness: " << m_frameData->LoudnessShortTerm << " LUFS, TP " << m_frameData->TruePeak << " dBTP\n";
+        ss << "AGC: " << (m_loudnessAgc ? "Loudness" : "Peak") << " (A)\n";
+        static const char* weightingNames[Weighting_Count] = { "Flat", "A-weighted", "Tilt" };
+        ss << "Weighting: " << weightingNames[m_spectrumWeighting] << " (W)\n";
+        ss << "Noise Gate: " << (m_noiseGate ? "On" : "Off") << " (Q)\n\n";
+        ss << std::setprecision(2);
         
         // Show visualization-specific settings and controls
         if (m_currentVis == Visualization::Spectrum) {
@@ -636,7 +721,7 @@ void Renderer::RenderOSD() {
     float x = 1.0f - w - padding; // Top Right
     float y = 1.0f - padding;
 
-    XMFLOAT4 color = {1.0f, 1.0f, 1.0f, 1.0f};
+    Vec4 color = {1.0f, 1.0f, 1.0f, 1.0f};
     
     vertices.push_back({ {x, y, 0.0f}, color, {0.0f, 0.0f} });
     vertices.push_back({ {x + w, y, 0.0f}, color, {1.0f, 0.0f} });
@@ -646,28 +731,15 @@ void Renderer::RenderOSD() {
     vertices.push_back({ {x + w, y - h, 0.0f}, color, {1.0f, 1.0f} });
     vertices.push_back({ {x, y - h, 0.0f}, color, {0.0f, 1.0f} });
 
-    D3D11_MAPPED_SUBRESOURCE ms;
-    m_context->Map(m_vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
-    memcpy(ms.pData, vertices.data(), vertices.size() * sizeof(Vertex));
-    m_context->Unmap(m_vertexBuffer, 0);
-
-    UINT stride = sizeof(Vertex);
-    UINT offset = 0;
-    m_context->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
-    m_context->IASetInputLayout(m_inputLayout);
-    m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    m_context->VSSetShader(m_vertexShader, NULL, 0);
-    m_context->PSSetShader(m_pixelShader, NULL, 0);
-    m_context->PSSetShaderResources(0, 1, &m_textSRV);
-
-    m_context->Draw(vertices.size(), 0);
+    m_renderDevice->BindShaderResource(m_textSRV);
+    m_renderDevice->DrawVertices(vertices);
     
     // Unbind SRV to allow update next frame
-    ID3D11ShaderResourceView* nullSRV = nullptr;
-    m_context->PSSetShaderResources(0, 1, &nullSRV);
+    m_renderDevice->BindShaderResource(nullptr);
 }
 
 void Renderer::ScanBackgrounds() {
+    PROFILE_ZONE("ScanBackgrounds");
     namespace fs = std::filesystem;
     m_backgroundFiles.clear();
     std::string bgPath = "Backgrounds";
@@ -684,6 +756,7 @@ void Renderer::ScanBackgrounds() {
 void Renderer::LoadBackground(int index) {
     if (m_backgroundFiles.empty()) return;
     if (index < 0 || index >= m_backgroundFiles.size()) return;
+    PROFILE_ZONE("LoadBackground");
 
     m_currentBgIndex = index;
     std::wstring selectedFile = m_backgroundFiles[index];
@@ -771,10 +844,35 @@ void Renderer::HandleInput(WPARAM key) {
         }
     } else if (key == 'I') {
         m_showInfo = !m_showInfo;
-        if (m_showInfo) { m_showHelp = false; m_showDisableMenu = false; }
+        if (m_showInfo) {
+            m_showHelp = false;
+            m_showDisableMenu = false;
+            
+            // Per-stage breakdown goes to the console; the OSD only has room for the total
+            const SpectrumAnalyzer& analyzer = m_audioEngine.GetAnalyzer();
+            std::cout << "Analysis stages:" << std::endl;
+            for (int i = 0; i < SpectrumAnalyzer::Stage_Count; i++) {
+                SpectrumAnalyzer::StageTiming timing = analyzer.GetStageTiming(i);
+                std::cout << "  " << std::left << std::setw(12) << timing.name << std::right
+                          << (timing.active ? "active  " : "skipped ")
+                          << std::fixed << std::setprecision(1) << timing.avgMicros << " us" << std::endl;
+            }
+        }
     } else if (key == 'C') {
         m_showClock = !m_showClock;
         SaveStateToConfig();
+    } else if (key == 'A') {
+        m_loudnessAgc = !m_loudnessAgc;
+        m_audioEngine.SetLoudnessAgc(m_loudnessAgc);
+        SaveStateToConfig();
+    } else if (key == 'W') {
+        m_spectrumWeighting = (m_spectrumWeighting + 1) % Weighting_Count;
+        m_audioEngine.SetSpectrumWeighting((SpectrumWeighting)m_spectrumWeighting);
+        SaveStateToConfig();
+    } else if (key == 'Q') {
+        m_noiseGate = !m_noiseGate;
+        m_audioEngine.SetNoiseGate(m_noiseGate);
+        SaveStateToConfig();
     } else if (key == 'D') {
         m_showDisableMenu = !m_showDisableMenu;
         if (m_showDisableMenu) { m_showHelp = false; m_showInfo = false; m_showClock = false; }
@@ -900,11 +998,30 @@ void Renderer::HandleInput(WPARAM key) {
         }
     } else if (key >= '0' && key <= '9') {
         // TODO: Switch to visualization index
+#ifdef MUSICVIS_PROFILER
+    } else if (key == 'T') {
+        ToggleProfiling();
+#endif
     } else if (key == VK_ESCAPE) {
-        PostQuitMessage(0);
+        // Runs on the render thread; the window thread closes the window
+        if (!m_closeRequested) PostMessage(m_hwnd, WM_CLOSE, 0, 0);
+        m_closeRequested = true;
     }
 }
 
+#ifdef MUSICVIS_PROFILER
+void Renderer::ToggleProfiling() {
+    Profiler& profiler = Profiler::Get();
+    if (!profiler.IsEnabled()) {
+        profiler.SetEnabled(true);
+        std::cout << "Profiler capture started (T to write the trace)" << std::endl;
+        return;
+    }
+    profiler.SetEnabled(false);
+    profiler.WriteTrace("trace" + std::to_string(++m_traceCount) + ".json");
+}
+#endif
+
 std::string Renderer::GetVisualizationName(int vis) {
     switch (vis) {
         case 0: return "Spectrum";
@@ -942,6 +1059,15 @@ int Renderer::GetNextEnabledVis(int currentVis, bool forward) {
 
 void Renderer::LoadConfigIntoState() {
     m_useNormalized = m_config.useNormalized;
+    m_loudnessAgc = m_config.loudnessAgc;
+    m_audioEngine.SetLoudnessAgc(m_loudnessAgc);
+    m_spectrumWeighting = (m_config.spectrumWeighting >= 0 && m_config.spectrumWeighting < Weighting_Count)
+                              ? m_config.spectrumWeighting : Weighting_Flat;
+    m_audioEngine.SetSpectrumWeighting((SpectrumWeighting)m_spectrumWeighting);
+    m_noiseGate = m_config.noiseGate;
+    m_audioEngine.SetNoiseGate(m_noiseGate);
+    m_audioEngine.SetSharedMemoryOutput(m_config.sharedMemoryOutput);
+    m_audioEngine.SetUdpOutput(m_config.udpOutput, m_config.udpBands);
     m_isFullscreen = m_isFullscreen;
     m_showBackground = m_config.showBackground;
     m_showClock = m_config.clockEnabled;
@@ -967,6 +1093,9 @@ void Renderer::LoadConfigIntoState() {
 
 void Renderer::SaveStateToConfig() {
     m_config.useNormalized = m_useNormalized;
+    m_config.loudnessAgc = m_loudnessAgc;
+    m_config.spectrumWeighting = m_spectrumWeighting;
+    m_config.noiseGate = m_noiseGate;
     m_config.isFullscreen = m_isFullscreen;
     m_config.showBackground = m_showBackground;
     m_config.clockEnabled = m_showClock;
@@ -1038,7 +1167,7 @@ void Renderer::RenderClock() {
     float bgY = y + (clockHeight * bgPadding * 0.5f);
     
     std::vector<Vertex> bgVertices;
-    XMFLOAT4 bgColor = {0.0f, 0.0f, 0.0f, 0.5f}; // Black, 50% transparent
+    Vec4 bgColor = {0.0f, 0.0f, 0.0f, 0.5f}; // Black, 50% transparent
     
     bgVertices.push_back({ {bgX, bgY, 0.0f}, bgColor, {-1.0f, -1.0f} });
     bgVertices.push_back({ {bgX + bgWidth, bgY, 0.0f}, bgColor, {-1.0f, -1.0f} });
@@ -1048,25 +1177,12 @@ void Renderer::RenderClock() {
     bgVertices.push_back({ {bgX + bgWidth, bgY - bgHeight, 0.0f}, bgColor, {-1.0f, -1.0f} });
     bgVertices.push_back({ {bgX, bgY - bgHeight, 0.0f}, bgColor, {-1.0f, -1.0f} });
 
-    D3D11_MAPPED_SUBRESOURCE ms;
-    m_context->Map(m_vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
-    memcpy(ms.pData, bgVertices.data(), bgVertices.size() * sizeof(Vertex));
-    m_context->Unmap(m_vertexBuffer, 0);
-
-    UINT stride = sizeof(Vertex);
-    UINT offset = 0;
-    m_context->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
-    m_context->IASetInputLayout(m_inputLayout);
-    m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    m_context->VSSetShader(m_vertexShader, NULL, 0);
-    m_context->PSSetShader(m_pixelShader, NULL, 0);
-
     // Draw background (no texture)
-    m_context->Draw(6, 0);
+    m_renderDevice->DrawVertices(bgVertices);
 
     // Now draw clock text on top
     std::vector<Vertex> textVertices;
-    XMFLOAT4 textColor = {1.0f, 1.0f, 1.0f, 1.0f};
+    Vec4 textColor = {1.0f, 1.0f, 1.0f, 1.0f};
     
     textVertices.push_back({ {x, y, 0.0f}, textColor, {0.0f, 0.0f} });
     textVertices.push_back({ {x + clockWidth, y, 0.0f}, textColor, {1.0f, 0.0f} });
@@ -1076,18 +1192,11 @@ void Renderer::RenderClock() {
     textVertices.push_back({ {x + clockWidth, y - clockHeight, 0.0f}, textColor, {1.0f, 1.0f} });
     textVertices.push_back({ {x, y - clockHeight, 0.0f}, textColor, {0.0f, 1.0f} });
 
-    m_context->Map(m_vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
-    memcpy(ms.pData, textVertices.data(), textVertices.size() * sizeof(Vertex));
-    m_context->Unmap(m_vertexBuffer, 0);
-
-    m_context->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
-    m_context->PSSetShaderResources(0, 1, &m_clockSRV);
-
-    m_context->Draw(6, 0);
+    m_renderDevice->BindShaderResource(m_clockSRV);
+    m_renderDevice->DrawVertices(textVertices);
 
     // Unbind texture
-    ID3D11ShaderResourceView* nullSRV = nullptr;
-    m_context->PSSetShaderResources(0, 1, &nullSRV);
+    m_renderDevice->BindShaderResource(nullptr);
 }
 
 void Renderer::SaveSnapshot(const std::string& filename) {
@@ -2,15 +2,18 @@
 #include <windows.h>
 #include <gdiplus.h>
 #include <d3d11.h>
-#include <d3dcompiler.h>
-#include <DirectXMath.h>
 #include <string>
 #include <memory>
+#include <atomic>
+#include <thread>
+#include "../audio/SpscQueue.h"
 #include "../audio/AudioEngine.h"
 #include "../Config.h"
 #include "../visualizations/BaseVisualization.h"
+#include "FrameScheduler.h"
+#include "RenderScale.h"
 
-using namespace DirectX;
+class D3D11RenderDevice;
 
 class Renderer {
 public:
@@ -19,10 +22,33 @@ public:
 
     bool Initialize(HINSTANCE hInstance, int width, int height, int startVis = -1);
     void Run(float timeoutSeconds = 0.0f, float snapshotSeconds = 0.0f);
+    // VSync (default), Fixed at targetFps, or Uncapped for benchmarking
+    void SetFramePacing(FrameScheduler::Mode mode, float targetFps = 60.0f);
 
 private:
     static LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
-    void Render();
+    void Render(float deltaTime);
+
+    // Rendering runs on its own thread so drags, resizes and modal loops
+    // on the window thread don't stall frames. The window thread only
+    // pumps messages and queues input; the render thread applies it at
+    // the start of each frame, in order, before drawing.
+    struct InputEvent {
+        WPARAM key;
+    };
+    void RenderLoop();
+    void StopRenderThread();  // Window thread; keeps pumping until the render thread exits
+    SpscQueue<InputEvent, 64> m_input;
+    std::thread m_renderThread;
+    std::atomic<bool> m_renderRunning{false};
+    std::atomic<bool> m_renderFinished{true};
+    bool m_closeRequested = false;  // Render thread: WM_CLOSE already posted
+
+    // Client size from the last WM_SIZE, packed as width << 16 | height.
+    // The render thread resizes the swap chain to it between frames.
+    void ResizeOutput(int width, int height);
+    std::atomic<uint32_t> m_pendingSize{0};
+    uint32_t m_appliedSize = 0;  // Render thread: last size handled
 
     AudioEngine& m_audioEngine;
     HWND m_hwnd;
@@ -34,10 +60,8 @@ private:
     IDXGISwapChain* m_swapChain = nullptr;
     ID3D11RenderTargetView* m_renderTargetView = nullptr;
 
-    ID3D11VertexShader* m_vertexShader = nullptr;
-    ID3D11PixelShader* m_pixelShader = nullptr;
-    ID3D11InputLayout* m_inputLayout = nullptr;
-    ID3D11Buffer* m_vertexBuffer = nullptr;
+    // Shared pipeline; the visualizations draw through it
+    std::unique_ptr<D3D11RenderDevice> m_renderDevice;
 
     // Visualization State
     enum class Visualization { Spectrum, CyberValley2, LineFader, Spectrum2, Circle };
@@ -45,23 +69,40 @@ private:
     
     // Visualization instances
     std::unique_ptr<BaseVisualization> m_visualizations[5];
+    
+    // Audio data interpolated to this frame's present time (heap: AudioData is large)
+    std::unique_ptr<AudioData> m_frameData;
 
-    LARGE_INTEGER m_lastTime;
-    LARGE_INTEGER m_frequency;
-    float m_fps = 0.0f;
-    int m_frameCount = 0;
-    float m_timeElapsed = 0.0f;
+    // Frame pacing and the clock every timer runs on
+    FrameScheduler m_scheduler;
     float m_timeoutSeconds = 0.0f;
     float m_snapshotSeconds = 0.0f;
     bool m_snapshotTaken = false;
     float m_runningTime = 0.0f;
 
+    // Render scale of each visualization's offscreen passes, adjusted from
+    // the frame time while it is the active one
+    float GetFrameBudgetMs() const;
+    void UpdateRenderScale(float deltaTime);
+    RenderScaleController m_renderScale[5];
+    int m_scaledVis = -1;  // Visualization the controller last measured
+
+#ifdef MUSICVIS_PROFILER
+    // T starts a profiler capture and the next T writes it to trace<N>.json;
+    // a capture still running at exit is written then
+    void ToggleProfiling();
+    int m_traceCount = 0;
+#endif
+
     // OSD State
     bool m_showHelp = false;
     bool m_showInfo = false;
     bool m_showClock = false;
     bool m_showDisableMenu = false;
     bool m_useNormalized = true;
+    bool m_loudnessAgc = false;
+    int m_spectrumWeighting = Weighting_Flat;
+    bool m_noiseGate = false;
     bool m_isFullscreen = false;
     
     // Config
@@ -75,9 +116,6 @@ private:
     ID3D11Texture2D* m_clockTexture = nullptr;
     ID3D11ShaderResourceView* m_clockSRV = nullptr;
     
-    ID3D11SamplerState* m_samplerState = nullptr;
-    ID3D11BlendState* m_blendState = nullptr;
-    
     // Background
     ID3D11Texture2D* m_backgroundTexture = nullptr;
     ID3D11ShaderResourceView* m_backgroundSRV = nullptr;
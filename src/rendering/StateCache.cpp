@@ -0,0 +1,109 @@
+#include "StateCache.h"
+
+void StateCache::SetContext(StateContext* context) {
+    m_context = context;
+    Invalidate();
+}
+
+bool StateCache::Needs(Kind kind, bool same) {
+    if (m_known[kind] && same) {
+        m_counters[kind].elided++;
+        return false;
+    }
+    m_known[kind] = true;
+    m_counters[kind].issued++;
+    return true;
+}
+
+void StateCache::SetVertexBuffer(ID3D11Buffer* buffer, unsigned stride) {
+    if (!Needs(Kind_VertexBuffer, m_vertexBuffer == buffer && m_stride == stride)) return;
+    m_vertexBuffer = buffer;
+    m_stride = stride;
+    m_context->SetVertexBuffer(buffer, stride);
+}
+
+void StateCache::SetInputLayout(ID3D11InputLayout* layout) {
+    if (!Needs(Kind_InputLayout, m_inputLayout == layout)) return;
+    m_inputLayout = layout;
+    m_context->SetInputLayout(layout);
+}
+
+void StateCache::SetTopology(int topology) {
+    if (!Needs(Kind_Topology, m_topology == topology)) return;
+    m_topology = topology;
+    m_context->SetTopology(topology);
+}
+
+void StateCache::SetVertexShader(ID3D11VertexShader* shader) {
+    if (!Needs(Kind_VertexShader, m_vertexShader == shader)) return;
+    m_vertexShader = shader;
+    m_context->SetVertexShader(shader);
+}
+
+void StateCache::SetPixelShader(ID3D11PixelShader* shader) {
+    if (!Needs(Kind_PixelShader, m_pixelShader == shader)) return;
+    m_pixelShader = shader;
+    m_context->SetPixelShader(shader);
+}
+
+void StateCache::SetRenderTarget(ID3D11RenderTargetView* rtv, int width, int height) {
+    bool same = m_renderTarget == rtv && m_targetWidth == width && m_targetHeight == height;
+    if (!Needs(Kind_RenderTarget, same)) return;
+    m_renderTarget = rtv;
+    m_targetWidth = width;
+    m_targetHeight = height;
+    m_context->SetRenderTarget(rtv, width, height);
+}
+
+void StateCache::SetShaderResource(ID3D11ShaderResourceView* srv) {
+    if (!Needs(Kind_ShaderResource, m_shaderResource == srv)) return;
+    m_shaderResource = srv;
+    m_context->SetShaderResource(srv);
+}
+
+void StateCache::SetBlendState(ID3D11BlendState* state) {
+    if (!Needs(Kind_BlendState, m_blendState == state)) return;
+    m_blendState = state;
+    m_context->SetBlendState(state);
+}
+
+void StateCache::SetSampler(ID3D11SamplerState* sampler) {
+    if (!Needs(Kind_Sampler, m_sampler == sampler)) return;
+    m_sampler = sampler;
+    m_context->SetSampler(sampler);
+}
+
+void StateCache::SetRasterizerState(ID3D11RasterizerState* state) {
+    if (!Needs(Kind_RasterizerState, m_rasterizerState == state)) return;
+    m_rasterizerState = state;
+    m_context->SetRasterizerState(state);
+}
+
+ID3D11ShaderResourceView* StateCache::GetShaderResource() const {
+    return m_known[Kind_ShaderResource] ? m_shaderResource : nullptr;
+}
+
+void StateCache::Invalidate() {
+    for (bool& known : m_known) known = false;
+}
+
+void StateCache::Forget(ID3D11RenderTargetView* rtv) {
+    if (m_renderTarget == rtv) m_known[Kind_RenderTarget] = false;
+}
+
+void StateCache::Forget(ID3D11ShaderResourceView* srv) {
+    if (m_shaderResource == srv) m_known[Kind_ShaderResource] = false;
+}
+
+StateCache::Counters StateCache::GetTotals() const {
+    Counters totals;
+    for (const Counters& counters : m_counters) {
+        totals.issued += counters.issued;
+        totals.elided += counters.elided;
+    }
+    return totals;
+}
+
+void StateCache::ResetCounters() {
+    for (Counters& counters : m_counters) counters = Counters();
+}
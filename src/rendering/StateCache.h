@@ -0,0 +1,101 @@
+#pragma once
+
+// D3D11 object types, only passed through here; the header stays portable
+// so the cache can be tested without D3D11
+struct ID3D11Buffer;
+struct ID3D11InputLayout;
+struct ID3D11VertexShader;
+struct ID3D11PixelShader;
+struct ID3D11RenderTargetView;
+struct ID3D11ShaderResourceView;
+struct ID3D11BlendState;
+struct ID3D11SamplerState;
+struct ID3D11RasterizerState;
+
+// The pipeline state calls StateCache filters, one per piece of state the
+// render device binds. D3D11RenderDevice forwards them to its
+// ID3D11DeviceContext; tests record them.
+class StateContext {
+public:
+    virtual ~StateContext() = default;
+    virtual void SetVertexBuffer(ID3D11Buffer* buffer, unsigned stride) = 0;  // Slot 0, offset 0
+    virtual void SetInputLayout(ID3D11InputLayout* layout) = 0;
+    virtual void SetTopology(int topology) = 0;                               // D3D11_PRIMITIVE_TOPOLOGY
+    virtual void SetVertexShader(ID3D11VertexShader* shader) = 0;
+    virtual void SetPixelShader(ID3D11PixelShader* shader) = 0;
+    virtual void SetRenderTarget(ID3D11RenderTargetView* rtv, int width, int height) = 0;  // And a full viewport
+    virtual void SetShaderResource(ID3D11ShaderResourceView* srv) = 0;        // Pixel shader slot 0
+    virtual void SetBlendState(ID3D11BlendState* state) = 0;
+    virtual void SetSampler(ID3D11SamplerState* sampler) = 0;                 // Pixel shader slot 0
+    virtual void SetRasterizerState(ID3D11RasterizerState* state) = 0;
+};
+
+// Tracks what is bound on a StateContext and drops calls that would bind
+// it again. Starts with nothing known, so the first call of each kind is
+// always issued; Invalidate returns to that after the context was touched
+// behind the cache's back. Calls issued and elided are counted per kind
+// until ResetCounters (once a frame).
+class StateCache {
+public:
+    enum Kind {
+        Kind_VertexBuffer, Kind_InputLayout, Kind_Topology, Kind_VertexShader, Kind_PixelShader,
+        Kind_RenderTarget, Kind_ShaderResource, Kind_BlendState, Kind_Sampler, Kind_RasterizerState,
+        Kind_Count
+    };
+
+    struct Counters {
+        int issued = 0;
+        int elided = 0;
+    };
+
+    explicit StateCache(StateContext* context = nullptr) : m_context(context) {}
+
+    // Also forgets all bound state
+    void SetContext(StateContext* context);
+
+    void SetVertexBuffer(ID3D11Buffer* buffer, unsigned stride);
+    void SetInputLayout(ID3D11InputLayout* layout);
+    void SetTopology(int topology);
+    void SetVertexShader(ID3D11VertexShader* shader);
+    void SetPixelShader(ID3D11PixelShader* shader);
+    void SetRenderTarget(ID3D11RenderTargetView* rtv, int width, int height);
+    void SetShaderResource(ID3D11ShaderResourceView* srv);
+    void SetBlendState(ID3D11BlendState* state);
+    void SetSampler(ID3D11SamplerState* sampler);
+    void SetRasterizerState(ID3D11RasterizerState* state);
+
+    // Bound shader resource; nullptr when none or unknown
+    ID3D11ShaderResourceView* GetShaderResource() const;
+
+    // Forget all bound state: the next call of each kind is issued
+    void Invalidate();
+    // A view is being released; a new one may reuse its address
+    void Forget(ID3D11RenderTargetView* rtv);
+    void Forget(ID3D11ShaderResourceView* srv);
+
+    const Counters& GetCounters(Kind kind) const { return m_counters[kind]; }
+    Counters GetTotals() const;
+    void ResetCounters();
+
+private:
+    // True when the call has to be issued; counts it either way
+    bool Needs(Kind kind, bool same);
+
+    StateContext* m_context;
+    bool m_known[Kind_Count] = {};
+    Counters m_counters[Kind_Count];
+
+    ID3D11Buffer* m_vertexBuffer = nullptr;
+    unsigned m_stride = 0;
+    ID3D11InputLayout* m_inputLayout = nullptr;
+    int m_topology = 0;
+    ID3D11VertexShader* m_vertexShader = nullptr;
+    ID3D11PixelShader* m_pixelShader = nullptr;
+    ID3D11RenderTargetView* m_renderTarget = nullptr;
+    int m_targetWidth = 0;
+    int m_targetHeight = 0;
+    ID3D11ShaderResourceView* m_shaderResource = nullptr;
+    ID3D11BlendState* m_blendState = nullptr;
+    ID3D11SamplerState* m_sampler = nullptr;
+    ID3D11RasterizerState* m_rasterizerState = nullptr;
+};
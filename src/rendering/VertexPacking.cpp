@@ -0,0 +1,118 @@
+#include "VertexPacking.h"
+#include "VectorOps.h"
+#include <algorithm>
+#include <cmath>
+
+// Round to nearest even, like cvtps2dq in the default rounding mode
+static inline int32_t Quantize(float v, float scale, float lo, float hi) {
+    return (int32_t)lrintf(std::min(hi, std::max(lo, v * scale)));
+}
+
+void PackVerticesScalar(const Vertex* in, PackedVertex* out, int count) {
+    for (int i = 0; i < count; i++) {
+        const Vertex& v = in[i];
+        PackedVertex& p = out[i];
+        p.x = (int16_t)Quantize(v.position.x, POSITION_SCALE, -32767.0f, 32767.0f);
+        p.y = (int16_t)Quantize(v.position.y, POSITION_SCALE, -32767.0f, 32767.0f);
+        p.u = (int16_t)Quantize(v.texCoord.x, 32767.0f, -32767.0f, 32767.0f);
+        p.v = (int16_t)Quantize(v.texCoord.y, 32767.0f, -32767.0f, 32767.0f);
+        p.r = (uint16_t)Quantize(v.color.x, 65535.0f, 0.0f, 65535.0f);
+        p.g = (uint16_t)Quantize(v.color.y, 65535.0f, 0.0f, 65535.0f);
+        p.b = (uint16_t)Quantize(v.color.z, 65535.0f, 0.0f, 65535.0f);
+        p.a = (uint16_t)Quantize(v.color.w, 65535.0f, 0.0f, 65535.0f);
+    }
+}
+
+void PackVertices(const Vertex* in, PackedVertex* out, int count) {
+#ifdef MUSICVIS_SSE2
+    // One vertex per iteration, all eight fields at once: {x, y, u, v} and
+    // {r, g, b, a} are scaled, clamped and converted to int32, then packed
+    // to int16 with signed saturation. The colour is biased by -32768 first
+    // (SSE2 has no unsigned 32->16 pack) and the bias flipped back with xor.
+    const __m128 posUvScale = _mm_setr_ps(POSITION_SCALE, POSITION_SCALE, 32767.0f, 32767.0f);
+    const __m128 posUvLimit = _mm_set1_ps(32767.0f);
+    const __m128 posUvNegLimit = _mm_set1_ps(-32767.0f);
+    const __m128 colorScale = _mm_set1_ps(65535.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128i colorBias = _mm_set1_epi32(32768);
+    const __m128i colorFlip = _mm_setr_epi16(0, 0, 0, 0, (short)0x8000, (short)0x8000, (short)0x8000, (short)0x8000);
+    for (int i = 0; i < count; i++) {
+        const Vertex& v = in[i];
+        __m128 position = _mm_loadu_ps(&v.position.x);                          // x y z r
+        __m128 uv = _mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)&v.texCoord.x));  // u v 0 0
+        __m128 posUv = _mm_movelh_ps(position, uv);                              // x y u v
+        __m128 color = _mm_loadu_ps(&v.color.x);                                 // r g b a
+
+        posUv = _mm_min_ps(_mm_max_ps(_mm_mul_ps(posUv, posUvScale), posUvNegLimit), posUvLimit);
+        color = _mm_min_ps(_mm_max_ps(_mm_mul_ps(color, colorScale), zero), colorScale);
+        __m128i posUvInt = _mm_cvtps_epi32(posUv);
+        __m128i colorInt = _mm_sub_epi32(_mm_cvtps_epi32(color), colorBias);
+        __m128i packed = _mm_xor_si128(_mm_packs_epi32(posUvInt, colorInt), colorFlip);
+        _mm_storeu_si128((__m128i*)&out[i], packed);
+    }
+#else
+    PackVerticesScalar(in, out, count);
+#endif
+}
+
+Vertex UnpackVertex(const PackedVertex& in) {
+    Vertex v;
+    v.position = { in.x / POSITION_SCALE, in.y / POSITION_SCALE, 0.0f };
+    // SNORM: -32768 and -32767 both map to -1
+    v.texCoord = { std::max(-1.0f, in.u / 32767.0f), std::max(-1.0f, in.v / 32767.0f) };
+    v.color = { in.r / 65535.0f, in.g / 65535.0f, in.b / 65535.0f, in.a / 65535.0f };
+    return v;
+}
+
+void PackSegmentsScalar(const Segment* in, PackedSegment* out, int count) {
+    for (int i = 0; i < count; i++) {
+        const Segment& s = in[i];
+        PackedSegment& p = out[i];
+        p.x0 = (int16_t)Quantize(s.p0.x, POSITION_SCALE, -32767.0f, 32767.0f);
+        p.y0 = (int16_t)Quantize(s.p0.y, POSITION_SCALE, -32767.0f, 32767.0f);
+        p.x1 = (int16_t)Quantize(s.p1.x, POSITION_SCALE, -32767.0f, 32767.0f);
+        p.y1 = (int16_t)Quantize(s.p1.y, POSITION_SCALE, -32767.0f, 32767.0f);
+        p.r = (uint16_t)Quantize(s.color.x, 65535.0f, 0.0f, 65535.0f);
+        p.g = (uint16_t)Quantize(s.color.y, 65535.0f, 0.0f, 65535.0f);
+        p.b = (uint16_t)Quantize(s.color.z, 65535.0f, 0.0f, 65535.0f);
+        p.a = (uint16_t)Quantize(s.color.w, 65535.0f, 0.0f, 65535.0f);
+        p.thickness = s.thickness;
+    }
+}
+
+void PackSegments(const Segment* in, PackedSegment* out, int count) {
+#ifdef MUSICVIS_SSE2
+    // As PackVertices, with both endpoints in the first four lanes
+    const __m128 posScale = _mm_set1_ps(POSITION_SCALE);
+    const __m128 posLimit = _mm_set1_ps(32767.0f);
+    const __m128 posNegLimit = _mm_set1_ps(-32767.0f);
+    const __m128 colorScale = _mm_set1_ps(65535.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128i colorBias = _mm_set1_epi32(32768);
+    const __m128i colorFlip = _mm_setr_epi16(0, 0, 0, 0, (short)0x8000, (short)0x8000, (short)0x8000, (short)0x8000);
+    for (int i = 0; i < count; i++) {
+        const Segment& s = in[i];
+        __m128 ends = _mm_loadu_ps(&s.p0.x);      // x0 y0 x1 y1
+        __m128 color = _mm_loadu_ps(&s.color.x);  // r g b a
+
+        ends = _mm_min_ps(_mm_max_ps(_mm_mul_ps(ends, posScale), posNegLimit), posLimit);
+        color = _mm_min_ps(_mm_max_ps(_mm_mul_ps(color, colorScale), zero), colorScale);
+        __m128i endsInt = _mm_cvtps_epi32(ends);
+        __m128i colorInt = _mm_sub_epi32(_mm_cvtps_epi32(color), colorBias);
+        __m128i packed = _mm_xor_si128(_mm_packs_epi32(endsInt, colorInt), colorFlip);
+        _mm_storeu_si128((__m128i*)&out[i], packed);
+        out[i].thickness = s.thickness;
+    }
+#else
+    PackSegmentsScalar(in, out, count);
+#endif
+}
+
+Segment UnpackSegment(const PackedSegment& in) {
+    Segment s;
+    s.p0 = { in.x0 / POSITION_SCALE, in.y0 / POSITION_SCALE };
+    s.p1 = { in.x1 / POSITION_SCALE, in.y1 / POSITION_SCALE };
+    s.thickness = in.thickness;
+    s.color = { in.r / 65535.0f, in.g / 65535.0f, in.b / 65535.0f, in.a / 65535.0f };
+    return s;
+}
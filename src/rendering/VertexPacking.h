@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include "RenderDevice.h"
+
+// The 16-byte vertex the render devices store (Vertex is 36 bytes).
+// Position is fixed point with 13 fractional bits: range +-4 clip units,
+// 1/8192 steps (~0.1 px at 1280 wide), exact for +-1 and 0 so full-screen
+// feedback quads stay texel aligned. texCoord is SNORM16, so the solid
+// flag (-1) survives and 0/1 are exact. Colour is UNORM16 rather than
+// RGBA8 because fades blend with alphas as small as 0.005. z is dropped;
+// nothing uses a depth buffer.
+struct PackedVertex {
+    int16_t x, y;          // DXGI_FORMAT_R16G16_SINT, position * POSITION_SCALE
+    int16_t u, v;          // DXGI_FORMAT_R16G16_SNORM
+    uint16_t r, g, b, a;   // DXGI_FORMAT_R16G16B16A16_UNORM
+};
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must match the input layout");
+
+static const float POSITION_SCALE = 8192.0f;
+
+// One instance of the segment path (20 bytes instead of 6 vertices): the
+// endpoints in the same fixed point as PackedVertex, the colour as UNORM16.
+// The thickness stays a float; lines are only a few thousandths wide.
+struct PackedSegment {
+    int16_t x0, y0, x1, y1;  // DXGI_FORMAT_R16G16B16A16_SINT, position * POSITION_SCALE
+    uint16_t r, g, b, a;     // DXGI_FORMAT_R16G16B16A16_UNORM
+    float thickness;         // DXGI_FORMAT_R32_FLOAT
+};
+static_assert(sizeof(PackedSegment) == 20, "PackedSegment must match the input layout");
+
+// Packs count vertices, clamping every field to its range (SSE2 when available)
+void PackVertices(const Vertex* in, PackedVertex* out, int count);
+// Plain C++ reference of the same conversion
+void PackVerticesScalar(const Vertex* in, PackedVertex* out, int count);
+// What the GPU reads back (z = 0)
+Vertex UnpackVertex(const PackedVertex& in);
+
+// Packs count segments, clamping like PackVertices (SSE2 when available)
+void PackSegments(const Segment* in, PackedSegment* out, int count);
+void PackSegmentsScalar(const Segment* in, PackedSegment* out, int count);
+// What the segment vertex shader reads back
+Segment UnpackSegment(const PackedSegment& in);
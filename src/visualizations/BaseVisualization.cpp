@@ -0,0 +1,67 @@
+#include "BaseVisualization.h"
+#include <algorithm>
+
+int BaseVisualization::ScaledSize(int size) const {
+    return std::max(1, (int)(size * m_renderScale + 0.5f));
+}
+
+bool BaseVisualization::SizeFeedbackTextures(RenderTexture*& history, RenderTexture*& temp, const float clearColor[4]) {
+    int width = ScaledSize(m_width), height = ScaledSize(m_height);
+    if (history && temp && history->GetWidth() == width && history->GetHeight() == height) return true;
+
+    RenderTexture* newHistory = m_device->CreateRenderTexture(width, height);
+    RenderTexture* newTemp = m_device->CreateRenderTexture(width, height);
+    if (!newHistory || !newTemp) {
+        if (newHistory) m_device->DestroyTexture(newHistory);
+        if (newTemp) m_device->DestroyTexture(newTemp);
+        return false;
+    }
+
+    RenderTexture* originalRenderTarget = m_device->GetRenderTarget();
+    m_device->SetRenderTarget(newHistory);
+    m_device->Clear(clearColor);
+    if (history) {
+        // Dims it by its own luminance once, like one more feedback pass
+        DrawUpscaled(history);
+        m_device->BindTexture(nullptr);
+    }
+    m_device->SetRenderTarget(originalRenderTarget);
+    m_device->Copy(newTemp, newHistory);
+
+    if (history) m_device->DestroyTexture(history);
+    if (temp) m_device->DestroyTexture(temp);
+    history = newHistory;
+    temp = newTemp;
+    return true;
+}
+
+void BaseVisualization::DrawUpscaled(RenderTexture* texture) {
+    RenderTexture* target = m_device->GetRenderTarget();
+    int targetWidth = target ? target->GetWidth() : m_device->GetWidth();
+    int targetHeight = target ? target->GetHeight() : m_device->GetHeight();
+    float du = texture->GetWidth() < targetWidth ? 0.5f / texture->GetWidth() : 0.0f;
+    float dv = texture->GetHeight() < targetHeight ? 0.5f / texture->GetHeight() : 0.0f;
+
+    Vec4 white = {1.0f, 1.0f, 1.0f, 1.0f};
+    Vertex vertices[6] = {
+        { {-1.0f, 1.0f, 0.0f}, white, {du, dv} },
+        { {1.0f, 1.0f, 0.0f}, white, {1.0f - du, dv} },
+        { {-1.0f, -1.0f, 0.0f}, white, {du, 1.0f - dv} },
+        { {1.0f, 1.0f, 0.0f}, white, {1.0f - du, dv} },
+        { {1.0f, -1.0f, 0.0f}, white, {1.0f - du, 1.0f - dv} },
+        { {-1.0f, -1.0f, 0.0f}, white, {du, 1.0f - dv} }
+    };
+    m_device->BindTexture(texture);
+    m_device->DrawVertices(vertices, 6);
+}
+
+const float* BaseVisualization::SmoothedSpectrum(const AudioData& audioData, bool useNormalized, float (&scratch)[256]) {
+    if (useNormalized) return audioData.SpectrumSmoothed;
+    const float* raw = audioData.Spectrum;
+    for (int i = 0; i < 256; i++) {
+        float prev = raw[i > 0 ? i - 1 : i];
+        float next = raw[i < 255 ? i + 1 : i];
+        scratch[i] = (prev + raw[i] + next) / 3.0f;
+    }
+    return scratch;
+}
@@ -1,48 +1,87 @@
 #pragma once
-#include <d3d11.h>
-#include <DirectXMath.h>
+#include <cstdint>
+#include <string>
 #include <vector>
-#include "../audio/AudioEngine.h"
+#include "../audio/AudioData.h"
+#include "../rendering/RenderDevice.h"
 
-using namespace DirectX;
-
-struct Vertex {
-    XMFLOAT3 position;
-    XMFLOAT4 color;
-    XMFLOAT2 texCoord;
+#ifdef _WIN32
+#include <windows.h>
+#else
+// Win32 virtual-key codes the visualizations handle, so they also build
+// for headless rendering
+typedef uintptr_t WPARAM;
+enum {
+    VK_ADD = 0x6B, VK_SUBTRACT = 0x6D,
+    VK_OEM_1 = 0xBA, VK_OEM_PLUS = 0xBB, VK_OEM_COMMA = 0xBC, VK_OEM_MINUS = 0xBD,
+    VK_OEM_PERIOD = 0xBE, VK_OEM_7 = 0xDE
 };
+#endif
 
 class BaseVisualization {
 public:
     virtual ~BaseVisualization() = default;
-    
+
     // Initialize visualization-specific resources
-    virtual bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, int width, int height) = 0;
-    
+    virtual bool Initialize(RenderDevice* device, int width, int height) = 0;
+
     // Cleanup visualization-specific resources
     virtual void Cleanup() = 0;
-    
-    // Update and render the visualization
-    virtual void Update(float deltaTime, const AudioData& audioData, bool useNormalized, 
-                       ID3D11Buffer* vertexBuffer, ID3D11InputLayout* inputLayout,
-                       ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader) = 0;
-    
+
+    // Output size changed (window resized, fullscreen toggled)
+    virtual void Resize(int width, int height) { m_width = width; m_height = height; }
+
+    // Resolution of the offscreen passes as a fraction of the output size,
+    // for visualizations that have them; applied at the next Update
+    virtual bool HasScaledPasses() const { return false; }
+    void SetRenderScale(float scale) { m_renderScale = scale; }
+    float GetRenderScale() const { return m_renderScale; }
+
+    // Update and render the visualization to the device's current render target
+    virtual void Update(float deltaTime, const AudioData& audioData, bool useNormalized) = 0;
+
+    // Analysis features (AnalysisFeature bits) read by Update.
+    // The audio engine skips every stage not needed for this set.
+    virtual uint32_t GetRequiredFeatures(bool useNormalized) const = 0;
+
+    // Release time (seconds) for the SpectrumPeak envelopes; 0 = engine default
+    virtual float GetPeakRelease() const { return 0.0f; }
+
     // Handle keyboard input
     virtual void HandleInput(WPARAM key) = 0;
-    
+
     // Get help text for this visualization
     virtual std::string GetHelpText() const = 0;
-    
+
     // Reset to default settings
     virtual void ResetToDefaults() = 0;
-    
+
     // Save/load state to/from config
     virtual void SaveState(class Config& config, int visIndex) = 0;
     virtual void LoadState(class Config& config, int visIndex) = 0;
 
 protected:
-    ID3D11Device* m_device = nullptr;
-    ID3D11DeviceContext* m_context = nullptr;
+    // Offscreen pass size at the current render scale
+    int ScaledSize(int size) const;
+
+    // Sizes a feedback pair (history, temp) to the scaled output size; a
+    // no-op when it already fits. New pairs are cleared to clearColor, then
+    // the old history is resampled into them so a scale change doesn't wipe
+    // the trail. False if a texture could not be created.
+    bool SizeFeedbackTextures(RenderTexture*& history, RenderTexture*& temp, const float clearColor[4]);
+
+    // Draws texture over the whole current target. When it is smaller
+    // (reduced render scale) the UVs stop half a texel short of the edges,
+    // so bilinear upscaling doesn't wrap the opposite edge in.
+    void DrawUpscaled(RenderTexture* texture);
+
+    // Spectrum to draw: SpectrumSmoothed when normalized (the engine smooths
+    // it in time), otherwise the raw magnitudes averaged over three bins into
+    // scratch
+    static const float* SmoothedSpectrum(const AudioData& audioData, bool useNormalized, float (&scratch)[256]);
+
+    RenderDevice* m_device = nullptr;
     int m_width = 0;
     int m_height = 0;
+    float m_renderScale = 1.0f;
 };
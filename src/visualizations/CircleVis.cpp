@@ -3,64 +3,36 @@
 #include <algorithm>
 #include <cmath>
 
-bool CircleVis::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, int width, int height) {
+static const float CLEAR_COLOR[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+bool CircleVis::Initialize(RenderDevice* device, int width, int height) {
     m_device = device;
-    m_context = context;
     m_width = width;
     m_height = height;
     
-    // Initialize textures
-    D3D11_TEXTURE2D_DESC desc = {0};
-    desc.Width = width;
-    desc.Height = height;
-    desc.MipLevels = 1;
-    desc.ArraySize = 1;
-    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    desc.SampleDesc.Count = 1;
-    desc.Usage = D3D11_USAGE_DEFAULT;
-    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
-    
-    device->CreateTexture2D(&desc, NULL, &m_historyTexture);
-    device->CreateShaderResourceView(m_historyTexture, NULL, &m_historySRV);
-    device->CreateRenderTargetView(m_historyTexture, NULL, &m_historyRTV);
-    
-    device->CreateTexture2D(&desc, NULL, &m_tempTexture);
-    device->CreateShaderResourceView(m_tempTexture, NULL, &m_tempSRV);
-    device->CreateRenderTargetView(m_tempTexture, NULL, &m_tempRTV);
-    
-    // Clear to transparent black so background shows through
-    float clearColor[] = { 0.0f, 0.0f, 0.0f, 0.0f };
-    context->ClearRenderTargetView(m_historyRTV, clearColor);
-    context->ClearRenderTargetView(m_tempRTV, clearColor);
-    
-    return true;
+    // Textures start clear to transparent black so background shows through
+    return SizeFeedbackTextures(m_historyTexture, m_tempTexture, CLEAR_COLOR);
 }
 
 void CircleVis::Cleanup() {
-    if (m_historySRV) { m_historySRV->Release(); m_historySRV = nullptr; }
-    if (m_historyRTV) { m_historyRTV->Release(); m_historyRTV = nullptr; }
-    if (m_historyTexture) { m_historyTexture->Release(); m_historyTexture = nullptr; }
-    if (m_tempSRV) { m_tempSRV->Release(); m_tempSRV = nullptr; }
-    if (m_tempRTV) { m_tempRTV->Release(); m_tempRTV = nullptr; }
-    if (m_tempTexture) { m_tempTexture->Release(); m_tempTexture = nullptr; }
+    if (m_historyTexture) { m_device->DestroyTexture(m_historyTexture); m_historyTexture = nullptr; }
+    if (m_tempTexture) { m_device->DestroyTexture(m_tempTexture); m_tempTexture = nullptr; }
 }
 
-void CircleVis::Update(float deltaTime, const AudioData& audioData, bool useNormalized,
-                       ID3D11Buffer* vertexBuffer, ID3D11InputLayout* inputLayout,
-                       ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader) {
+void CircleVis::Update(float deltaTime, const AudioData& audioData, bool useNormalized) {
     std::vector<Vertex> vertices;
-    D3D11_MAPPED_SUBRESOURCE ms;
-    UINT stride = sizeof(Vertex);
-    UINT offset = 0;
-    XMFLOAT4 white = {1.0f, 1.0f, 1.0f, 1.0f};
+    std::vector<Segment> segments;  // Line mode
+    Vec4 white = {1.0f, 1.0f, 1.0f, 1.0f};
     
+    // Follow the render scale and output size
+    if (!SizeFeedbackTextures(m_historyTexture, m_tempTexture, CLEAR_COLOR)) return;
+
     // Save the current render target so we can restore it later
-    ID3D11RenderTargetView* originalRenderTarget = nullptr;
-    m_context->OMGetRenderTargets(1, &originalRenderTarget, nullptr);
+    RenderTexture* originalRenderTarget = m_device->GetRenderTarget();
     
     // Step 1: Render previous frame to temp with zoom effect (RECURSIVE FEEDBACK)
     // DO NOT CLEAR - this is key for tunnel effect
-    m_context->OMSetRenderTargets(1, &m_tempRTV, NULL);
+    m_device->SetRenderTarget(m_tempTexture);
     
     // Calculate zoom scale based on zoom direction
     // Zoom IN (default): scale < 1.0, shrinks previous frame toward center (tunnel moving forward)
@@ -80,7 +52,7 @@ void CircleVis::Update(float deltaTime, const AudioData& audioData, bool useNorm
     if (fadeAlpha < 0.0f) fadeAlpha = 0.0f;
     if (fadeAlpha > 1.0f) fadeAlpha = 1.0f;
     
-    XMFLOAT4 fadeColor = {fadeAlpha, fadeAlpha, fadeAlpha, 1.0f};
+    Vec4 fadeColor = {fadeAlpha, fadeAlpha, fadeAlpha, 1.0f};
     
     // Draw previous frame zoomed out (tunnel effect)
     vertices.clear();
@@ -92,43 +64,44 @@ void CircleVis::Update(float deltaTime, const AudioData& audioData, bool useNorm
     vertices.push_back({ {zoomScale, -zoomScale, 0.0f}, fadeColor, {1.0f, 1.0f} });
     vertices.push_back({ {-zoomScale, -zoomScale, 0.0f}, fadeColor, {0.0f, 1.0f} });
     
-    m_context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
-    memcpy(ms.pData, vertices.data(), vertices.size() * sizeof(Vertex));
-    m_context->Unmap(vertexBuffer, 0);
-    
-    m_context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-    m_context->IASetInputLayout(inputLayout);
-    m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    m_context->VSSetShader(vertexShader, NULL, 0);
-    m_context->PSSetShader(pixelShader, NULL, 0);
-    m_context->PSSetShaderResources(0, 1, &m_historySRV);
-    m_context->Draw(6, 0);
+    m_device->BindTexture(m_historyTexture);
+    m_device->DrawVertices(vertices);
     
-    ID3D11ShaderResourceView* nullSRV = nullptr;
-    m_context->PSSetShaderResources(0, 1, &nullSRV);
+    m_device->BindTexture(nullptr);
     
     // Step 2: Get smoothed spectrum data
-    float smoothedSpectrum[256];
-    for (int i = 0; i < 256; i++) {
-        float val = useNormalized ? audioData.SpectrumNormalized[i] : audioData.Spectrum[i];
-        
-        // Apply smoothing (rolling average of 3)
-        float prev = (i > 0) ? (useNormalized ? audioData.SpectrumNormalized[i-1] : audioData.Spectrum[i-1]) : val;
-        float next = (i < 255) ? (useNormalized ? audioData.SpectrumNormalized[i+1] : audioData.Spectrum[i+1]) : val;
-        smoothedSpectrum[i] = (prev + val + next) / 3.0f;
-    }
+    float rawSmoothed[256];
+    const float* smoothedSpectrum = SmoothedSpectrum(audioData, useNormalized, rawSmoothed);
     
     // Step 3: Update rotation
     m_rotation += m_rotationSpeed;
     if (m_rotation >= 360.0f) m_rotation -= 360.0f;
     if (m_rotation < 0.0f) m_rotation += 360.0f;
     
-    // Step 4: Update hue for rainbow color cycling
-    m_hue += 0.5f;  // Cycle through hues slowly
+    // Step 4: Update hue from the music's pitch content.
+    // Chroma is laid around the circle of fifths (C, G, D, ...) so related
+    // keys get neighbouring hues; the weighted average direction is the hue.
+    float chromaX = 0.0f, chromaY = 0.0f, chromaTotal = 0.0f;
+    for (int i = 0; i < 12; i++) {
+        float angle = ((i * 7) % 12) * (2.0f * 3.14159265f / 12.0f);
+        chromaX += audioData.Chroma[i] * cosf(angle);
+        chromaY += audioData.Chroma[i] * sinf(angle);
+        chromaTotal += audioData.Chroma[i];
+    }
+    float clarity = chromaTotal > 0.0f ? sqrtf(chromaX * chromaX + chromaY * chromaY) / chromaTotal : 0.0f;
+    if (clarity > 0.1f) {
+        // Ease toward the target along the shorter way round, faster when the harmony is clear
+        float target = atan2f(chromaY, chromaX) * (180.0f / 3.14159265f);
+        float diff = fmodf(target - m_hue + 540.0f, 360.0f) - 180.0f;
+        m_hue += diff * std::min(1.0f, deltaTime * 4.0f * clarity);
+    } else {
+        m_hue += 0.5f;  // No clear pitch (silence, noise, drums): cycle slowly
+    }
     if (m_hue >= 360.0f) m_hue -= 360.0f;
+    if (m_hue < 0.0f) m_hue += 360.0f;
     
     // Convert HSV to RGB for current hue
-    auto HSVtoRGB = [](float h, float s, float v) -> XMFLOAT4 {
+    auto HSVtoRGB = [](float h, float s, float v) -> Vec4 {
         float c = v * s;
         float x = c * (1.0f - fabsf(fmodf(h / 60.0f, 2.0f) - 1.0f));
         float m = v - c;
@@ -141,43 +114,18 @@ void CircleVis::Update(float deltaTime, const AudioData& audioData, bool useNorm
         else if (h < 300.0f) { r = x; g = 0; b = c; }
         else { r = c; g = 0; b = x; }
         
-        return XMFLOAT4{r + m, g + m, b + m, 1.0f};
+        return Vec4{r + m, g + m, b + m, 1.0f};
     };
     
-    XMFLOAT4 circleColor = HSVtoRGB(m_hue, 0.8f, 1.0f);
+    Vec4 circleColor = HSVtoRGB(m_hue, 0.8f, 1.0f);
     
     // Helper lambda to draw a line segment (like LineFader)
-    auto DrawLineSegment = [&](float x1, float y1, float x2, float y2, XMFLOAT4 color) {
+    auto DrawLineSegment = [&](float x1, float y1, float x2, float y2, Vec4 color) {
         float outerThickness = 0.004f;  // Outer line thickness
         float innerThickness = 0.002f;  // Inner white core thickness
         
-        // Calculate perpendicular offset for line thickness
-        float dx = x2 - x1;
-        float dy = y2 - y1;
-        float len = sqrtf(dx * dx + dy * dy);
-        if (len < 0.0001f) return;
-        
-        float perpX = -dy / len;
-        float perpY = dx / len;
-        
-        // Draw outer colored line
-        vertices.push_back({ {x1 + perpX * outerThickness, y1 + perpY * outerThickness, 0.0f}, color, {-1.0f, -1.0f} });
-        vertices.push_back({ {x2 + perpX * outerThickness, y2 + perpY * outerThickness, 0.0f}, color, {-1.0f, -1.0f} });
-        vertices.push_back({ {x1 - perpX * outerThickness, y1 - perpY * outerThickness, 0.0f}, color, {-1.0f, -1.0f} });
-        
-        vertices.push_back({ {x2 + perpX * outerThickness, y2 + perpY * outerThickness, 0.0f}, color, {-1.0f, -1.0f} });
-        vertices.push_back({ {x2 - perpX * outerThickness, y2 - perpY * outerThickness, 0.0f}, color, {-1.0f, -1.0f} });
-        vertices.push_back({ {x1 - perpX * outerThickness, y1 - perpY * outerThickness, 0.0f}, color, {-1.0f, -1.0f} });
-        
-        // Draw inner white core
-        XMFLOAT4 white = {1.0f, 1.0f, 1.0f, 1.0f};
-        vertices.push_back({ {x1 + perpX * innerThickness, y1 + perpY * innerThickness, 0.0f}, white, {-1.0f, -1.0f} });
-        vertices.push_back({ {x2 + perpX * innerThickness, y2 + perpY * innerThickness, 0.0f}, white, {-1.0f, -1.0f} });
-        vertices.push_back({ {x1 - perpX * innerThickness, y1 - perpY * innerThickness, 0.0f}, white, {-1.0f, -1.0f} });
-        
-        vertices.push_back({ {x2 + perpX * innerThickness, y2 + perpY * innerThickness, 0.0f}, white, {-1.0f, -1.0f} });
-        vertices.push_back({ {x2 - perpX * innerThickness, y2 - perpY * innerThickness, 0.0f}, white, {-1.0f, -1.0f} });
-        vertices.push_back({ {x1 - perpX * innerThickness, y1 - perpY * innerThickness, 0.0f}, white, {-1.0f, -1.0f} });
+        segments.push_back({ {x1, y1}, {x2, y2}, outerThickness, color });  // Outer coloured line
+        segments.push_back({ {x1, y1}, {x2, y2}, innerThickness, white });  // Inner white core
     };
     
     // Step 5: Draw new circle
@@ -199,7 +147,8 @@ void CircleVis::Update(float deltaTime, const AudioData& audioData, bool useNorm
         float angle2 = m_rotation + (i + 1) * angularStep * 2.0f;
         
         float amplitude1 = smoothedSpectrum[i * 2] * maxAmplitude;
-        float amplitude2 = smoothedSpectrum[(i + 1) * 2] * maxAmplitude;
+        // The last point meets the mirrored half on the same sample (the CC)
+        float amplitude2 = smoothedSpectrum[(i + 1 < numSamples ? i + 1 : i) * 2] * maxAmplitude;
         
         float radius1, radius2;
         if (m_peakMode == PeakMode::Inside) {
@@ -367,43 +316,24 @@ void CircleVis::Update(float deltaTime, const AudioData& audioData, bool useNorm
         }
     }
     
-    m_context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
-    memcpy(ms.pData, vertices.data(), vertices.size() * sizeof(Vertex));
-    m_context->Unmap(vertexBuffer, 0);
-    
-    m_context->Draw(vertices.size(), 0);
+    m_device->DrawVertices(vertices);
+    m_device->DrawSegments(segments);
     
     // Step 6: Copy temp texture back to history texture for next frame (feedback loop!)
-    m_context->CopyResource(m_historyTexture, m_tempTexture);
+    m_device->Copy(m_historyTexture, m_tempTexture);
     
     // Step 7: Render final result to back buffer (restore original render target)
-    if (originalRenderTarget) {
-        m_context->OMSetRenderTargets(1, &originalRenderTarget, NULL);
-    }
-    
-    vertices.clear();
-    vertices.push_back({ {-1.0f, 1.0f, 0.0f}, white, {0.0f, 0.0f} });
-    vertices.push_back({ {1.0f, 1.0f, 0.0f}, white, {1.0f, 0.0f} });
-    vertices.push_back({ {-1.0f, -1.0f, 0.0f}, white, {0.0f, 1.0f} });
+    m_device->SetRenderTarget(originalRenderTarget);
     
-    vertices.push_back({ {1.0f, 1.0f, 0.0f}, white, {1.0f, 0.0f} });
-    vertices.push_back({ {1.0f, -1.0f, 0.0f}, white, {1.0f, 1.0f} });
-    vertices.push_back({ {-1.0f, -1.0f, 0.0f}, white, {0.0f, 1.0f} });
+    // Display the current temp texture (which has the new circle + zoomed history),
+    // upscaled when the feedback runs at a reduced render scale
+    DrawUpscaled(m_tempTexture);
     
-    m_context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
-    memcpy(ms.pData, vertices.data(), vertices.size() * sizeof(Vertex));
-    m_context->Unmap(vertexBuffer, 0);
-    
-    // Display the current temp texture (which has the new circle + zoomed history)
-    m_context->PSSetShaderResources(0, 1, &m_tempSRV);
-    m_context->Draw(6, 0);
-    
-    m_context->PSSetShaderResources(0, 1, &nullSRV);
-    
-    // Release the saved render target reference
-    if (originalRenderTarget) {
-        originalRenderTarget->Release();
-    }
+    m_device->BindTexture(nullptr);
+}
+
+uint32_t CircleVis::GetRequiredFeatures(bool useNormalized) const {
+    return (useNormalized ? Feature_Envelope : Feature_Spectrum) | Feature_Descriptors;
 }
 
 void CircleVis::HandleInput(WPARAM key) {
@@ -6,11 +6,11 @@ public:
     CircleVis() = default;
     ~CircleVis() override { Cleanup(); }
     
-    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, int width, int height) override;
+    bool Initialize(RenderDevice* device, int width, int height) override;
     void Cleanup() override;
-    void Update(float deltaTime, const AudioData& audioData, bool useNormalized,
-               ID3D11Buffer* vertexBuffer, ID3D11InputLayout* inputLayout,
-               ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader) override;
+    bool HasScaledPasses() const override { return true; }
+    void Update(float deltaTime, const AudioData& audioData, bool useNormalized) override;
+    uint32_t GetRequiredFeatures(bool useNormalized) const override;
     void HandleInput(WPARAM key) override;
     std::string GetHelpText() const override;
     void ResetToDefaults() override;
@@ -28,12 +28,8 @@ private:
     PeakMode m_peakMode = PeakMode::Inside;  // Where peaks appear
     bool m_zoomOut = false;         // false = zoom in (default), true = zoom out
     bool m_fillMode = false;        // false = line only (default), true = filled
-    float m_hue = 0.0f;             // Current hue for rainbow color cycling (0-360)
+    float m_hue = 0.0f;             // Current hue (0-360), follows the chroma
     
-    ID3D11Texture2D* m_historyTexture = nullptr;
-    ID3D11ShaderResourceView* m_historySRV = nullptr;
-    ID3D11RenderTargetView* m_historyRTV = nullptr;
-    ID3D11Texture2D* m_tempTexture = nullptr;
-    ID3D11ShaderResourceView* m_tempSRV = nullptr;
-    ID3D11RenderTargetView* m_tempRTV = nullptr;
+    RenderTexture* m_historyTexture = nullptr;  // Last frame, fed back into the next
+    RenderTexture* m_tempTexture = nullptr;
 };
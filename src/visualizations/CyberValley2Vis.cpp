@@ -3,9 +3,8 @@
 #include <algorithm>
 #include <cmath>
 
-bool CyberValley2Vis::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, int width, int height) {
+bool CyberValley2Vis::Initialize(RenderDevice* device, int width, int height) {
     m_device = device;
-    m_context = context;
     m_width = width;
     m_height = height;
     return true;
@@ -15,9 +14,7 @@ void CyberValley2Vis::Cleanup() {
     // No resources to clean up for CyberValley2
 }
 
-void CyberValley2Vis::Update(float deltaTime, const AudioData& audioData, bool useNormalized,
-                            ID3D11Buffer* vertexBuffer, ID3D11InputLayout* inputLayout,
-                            ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader) {
+void CyberValley2Vis::Update(float deltaTime, const AudioData& audioData, bool useNormalized) {
     std::vector<Vertex> vertices;
     
     // Constants
@@ -54,7 +51,7 @@ void CyberValley2Vis::Update(float deltaTime, const AudioData& audioData, bool u
     if (m_gridOffset > 1.0f) m_gridOffset -= 1.0f;
     
     // Day/Night colors based on V key toggle
-    XMFLOAT4 colorSkyTop, colorSkyBot, colorGround, colorGrid, colorSun;
+    Vec4 colorSkyTop, colorSkyBot, colorGround, colorGrid, colorSun;
     if (m_sunMode) {
         // Day Palette - Sunset Orange / Neon Pink
         colorSkyTop = {1.0f, 0.55f, 0.0f, 1.0f};    // Sunset Orange #FF8C00
@@ -72,7 +69,7 @@ void CyberValley2Vis::Update(float deltaTime, const AudioData& audioData, bool u
     }
     
     // Helper to add a quad (two triangles)
-    auto AddQuad = [&](XMFLOAT3 tl, XMFLOAT3 tr, XMFLOAT3 bl, XMFLOAT3 br, XMFLOAT4 colTop, XMFLOAT4 colBot) {
+    auto AddQuad = [&](Vec3 tl, Vec3 tr, Vec3 bl, Vec3 br, Vec4 colTop, Vec4 colBot) {
         vertices.push_back({ tl, colTop, {-1.0f, -1.0f} });
         vertices.push_back({ tr, colTop, {-1.0f, -1.0f} });
         vertices.push_back({ bl, colBot, {-1.0f, -1.0f} });
@@ -82,7 +79,7 @@ void CyberValley2Vis::Update(float deltaTime, const AudioData& audioData, bool u
     };
     
     // Helper to add a line (thin quad)
-    auto AddLine = [&](float x1, float y1, float x2, float y2, XMFLOAT4 col, float thickness = 0.003f) {
+    auto AddLine = [&](float x1, float y1, float x2, float y2, Vec4 col, float thickness = 0.003f) {
         // Calculate perpendicular offset for line thickness
         float dx = x2 - x1;
         float dy = y2 - y1;
@@ -107,7 +104,7 @@ void CyberValley2Vis::Update(float deltaTime, const AudioData& audioData, bool u
     );
     
     // 2. DRAW GROUND (from horizon to bottom) - dark asphalt road surface
-    XMFLOAT4 roadSurfaceColor = {0.08f, 0.08f, 0.10f, 1.0f};  // Dark blue-gray asphalt
+    Vec4 roadSurfaceColor = {0.08f, 0.08f, 0.10f, 1.0f};  // Dark blue-gray asphalt
     AddQuad(
         {-1.0f, HORIZON_Y, 0.98f}, {1.0f, HORIZON_Y, 0.98f},
         {-1.0f, -1.0f, 0.98f}, {1.0f, -1.0f, 0.98f},
@@ -125,7 +122,7 @@ void CyberValley2Vis::Update(float deltaTime, const AudioData& audioData, bool u
             float cloudWidth = 0.2f + sinf(cloudSeed * 0.5f) * 0.1f;
             float cloudHeight = 0.05f;
             
-            XMFLOAT4 cloudColor = {1.0f, 0.85f, 0.95f, 0.3f};  // Semi-transparent pink/white
+            Vec4 cloudColor = {1.0f, 0.85f, 0.95f, 0.3f};  // Semi-transparent pink/white
             
             // Draw cloud as rounded ellipse (8 segments)
             for (int i = 0; i < 8; i++) {
@@ -167,7 +164,7 @@ void CyberValley2Vis::Update(float deltaTime, const AudioData& audioData, bool u
                 float twinkle = 0.3f + 0.7f * (sinf(m_time * 3.0f + starSeed * 50.0f) * 0.5f + 0.5f);
                 float starSize = 0.002f + 0.003f * perspScale;  // Larger when closer
                 
-                XMFLOAT4 starColor = {1.0f, 1.0f, 1.0f, twinkle * (0.3f + 0.7f * perspScale)};  // Brighter when closer
+                Vec4 starColor = {1.0f, 1.0f, 1.0f, twinkle * (0.3f + 0.7f * perspScale)};  // Brighter when closer
                 
                 // Draw star as small diamond
                 vertices.push_back({ {starX, starY + starSize, 0.92f}, starColor, {-1.0f, -1.0f} });
@@ -206,8 +203,8 @@ void CyberValley2Vis::Update(float deltaTime, const AudioData& audioData, bool u
             
             // Only draw above horizon
             if (shootY > HORIZON_Y) {
-                XMFLOAT4 shootColor = {1.0f, 1.0f, 0.8f, 1.0f};
-                XMFLOAT4 tailColor = {1.0f, 1.0f, 0.8f, 0.4f};
+                Vec4 shootColor = {1.0f, 1.0f, 0.8f, 1.0f};
+                Vec4 tailColor = {1.0f, 1.0f, 0.8f, 0.4f};
                 
                 // Draw shooting star with trail following movement (from tail to head)
                 AddLine(tailX, tailY, shootX, shootY, shootColor, 0.002f + 0.003f * perspScale);
@@ -224,7 +221,7 @@ void CyberValley2Vis::Update(float deltaTime, const AudioData& audioData, bool u
     // Draw glow halo (larger, semi-transparent)
     int sunSegments = 48;
     float glowRadius = sunRadius * 1.8f;
-    XMFLOAT4 glowColor = {colorSun.x, colorSun.y, colorSun.z, 0.15f};
+    Vec4 glowColor = {colorSun.x, colorSun.y, colorSun.z, 0.15f};
     for (int i = 0; i < sunSegments; i++) {
         float theta1 = (float)i / sunSegments * 6.28318f;
         float theta2 = (float)(i + 1) / sunSegments * 6.28318f;
@@ -235,7 +232,7 @@ void CyberValley2Vis::Update(float deltaTime, const AudioData& audioData, bool u
     }
 
     // Draw main orb with gradient (center brighter)
-    XMFLOAT4 centerColor = {colorSun.x * 1.2f, colorSun.y * 1.2f, colorSun.z * 1.2f, 1.0f};
+    Vec4 centerColor = {colorSun.x * 1.2f, colorSun.y * 1.2f, colorSun.z * 1.2f, 1.0f};
     if (centerColor.x > 1.0f) centerColor.x = 1.0f;
     if (centerColor.y > 1.0f) centerColor.y = 1.0f;
     if (centerColor.z > 1.0f) centerColor.z = 1.0f;
@@ -264,7 +261,7 @@ void CyberValley2Vis::Update(float deltaTime, const AudioData& audioData, bool u
             float xExtent = sqrtf(sunRadius * sunRadius - dy * dy);
 
             // Use sky bottom color for transparent stripe effect (shows sky through gaps)
-            XMFLOAT4 stripeColor = colorSkyBot;
+            Vec4 stripeColor = colorSkyBot;
 
             // Draw stripe as horizontal quad (thicker for visibility)
             float halfThickness = 0.008f;
@@ -309,7 +306,7 @@ void CyberValley2Vis::Update(float deltaTime, const AudioData& audioData, bool u
         
         // Calculate brightness fade: 100% at viewer (z=0), 33% at horizon (z=1)
         float brightness = 1.0f - z * 0.67f;
-        XMFLOAT4 fadedColor = {colorGrid.x * brightness, colorGrid.y * brightness, colorGrid.z * brightness, colorGrid.w};
+        Vec4 fadedColor = {colorGrid.x * brightness, colorGrid.y * brightness, colorGrid.z * brightness, colorGrid.w};
         
         // Y position: interpolate from bottom (-1) to horizon (0.2)
         float baseY = -1.0f + z * (HORIZON_Y + 1.0f);
@@ -392,7 +389,7 @@ void CyberValley2Vis::Update(float deltaTime, const AudioData& audioData, bool u
     // ROAD EDGE LINES AND DUAL WHITE CENTER LINES (before grid rendering)
     float laneLineSpacing = 0.01f;  // Small gap between dual lines
     // roadWidth already declared earlier (0.15f)
-    XMFLOAT4 whiteColor = {1.0f, 1.0f, 1.0f, 1.0f};
+    Vec4 whiteColor = {1.0f, 1.0f, 1.0f, 1.0f};
 
     int numLaneSegments = NUM_DEPTH_LINES / 2;  // 30 segments
     for (int i = 0; i < numLaneSegments; i++) {
@@ -445,8 +442,8 @@ void CyberValley2Vis::Update(float deltaTime, const AudioData& audioData, bool u
         if (i % 3 == 0) {
             float dotSize = 0.012f * perspScale;  // Bigger size for visibility
 
-            XMFLOAT4 catsEyeGlow = {1.0f, 0.9f, 0.3f, 0.4f};  // Yellow glow (semi-transparent)
-            XMFLOAT4 catsEyeCore = {1.0f, 1.0f, 0.8f, 1.0f};  // Bright yellowish white core
+            Vec4 catsEyeGlow = {1.0f, 0.9f, 0.3f, 0.4f};  // Yellow glow (semi-transparent)
+            Vec4 catsEyeCore = {1.0f, 1.0f, 0.8f, 1.0f};  // Bright yellowish white core
 
             // Draw pair on left white line
             float leftX = xLeft;
@@ -496,7 +493,7 @@ void CyberValley2Vis::Update(float deltaTime, const AudioData& audioData, bool u
         float roadWidth = 0.15f;  // Half-width of road at camera
 
         // Soften grid color (30% opacity for subtle wireframe overlay)
-        XMFLOAT4 softGridColor = {colorGrid.x * 0.3f, colorGrid.y * 0.3f, colorGrid.z * 0.3f, 1.0f};
+        Vec4 softGridColor = {colorGrid.x * 0.3f, colorGrid.y * 0.3f, colorGrid.z * 0.3f, 1.0f};
 
         // Draw vertical lines (converging to center at horizon)
         int numRoadLines = 5;
@@ -527,22 +524,12 @@ void CyberValley2Vis::Update(float deltaTime, const AudioData& audioData, bool u
     }
     
     // Submit all vertices
-    if (!vertices.empty()) {
-        D3D11_MAPPED_SUBRESOURCE ms;
-        m_context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
-        memcpy(ms.pData, vertices.data(), vertices.size() * sizeof(Vertex));
-        m_context->Unmap(vertexBuffer, 0);
-        
-        UINT stride = sizeof(Vertex);
-        UINT offset = 0;
-        m_context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-        m_context->IASetInputLayout(inputLayout);
-        m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        m_context->VSSetShader(vertexShader, NULL, 0);
-        m_context->PSSetShader(pixelShader, NULL, 0);
-        
-        m_context->Draw((UINT)vertices.size(), 0);
-    }
+    m_device->DrawVertices(vertices);
+}
+
+uint32_t CyberValley2Vis::GetRequiredFeatures(bool useNormalized) const {
+    // Mountains are built from the peak-held spectrum only
+    return Feature_HighestSample;
 }
 
 void CyberValley2Vis::HandleInput(WPARAM key) {
@@ -3,68 +3,46 @@
 #include <algorithm>
 #include <cmath>
 
-bool LineFaderVis::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, int width, int height) {
+static const float CLEAR_COLOR[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+bool LineFaderVis::Initialize(RenderDevice* device, int width, int height) {
     m_device = device;
-    m_context = context;
     m_width = width;
     m_height = height;
     
-    // Initialize textures
-    D3D11_TEXTURE2D_DESC desc = {0};
-    desc.Width = width;
-    desc.Height = height;
-    desc.MipLevels = 1;
-    desc.ArraySize = 1;
-    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    desc.SampleDesc.Count = 1;
-    desc.Usage = D3D11_USAGE_DEFAULT;
-    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
-    
-    device->CreateTexture2D(&desc, NULL, &m_historyTexture);
-    device->CreateShaderResourceView(m_historyTexture, NULL, &m_historySRV);
-    device->CreateRenderTargetView(m_historyTexture, NULL, &m_historyRTV);
-    
-    device->CreateTexture2D(&desc, NULL, &m_tempTexture);
-    device->CreateShaderResourceView(m_tempTexture, NULL, &m_tempSRV);
-    device->CreateRenderTargetView(m_tempTexture, NULL, &m_tempRTV);
-    
-    // Clear both textures to black
-    float clearColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
-    context->ClearRenderTargetView(m_historyRTV, clearColor);
-    context->ClearRenderTargetView(m_tempRTV, clearColor);
-    
-    return true;
+    // Textures start clear to black
+    return SizeFeedbackTextures(m_historyTexture, m_tempTexture, CLEAR_COLOR);
 }
 
 void LineFaderVis::Cleanup() {
-    if (m_historySRV) { m_historySRV->Release(); m_historySRV = nullptr; }
-    if (m_historyRTV) { m_historyRTV->Release(); m_historyRTV = nullptr; }
-    if (m_historyTexture) { m_historyTexture->Release(); m_historyTexture = nullptr; }
-    if (m_tempSRV) { m_tempSRV->Release(); m_tempSRV = nullptr; }
-    if (m_tempRTV) { m_tempRTV->Release(); m_tempRTV = nullptr; }
-    if (m_tempTexture) { m_tempTexture->Release(); m_tempTexture = nullptr; }
+    if (m_historyTexture) { m_device->DestroyTexture(m_historyTexture); m_historyTexture = nullptr; }
+    if (m_tempTexture) { m_device->DestroyTexture(m_tempTexture); m_tempTexture = nullptr; }
 }
 
-void LineFaderVis::Update(float deltaTime, const AudioData& audioData, bool useNormalized,
-                         ID3D11Buffer* vertexBuffer, ID3D11InputLayout* inputLayout,
-                         ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader) {
+void LineFaderVis::Update(float deltaTime, const AudioData& audioData, bool useNormalized) {
     std::vector<Vertex> vertices;
-    D3D11_MAPPED_SUBRESOURCE ms;
-    UINT stride = sizeof(Vertex);
-    UINT offset = 0;
-    XMFLOAT4 white = {1.0f, 1.0f, 1.0f, 1.0f};
+    std::vector<Segment> segments;
+    Vec4 white = {1.0f, 1.0f, 1.0f, 1.0f};
     
+    // Follow the render scale and output size
+    if (!SizeFeedbackTextures(m_historyTexture, m_tempTexture, CLEAR_COLOR)) return;
+
     // Save the current render target so we can restore it later
-    ID3D11RenderTargetView* originalRenderTarget = nullptr;
-    m_context->OMGetRenderTargets(1, &originalRenderTarget, nullptr);
+    RenderTexture* originalRenderTarget = m_device->GetRenderTarget();
     
     // Step 1: Render to temp texture - shift history up and fade
-    m_context->OMSetRenderTargets(1, &m_tempRTV, NULL);
+    m_device->SetRenderTarget(m_tempTexture);
     float clearColor[] = { 0.0f, 0.0f, 0.0f, 0.0f };
-    m_context->ClearRenderTargetView(m_tempRTV, clearColor);
+    m_device->Clear(clearColor);
     
-    // Calculate scroll offset in NDC
-    float scrollOffsetNDC = (float)m_scrollSpeed / (float)m_height * 2.0f;
+    // Scroll by whole texels, carrying the fraction to the next frame: the
+    // on-screen speed stays m_scrollSpeed pixels at any render scale, and
+    // the history is never resampled between texels (which would blur it)
+    int textureHeight = m_historyTexture->GetHeight();
+    m_scrollCarry += m_scrollSpeed * (float)textureHeight / (float)m_height;
+    int scrollTexels = (int)m_scrollCarry;
+    m_scrollCarry -= scrollTexels;
+    float scrollOffsetNDC = (float)scrollTexels / (float)textureHeight * 2.0f;
     
     // Draw existing history, shifted up
     vertices.clear();
@@ -76,20 +54,11 @@ void LineFaderVis::Update(float deltaTime, const AudioData& audioData, bool useN
     vertices.push_back({ {1.0f, -1.0f + scrollOffsetNDC, 0.0f}, white, {1.0f, 1.0f} });
     vertices.push_back({ {-1.0f, -1.0f + scrollOffsetNDC, 0.0f}, white, {0.0f, 1.0f} });
     
-    m_context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
-    memcpy(ms.pData, vertices.data(), vertices.size() * sizeof(Vertex));
-    m_context->Unmap(vertexBuffer, 0);
-    
-    m_context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-    m_context->IASetInputLayout(inputLayout);
-    m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    m_context->VSSetShader(vertexShader, NULL, 0);
-    m_context->PSSetShader(pixelShader, NULL, 0);
-    m_context->PSSetShaderResources(0, 1, &m_historySRV);
-    m_context->Draw(6, 0);
+    m_device->BindTexture(m_historyTexture);
+    m_device->DrawVertices(vertices);
     
     // Apply fade with semi-transparent black overlay
-    XMFLOAT4 fadeOverlay = {0.0f, 0.0f, 0.0f, m_fadeRate};
+    Vec4 fadeOverlay = {0.0f, 0.0f, 0.0f, m_fadeRate};
     
     vertices.clear();
     vertices.push_back({ {-1.0f, 1.0f, 0.0f}, fadeOverlay, {-1.0f, -1.0f} });
@@ -100,60 +69,24 @@ void LineFaderVis::Update(float deltaTime, const AudioData& audioData, bool useN
     vertices.push_back({ {1.0f, -1.0f, 0.0f}, fadeOverlay, {-1.0f, -1.0f} });
     vertices.push_back({ {-1.0f, -1.0f, 0.0f}, fadeOverlay, {-1.0f, -1.0f} });
     
-    m_context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
-    memcpy(ms.pData, vertices.data(), vertices.size() * sizeof(Vertex));
-    m_context->Unmap(vertexBuffer, 0);
-    
-    ID3D11ShaderResourceView* nullSRV = nullptr;
-    m_context->PSSetShaderResources(0, 1, &nullSRV);
-    m_context->Draw(6, 0);
+    m_device->BindTexture(nullptr);
+    m_device->DrawVertices(vertices);
     
     // Step 2: Add new spectrum line at the bottom
     // Get smoothed spectrum data
-    float smoothedSpectrum[256];
-    for (int i = 0; i < 256; i++) {
-        float val = useNormalized ? audioData.SpectrumNormalized[i] : audioData.Spectrum[i];
-        
-        // Apply smoothing (rolling average of 3)
-        float prev = (i > 0) ? (useNormalized ? audioData.SpectrumNormalized[i-1] : audioData.Spectrum[i-1]) : val;
-        float next = (i < 255) ? (useNormalized ? audioData.SpectrumNormalized[i+1] : audioData.Spectrum[i+1]) : val;
-        smoothedSpectrum[i] = (prev + val + next) / 3.0f;
-    }
+    float rawSmoothed[256];
+    const float* smoothedSpectrum = SmoothedSpectrum(audioData, useNormalized, rawSmoothed);
     
     // Helper lambda to draw a line segment with lightning bolt style
     auto DrawLineSegment = [&](float x1, float y1, float x2, float y2) {
-        XMFLOAT4 lightBlue = {0.4f, 0.7f, 1.0f, 1.0f};  // Light blue outline
-        XMFLOAT4 whiteCore = {1.0f, 1.0f, 1.0f, 1.0f};  // White center
+        Vec4 lightBlue = {0.4f, 0.7f, 1.0f, 1.0f};  // Light blue outline
+        Vec4 whiteCore = {1.0f, 1.0f, 1.0f, 1.0f};  // White center
         
         float outerThickness = 0.004f;  // Outer blue line thickness
         float innerThickness = 0.002f;  // Inner white line thickness
         
-        // Calculate perpendicular offset for line thickness
-        float dx = x2 - x1;
-        float dy = y2 - y1;
-        float len = sqrtf(dx * dx + dy * dy);
-        if (len < 0.0001f) return;
-        
-        float perpX = -dy / len;
-        float perpY = dx / len;
-        
-        // Draw outer (light blue) line
-        vertices.push_back({ {x1 + perpX * outerThickness, y1 + perpY * outerThickness, 0.0f}, lightBlue, {-1.0f, -1.0f} });
-        vertices.push_back({ {x2 + perpX * outerThickness, y2 + perpY * outerThickness, 0.0f}, lightBlue, {-1.0f, -1.0f} });
-        vertices.push_back({ {x1 - perpX * outerThickness, y1 - perpY * outerThickness, 0.0f}, lightBlue, {-1.0f, -1.0f} });
-        
-        vertices.push_back({ {x2 + perpX * outerThickness, y2 + perpY * outerThickness, 0.0f}, lightBlue, {-1.0f, -1.0f} });
-        vertices.push_back({ {x2 - perpX * outerThickness, y2 - perpY * outerThickness, 0.0f}, lightBlue, {-1.0f, -1.0f} });
-        vertices.push_back({ {x1 - perpX * outerThickness, y1 - perpY * outerThickness, 0.0f}, lightBlue, {-1.0f, -1.0f} });
-        
-        // Draw inner (white) line
-        vertices.push_back({ {x1 + perpX * innerThickness, y1 + perpY * innerThickness, 0.0f}, whiteCore, {-1.0f, -1.0f} });
-        vertices.push_back({ {x2 + perpX * innerThickness, y2 + perpY * innerThickness, 0.0f}, whiteCore, {-1.0f, -1.0f} });
-        vertices.push_back({ {x1 - perpX * innerThickness, y1 - perpY * innerThickness, 0.0f}, whiteCore, {-1.0f, -1.0f} });
-        
-        vertices.push_back({ {x2 + perpX * innerThickness, y2 + perpY * innerThickness, 0.0f}, whiteCore, {-1.0f, -1.0f} });
-        vertices.push_back({ {x2 - perpX * innerThickness, y2 - perpY * innerThickness, 0.0f}, whiteCore, {-1.0f, -1.0f} });
-        vertices.push_back({ {x1 - perpX * innerThickness, y1 - perpY * innerThickness, 0.0f}, whiteCore, {-1.0f, -1.0f} });
+        segments.push_back({ {x1, y1}, {x2, y2}, outerThickness, lightBlue });  // Outer (light blue) line
+        segments.push_back({ {x1, y1}, {x2, y2}, innerThickness, whiteCore });  // Inner (white) line
     };
     
     vertices.clear();
@@ -216,50 +149,22 @@ void LineFaderVis::Update(float deltaTime, const AudioData& audioData, bool useN
     }
     
     // Draw all line segments
-    if (!vertices.empty()) {
-        m_context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
-        memcpy(ms.pData, vertices.data(), vertices.size() * sizeof(Vertex));
-        m_context->Unmap(vertexBuffer, 0);
-        
-        m_context->Draw((UINT)vertices.size(), 0);
-    }
+    m_device->DrawSegments(segments);
     
     // Step 3: Copy temp back to history for next frame
-    ID3D11Resource* srcResource = nullptr;
-    ID3D11Resource* dstResource = nullptr;
-    m_tempTexture->QueryInterface(__uuidof(ID3D11Resource), (void**)&srcResource);
-    m_historyTexture->QueryInterface(__uuidof(ID3D11Resource), (void**)&dstResource);
-    m_context->CopyResource(dstResource, srcResource);
-    srcResource->Release();
-    dstResource->Release();
+    m_device->Copy(m_historyTexture, m_tempTexture);
     
     // Step 4: Render final result to screen (restore original render target)
-    if (originalRenderTarget) {
-        m_context->OMSetRenderTargets(1, &originalRenderTarget, NULL);
-    }
-    
-    vertices.clear();
-    vertices.push_back({ {-1.0f, 1.0f, 0.0f}, white, {0.0f, 0.0f} });
-    vertices.push_back({ {1.0f, 1.0f, 0.0f}, white, {1.0f, 0.0f} });
-    vertices.push_back({ {-1.0f, -1.0f, 0.0f}, white, {0.0f, 1.0f} });
+    m_device->SetRenderTarget(originalRenderTarget);
     
-    vertices.push_back({ {1.0f, 1.0f, 0.0f}, white, {1.0f, 0.0f} });
-    vertices.push_back({ {1.0f, -1.0f, 0.0f}, white, {1.0f, 1.0f} });
-    vertices.push_back({ {-1.0f, -1.0f, 0.0f}, white, {0.0f, 1.0f} });
-    
-    m_context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
-    memcpy(ms.pData, vertices.data(), vertices.size() * sizeof(Vertex));
-    m_context->Unmap(vertexBuffer, 0);
-    
-    m_context->PSSetShaderResources(0, 1, &m_historySRV);
-    m_context->Draw(6, 0);
-    
-    m_context->PSSetShaderResources(0, 1, &nullSRV);
+    // Upscaled when the feedback runs at a reduced render scale
+    DrawUpscaled(m_historyTexture);
     
-    // Release the saved render target reference
-    if (originalRenderTarget) {
-        originalRenderTarget->Release();
-    }
+    m_device->BindTexture(nullptr);
+}
+
+uint32_t LineFaderVis::GetRequiredFeatures(bool useNormalized) const {
+    return useNormalized ? Feature_Envelope : Feature_Spectrum;
 }
 
 void LineFaderVis::HandleInput(WPARAM key) {
@@ -6,11 +6,11 @@ public:
     LineFaderVis() = default;
     ~LineFaderVis() override { Cleanup(); }
     
-    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, int width, int height) override;
+    bool Initialize(RenderDevice* device, int width, int height) override;
     void Cleanup() override;
-    void Update(float deltaTime, const AudioData& audioData, bool useNormalized,
-               ID3D11Buffer* vertexBuffer, ID3D11InputLayout* inputLayout,
-               ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader) override;
+    bool HasScaledPasses() const override { return true; }
+    void Update(float deltaTime, const AudioData& audioData, bool useNormalized) override;
+    uint32_t GetRequiredFeatures(bool useNormalized) const override;
     void HandleInput(WPARAM key) override;
     std::string GetHelpText() const override;
     void ResetToDefaults() override;
@@ -23,11 +23,8 @@ private:
     int m_scrollSpeed = 5;          // Scroll speed in pixels per frame (1-50)
     float m_fadeRate = 0.005f;      // Fade rate per frame (0.0005 - 0.005, i.e., 0.05% - 0.50%)
     MirrorMode m_mirrorMode = MirrorMode::BassEdges;
+    float m_scrollCarry = 0.0f;     // Fraction of a history texel not yet scrolled
     
-    ID3D11Texture2D* m_historyTexture = nullptr;
-    ID3D11ShaderResourceView* m_historySRV = nullptr;
-    ID3D11RenderTargetView* m_historyRTV = nullptr;
-    ID3D11Texture2D* m_tempTexture = nullptr;
-    ID3D11ShaderResourceView* m_tempSRV = nullptr;
-    ID3D11RenderTargetView* m_tempRTV = nullptr;
+    RenderTexture* m_historyTexture = nullptr;  // Last frame, fed back into the next
+    RenderTexture* m_tempTexture = nullptr;
 };
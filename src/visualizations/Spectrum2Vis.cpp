@@ -2,9 +2,8 @@
 #include "../Config.h"
 #include <algorithm>
 
-bool Spectrum2Vis::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, int width, int height) {
+bool Spectrum2Vis::Initialize(RenderDevice* device, int width, int height) {
     m_device = device;
-    m_context = context;
     m_width = width;
     m_height = height;
     return true;
@@ -14,10 +13,8 @@ void Spectrum2Vis::Cleanup() {
     // No resources to clean up for Spectrum2
 }
 
-void Spectrum2Vis::Update(float deltaTime, const AudioData& audioData, bool useNormalized,
-                         ID3D11Buffer* vertexBuffer, ID3D11InputLayout* inputLayout,
-                         ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader) {
-    std::vector<Vertex> vertices;
+void Spectrum2Vis::Update(float deltaTime, const AudioData& audioData, bool useNormalized) {
+    std::vector<Segment> segments;
 
     // 28 bars, 48 segments per bar
     const int numBars = 28;
@@ -81,18 +78,21 @@ void Spectrum2Vis::Update(float deltaTime, const AudioData& audioData, bool useN
                 if (val > barValue) barValue = val;
             }
         }
+
+        // Peaks come from the audio engine's peak envelopes, which catch every
+        // block (including ones between two renders) and fall in real time
+        float peakValue = barValue;
+        for (int j = 0; j < binsPerBucket; j++) {
+            int binIndex = dataIndex * binsPerBucket + j;
+            if (binIndex < maxBinIndex && audioData.SpectrumPeak[binIndex] > peakValue) {
+                peakValue = audioData.SpectrumPeak[binIndex];
+            }
+        }
         
         // Scale to 48 segments
         float currentHeightSegments = barValue * segmentsPerBar;
         int numSegments = (int)currentHeightSegments;
-        
-        // Update Peak
-        if (currentHeightSegments > m_peakLevels[i]) {
-            m_peakLevels[i] = currentHeightSegments;
-        } else {
-            m_peakLevels[i] -= m_decayRate * deltaTime;
-            if (m_peakLevels[i] < 0.0f) m_peakLevels[i] = 0.0f;
-        }
+        m_peakLevels[i] = peakValue * segmentsPerBar;
 
         // Calculate bar position
         float xStart, barWidth;
@@ -108,7 +108,7 @@ void Spectrum2Vis::Update(float deltaTime, const AudioData& audioData, bool useN
             float segH = h - 2 * segGap;
 
             // Smooth color gradient with 65% transparency (alpha = 0.35)
-            XMFLOAT4 color;
+            Vec4 color;
             if (s < 12) {
                 // Green zone (0-12)
                 color = {0.0f, 1.0f, 0.0f, 0.35f};
@@ -130,26 +130,14 @@ void Spectrum2Vis::Update(float deltaTime, const AudioData& audioData, bool useN
             float x = xStart + gap;
             
             // Center quad (main body)
-            vertices.push_back({ {x + 0.002f, y + segH - 0.001f, 0.0f}, color, {-1.0f, -1.0f} });
-            vertices.push_back({ {x + w - 0.002f, y + segH - 0.001f, 0.0f}, color, {-1.0f, -1.0f} });
-            vertices.push_back({ {x + 0.002f, y + 0.001f, 0.0f}, color, {-1.0f, -1.0f} });
-            
-            vertices.push_back({ {x + w - 0.002f, y + segH - 0.001f, 0.0f}, color, {-1.0f, -1.0f} });
-            vertices.push_back({ {x + w - 0.002f, y + 0.001f, 0.0f}, color, {-1.0f, -1.0f} });
-            vertices.push_back({ {x + 0.002f, y + 0.001f, 0.0f}, color, {-1.0f, -1.0f} });
+            segments.push_back(MakeBar(x + 0.002f, y + 0.001f, x + w - 0.002f, y + segH - 0.001f, color));
             
             // Darker border
-            XMFLOAT4 borderColor = {color.x * 0.6f, color.y * 0.6f, color.z * 0.6f, color.w};
+            Vec4 borderColor = {color.x * 0.6f, color.y * 0.6f, color.z * 0.6f, color.w};
             float borderThickness = 0.0008f;
             
             // Top border
-            vertices.push_back({ {x, y + segH, 0.0f}, borderColor, {-1.0f, -1.0f} });
-            vertices.push_back({ {x + w, y + segH, 0.0f}, borderColor, {-1.0f, -1.0f} });
-            vertices.push_back({ {x, y + segH - borderThickness, 0.0f}, borderColor, {-1.0f, -1.0f} });
-            
-            vertices.push_back({ {x + w, y + segH, 0.0f}, borderColor, {-1.0f, -1.0f} });
-            vertices.push_back({ {x + w, y + segH - borderThickness, 0.0f}, borderColor, {-1.0f, -1.0f} });
-            vertices.push_back({ {x, y + segH - borderThickness, 0.0f}, borderColor, {-1.0f, -1.0f} });
+            segments.push_back(MakeBar(x, y + segH - borderThickness, x + w, y + segH, borderColor));
         }
 
         // Draw Peak with 50% transparency
@@ -159,34 +147,23 @@ void Spectrum2Vis::Update(float deltaTime, const AudioData& audioData, bool useN
             float segH = h - 2 * segGap;
             float x = xStart + gap;
             float w = barWidth - 2 * gap;
-            XMFLOAT4 peakColor = {1.0f, 0.0f, 0.0f, 0.5f}; // Red peak, 50% alpha
-
-            vertices.push_back({ {x, y + segH, 0.0f}, peakColor, {-1.0f, -1.0f} });
-            vertices.push_back({ {x + w, y + segH, 0.0f}, peakColor, {-1.0f, -1.0f} });
-            vertices.push_back({ {x, y, 0.0f}, peakColor, {-1.0f, -1.0f} });
-
-            vertices.push_back({ {x + w, y + segH, 0.0f}, peakColor, {-1.0f, -1.0f} });
-            vertices.push_back({ {x + w, y, 0.0f}, peakColor, {-1.0f, -1.0f} });
-            vertices.push_back({ {x, y, 0.0f}, peakColor, {-1.0f, -1.0f} });
+            Vec4 peakColor = {1.0f, 0.0f, 0.0f, 0.5f}; // Red peak, 50% alpha
+            segments.push_back(MakeBar(x, y, x + w, y + segH, peakColor));
         }
     }
 
-    if (vertices.empty()) return;
-
-    D3D11_MAPPED_SUBRESOURCE ms;
-    m_context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
-    memcpy(ms.pData, vertices.data(), vertices.size() * sizeof(Vertex));
-    m_context->Unmap(vertexBuffer, 0);
+    m_device->DrawSegments(segments);
+}
 
-    UINT stride = sizeof(Vertex);
-    UINT offset = 0;
-    m_context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-    m_context->IASetInputLayout(inputLayout);
-    m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    m_context->VSSetShader(vertexShader, NULL, 0);
-    m_context->PSSetShader(pixelShader, NULL, 0);
+uint32_t Spectrum2Vis::GetRequiredFeatures(bool useNormalized) const {
+    // Always draws the normalized spectrum
+    return Feature_SpectrumNormalized | Feature_Envelope;
+}
 
-    m_context->Draw((UINT)vertices.size(), 0);
+float Spectrum2Vis::GetPeakRelease() const {
+    // Same fall time as the old linear decay of m_decayRate segments/s
+    // (see SpectrumVis::GetPeakRelease)
+    return 48.0f / (3.0f * m_decayRate);
 }
 
 void Spectrum2Vis::HandleInput(WPARAM key) {
@@ -6,11 +6,11 @@ public:
     Spectrum2Vis() = default;
     ~Spectrum2Vis() override { Cleanup(); }
     
-    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, int width, int height) override;
+    bool Initialize(RenderDevice* device, int width, int height) override;
     void Cleanup() override;
-    void Update(float deltaTime, const AudioData& audioData, bool useNormalized,
-               ID3D11Buffer* vertexBuffer, ID3D11InputLayout* inputLayout,
-               ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader) override;
+    void Update(float deltaTime, const AudioData& audioData, bool useNormalized) override;
+    uint32_t GetRequiredFeatures(bool useNormalized) const override;
+    float GetPeakRelease() const override;
     void HandleInput(WPARAM key) override;
     std::string GetHelpText() const override;
     void ResetToDefaults() override;
@@ -2,9 +2,8 @@
 #include "../Config.h"
 #include <algorithm>
 
-bool SpectrumVis::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, int width, int height) {
+bool SpectrumVis::Initialize(RenderDevice* device, int width, int height) {
     m_device = device;
-    m_context = context;
     m_width = width;
     m_height = height;
     return true;
@@ -14,10 +13,8 @@ void SpectrumVis::Cleanup() {
     // No resources to clean up for Spectrum
 }
 
-void SpectrumVis::Update(float deltaTime, const AudioData& audioData, bool useNormalized,
-                        ID3D11Buffer* vertexBuffer, ID3D11InputLayout* inputLayout,
-                        ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader) {
-    std::vector<Vertex> vertices;
+void SpectrumVis::Update(float deltaTime, const AudioData& audioData, bool useNormalized) {
+    std::vector<Segment> segments;
 
     // 16 bars
     float barWidth = 2.0f / 16.0f;
@@ -35,14 +32,25 @@ void SpectrumVis::Update(float deltaTime, const AudioData& audioData, bool useNo
                 if (val > barValue) barValue = val;
             }
         }
+
+        // Peaks come from the audio engine's peak envelopes, which catch every
+        // block (including ones between two renders) and fall in real time
+        float peakValue = barValue;
+        if (useNormalized) {
+            for (int j = 0; j < 14; j++) {
+                float val = audioData.SpectrumPeak[i * 14 + j];
+                if (val > peakValue) peakValue = val;
+            }
+        }
         
         // 16 segments per bar
         float currentHeightSegments = barValue * 16.0f;
         int numSegments = (int)currentHeightSegments;
+        float peakHeightSegments = peakValue * 16.0f;
         
-        // Update Peak
-        if (currentHeightSegments > m_peakLevels[i]) {
-            m_peakLevels[i] = currentHeightSegments;
+        // Update Peak (raw values have no envelope; decay them here)
+        if (useNormalized || peakHeightSegments > m_peakLevels[i]) {
+            m_peakLevels[i] = peakHeightSegments;
         } else {
             m_peakLevels[i] -= m_decayRate * deltaTime;
             if (m_peakLevels[i] < 0.0f) m_peakLevels[i] = 0.0f;
@@ -59,20 +67,13 @@ void SpectrumVis::Update(float deltaTime, const AudioData& audioData, bool useNo
             float segH = h - 2 * segGap;
 
             // Color gradient
-            XMFLOAT4 color;
+            Vec4 color;
             if (s < 8) color = {0.0f, 1.0f, 0.0f, 0.5f}; // Green, 50% alpha
             else if (s < 12) color = {1.0f, 1.0f, 0.0f, 0.5f}; // Yellow, 50% alpha
             else if (s < 14) color = {1.0f, 0.5f, 0.0f, 0.5f}; // Orange, 50% alpha
             else color = {1.0f, 0.0f, 0.0f, 0.5f}; // Red, 50% alpha
 
-            // Quad
-            vertices.push_back({ {x, y + segH, 0.0f}, color, {-1.0f, -1.0f} });
-            vertices.push_back({ {x + w, y + segH, 0.0f}, color, {-1.0f, -1.0f} });
-            vertices.push_back({ {x, y, 0.0f}, color, {-1.0f, -1.0f} });
-
-            vertices.push_back({ {x + w, y + segH, 0.0f}, color, {-1.0f, -1.0f} });
-            vertices.push_back({ {x + w, y, 0.0f}, color, {-1.0f, -1.0f} });
-            vertices.push_back({ {x, y, 0.0f}, color, {-1.0f, -1.0f} });
+            segments.push_back(MakeBar(x, y, x + w, y + segH, color));
         }
 
         // Draw Peak
@@ -80,34 +81,23 @@ void SpectrumVis::Update(float deltaTime, const AudioData& audioData, bool useNo
         if (peakSegment >= 0 && peakSegment < 17) { // Allow going one above
              float y = -1.0f + peakSegment * h + segGap;
              float segH = h - 2 * segGap;
-             XMFLOAT4 color = {1.0f, 0.0f, 0.0f, 0.5f}; // Red peak, 50% alpha
-
-             vertices.push_back({ {x, y + segH, 0.0f}, color, {-1.0f, -1.0f} });
-             vertices.push_back({ {x + w, y + segH, 0.0f}, color, {-1.0f, -1.0f} });
-             vertices.push_back({ {x, y, 0.0f}, color, {-1.0f, -1.0f} });
-
-             vertices.push_back({ {x + w, y + segH, 0.0f}, color, {-1.0f, -1.0f} });
-             vertices.push_back({ {x + w, y, 0.0f}, color, {-1.0f, -1.0f} });
-             vertices.push_back({ {x, y, 0.0f}, color, {-1.0f, -1.0f} });
+             Vec4 color = {1.0f, 0.0f, 0.0f, 0.5f}; // Red peak, 50% alpha
+             segments.push_back(MakeBar(x, y, x + w, y + segH, color));
         }
     }
 
-    if (vertices.empty()) return;
-
-    D3D11_MAPPED_SUBRESOURCE ms;
-    m_context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
-    memcpy(ms.pData, vertices.data(), vertices.size() * sizeof(Vertex));
-    m_context->Unmap(vertexBuffer, 0);
+    m_device->DrawSegments(segments);
+}
 
-    UINT stride = sizeof(Vertex);
-    UINT offset = 0;
-    m_context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-    m_context->IASetInputLayout(inputLayout);
-    m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    m_context->VSSetShader(vertexShader, NULL, 0);
-    m_context->PSSetShader(pixelShader, NULL, 0);
+uint32_t SpectrumVis::GetRequiredFeatures(bool useNormalized) const {
+    return useNormalized ? (Feature_SpectrumNormalized | Feature_Envelope) : Feature_Spectrum;
+}
 
-    m_context->Draw(vertices.size(), 0);
+float SpectrumVis::GetPeakRelease() const {
+    // The old linear fall of m_decayRate segments/s reached the bottom in
+    // 16 / m_decayRate seconds; this time constant falls below one segment
+    // (5%) in the same time
+    return 16.0f / (3.0f * m_decayRate);
 }
 
 void SpectrumVis::HandleInput(WPARAM key) {
@@ -0,0 +1,92 @@
+// Checks the constant-Q transform: tones peak in their semitone bin at every
+// sample rate (including rates where the low kernels are clipped to
+// FFT_SIZE), a cached kernel loads and matches the built one, and corrupt
+// caches are rebuilt instead of trusted. Returns non-zero on failure.
+
+#include "ConstantQ.h"
+#include "TestUtil.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+// Fills the ring with a sine and returns the bins of the last block
+static std::vector<float> Tone(ConstantQ& cqt, double freq) {
+    const int hop = 512;
+    std::vector<float> block(hop), out(ConstantQ::NUM_BINS);
+    cqt.Reset();
+    for (int b = 0; b < ConstantQ::FFT_SIZE / hop; b++) {
+        for (int i = 0; i < hop; i++) {
+            block[i] = (float)(0.5 * sin(2.0 * M_PI * freq * (b * hop + i) / cqt.GetSampleRate()));
+        }
+        cqt.Process(block.data(), hop, out.data());
+    }
+    return out;
+}
+
+static int Strongest(const std::vector<float>& bins) {
+    return (int)(std::max_element(bins.begin(), bins.end()) - bins.begin());
+}
+
+// Overwrites one int of a kernel file
+static void Patch(const std::filesystem::path& path, std::streamoff offset, int32_t value) {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(offset);
+    file.write((const char*)&value, sizeof(value));
+}
+
+int main() {
+    // D3 (bin 5), A3 (bin 12) and A5 (bin 36). At 88.2 and 96 kHz the
+    // windows of the low bins are longer than FFT_SIZE and get clipped.
+    struct Case { double freq; int bin; };
+    const Case tones[] = { {146.83, 5}, {220.0, 12}, {880.0, 36} };
+    for (int rate : { 44100, 48000, 88200, 96000 }) {
+        std::unique_ptr<ConstantQ> cqt(new ConstantQ());
+        cqt->Configure(rate);
+        for (const Case& tone : tones) {
+            int bin = Strongest(Tone(*cqt, tone.freq));
+            char name[96];
+            snprintf(name, sizeof(name), "%.2f Hz @ %d peaks in bin %d (got %d)", tone.freq, rate, tone.bin, bin);
+            Check(name, bin == tone.bin);
+        }
+    }
+
+    // Cache round trip, through a directory name that isn't plain ASCII
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / std::filesystem::u8path("musicvis_cqt_t\xc3\xa9st");
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    std::unique_ptr<ConstantQ> built(new ConstantQ());
+    built->Configure(96000, dir);
+    std::unique_ptr<ConstantQ> loaded(new ConstantQ());
+    loaded->Configure(96000, dir);
+    Check("kernel built, then loaded from the cache", !built->IsLoadedFromCache() && loaded->IsLoadedFromCache());
+    Check("cached kernel matches", loaded->GetNonZeroCount() == built->GetNonZeroCount() &&
+                                   Tone(*loaded, 146.83) == Tone(*built, 146.83));
+
+    std::filesystem::path file;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dir)) file = entry.path();
+
+    // Header: magic, version, rate, FFT size, bins, bins per octave, min
+    // frequency, threshold and non-zero count; then the row starts and columns
+    const std::streamoff rowStarts = 40;
+    const std::streamoff columns = rowStarts + (ConstantQ::NUM_BINS + 1) * 4;
+
+    Patch(file, rowStarts + 4, 1 << 30);
+    std::unique_ptr<ConstantQ> rows(new ConstantQ());
+    rows->Configure(96000, dir);
+    Check("decreasing row start rebuilt", !rows->IsLoadedFromCache() && Strongest(Tone(*rows, 146.83)) == 5);
+
+    // The rebuild rewrote the cache; break a column this time
+    Patch(file, columns, ConstantQ::FFT_SIZE / 2 + 1);
+    std::unique_ptr<ConstantQ> cols(new ConstantQ());
+    cols->Configure(96000, dir);
+    Check("out of range column rebuilt", !cols->IsLoadedFromCache() && Strongest(Tone(*cols, 146.83)) == 5);
+
+    std::filesystem::remove_all(dir);
+    return TestResult();
+}
@@ -0,0 +1,76 @@
+// Checks the chroma and spectral shape descriptors on synthesized blocks fed
+// through SpectrumAnalyzer: tones land on the right pitch class, a tone is
+// less flat than noise, and flux fires on a change. Returns non-zero on
+// failure.
+
+#include "SpectrumAnalyzer.h"
+#include "TestUtil.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+static const int SAMPLE_RATE = 48000;
+
+// Runs blocks of a signal through the analyzer; data holds the last block's results
+template <typename Signal>
+static void Run(SpectrumAnalyzer& analyzer, AudioData& data, int blocks, Signal signal, long& sample) {
+    std::vector<float> block(SpectrumAnalyzer::FFT_SIZE);
+    for (int b = 0; b < blocks; b++) {
+        for (float& s : block) s = signal((double)(sample++) / SAMPLE_RATE);
+        analyzer.Process(block, (float)SpectrumAnalyzer::FFT_SIZE / SAMPLE_RATE, data);
+    }
+}
+
+static int Strongest(const float* chroma) {
+    return (int)(std::max_element(chroma, chroma + 12) - chroma);
+}
+
+int main() {
+    std::unique_ptr<SpectrumAnalyzer> analyzer(new SpectrumAnalyzer());
+    analyzer->SetSampleRate(SAMPLE_RATE);
+    analyzer->SetRequiredFeatures(Feature_Descriptors);
+    std::unique_ptr<AudioData> data(new AudioData());
+    long sample = 0;
+
+    // A harmonic tone: A3 (220 Hz) with falling overtones
+    auto tone = [](double t) {
+        double v = 0.0;
+        for (int h = 1; h <= 8; h++) v += 0.4 / h * sin(2.0 * M_PI * 220.0 * h * t);
+        return (float)v;
+    };
+    Run(*analyzer, *data, 20, tone, sample);
+    printf("      A3: chroma peak %d, centroid %.0f Hz, rolloff %.0f Hz, flatness %.3f\n",
+           Strongest(data->Chroma), data->SpectralCentroid, data->SpectralRolloff, data->SpectralFlatness);
+    Check("A3 tone peaks on pitch class A", Strongest(data->Chroma) == 9);
+    Check("A3 centroid between the fundamental and the top partial",
+          data->SpectralCentroid > 220.0f && data->SpectralCentroid < 1760.0f);
+    Check("A3 rolloff below 2 kHz", data->SpectralRolloff < 2000.0f);
+    float toneFlatness = data->SpectralFlatness;
+    float steadyFlux = data->SpectralFlux;
+
+    // C5 (523.25 Hz) plain sine
+    auto c5 = [](double t) { return (float)(0.5 * sin(2.0 * M_PI * 523.25 * t)); };
+    Run(*analyzer, *data, 1, c5, sample);
+    printf("      flux: steady %.3f, note change %.3f\n", steadyFlux, data->SpectralFlux);
+    Check("a change of note has more flux than a steady tone", data->SpectralFlux > 2.0f * steadyFlux);
+    Run(*analyzer, *data, 20, c5, sample);
+    Check("C5 sine peaks on pitch class C", Strongest(data->Chroma) == 0);
+
+    // White noise
+    srand(1);
+    auto noise = [](double) { return 0.5f * ((float)rand() / RAND_MAX - 0.5f); };
+    Run(*analyzer, *data, 20, noise, sample);
+    printf("      noise: centroid %.0f Hz, flatness %.3f\n", data->SpectralCentroid, data->SpectralFlatness);
+    Check("noise is flatter than a tone", data->SpectralFlatness > 0.3f && data->SpectralFlatness > 5.0f * toneFlatness);
+    Check("noise centroid near the middle of the band", data->SpectralCentroid > 8000.0f && data->SpectralCentroid < 16000.0f);
+
+    // Silence clears everything
+    Run(*analyzer, *data, 2, [](double) { return 0.0f; }, sample);
+    Check("silence clears the descriptors", data->SpectralCentroid == 0.0f && data->Chroma[0] == 0.0f &&
+                                                data->SpectralFlux == 0.0f);
+
+    return TestResult();
+}
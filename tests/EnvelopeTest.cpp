@@ -0,0 +1,86 @@
+// Checks the envelope follower bank: attack and release land on the exact
+// exponential after one time constant, the result doesn't depend on the
+// block rate or on uneven block spacing, per-band times are independent,
+// and the analyzer publishes smoothed and peak envelopes. Returns non-zero
+// on failure.
+
+#include "EnvelopeFollower.h"
+#include "SpectrumAnalyzer.h"
+#include "TestUtil.h"
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+static const int BANDS = 8;
+
+// Primes the bank at 0, then holds the input at 1 for 'seconds' in blocks
+// of the given lengths (cycled); returns band 0's envelope
+static float StepResponse(EnvelopeFollowerBank& bank, float seconds, const std::vector<float>& blocks) {
+    std::vector<float> zero(BANDS, 0.0f), one(BANDS, 1.0f), out(BANDS);
+    bank.Reset();
+    bank.Process(zero.data(), 0.0f, out.data());
+    double elapsed = 0.0;
+    for (size_t b = 0; elapsed < seconds - 1e-6; b++) {
+        float dt = blocks[b % blocks.size()];
+        bank.Process(one.data(), dt, out.data());
+        elapsed += dt;
+    }
+    return out[0];
+}
+
+int main() {
+    const float attack = 0.05f, release = 0.4f;
+    const float expected = 1.0f - expf(-1.0f);
+    EnvelopeFollowerBank bank(BANDS);
+    bank.SetTimes(attack, release);
+
+    float at93 = StepResponse(bank, 0.2f, { 0.2f / 20 });
+    float at200 = StepResponse(bank, 0.2f, { 0.2f / 40 });
+    float uneven = StepResponse(bank, 0.2f, { 0.002f, 0.008f });
+    float oneTau = StepResponse(bank, attack, { attack / 5 });
+    printf("      after 1 tau %.4f (expect %.4f); 0.2 s at 20/40/uneven blocks %.5f %.5f %.5f\n",
+           oneTau, expected, at93, at200, uneven);
+    Check("attack reaches 1 - 1/e after one time constant", fabsf(oneTau - expected) < 1e-4f);
+    Check("envelope doesn't depend on the block rate", fabsf(at93 - at200) < 1e-4f);
+    Check("uneven block spacing gives the same envelope", fabsf(at93 - uneven) < 1e-4f);
+
+    // Release from 1 over one release time constant; band 1 is instant
+    bank.SetBandTimes(1, 0.0f, 0.0f);
+    std::vector<float> one(BANDS, 1.0f), zero(BANDS, 0.0f), out(BANDS);
+    bank.Reset();
+    bank.Process(one.data(), 0.0f, out.data());
+    for (int b = 0; b < 10; b++) bank.Process(zero.data(), release / 10, out.data());
+    printf("      release after 1 tau %.4f, instant band %.4f\n", out[0], out[1]);
+    Check("release falls to 1/e after one time constant", fabsf(out[0] - expf(-1.0f)) < 1e-4f);
+    Check("per-band times are independent", out[1] == 0.0f && out[2] == out[0]);
+
+    // Through the analyzer: a tone that stops
+    std::unique_ptr<SpectrumAnalyzer> analyzer(new SpectrumAnalyzer());
+    analyzer->SetSampleRate(48000.0);
+    analyzer->SetRequiredFeatures(Feature_Envelope);
+    std::unique_ptr<AudioData> data(new AudioData());
+    std::vector<float> block(SpectrumAnalyzer::FFT_SIZE);
+    const float blockSeconds = (float)SpectrumAnalyzer::FFT_SIZE / 48000.0f;
+    const int toneBin = 40;  // 3750 Hz
+    long sample = 0;
+    auto run = [&](int blocks, float amplitude) {
+        for (int b = 0; b < blocks; b++) {
+            for (float& s : block) s = amplitude * (float)sin(2.0 * M_PI * 3750.0 * (double)(sample++) / 48000.0);
+            analyzer->Process(block, blockSeconds, *data);
+        }
+    };
+
+    run(50, 0.5f);
+    float toneLevel = data->SpectrumNormalized[toneBin];
+    Check("smoothed envelope settles on a steady tone", fabsf(data->SpectrumSmoothed[toneBin] - toneLevel) < 0.01f);
+
+    // Silence for 0.25 s: well past the smoothing release, a quarter of the peak release
+    run(23, 0.0f);
+    printf("      tone %.3f -> smoothed %.3f, peak %.3f after 0.25 s of silence\n",
+           toneLevel, data->SpectrumSmoothed[toneBin], data->SpectrumPeak[toneBin]);
+    Check("smoothed envelope releases", data->SpectrumSmoothed[toneBin] < 0.2f * toneLevel);
+    Check("peak envelope holds on", data->SpectrumPeak[toneBin] > 0.7f * toneLevel);
+
+    return TestResult();
+}
@@ -0,0 +1,110 @@
+// Checks the frame scheduler against a fake clock: fixed-rate frames land
+// on their slots despite a sleep that overshoots, the grid doesn't drift
+// over many frames, a late frame restarts the grid instead of bunching
+// frames, vsync and uncapped modes never sleep, and CPU and present time
+// are measured apart. Returns non-zero on failure.
+
+#include "FrameScheduler.h"
+#include "TestUtil.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Every read costs a microsecond (so spinning makes progress); every sleep
+// overshoots by 'oversleep', like a coarse OS timer
+class FakeClock : public FrameClock {
+public:
+    double time = 100.0;
+    double oversleep = 0.0015;
+    int sleeps = 0;
+
+    double Now() override {
+        time += 1e-6;
+        return time;
+    }
+    void Sleep(double seconds) override {
+        time += seconds + oversleep;
+        sleeps++;
+    }
+    void Work(double seconds) { time += seconds; }
+};
+
+// One frame: CPU work, then a Present that blocks for 'present' seconds
+static float RunFrame(FrameScheduler& scheduler, FakeClock& clock, double cpu, double present) {
+    float delta = scheduler.BeginFrame();
+    clock.Work(cpu);
+    scheduler.BeginPresent();
+    clock.Work(present);
+    scheduler.EndPresent();
+    return delta;
+}
+
+int main() {
+    // Fixed 60 FPS: every frame starts within a few microseconds of its slot
+    {
+        FakeClock clock;
+        FrameScheduler scheduler(&clock);
+        scheduler.SetMode(FrameScheduler::Mode::Fixed, 60.0f);
+        std::vector<double> starts;
+        for (int i = 0; i < 600; i++) {
+            RunFrame(scheduler, clock, 0.005, 0.0);
+            starts.push_back(clock.time - 0.005);
+        }
+        double worst = 0.0;
+        for (size_t i = 1; i < starts.size(); i++) {
+            worst = std::max(worst, fabs(starts[i] - starts[0] - i / 60.0));
+        }
+        Check("fixed frames start on their slots", worst < 1e-4);
+        Check("sleep used for the bulk of the wait", clock.sleeps == 599);
+        Check("600 frames take 10 s, no drift", fabs(starts.back() - starts[0] - 599.0 / 60.0) < 1e-4);
+        Check("sync interval 0 in fixed mode", scheduler.GetSyncInterval() == 0);
+    }
+
+    // A frame that overruns restarts the grid rather than bunching the next ones
+    {
+        FakeClock clock;
+        FrameScheduler scheduler(&clock);
+        scheduler.SetMode(FrameScheduler::Mode::Fixed, 50.0f);
+        for (int i = 0; i < 10; i++) RunFrame(scheduler, clock, 0.004, 0.0);
+        RunFrame(scheduler, clock, 0.050, 0.0);  // Misses two slots
+        float afterStall = RunFrame(scheduler, clock, 0.004, 0.0);
+        float next = RunFrame(scheduler, clock, 0.004, 0.0);
+        Check("stalled frame's delta is its real length", fabsf(afterStall - 0.050f) < 1e-3f);
+        Check("no catch-up burst after a stall", fabsf(next - 0.020f) < 1e-4f);
+    }
+
+    // VSync and uncapped never sleep; delta is the real frame time
+    {
+        FakeClock clock;
+        FrameScheduler scheduler(&clock);
+        Check("vsync by default, sync interval 1",
+              scheduler.GetMode() == FrameScheduler::Mode::VSync && scheduler.GetSyncInterval() == 1);
+        Check("first frame delta is 0", RunFrame(scheduler, clock, 0.003, 0.0137) == 0.0f);
+        float delta = RunFrame(scheduler, clock, 0.003, 0.0137);
+        Check("vsync delta is CPU plus present time", fabsf(delta - 0.0167f) < 1e-4f);
+
+        scheduler.SetMode(FrameScheduler::Mode::Uncapped);
+        for (int i = 0; i < 100; i++) RunFrame(scheduler, clock, 0.001, 0.0);
+        Check("no sleeping in vsync or uncapped mode", clock.sleeps == 0);
+    }
+
+    // CPU and present time are reported apart, averaged over a second
+    {
+        FakeClock clock;
+        FrameScheduler scheduler(&clock);
+        for (int i = 0; i < 130; i++) RunFrame(scheduler, clock, 0.004, 0.0127);
+        const FrameScheduler::Stats& stats = scheduler.GetStats();
+        Check("fps measured", fabsf(stats.fps - 59.88f) < 0.1f);
+        Check("CPU time measured", fabsf(stats.cpuMs - 4.0f) < 0.01f);
+        Check("present time measured", fabsf(stats.presentMs - 12.7f) < 0.01f);
+        Check("elapsed follows the clock", fabs(scheduler.GetElapsed() - 129 * 0.0167) < 0.02);
+
+        scheduler.SetMode(FrameScheduler::Mode::Fixed, 100.0f);
+        for (int i = 0; i < 250; i++) RunFrame(scheduler, clock, 0.004, 0.0);
+        Check("wait time is the rest of the slot", fabsf(scheduler.GetStats().waitMs - 6.0f) < 0.05f &&
+                                                   fabsf(scheduler.GetStats().fps - 100.0f) < 0.5f);
+    }
+
+    return TestResult();
+}
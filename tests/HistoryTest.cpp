@@ -0,0 +1,78 @@
+// Checks the SpectrumHistory tiers: downsampled max/mean values, tier
+// selection in Read(), and that a reader racing the writer never sees a
+// torn column. Returns non-zero on failure.
+
+#include "SpectrumHistory.h"
+#include "TestUtil.h"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Frame n holds n in every bin
+static void PushFrames(SpectrumHistory& history, int first, int count) {
+    std::vector<float> frame(SpectrumHistory::NUM_BINS);
+    for (int n = first; n < first + count; n++) {
+        for (float& v : frame) v = (float)n;
+        history.Push(frame.data());
+    }
+}
+
+int main() {
+    const int BINS = SpectrumHistory::NUM_BINS;
+    std::unique_ptr<SpectrumHistory> history(new SpectrumHistory());
+    history->SetFrameRate(100.0f);  // Column widths: 10 ms, 100 ms, 1 s
+
+    // 1000 frames: 100 tier-1 columns, 10 tier-2 columns, no partials
+    PushFrames(*history, 0, 1000);
+
+    std::vector<float> maxCols(SpectrumHistory::TIER_LENGTH * BINS), meanCols(SpectrumHistory::TIER_LENGTH * BINS);
+    int tier = -1;
+
+    int n = history->Read(0.5f, 100, maxCols.data(), meanCols.data(), &tier);
+    Check("0.5 s in 100 columns reads tier 0", tier == 0 && n == 50);
+    Check("tier 0 newest column is the last frame", maxCols[0] == 999.0f && meanCols[0] == 999.0f);
+
+    n = history->Read(5.0f, 100, maxCols.data(), meanCols.data(), &tier);
+    Check("5 s in 100 columns reads tier 1", tier == 1 && n == 50);
+    // Newest tier-1 column covers frames 990-999
+    Check("tier 1 max and mean", maxCols[0] == 999.0f && fabsf(meanCols[0] - 994.5f) < 1e-3f);
+    Check("tier 1 second column", maxCols[BINS] == 989.0f && fabsf(meanCols[BINS] - 984.5f) < 1e-3f);
+
+    n = history->Read(60.0f, 100, maxCols.data(), meanCols.data(), &tier);
+    // Only 10 s pushed so far, so only 10 columns exist
+    Check("60 s reads tier 2, limited to what exists", tier == 2 && n == 10);
+    Check("tier 2 max and mean", maxCols[0] == 999.0f && fabsf(meanCols[0] - 949.5f) < 1e-3f);
+
+    // A partial aggregate shows up as the newest coarse column
+    PushFrames(*history, 1000, 3);
+    n = history->Read(5.0f, 100, maxCols.data(), meanCols.data(), &tier);
+    Check("partial tier 1 column", tier == 1 && maxCols[0] == 1002.0f && fabsf(meanCols[0] - 1001.0f) < 1e-3f &&
+                                   maxCols[BINS] == 999.0f);
+
+    // Writer and reader on different threads: every column must be uniform
+    history->Reset();
+    std::atomic<bool> done(false);
+    std::thread writer([&] {
+        PushFrames(*history, 0, 200000);
+        done = true;
+    });
+    bool torn = false;
+    int reads = 0;
+    while (!done) {
+        int cols = history->Read(2.0f, 200, maxCols.data(), nullptr);
+        for (int c = 0; c < cols && !torn; c++) {
+            for (int b = 1; b < BINS; b++) {
+                if (maxCols[c * BINS + b] != maxCols[c * BINS]) { torn = true; break; }
+            }
+        }
+        reads++;
+    }
+    writer.join();
+    printf("      (%d concurrent reads)\n", reads);
+    Check("no torn columns under concurrent writes", !torn);
+
+    return TestResult();
+}
@@ -0,0 +1,143 @@
+// Checks harmonic/percussive separation: SlidingMedian against a sorted
+// copy of the window, the split adding back up to its input, a steady tone
+// going to the harmonic part and a broadband click to the percussive one,
+// and the budget cutoff keeping the previous mask while the frequency
+// window shrinks. Returns non-zero on failure.
+
+#include "HarmonicPercussive.h"
+#include "SlidingMedian.h"
+#include "TestUtil.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+// Upper median of the window, by sorting it
+static float ReferenceMedian(const std::deque<float>& window) {
+    if (window.empty()) return 0.0f;
+    std::vector<float> sorted(window.begin(), window.end());
+    std::sort(sorted.begin(), sorted.end());
+    return sorted[sorted.size() / 2];
+}
+
+// Pushes a stream with many repeated values, popping now and then, and
+// compares every median with the reference
+static bool MatchesReference(int capacity, int steps) {
+    SlidingMedian median(capacity);
+    std::deque<float> window;
+    uint32_t state = 12345u + capacity;
+    for (int i = 0; i < steps; i++) {
+        state = state * 1664525u + 1013904223u;
+        if ((state >> 28) == 0 && !window.empty()) {
+            median.PopOldest();
+            window.pop_front();
+        } else {
+            float value = (float)((state >> 24) % 8);
+            median.Push(value);
+            window.push_back(value);
+            if ((int)window.size() > capacity) window.pop_front();
+        }
+        if (median.Size() != (int)window.size() || median.Median() != ReferenceMedian(window)) return false;
+    }
+    return true;
+}
+
+static const int BINS = 256;
+static const int TONE_BIN = 40;
+
+// A low broadband floor with a steady tone at TONE_BIN
+static std::vector<float> ToneFrame() {
+    std::vector<float> frame(BINS, 0.01f);
+    frame[TONE_BIN] = 1.0f;
+    return frame;
+}
+
+static float HarmonicShare(const std::vector<float>& input, const std::vector<float>& harmonic, int bin) {
+    return harmonic[bin] / input[bin];
+}
+
+int main() {
+    // SlidingMedian
+    bool matches = true;
+    for (int capacity : { 1, 2, 5, 6, 17 }) {
+        matches = matches && MatchesReference(capacity, 5000);
+    }
+    Check("sliding median matches a sorted window (duplicates, eviction, pops)", matches);
+
+    SlidingMedian single(1);
+    single.Push(3.0f);
+    single.Push(7.0f);
+    Check("capacity 1 holds the newest value", single.Size() == 1 && single.Median() == 7.0f);
+
+    SlidingMedian reset(5);
+    for (float v : { 9.0f, 9.0f, 9.0f, 9.0f }) reset.Push(v);
+    reset.Reset();
+    bool emptied = reset.Size() == 0 && reset.Median() == 0.0f;
+    reset.Push(1.0f);
+    reset.Push(2.0f);
+    Check("reset empties the window", emptied && reset.Size() == 2 && reset.Median() == 2.0f);
+
+    // Separation. A huge budget keeps the cutoff out of the way.
+    HarmonicPercussiveSeparator hpss(BINS);
+    hpss.SetBudgetMicros(1e9f);
+    std::vector<float> harmonic(BINS), percussive(BINS);
+    std::vector<float> tone = ToneFrame();
+    for (int block = 0; block < 2 * HarmonicPercussiveSeparator::HARMONIC_FRAMES; block++) {
+        hpss.Process(tone.data(), tone.data(), harmonic.data(), percussive.data());
+    }
+    float toneShare = HarmonicShare(tone, harmonic, TONE_BIN);
+    printf("      steady tone: %.3f harmonic\n", toneShare);
+    Check("steady tone is harmonic", toneShare > 0.9f);
+
+    std::vector<float> click(BINS, 1.0f);
+    hpss.Process(click.data(), click.data(), harmonic.data(), percussive.data());
+    float clickShare = HarmonicShare(click, harmonic, 100);
+    printf("      click: %.3f percussive\n", 1.0f - clickShare);
+    Check("broadband click is percussive", clickShare < 0.1f);
+
+    bool sums = true;
+    for (int b = 0; b < BINS; b++) {
+        sums = sums && fabsf(harmonic[b] + percussive[b] - click[b]) <= 1e-6f && harmonic[b] >= 0.0f &&
+               percussive[b] >= 0.0f;
+    }
+    Check("harmonic + percussive == input", sums);
+
+    // Budget cutoff. The clock is first checked 16 bins in, so with no
+    // budget bins 0-15 get a new mask and the rest keep the last one.
+    hpss.Reset();
+    for (int block = 0; block < 2 * HarmonicPercussiveSeparator::HARMONIC_FRAMES; block++) {
+        hpss.Process(tone.data(), tone.data(), harmonic.data(), percussive.data());
+    }
+    std::vector<float> toneMask(BINS);
+    for (int b = 0; b < BINS; b++) toneMask[b] = HarmonicShare(tone, harmonic, b);
+
+    hpss.SetBudgetMicros(1e-6f);
+    std::vector<int> windows;
+    for (int block = 0; block < 3; block++) {
+        hpss.Process(click.data(), click.data(), harmonic.data(), percussive.data());
+        windows.push_back(hpss.GetPercussiveWindow());
+    }
+    bool kept = true;
+    for (int b = 16; b < BINS; b++) {
+        kept = kept && fabsf(HarmonicShare(click, harmonic, b) - toneMask[b]) < 1e-6f;
+    }
+    Check("bins past the cutoff keep the previous mask", kept && HarmonicShare(click, harmonic, 3) < 0.1f &&
+                                                         hpss.GetCutoffCount() == 3);
+    printf("      window %d -> %d -> %d\n", windows[0], windows[1], windows[2]);
+    Check("frequency window shrinks 17 -> 9 -> 5", windows[0] == 9 && windows[1] == 5 && windows[2] == 5);
+
+    // Well under budget again, it grows back a step per 100 cool blocks
+    hpss.SetBudgetMicros(1e9f);
+    for (int block = 0; block < 100; block++) {
+        hpss.Process(tone.data(), tone.data(), harmonic.data(), percussive.data());
+    }
+    int grown = hpss.GetPercussiveWindow();
+    for (int block = 0; block < 100; block++) {
+        hpss.Process(tone.data(), tone.data(), harmonic.data(), percussive.data());
+    }
+    Check("frequency window grows back 5 -> 9 -> 17", grown == 9 && hpss.GetPercussiveWindow() == 17);
+
+    return TestResult();
+}
@@ -0,0 +1,116 @@
+// Checks the batch library analysis: the work-stealing pool runs every task
+// (including ones submitted from tasks), synthesized tracks get sensible
+// summaries, a re-run is served from the content-hash cache, and only a
+// changed file is analyzed again. Returns non-zero on failure.
+
+#include "LibraryAnalyzer.h"
+#include "WorkStealingPool.h"
+#include "TestUtil.h"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static const int SAMPLE_RATE = 48000;
+
+static std::vector<float> Tone(float hz, float amplitude, float seconds) {
+    std::vector<float> samples((size_t)(SAMPLE_RATE * seconds));
+    for (size_t i = 0; i < samples.size(); i++) samples[i] = amplitude * (float)sin(2.0 * M_PI * hz * i / SAMPLE_RATE);
+    return samples;
+}
+
+static const LibraryTrack* Find(const std::vector<LibraryTrack>& tracks, const char* name) {
+    for (const LibraryTrack& track : tracks) {
+        if (fs::path(track.path).filename() == name) return &track;
+    }
+    return nullptr;
+}
+
+int main() {
+    // Pool: nested submissions, all run exactly once
+    {
+        std::atomic<int> count(0);
+        WorkStealingPool pool(4);
+        for (int i = 0; i < 100; i++) {
+            pool.Submit([&pool, &count] {
+                for (int j = 0; j < 10; j++) pool.Submit([&count] { count++; });
+                count++;
+            });
+        }
+        pool.Wait();
+        printf("      pool: %d tasks on %d threads, %llu steals\n", count.load(), pool.GetThreadCount(),
+               (unsigned long long)pool.GetStealCount());
+        Check("pool runs every task, including nested ones", count.load() == 1100);
+    }
+
+    fs::path root = fs::temp_directory_path() / "musicvis_library_test";
+    fs::remove_all(root);
+    fs::create_directories(root / "music" / "sub");
+    std::string music = (root / "music").string(), cache = (root / "cache").string();
+    WriteWav((root / "music" / "clicks.wav").string(), ClickTrack(120.0f, SAMPLE_RATE, 12.0f), SAMPLE_RATE);
+    WriteWav((root / "music" / "sub" / "bass.wav").string(), Tone(110.0f, 0.5f, 5.0f), SAMPLE_RATE);
+    WriteWav((root / "music" / "sub" / "quiet.WAV").string(), Tone(3000.0f, 0.05f, 3.0f), SAMPLE_RATE);
+    std::ofstream((root / "music" / "notes.txt").string()) << "not audio";
+
+    LibraryStats stats;
+    std::vector<LibraryTrack> tracks = AnalyzeLibrary(music, cache, 0, &stats);
+    printf("      first run: %d analyzed, %d cached, %d failed\n", stats.analyzed, stats.cached, stats.failed);
+    Check("finds every WAV, recursively, and only WAVs", tracks.size() == 3 && stats.analyzed == 3);
+
+    const LibraryTrack* clicks = Find(tracks, "clicks.wav");
+    const LibraryTrack* bass = Find(tracks, "bass.wav");
+    const LibraryTrack* quiet = Find(tracks, "quiet.WAV");
+    if (!clicks || !bass || !quiet) {
+        Check("summaries present", false);
+        return 1;
+    }
+    printf("      clicks %.1f BPM, bass band %d (%.0f Hz+), quiet %.1f LUFS vs bass %.1f LUFS\n",
+           clicks->summary.tempoBPM, bass->summary.dominantBand, bass->summary.bandLowHz[bass->summary.dominantBand],
+           quiet->summary.loudnessLUFS, bass->summary.loudnessLUFS);
+    Check("click track tempo is 120 BPM", fabsf(clicks->summary.tempoBPM - 120.0f) < 3.0f);
+    Check("110 Hz tone dominates the lowest band", bass->summary.dominantBand == 0);
+    Check("3 kHz tone dominates the 3-6 kHz band", quiet->summary.dominantBand == 5);
+    Check("quieter track measures quieter", quiet->summary.loudnessLUFS < bass->summary.loudnessLUFS - 10.0f);
+    Check("energy curve has one value per second", bass->summary.energyCurve.size() == 5 &&
+                                                   fabsf(bass->summary.energyCurve[2] - 0.5f / sqrtf(2.0f)) < 0.01f);
+
+    // Second run: everything from the cache, with identical summaries
+    std::vector<LibraryTrack> again = AnalyzeLibrary(music, cache, 0, &stats);
+    const LibraryTrack* clicksAgain = Find(again, "clicks.wav");
+    Check("re-run is served from the cache", stats.cached == 3 && stats.analyzed == 0);
+    Check("cached summary matches", clicksAgain && clicksAgain->summary.tempoBPM == clicks->summary.tempoBPM &&
+                                    clicksAgain->summary.energyCurve == clicks->summary.energyCurve);
+
+    // Moving a file keeps its entry; changing one re-analyzes only that one
+    fs::rename(root / "music" / "sub" / "bass.wav", root / "music" / "moved.wav");
+    WriteWav((root / "music" / "sub" / "quiet.WAV").string(), Tone(3000.0f, 0.1f, 3.0f), SAMPLE_RATE);
+    AnalyzeLibrary(music, cache, 0, &stats);
+    printf("      after move + edit: %d analyzed, %d cached\n", stats.analyzed, stats.cached);
+    Check("only the changed file is analyzed again", stats.analyzed == 1 && stats.cached == 2);
+
+    // Loudness comes from the channels, not the mix: anti-phase stereo cancels
+    // in mono but reads as two -6 dBFS channels (-6 LUFS)
+    {
+        std::vector<float> tone = Tone(1000.0f, 0.5f, 4.0f), stereo(tone.size() * 2);
+        for (size_t i = 0; i < tone.size(); i++) {
+            stereo[i * 2] = tone[i];
+            stereo[i * 2 + 1] = -tone[i];
+        }
+        std::string path = (root / "stereo.wav").string();
+        WriteWav(path, stereo, SAMPLE_RATE, 2);
+        WavData wav;
+        TrackSummary summary;
+        bool ok = ReadWavFile(path, wav) && AnalyzeTrack(wav, summary);
+        printf("      anti-phase stereo: %.2f LUFS\n", summary.loudnessLUFS);
+        Check("stereo loudness measured per channel", ok && wav.channels == 2 && fabsf(summary.loudnessLUFS + 6.0f) < 0.3f);
+    }
+
+    fs::remove_all(root);
+    return TestResult();
+}
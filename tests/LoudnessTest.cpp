@@ -0,0 +1,92 @@
+// Offline check of LoudnessMeter against reference signals from BS.1770 /
+// EBU Tech 3341. Returns non-zero if any case misses its tolerance.
+
+#include "LoudnessMeter.h"
+#include "TestUtil.h"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Interleaved sine on the given channels
+static std::vector<float> Sine(double freq, double amplitude, double phase, int sampleRate, int channels,
+                               const std::vector<int>& active, double seconds) {
+    size_t frames = (size_t)(sampleRate * seconds);
+    std::vector<float> samples(frames * channels, 0.0f);
+    for (size_t f = 0; f < frames; f++) {
+        float v = (float)(amplitude * sin(2.0 * M_PI * freq * f / sampleRate + phase));
+        for (int c : active) samples[f * channels + c] = v;
+    }
+    return samples;
+}
+
+static void Check(const char* name, float value, float expected, float tolerance) {
+    char label[128];
+    snprintf(label, sizeof(label), "%-40s %8.2f (expected %.2f +/- %.2f)", name, value, expected, tolerance);
+    Check(label, fabsf(value - expected) <= tolerance);
+}
+
+int main() {
+    LoudnessMeter meter;
+
+    // 997 Hz at 0 dBFS in one channel reads -3.01 LUFS (BS.1770 calibration)
+    for (int rate : { 44100, 48000, 96000 }) {
+        meter.Configure(rate, 2);
+        std::vector<float> s = Sine(997.0, 1.0, 0.0, rate, 2, { 0 }, 4.0);
+        meter.Process(s.data(), (int)(s.size() / 2));
+        char name[64];
+        snprintf(name, sizeof(name), "997 Hz 0 dBFS, one channel @ %d", rate);
+        Check(name, meter.GetShortTermLUFS(), -3.01f, 0.1f);
+    }
+
+    // EBU 3341 case 1: stereo 1 kHz at -23 dBFS reads -23 LUFS momentary and short-term
+    meter.Configure(48000, 2);
+    {
+        std::vector<float> s = Sine(1000.0, pow(10.0, -23.0 / 20.0), 0.0, 48000, 2, { 0, 1 }, 4.0);
+        meter.Process(s.data(), (int)(s.size() / 2));
+        Check("1 kHz -23 dBFS stereo, momentary", meter.GetMomentaryLUFS(), -23.0f, 0.1f);
+        Check("1 kHz -23 dBFS stereo, short-term", meter.GetShortTermLUFS(), -23.0f, 0.1f);
+    }
+
+    // 5.1: LFE doesn't count, surrounds are weighted +1.5 dB
+    meter.Configure(48000, 6);
+    {
+        std::vector<float> s = Sine(1000.0, pow(10.0, -23.0 / 20.0), 0.0, 48000, 6, { 3 }, 2.0);
+        meter.Process(s.data(), (int)(s.size() / 6));
+        Check("5.1 LFE only", meter.GetMomentaryLUFS(), LoudnessMeter::SILENCE_LUFS, 0.01f);
+
+        meter.Reset();
+        s = Sine(1000.0, pow(10.0, -23.0 / 20.0), 0.0, 48000, 6, { 4 }, 2.0);
+        meter.Process(s.data(), (int)(s.size() / 6));
+        Check("5.1 left surround only", meter.GetMomentaryLUFS(), -26.01f + 1.49f, 0.1f);
+    }
+
+    // 7.1.4: the first MAX_CHANNELS are measured, the heights are skipped
+    // without shifting the interleave
+    meter.Configure(48000, 12);
+    {
+        std::vector<float> s = Sine(1000.0, pow(10.0, -23.0 / 20.0), 0.0, 48000, 12, { 0 }, 2.0);
+        meter.Process(s.data(), (int)(s.size() / 12));
+        Check("7.1.4 left only", meter.GetMomentaryLUFS(), -26.01f, 0.1f);
+
+        meter.Reset();
+        s = Sine(1000.0, pow(10.0, -23.0 / 20.0), 0.0, 48000, 12, { 9 }, 2.0);
+        meter.Process(s.data(), (int)(s.size() / 12));
+        Check("7.1.4 height only", meter.GetMomentaryLUFS(), LoudnessMeter::SILENCE_LUFS, 0.01f);
+    }
+
+    // True peak: fs/4 sine at 45 degrees has sample peaks of 0.707 but a
+    // true peak of 1.0 (0 dBTP). The interpolator must find it.
+    meter.Configure(48000, 2);
+    {
+        std::vector<float> s = Sine(12000.0, 1.0, M_PI / 4.0, 48000, 2, { 0, 1 }, 1.0);
+        meter.Process(s.data(), (int)(s.size() / 2));
+        Check("fs/4 sine at 45 deg, true peak (dBTP)", meter.GetTruePeakDB(), 0.0f, 0.6f);
+    }
+
+    // Silence reads the floor
+    meter.Configure(48000, 2);
+    meter.Process(nullptr, 48000);
+    Check("Silence", meter.GetShortTermLUFS(), LoudnessMeter::SILENCE_LUFS, 0.01f);
+
+    return TestResult();
+}
@@ -0,0 +1,86 @@
+// Checks the minimum-statistics noise floor: it settles on steady noise,
+// ignores intermittent tones, follows a drop in the noise level within the
+// tracking window, and the analyzer's gate removes hiss but keeps music.
+// Returns non-zero on failure.
+
+#include "NoiseFloorTracker.h"
+#include "SpectrumAnalyzer.h"
+#include "TestUtil.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+static const int BINS = 16;
+static const float FRAME_RATE = 100.0f;
+static const int TONE_BIN = 5;
+
+// Noise of the given mean level in every bin, plus a tone in TONE_BIN that
+// is on for half of every second
+static void Feed(NoiseFloorTracker& tracker, int frames, float noise, int& frame) {
+    std::vector<float> magnitudes(BINS);
+    for (int f = 0; f < frames; f++, frame++) {
+        for (int i = 0; i < BINS; i++) magnitudes[i] = noise * (0.5f + (float)rand() / RAND_MAX);
+        if ((frame / 50) % 2 == 0) magnitudes[TONE_BIN] += 20.0f;
+        for (int i = 0; i < BINS; i += 4) tracker.Update4(i, F4Load(&magnitudes[i]));
+        tracker.EndFrame();
+    }
+}
+
+int main() {
+    srand(1);
+    NoiseFloorTracker tracker(BINS);
+    tracker.SetFrameRate(FRAME_RATE);
+    int frame = 0;
+
+    Feed(tracker, 400, 1.0f, frame);
+    const float* floor = tracker.GetFloor();
+    printf("      floor: noise bin %.2f, tone bin %.2f\n", floor[0], floor[TONE_BIN]);
+    Check("floor settles near the noise level", floor[0] > 0.5f && floor[0] < 1.5f);
+    Check("intermittent tone stays out of the floor", floor[TONE_BIN] < 2.0f);
+
+    // Noise drops 20 dB; the old minimum ages out of the window
+    Feed(tracker, (int)(NoiseFloorTracker::WINDOW_SECONDS * FRAME_RATE) + tracker.GetSubwindowFrames(), 0.1f, frame);
+    printf("      floor after drop: %.3f\n", floor[0]);
+    Check("floor follows a drop in noise within the window", floor[0] > 0.05f && floor[0] < 0.15f);
+
+    // Through the analyzer: quiet hiss plus a tone, gate off vs on
+    std::unique_ptr<SpectrumAnalyzer> analyzer(new SpectrumAnalyzer());
+    analyzer->SetSampleRate(48000.0);
+    analyzer->SetRequiredFeatures(Feature_SpectrumNormalized | Feature_NoiseFloor);
+    std::unique_ptr<AudioData> data(new AudioData());
+    std::vector<float> block(SpectrumAnalyzer::FFT_SIZE);
+    const int toneBin = 40;  // 3750 Hz, centred on a bin
+    long sample = 0;
+    auto run = [&](int blocks) {
+        for (int b = 0; b < blocks; b++) {
+            for (float& s : block) {
+                double t = (double)(sample++) / 48000.0;
+                s = 0.002f * ((float)rand() / RAND_MAX - 0.5f) + 0.05f * (float)sin(2.0 * M_PI * 3750.0 * t);
+            }
+            analyzer->Process(block, (float)SpectrumAnalyzer::FFT_SIZE / 48000.0f, *data);
+        }
+    };
+    auto hissLevel = [&]() {
+        float sum = 0.0f;
+        int count = 0;
+        for (int i = 60; i < 250; i++, count++) sum += data->SpectrumNormalized[i];
+        return sum / count;
+    };
+
+    run(400);
+    float hissOpen = hissLevel();
+    float toneOpen = data->SpectrumNormalized[toneBin];
+    Check("floor published for the hiss", data->NoiseFloor[100] > 0.0f);
+
+    analyzer->SetNoiseGate(true);
+    run(100);
+    float hissGated = hissLevel();
+    float toneGated = data->SpectrumNormalized[toneBin];
+    printf("      hiss %.3f -> %.3f, tone %.3f -> %.3f\n", hissOpen, hissGated, toneOpen, toneGated);
+    Check("gate removes most of the hiss", hissGated < 0.3f * hissOpen);
+    Check("gate keeps the tone", toneGated > 0.8f * toneOpen);
+
+    return TestResult();
+}
@@ -0,0 +1,139 @@
+// Checks the scoped-zone profiler: nothing is recorded outside a capture,
+// nested zones nest in the trace, each thread gets its own named track, a
+// full ring keeps the newest zones, a new capture drops the old one, and a
+// trace written while other threads record stays consistent. Returns
+// non-zero on failure.
+
+#include "Profiler.h"
+#include "TestUtil.h"
+#include <atomic>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::string Trace(int* zones = nullptr) {
+    std::ostringstream out;
+    int n = Profiler::Get().WriteTrace(out);
+    if (zones) *zones = n;
+    return out.str();
+}
+
+static int Count(const std::string& text, const std::string& what) {
+    int n = 0;
+    for (size_t at = text.find(what); at != std::string::npos; at = text.find(what, at + 1)) n++;
+    return n;
+}
+
+// Start and end (us) of the first zone with this name
+static bool FindZone(const std::string& trace, const char* name, double& start, double& end, int& tid) {
+    size_t at = trace.find(std::string("{\"name\":\"") + name + "\",\"ph\":\"X\"");
+    if (at == std::string::npos) return false;
+    double dur = 0.0;
+    if (sscanf(trace.c_str() + trace.find("\"tid\":", at), "\"tid\":%d,\"ts\":%lf,\"dur\":%lf", &tid, &start, &dur) != 3) {
+        return false;
+    }
+    end = start + dur;
+    return true;
+}
+
+static void Spin(int micros) {
+    int64_t until = Profiler::Now() + Profiler::TicksPerSecond() * micros / 1000000;
+    while (Profiler::Now() < until) {}
+}
+
+int main() {
+    Profiler& profiler = Profiler::Get();
+    PROFILE_THREAD("Main");
+
+    // Not capturing: zones cost a flag check and leave nothing behind
+    { PROFILE_ZONE("Idle"); }
+    int zones = -1;
+    std::string trace = Trace(&zones);
+    Check("nothing recorded while off", zones == 0 && Count(trace, "Idle") == 0);
+
+    profiler.SetEnabled(true);
+    {
+        PROFILE_ZONE("Outer");
+        Spin(200);
+        {
+            PROFILE_ZONE("Inner");
+            Spin(200);
+        }
+        Spin(200);
+    }
+    { PROFILE_ZONE("Quote\"d"); }
+    trace = Trace(&zones);
+    double outerStart, outerEnd, innerStart, innerEnd;
+    int outerTid = 0, innerTid = 0;
+    bool found = FindZone(trace, "Outer", outerStart, outerEnd, outerTid) &&
+                 FindZone(trace, "Inner", innerStart, innerEnd, innerTid);
+    Check("zones recorded", found && zones == 3);
+    Check("inner zone inside outer", found && outerTid == innerTid && innerStart >= outerStart &&
+                                     innerEnd <= outerEnd && outerEnd - outerStart >= 600.0);
+    Check("trace framing", trace.compare(0, 16, "{\"traceEvents\":[") == 0 &&
+                           trace.find("\"displayTimeUnit\":\"ms\"}") != std::string::npos);
+    Check("names escaped", trace.find("\"Quote\\\"d\"") != std::string::npos);
+    Check("thread named", trace.find("\"args\":{\"name\":\"Main\"}") != std::string::npos);
+
+    // Zones from other threads land on their own tracks, and a thread's
+    // zones survive it exiting
+    std::thread worker([] {
+        PROFILE_THREAD("Worker");
+        PROFILE_ZONE("WorkerZone");
+        Spin(100);
+    });
+    std::thread unnamed([] { PROFILE_ZONE("UnnamedZone"); });
+    worker.join();
+    unnamed.join();
+    trace = Trace();
+    double start, end;
+    int workerTid = 0, unnamedTid = 0;
+    Check("one track per thread", FindZone(trace, "WorkerZone", start, end, workerTid) &&
+                                  FindZone(trace, "UnnamedZone", start, end, unnamedTid) &&
+                                  workerTid != outerTid && unnamedTid != outerTid && workerTid != unnamedTid);
+    Check("threads named", trace.find("\"args\":{\"name\":\"Worker\"}") != std::string::npos &&
+                           trace.find("\"args\":{\"name\":\"Thread ") != std::string::npos);
+
+    // A new capture starts empty
+    profiler.SetEnabled(false);
+    profiler.SetEnabled(true);
+    { PROFILE_ZONE("Second"); }
+    trace = Trace(&zones);
+    Check("new capture drops the old one", zones == 1 && Count(trace, "Outer") == 0 && Count(trace, "Second") == 1);
+
+    // A full ring keeps the newest RING_EVENTS zones
+    const int EXTRA = 1000;
+    for (int i = 0; i < Profiler::RING_EVENTS + EXTRA; i++) {
+        PROFILE_ZONE(i < EXTRA ? "Old" : "New");
+    }
+    trace = Trace(&zones);
+    Check("full ring keeps the newest", Count(trace, "\"Old\"") == 0 && Count(trace, "\"New\"") == Profiler::RING_EVENTS);
+
+    // Writing while threads record: every zone written is whole
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 3; t++) {
+        writers.emplace_back([&stop] {
+            PROFILE_THREAD("Writer");
+            while (!stop.load()) {
+                PROFILE_ZONE("Busy");
+            }
+        });
+    }
+    bool consistent = true;
+    for (int i = 0; i < 2; i++) {
+        trace = Trace(&zones);
+        // This thread's ring still holds the "New" zones
+        int busy = Count(trace, "{\"name\":\"Busy\",\"ph\":\"X\"");
+        consistent = consistent && Count(trace, "\"ph\":\"X\"") == zones && busy + Profiler::RING_EVENTS == zones &&
+                     Count(trace, "\"dur\":-") == 0;
+    }
+    stop = true;
+    for (std::thread& writer : writers) writer.join();
+    Check("trace consistent under load", consistent && Count(trace, "\"args\":{\"name\":\"Writer\"}") == 3);
+
+    profiler.SetEnabled(false);
+    return TestResult();
+}
@@ -0,0 +1,142 @@
+// Checks frame publication for the renderer: nothing to read before the
+// first frame, a lone frame is held, two frames are lerped to the requested
+// time and extrapolated at most half a frame, the beat phase wraps, and a
+// reader racing the writer never sees a torn pair of frames. Returns
+// non-zero on failure.
+
+#include "SpectrumPublisher.h"
+#include "TestUtil.h"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+// Every interpolated array of the frame set to v
+static void FillFrame(AudioData& data, float v) {
+    for (int i = 0; i < 256; i++) {
+        data.Spectrum[i] = data.SpectrumNormalized[i] = data.SpectrumHighestSample[i] = v;
+        data.SpectrumHarmonic[i] = data.SpectrumPercussive[i] = v;
+        data.SpectrumSmoothed[i] = data.SpectrumPeak[i] = v;
+    }
+    for (int i = 0; i < 84; i++) data.SpectrumCQT[i] = v;
+    for (int i = 0; i < 12; i++) data.Chroma[i] = v;
+}
+
+static bool Near(float a, float b) {
+    return fabsf(a - b) < 1e-5f;
+}
+
+// Every interpolated bin of out equals v (Spectrum, which isn't clamped to
+// 1, equals raw)
+static bool AllNear(const AudioData& out, float v, float raw) {
+    for (int i = 0; i < 256; i++) {
+        if (!Near(out.Spectrum[i], raw) || !Near(out.SpectrumNormalized[i], v) ||
+            !Near(out.SpectrumHighestSample[i], v) || !Near(out.SpectrumHarmonic[i], v) ||
+            !Near(out.SpectrumPercussive[i], v) || !Near(out.SpectrumSmoothed[i], v) ||
+            !Near(out.SpectrumPeak[i], v)) return false;
+    }
+    for (int i = 0; i < 84; i++) if (!Near(out.SpectrumCQT[i], v)) return false;
+    for (int i = 0; i < 12; i++) if (!Near(out.Chroma[i], v)) return false;
+    return true;
+}
+
+// Every array of frame n holds n, and so does its timestamp
+static bool FrameConsistent(const SpectrumFrame& frame) {
+    float v = (float)frame.timestamp;
+    for (int i = 0; i < 256; i++) {
+        if (frame.Spectrum[i] != v || frame.SpectrumNormalized[i] != v || frame.SpectrumPeak[i] != v) return false;
+    }
+    for (int i = 0; i < 84; i++) if (frame.SpectrumCQT[i] != v) return false;
+    return frame.TempoBPM == v;
+}
+
+int main() {
+    std::unique_ptr<SpectrumPublisher> publisher(new SpectrumPublisher());
+    std::unique_ptr<AudioData> data(new AudioData());
+    std::unique_ptr<AudioData> out(new AudioData());
+    std::unique_ptr<SpectrumFrame> previous(new SpectrumFrame()), current(new SpectrumFrame());
+
+    Check("nothing to read before the first frame", !publisher->Interpolate(1.0, 0.0, *out) &&
+          publisher->ReadLatest(*previous, *current) == 0);
+
+    // One frame: held whatever the time
+    FillFrame(*data, 0.2f);
+    data->Scale = 2.0f;
+    publisher->Publish(*data, 1.0);
+    bool held = publisher->Interpolate(0.0, 0.0, *out) && AllNear(*out, 0.2f, 0.2f) &&
+                publisher->Interpolate(5.0, 0.0, *out) && AllNear(*out, 0.2f, 0.2f) && Near(out->Scale, 2.0f);
+    Check("single frame is held", held && publisher->ReadLatest(*previous, *current) == 1);
+
+    // Two frames, one second apart
+    FillFrame(*data, 0.6f);
+    data->Scale = 4.0f;
+    publisher->Publish(*data, 2.0);
+    Check("two frames readable", publisher->ReadLatest(*previous, *current) == 2 &&
+          previous->timestamp == 1.0 && current->timestamp == 2.0);
+
+    publisher->Interpolate(1.0, 0.0, *out);
+    Check("lerp at t = 0 is the older frame", AllNear(*out, 0.2f, 0.2f) && Near(out->Scale, 2.0f));
+    publisher->Interpolate(1.5, 0.0, *out);
+    Check("lerp at t = 0.5 is halfway", AllNear(*out, 0.4f, 0.4f) && Near(out->Scale, 3.0f));
+    publisher->Interpolate(2.0, 0.0, *out);
+    Check("lerp at t = 1 is the newer frame", AllNear(*out, 0.6f, 0.6f) && Near(out->Scale, 4.0f));
+    publisher->Interpolate(2.25, 0.5, *out);
+    Check("delay shifts the lerp back", AllNear(*out, 0.5f, 0.5f));
+
+    publisher->Interpolate(0.0, 0.0, *out);
+    Check("t < 0 clamps to the older frame", AllNear(*out, 0.2f, 0.2f));
+    publisher->Interpolate(2.5, 0.0, *out);
+    Check("t = 1.5 extrapolates half a frame", AllNear(*out, 0.8f, 0.8f) && Near(out->Scale, 5.0f));
+    publisher->Interpolate(10.0, 0.0, *out);
+    Check("extrapolation stops at t = 1.5", AllNear(*out, 0.8f, 0.8f));
+
+    // Extrapolating past 1 clamps normalized values, but not raw magnitudes
+    FillFrame(*data, 0.9f);
+    publisher->Publish(*data, 3.0);
+    publisher->Interpolate(3.5, 0.0, *out);
+    Check("extrapolation clamps normalized values to 1", AllNear(*out, 1.0f, 1.05f));
+
+    // Beat phase runs on from the newest frame at its tempo, both ways
+    data->TempoBPM = 120.0f;
+    data->BeatPhase = 0.9f;
+    publisher->Publish(*data, 4.0);
+    publisher->Interpolate(4.25, 0.0, *out);
+    bool forward = Near(out->BeatPhase, 0.4f) && out->TempoBPM == 120.0f;
+    data->BeatPhase = 0.1f;
+    publisher->Publish(*data, 5.0);
+    publisher->Interpolate(5.0, 0.1, *out);
+    bool backward = Near(out->BeatPhase, 0.9f);
+    printf("      beat phase %.3f after wrapping back\n", out->BeatPhase);
+    Check("beat phase wraps around", forward && backward);
+
+    // Reader thread against a writer publishing as fast as it can. Frame n
+    // is stamped n and filled with n, so a torn frame or a pair that isn't
+    // two consecutive frames shows up.
+    std::unique_ptr<SpectrumPublisher> raced(new SpectrumPublisher());
+    std::atomic<bool> done(false);
+    std::atomic<int> reads(0), torn(0);
+    std::thread reader([&] {
+        std::unique_ptr<SpectrumFrame> a(new SpectrumFrame()), b(new SpectrumFrame());
+        while (!done) {
+            if (raced->ReadLatest(*a, *b) < 2) continue;
+            if (!FrameConsistent(*a) || !FrameConsistent(*b) || b->timestamp != a->timestamp + 1.0) torn++;
+            reads++;
+        }
+    });
+
+    const int frames = 200000;
+    for (int n = 1; n <= frames; n++) {
+        FillFrame(*data, (float)n);
+        data->TempoBPM = (float)n;
+        raced->Publish(*data, (double)n);
+    }
+    done = true;
+    reader.join();
+
+    printf("      %d reads, %d torn\n", reads.load(), torn.load());
+    Check("reader never sees a torn frame", torn.load() == 0 && reads.load() > 0);
+    Check("frame counter counts every publish", raced->GetFrameCount() == (uint64_t)frames);
+
+    return TestResult();
+}
@@ -0,0 +1,224 @@
+// Checks the software render device against the D3D11 rules it follows:
+// shared edges are covered exactly once, blending and the luminance-alpha
+// texture path match the pixel shader, render targets and copies behave,
+// and the tiled multithreaded rasterizer matches a single-threaded one.
+// Then renders every visualization headless. Returns non-zero on failure.
+
+#include "CpuRenderDevice.h"
+#include "HeadlessRenderer.h"
+#include "TestUtil.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static Vertex MakeVertex(float x, float y, Vec4 color, Vec2 uv = { -1.0f, -1.0f }) {
+    Vertex v;
+    v.position = { x, y, 0.0f };
+    v.color = color;
+    v.texCoord = uv;
+    return v;
+}
+
+// Pixel rectangle (x0, y0)-(x1, y1) as two triangles in clip space
+static void AddQuad(std::vector<Vertex>& out, int w, int h, float x0, float y0, float x1, float y1,
+                    Vec4 color, bool textured = false) {
+    float l = x0 / w * 2.0f - 1.0f, r = x1 / w * 2.0f - 1.0f;
+    float t = 1.0f - y0 / h * 2.0f, b = 1.0f - y1 / h * 2.0f;
+    float u0 = textured ? 0.0f : -1.0f, u1 = textured ? 1.0f : -1.0f;
+    out.push_back(MakeVertex(l, t, color, { u0, textured ? 0.0f : -1.0f }));
+    out.push_back(MakeVertex(r, t, color, { u1, textured ? 0.0f : -1.0f }));
+    out.push_back(MakeVertex(l, b, color, { u0, textured ? 1.0f : -1.0f }));
+    out.push_back(MakeVertex(r, t, color, { u1, textured ? 0.0f : -1.0f }));
+    out.push_back(MakeVertex(r, b, color, { u1, textured ? 1.0f : -1.0f }));
+    out.push_back(MakeVertex(l, b, color, { u0, textured ? 1.0f : -1.0f }));
+}
+
+// Pseudo-random overlapping translucent triangles, some far off screen
+static void RandomScene(RenderDevice& device, uint32_t seed) {
+    std::vector<Vertex> vertices;
+    auto next = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) / 16777216.0f;
+    };
+    for (int i = 0; i < 3000; i++) {
+        float spread = (i % 50 == 0) ? 200.0f : 1.2f;
+        Vec4 color = { next(), next(), next(), next() };
+        for (int k = 0; k < 3; k++) {
+            vertices.push_back(MakeVertex((next() * 2.0f - 1.0f) * spread, (next() * 2.0f - 1.0f) * spread, color));
+        }
+    }
+    float black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    device.Clear(black);
+    device.DrawVertices(vertices);
+}
+
+int main() {
+    const int W = 200, H = 150;
+
+    // Shared edges: a fan of triangles around the centre, drawn at half
+    // alpha over black, must give one uniform level (no seams, no double blend)
+    {
+        CpuRenderDevice device(W, H, 1);
+        float black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        device.Clear(black);
+        std::vector<Vertex> vertices;
+        const int SEGMENTS = 37;
+        Vec4 color = { 1.0f, 1.0f, 1.0f, 0.5f };
+        for (int i = 0; i < SEGMENTS; i++) {
+            float a0 = 2.0f * 3.14159265f * i / SEGMENTS, a1 = 2.0f * 3.14159265f * (i + 1) / SEGMENTS;
+            vertices.push_back(MakeVertex(0.013f, -0.021f, color));
+            vertices.push_back(MakeVertex(0.8f * cosf(a0), 0.8f * sinf(a0), color));
+            vertices.push_back(MakeVertex(0.8f * cosf(a1), 0.8f * sinf(a1), color));
+        }
+        device.DrawVertices(vertices);
+        const uint8_t* pixels = device.ReadPixels();
+        int covered = 0, wrong = 0;
+        for (int i = 0; i < W * H; i++) {
+            uint8_t r = pixels[i * 4];
+            if (r == 0) continue;
+            covered++;
+            if (r != 128) wrong++;
+        }
+        Check("fan interior covered", covered > W * H / 4);
+        Check("shared edges blended exactly once", wrong == 0);
+    }
+
+    // Two quads that meet at x = 100 cover every pixel of the row exactly once
+    {
+        CpuRenderDevice device(W, H, 1);
+        float black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        device.Clear(black);
+        std::vector<Vertex> vertices;
+        AddQuad(vertices, W, H, 0.0f, 0.0f, 100.0f, (float)H, { 1.0f, 0.0f, 0.0f, 0.5f });
+        AddQuad(vertices, W, H, 100.0f, 0.0f, (float)W, (float)H, { 1.0f, 0.0f, 0.0f, 0.5f });
+        device.DrawVertices(vertices);
+        const uint8_t* pixels = device.ReadPixels();
+        bool uniform = true;
+        for (int i = 0; i < W * H; i++) uniform = uniform && pixels[i * 4] == 128;
+        Check("adjacent quads tile the target", uniform);
+    }
+
+    // Blend: src * a + dst * (1 - a) on colour, alpha written as-is
+    {
+        CpuRenderDevice device(4, 4, 1);
+        float grey[] = { 0.2f, 0.4f, 0.6f, 1.0f };
+        device.Clear(grey);
+        std::vector<Vertex> vertices;
+        AddQuad(vertices, 4, 4, 0.0f, 0.0f, 4.0f, 4.0f, { 1.0f, 0.0f, 0.5f, 0.25f });
+        device.DrawVertices(vertices);
+        const uint8_t* p = device.ReadPixels();
+        auto expect = [](float s, float d, float a) { return (int)((s * a + d * (1.0f - a)) * 255.0f + 0.5f); };
+        int dr = (int)(0.2f * 255.0f + 0.5f), dg = (int)(0.4f * 255.0f + 0.5f), db = (int)(0.6f * 255.0f + 0.5f);
+        bool ok = abs(p[0] - expect(1.0f, dr / 255.0f, 0.25f)) <= 1 && abs(p[1] - expect(0.0f, dg / 255.0f, 0.25f)) <= 1 &&
+                  abs(p[2] - expect(0.5f, db / 255.0f, 0.25f)) <= 1 && p[3] == 64;
+        Check("alpha blend", ok);
+    }
+
+    // Textured draw: luminance becomes alpha, tinted by the vertex colour
+    {
+        CpuRenderDevice device(8, 8, 1);
+        RenderTexture* texture = device.CreateRenderTexture(8, 8);
+        device.SetRenderTarget(texture);
+        float white[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        device.Clear(white);
+        device.SetRenderTarget(nullptr);
+        Check("render target restored", device.GetRenderTarget() == nullptr);
+
+        float black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        device.Clear(black);
+        device.BindTexture(texture);
+        std::vector<Vertex> vertices;
+        AddQuad(vertices, 8, 8, 0.0f, 0.0f, 8.0f, 8.0f, { 0.0f, 1.0f, 0.0f, 1.0f }, true);
+        device.DrawVertices(vertices);
+        device.BindTexture(nullptr);
+        const uint8_t* p = device.ReadPixels();
+        Check("white texture tinted green", p[0] == 0 && p[1] == 255 && p[2] == 0);
+
+        // Unbound texture samples zero: nothing is drawn
+        device.Clear(black);
+        device.DrawVertices(vertices);
+        p = device.ReadPixels();
+        Check("unbound texture draws nothing", p[1] == 0 && p[3] == 0);
+
+        // Copy the back buffer into the texture and read it back
+        RenderTexture* copy = device.CreateRenderTexture(8, 8);
+        device.Copy(copy, texture);
+        Check("copy between textures", device.ReadPixels(copy)[0] == 255);
+        device.DestroyTexture(copy);
+        device.DestroyTexture(texture);
+    }
+
+    // Tiled multithreaded rasterization matches the single-threaded result
+    {
+        const int BW = 333, BH = 251;  // Not a multiple of the tile size
+        CpuRenderDevice single(BW, BH, 1);
+        CpuRenderDevice multi(BW, BH, 4);
+        RandomScene(single, 99);
+        RandomScene(multi, 99);
+        bool same = memcmp(single.ReadPixels(), multi.ReadPixels(), (size_t)BW * BH * 4) == 0;
+        Check("4 threads match 1 thread bit for bit", same);
+    }
+
+    // A vertex far off screen clamps to the packed range (+-4); the
+    // triangle still covers the target instead of being lost
+    {
+        CpuRenderDevice device(64, 64, 1);
+        float black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        device.Clear(black);
+        Vec4 white = { 1.0f, 1.0f, 1.0f, 1.0f };
+        Vertex huge[3] = { MakeVertex(-1.0f, -1.0f, white), MakeVertex(5000.0f, -1.0f, white),
+                           MakeVertex(-1.0f, 5000.0f, white) };
+        device.DrawVertices(huge, 3);
+        const uint8_t* p = device.ReadPixels();
+        bool full = true;
+        for (int i = 0; i < 64 * 64; i++) full = full && p[i * 4] == 255;
+        Check("far off-screen vertex clamped, triangle kept", full && device.GetTrianglesDrawn() == 1);
+    }
+
+    // A batch past the vertex buffer is split into several draws, with no
+    // triangle lost or torn between two of them
+    {
+        CpuRenderDevice device(100, 100, 1);
+        float black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        device.Clear(black);
+        std::vector<Vertex> vertices;
+        const int QUADS = RenderDevice::MAX_VERTICES / 6 + 2000;  // 100 x 100 grid is 10000
+        for (int i = 0; i < QUADS; i++) {
+            int cell = i % 10000;
+            float x = (float)(cell % 100), y = (float)(cell / 100);
+            AddQuad(vertices, 100, 100, x, y, x + 1.0f, y + 1.0f, { 1.0f, 1.0f, 1.0f, 1.0f });
+        }
+        device.DrawVertices(vertices);
+        const uint8_t* p = device.ReadPixels();
+        bool full = true;
+        for (int i = 0; i < 100 * 100; i++) full = full && p[i * 4] == 255;
+        Check("oversized batch drawn in full", full && device.GetTrianglesDrawn() == (uint64_t)QUADS * 2);
+        Check("vertex high-water recorded", device.GetVertexHighWater() == QUADS * 6);
+    }
+
+    // Every visualization renders something from the test signal
+    {
+        const char* names[] = { "spectrum", "cybervalley2", "linefader", "spectrum2", "circle" };
+        for (const char* name : names) {
+            const char* argv[] = { "RasterizerTest", "--vis", name, "--frames", "90", "--size", "320x180", "--out", "." };
+            bool ran = RunHeadless(9, (char**)argv) == 0;
+            std::string path = std::string(name) + ".bmp";
+            FILE* f = fopen(path.c_str(), "rb");
+            std::vector<uint8_t> bytes;
+            if (f) {
+                uint8_t buffer[4096];
+                size_t n;
+                while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) bytes.insert(bytes.end(), buffer, buffer + n);
+                fclose(f);
+            }
+            int lit = 0;
+            for (size_t i = 54; i < bytes.size(); i++) lit += bytes[i] > 16;
+            std::string label = std::string(name) + " renders headless";
+            Check(label.c_str(), ran && bytes.size() == 54 + 320 * 180 * 3 && lit > 100);
+        }
+    }
+
+    return TestResult();
+}
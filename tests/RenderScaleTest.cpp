@@ -0,0 +1,186 @@
+// Checks the render scale controller and the scaled feedback passes: the
+// scale steps down when frames miss their refresh and not below its floor,
+// climbs back when there is headroom, backs off after a failed probe, and
+// ignores stray misses; the feedback visualizations keep their trail across
+// a scale change or resize and still fill the output. Returns non-zero on
+// failure.
+
+#include "CpuRenderDevice.h"
+#include "RenderScale.h"
+#include "../src/visualizations/CircleVis.h"
+#include "../src/visualizations/LineFaderVis.h"
+#include "TestUtil.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+// Frame time under vsync for a GPU cost that grows with the pixel count:
+// one refresh if it fits, two if it doesn't
+static float VsyncFrame(float budget, float fullCost, float scale) {
+    return fullCost * scale * scale <= budget ? budget : 2.0f * budget;
+}
+
+// Sum of the colour channels over the back buffer
+static int Brightness(CpuRenderDevice& device) {
+    const uint8_t* p = device.ReadPixels();
+    int sum = 0;
+    for (int i = 0; i < device.GetWidth() * device.GetHeight(); i++) sum += p[i * 4] + p[i * 4 + 1] + p[i * 4 + 2];
+    return sum;
+}
+
+// Box around everything drawn: { minX, minY, maxX, maxY }
+struct LitBox {
+    int minX, minY, maxX, maxY;
+};
+
+static LitBox LitBounds(CpuRenderDevice& device) {
+    const uint8_t* p = device.ReadPixels();
+    int w = device.GetWidth(), h = device.GetHeight();
+    LitBox box = { w, h, -1, -1 };
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            if (p[(y * w + x) * 4 + 1] <= 8) continue;
+            box.minX = std::min(box.minX, x);
+            box.maxX = std::max(box.maxX, x);
+            box.minY = std::min(box.minY, y);
+            box.maxY = std::max(box.maxY, y);
+        }
+    }
+    return box;
+}
+
+// Every edge within maxShift pixels. Counting lit rows and columns instead
+// would measure how thin lines break up at reduced scale, not the area.
+static bool SameBounds(const LitBox& a, const LitBox& b, int maxShift) {
+    return a.maxX >= 0 && b.maxX >= 0 && abs(a.minX - b.minX) <= maxShift && abs(a.minY - b.minY) <= maxShift &&
+           abs(a.maxX - b.maxX) <= maxShift && abs(a.maxY - b.maxY) <= maxShift;
+}
+
+int main() {
+    const float BUDGET = 1000.0f / 60.0f;
+    const int WINDOW = RenderScaleController::WINDOW_FRAMES;
+
+    // No budget (uncapped): full scale whatever the frame time
+    {
+        RenderScaleController controller;
+        bool changed = false;
+        for (int i = 0; i < 1000; i++) changed = controller.AddFrame(100.0f) || changed;
+        Check("no budget, no adjustment", !changed && controller.GetScale() == 1.0f);
+    }
+
+    // Every frame missing: one step per window down to the floor
+    {
+        RenderScaleController controller;
+        controller.SetBudget(BUDGET);
+        int changes = 0;
+        for (int i = 0; i < WINDOW * 20; i++) changes += controller.AddFrame(2.0f * BUDGET);
+        Check("steps down to the floor and stays", controller.GetScale() == RenderScaleController::MIN_SCALE &&
+                                                   changes == 4);
+
+        controller.SetBudget(0.0f);
+        Check("clearing the budget restores full scale", controller.GetScale() == 1.0f);
+    }
+
+    // A miss or two per window (a hitch, not load) doesn't drop the scale
+    {
+        RenderScaleController controller;
+        controller.SetBudget(BUDGET);
+        for (int i = 0; i < WINDOW * 20; i++) controller.AddFrame(i % WINDOW == 7 ? 3.0f * BUDGET : BUDGET);
+        Check("stray misses ignored", controller.GetScale() == 1.0f);
+    }
+
+    // Load that fits at 7/8 scale: settles there, probes full scale with
+    // growing gaps, and spends few frames missing
+    {
+        RenderScaleController controller;
+        controller.SetBudget(BUDGET);
+        const float cost = BUDGET * 1.2f;  // 0.875^2 * 1.2 = 0.92 of the budget
+        std::vector<int> probes;
+        int missed = 0;
+        const int FRAMES = 60 * 120;
+        for (int i = 0; i < FRAMES; i++) {
+            float frame = VsyncFrame(BUDGET, cost, controller.GetScale());
+            missed += frame > BUDGET;
+            if (controller.AddFrame(frame) && controller.GetScale() == 1.0f) probes.push_back(i);
+        }
+        bool backingOff = probes.size() >= 3;
+        for (size_t i = 2; i < probes.size(); i++) {
+            backingOff = backingOff && probes[i] - probes[i - 1] >= probes[i - 1] - probes[i - 2];
+        }
+        Check("settles at the largest scale that fits", controller.GetScale() == 0.875f);
+        Check("probes back off", backingOff && probes.back() - probes[probes.size() - 2] >=
+                                                   RenderScaleController::MAX_CLEAN_WINDOWS / 2 * WINDOW);
+        Check("under 5% of frames missed", missed * 20 < FRAMES);
+
+        // Load drops: climbs back to full scale
+        for (int i = 0; i < 60 * 120 && controller.GetScale() < 1.0f; i++) {
+            controller.AddFrame(VsyncFrame(BUDGET, BUDGET * 0.5f, controller.GetScale()));
+        }
+        Check("climbs back when headroom returns", controller.GetScale() == 1.0f);
+    }
+
+    // Feedback visualizations at reduced scale: the trail survives the
+    // switch and the upscaled result still covers the output
+    {
+        const int W = 320, H = 180;
+        std::unique_ptr<AudioData> data(new AudioData());
+        data->playing = true;
+        for (int b = 0; b < 256; b++) data->Spectrum[b] = 0.3f + 0.3f * sinf(b * 0.1f);
+
+        const char* names[2] = { "linefader", "circle" };
+        for (int v = 0; v < 2; v++) {
+            CpuRenderDevice device(W, H, 1);
+            auto create = [v]() -> std::unique_ptr<BaseVisualization> {
+                if (v == 0) return std::make_unique<LineFaderVis>();
+                return std::make_unique<CircleVis>();
+            };
+            std::unique_ptr<BaseVisualization> vis = create(), fresh = create();
+            float black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            auto frame = [&](BaseVisualization& target) {
+                device.SetRenderTarget(nullptr);
+                device.Clear(black);
+                target.Update(1.0f / 60.0f, *data, false);
+                return Brightness(device);
+            };
+
+            // One frame with no history: what a wiped trail would look like
+            fresh->SetRenderScale(0.5f);
+            fresh->Initialize(&device, W, H);
+            int wiped = frame(*fresh);
+            fresh->Cleanup();
+
+            vis->Initialize(&device, W, H);
+            for (int i = 0; i < 60; i++) frame(*vis);
+            int full = frame(*vis);
+            LitBox fullBounds = LitBounds(device);
+            vis->SetRenderScale(0.5f);
+            int switched = frame(*vis);
+            int scaled = switched;
+            for (int i = 0; i < 60; i++) scaled = frame(*vis);
+            LitBox scaledBounds = LitBounds(device);
+
+            char label[96];
+            // Resampled, not cleared (thin lines keep little through a 2:1 downsample)
+            snprintf(label, sizeof(label), "%s keeps its trail across a scale change", names[v]);
+            Check(label, switched > wiped);
+            // Thin lines lose brightness to the upscale (luminance is alpha),
+            // but the picture covers the same area. Edges move by a few
+            // texels at most (the faint end of a trail fades out sooner); a
+            // wrapped edge would light the opposite side of the output.
+            snprintf(label, sizeof(label), "%s at half scale fills the output", names[v]);
+            Check(label, scaled > full / 3 && SameBounds(scaledBounds, fullBounds, 12));
+
+            // Output resized (the visualization only sees the new size)
+            vis->Resize(W / 2, H);
+            int resized = frame(*vis);
+            snprintf(label, sizeof(label), "%s follows a resize", names[v]);
+            Check(label, resized > wiped);
+            vis->Cleanup();
+        }
+    }
+
+    return TestResult();
+}
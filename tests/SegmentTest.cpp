@@ -0,0 +1,131 @@
+// Checks the instanced segment path against the vertex path it replaces:
+// ExpandSegments builds the same quads the visualizations built by hand,
+// segments render like those quads on the software device, the instance
+// packer matches its scalar reference, and large batches are split.
+// Returns non-zero on failure.
+
+#include "CpuRenderDevice.h"
+#include "VertexPacking.h"
+#include "TestUtil.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static bool Near(const Vec3& a, float x, float y) {
+    return fabsf(a.x - x) < 1e-6f && fabsf(a.y - y) < 1e-6f;
+}
+
+int main() {
+    const int W = 256, H = 128;
+    Vec4 green = { 0.0f, 1.0f, 0.0f, 0.5f };
+
+    // A bar expands to the quad SpectrumVis used to build
+    {
+        Segment bar = MakeBar(-0.5f, -0.25f, 0.25f, 0.75f, green);
+        Vertex out[6];
+        int n = ExpandSegments(&bar, 1, out);
+        bool corners = n == 6 && Near(out[0].position, -0.5f, -0.25f) && Near(out[1].position, -0.5f, 0.75f) &&
+                       Near(out[2].position, 0.25f, -0.25f) && Near(out[4].position, 0.25f, 0.75f);
+        bool same = memcmp(&out[1], &out[3], sizeof(Vertex)) == 0 && memcmp(&out[2], &out[5], sizeof(Vertex)) == 0;
+        bool solid = out[0].texCoord.x == -1.0f && out[0].color.y == 1.0f && out[0].color.w == 0.5f;
+        Check("bar expands to its rectangle", corners && same && solid);
+
+        Segment dot = { { 0.1f, 0.1f }, { 0.1f, 0.10005f }, 0.01f, green };
+        Check("too-short segment skipped", ExpandSegments(&dot, 1, out) == 0);
+    }
+
+    // Pixel-aligned bars render exactly like the hand-built quads
+    {
+        std::vector<Segment> segments;
+        std::vector<Vertex> vertices;
+        for (int i = 0; i < 16; i++) {
+            float l = -1.0f + i * 0.125f, r = l + 0.0625f;
+            float b = -1.0f + (i % 4) * 0.25f, t = b + 0.5f;
+            Vec4 color = { i / 15.0f, 1.0f - i / 15.0f, 0.5f, 0.5f };
+            segments.push_back(MakeBar(l, b, r, t, color));
+            vertices.push_back({ { l, t, 0.0f }, color, { -1.0f, -1.0f } });
+            vertices.push_back({ { r, t, 0.0f }, color, { -1.0f, -1.0f } });
+            vertices.push_back({ { l, b, 0.0f }, color, { -1.0f, -1.0f } });
+            vertices.push_back({ { r, t, 0.0f }, color, { -1.0f, -1.0f } });
+            vertices.push_back({ { r, b, 0.0f }, color, { -1.0f, -1.0f } });
+            vertices.push_back({ { l, b, 0.0f }, color, { -1.0f, -1.0f } });
+        }
+        CpuRenderDevice quads(W, H, 1), bars(W, H, 1);
+        float black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        quads.Clear(black);
+        bars.Clear(black);
+        quads.DrawVertices(vertices);
+        bars.DrawSegments(segments);
+        Check("bars match quads bit for bit", memcmp(quads.ReadPixels(), bars.ReadPixels(), (size_t)W * H * 4) == 0);
+        Check("20 bytes per bar instead of 96", bars.GetUploadBytes() * 96 == quads.GetUploadBytes() * 20);
+    }
+
+    // Thin diagonal lines: same coverage as the expanded vertices, up to
+    // edge pixels (endpoints are quantized instead of corners)
+    {
+        std::vector<Segment> segments;
+        for (int i = 0; i < 40; i++) {
+            float a = 0.157f * i;
+            Vec2 p0 = { 0.1f * cosf(a), 0.1f * sinf(a) };
+            Vec2 p1 = { 0.9f * cosf(a), 0.9f * sinf(a) };
+            segments.push_back({ p0, p1, 0.004f, { 0.4f, 0.7f, 1.0f, 1.0f } });
+            segments.push_back({ p0, p1, 0.002f, { 1.0f, 1.0f, 1.0f, 1.0f } });
+        }
+        std::vector<Vertex> vertices(segments.size() * 6);
+        vertices.resize(ExpandSegments(segments.data(), (int)segments.size(), vertices.data()));
+
+        CpuRenderDevice expanded(W, H, 1), instanced(W, H, 1);
+        float black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        expanded.Clear(black);
+        instanced.Clear(black);
+        expanded.DrawVertices(vertices);
+        instanced.DrawSegments(segments);
+        const uint8_t* a = expanded.ReadPixels();
+        const uint8_t* b = instanced.ReadPixels();
+        int lit = 0, differ = 0;
+        for (int i = 0; i < W * H; i++) {
+            lit += a[i * 4 + 2] != 0;
+            differ += a[i * 4 + 2] != b[i * 4 + 2];
+        }
+        Check("lines drawn", lit > 1000);
+        Check("lines match expanded vertices to a few edge pixels", differ * 50 < lit);
+    }
+
+    // SSE2 instance packer matches the scalar reference; endpoints at +-1 exact
+    {
+        std::vector<Segment> segments(1001);
+        uint32_t seed = 3;
+        auto next = [&seed](float lo, float hi) {
+            seed = seed * 1664525u + 1013904223u;
+            return lo + (hi - lo) * ((seed >> 8) / 16777216.0f);
+        };
+        for (Segment& s : segments) {
+            s.p0 = { next(-5.0f, 5.0f), next(-5.0f, 5.0f) };
+            s.p1 = { next(-5.0f, 5.0f), next(-5.0f, 5.0f) };
+            s.thickness = next(0.0f, 0.01f);
+            s.color = { next(-0.2f, 1.2f), next(-0.2f, 1.2f), next(-0.2f, 1.2f), next(-0.2f, 1.2f) };
+        }
+        segments[0] = MakeBar(-1.0f, -1.0f, 1.0f, 1.0f, green);
+        std::vector<PackedSegment> simd(segments.size()), scalar(segments.size());
+        PackSegments(segments.data(), simd.data(), (int)segments.size());
+        PackSegmentsScalar(segments.data(), scalar.data(), (int)segments.size());
+        Check("vectorized segment packer matches scalar",
+              memcmp(simd.data(), scalar.data(), simd.size() * sizeof(PackedSegment)) == 0);
+        Segment back = UnpackSegment(simd[0]);
+        Check("bar endpoints exact", back.p0.x == 0.0f && back.p0.y == -1.0f && back.p1.y == 1.0f &&
+                                     back.thickness == 1.0f && back.color.y == 1.0f);
+    }
+
+    // More segments than one pass holds are drawn in several
+    {
+        CpuRenderDevice device(64, 64, 1);
+        std::vector<Segment> segments(RenderDevice::MAX_VERTICES / 6 * 2 + 7,
+                                      { { -0.5f, 0.0f }, { 0.5f, 0.0f }, 0.1f, green });
+        device.DrawSegments(segments);
+        Check("large batch split, nothing dropped", device.GetTrianglesDrawn() == segments.size() * 2 &&
+                                                    device.GetSegmentsDrawn() == segments.size());
+    }
+
+    return TestResult();
+}
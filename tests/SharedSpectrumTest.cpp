@@ -0,0 +1,104 @@
+// Checks shared-memory publication: a reader mapping the segment through
+// the C header sees the header fields and the published frame, and a
+// reader thread racing the writer never sees a torn frame. Returns non-zero
+// on failure.
+
+#include "SharedSpectrum.h"
+#include "TestUtil.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+// Every published value in frame n is n, so a mix of two frames shows up
+static void FillFrame(AudioData& data, int n) {
+    float v = (float)n;
+    for (int i = 0; i < 256; i++) {
+        data.Spectrum[i] = data.SpectrumNormalized[i] = data.SpectrumSmoothed[i] = data.SpectrumPeak[i] = v;
+    }
+    for (int i = 0; i < 84; i++) data.SpectrumCQT[i] = v;
+    for (int i = 0; i < 12; i++) data.Chroma[i] = v;
+    data.TempoBPM = v;
+}
+
+static bool FrameConsistent(const MusicVisShmFrame& frame) {
+    float v = frame.tempoBPM;
+    if ((double)v != frame.timestamp) return false;
+    for (int i = 0; i < MUSICVIS_SHM_BINS; i++) {
+        if (frame.spectrum[i] != v || frame.spectrumNormalized[i] != v || frame.spectrumSmoothed[i] != v ||
+            frame.spectrumPeak[i] != v) return false;
+    }
+    for (int i = 0; i < MUSICVIS_SHM_CQT_BINS; i++) if (frame.spectrumCQT[i] != v) return false;
+    for (int i = 0; i < 12; i++) if (frame.chroma[i] != v) return false;
+    return true;
+}
+
+int main() {
+#ifdef _WIN32
+    std::string name = "Local\\MusicVisSpectrumTest";
+#else
+    std::string name = "/musicvis_spectrum_test_" + std::to_string((long)getpid());
+#endif
+    Check("no segment before the writer opens it", musicvis_shm_open(name.c_str()) == nullptr);
+
+    SharedSpectrumWriter writer;
+    if (!writer.Open(name)) {
+        Check("writer opens the segment", false);
+        return 1;
+    }
+    std::unique_ptr<AudioData> data(new AudioData());
+    FillFrame(*data, 7);
+    writer.Publish(*data, 7.0, Feature_SpectrumNormalized | Feature_Envelope);
+
+    const MusicVisShmSegment* shm = musicvis_shm_open(name.c_str());
+    if (!shm) {
+        Check("reader maps the segment", false);
+        return 1;
+    }
+    Check("header carries magic, version and size", shm->magic == MUSICVIS_SHM_MAGIC &&
+          shm->version == MUSICVIS_SHM_VERSION && shm->segmentSize == sizeof(MusicVisShmSegment));
+    uint32_t seq = musicvis_shm_read_begin(shm);
+    bool ok = FrameConsistent(shm->frame) && shm->frame.tempoBPM == 7.0f && shm->frameCount == 1 &&
+              shm->frame.features == (Feature_SpectrumNormalized | Feature_Envelope);
+    Check("reader sees the published frame in place", !musicvis_shm_read_retry(shm, seq) && ok);
+
+    // Reader thread against a writer publishing as fast as it can
+    std::atomic<bool> done(false);
+    std::atomic<int> reads(0), torn(0), retries(0);
+    std::thread reader([&] {
+        while (!done) {
+            uint32_t s;
+            bool consistent;
+            do {
+                s = musicvis_shm_read_begin(shm);
+                consistent = FrameConsistent(shm->frame);
+                if (musicvis_shm_read_retry(shm, s)) retries++;
+                else break;
+            } while (true);
+            if (!consistent) torn++;
+            reads++;
+        }
+    });
+
+    const int frames = 200000;
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 8; n < 8 + frames; n++) {
+        FillFrame(*data, n);
+        writer.Publish(*data, (double)n, 0);
+    }
+    double publishMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    done = true;
+    reader.join();
+
+    printf("      %d reads, %d retried, %d torn; publish %.3f us/frame (includes filling the test frame)\n",
+           reads.load(), retries.load(), torn.load(), publishMicros / frames);
+    Check("reader never sees a torn frame", torn.load() == 0 && reads.load() > 0);
+    Check("frame counter counts every publish", shm->frameCount == (uint64_t)frames + 1);
+
+    musicvis_shm_close(shm);
+    writer.Close();
+    Check("segment removed on close", musicvis_shm_open(name.c_str()) == nullptr);
+    return TestResult();
+}
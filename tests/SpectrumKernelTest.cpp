@@ -0,0 +1,190 @@
+// Checks the fused post-FFT pass against the three-pass code it replaced
+// (magnitude, then normalize, then a history rescan for the peak hold) on a
+// fixed signal whose level jumps, so both the decaying scale and the
+// re-normalization on expansion run. Also checks the weighting curves:
+// A-weighting is 0 dB at 1 kHz and the tilt rises 3 dB per octave.
+// Returns non-zero on failure.
+
+#include "SpectrumAnalyzer.h"
+#include "TestUtil.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+static const int FFT_SIZE = SpectrumAnalyzer::FFT_SIZE;
+static const int BINS = SpectrumAnalyzer::NUM_BINS;
+
+// The original per-stage code, fed the same windowed FFT
+class Baseline {
+public:
+    Baseline() : m_fft(FFT_SIZE), m_window(FFT_SIZE), m_bins(FFT_SIZE) {
+        for (int i = 0; i < FFT_SIZE; i++) m_window[i] = 0.5f * (1.0f - cos(2.0f * M_PI * i / (FFT_SIZE - 1)));
+    }
+
+    // Returns true if the block expanded the peak
+    bool Process(const std::vector<float>& samples, float deltaTime, AudioData& data) {
+        data.historyIndex = (data.historyIndex + 1) % SpectrumAnalyzer::HISTORY_SIZE;
+
+        float sum = 0.0f;
+        for (int i = 0; i < FFT_SIZE; i++) sum += samples[i];
+        float mean = sum / FFT_SIZE;
+        for (int i = 0; i < FFT_SIZE; i++) m_bins[i] = (samples[i] - mean) * m_window[i];
+        m_fft.Forward(m_bins.data());
+
+        // Magnitude
+        float maxVal = 0.0f;
+        for (int i = 0; i < BINS; i++) {
+            data.Spectrum[i] = sqrtf(std::abs(m_bins[i]));
+            if (data.Spectrum[i] > maxVal) maxVal = data.Spectrum[i];
+        }
+
+        // Normalize
+        float currentPeak = (data.Scale > 0.00001f) ? (1.0f / data.Scale) : 1.0f;
+        bool expanded = maxVal > currentPeak;
+        if (expanded) currentPeak = maxVal;
+        else currentPeak -= currentPeak * 0.50f * deltaTime;
+        if (currentPeak < 0.667f) currentPeak = 0.667f;
+        data.Scale = 1.0f / currentPeak;
+        for (int i = 0; i < BINS; i++) {
+            data.SpectrumNormalized[i] = data.Spectrum[i] * data.Scale;
+            if (data.SpectrumNormalized[i] > 1.0f) data.SpectrumNormalized[i] = 1.0f;
+        }
+
+        // History rows
+        for (int i = 0; i < BINS; i++) {
+            data.History[data.historyIndex][i] = data.Spectrum[i];
+            data.HistoryNormalized[data.historyIndex][i] = data.SpectrumNormalized[i];
+        }
+
+        // Peak hold
+        for (int i = 0; i < BINS; i++) {
+            float highest = 0.0f;
+            for (int h = 0; h < SpectrumAnalyzer::PEAK_HOLD_FRAMES; h++) {
+                int idx = (data.historyIndex - h + SpectrumAnalyzer::HISTORY_SIZE) % SpectrumAnalyzer::HISTORY_SIZE;
+                if (data.HistoryNormalized[idx][i] > highest) highest = data.HistoryNormalized[idx][i];
+            }
+            data.SpectrumHighestSample[i] = highest;
+        }
+        return expanded;
+    }
+
+private:
+    FftPlan m_fft;
+    std::vector<float> m_window;
+    std::vector<std::complex<float>> m_bins;
+};
+
+// Largest difference relative to the larger of the two values (and 1e-3,
+// so bins near zero are compared absolutely)
+static float MaxError(const float* a, const float* b, int count) {
+    float worst = 0.0f;
+    for (int i = 0; i < count; i++) {
+        float scale = std::max(1e-3f, std::max(fabsf(a[i]), fabsf(b[i])));
+        worst = std::max(worst, fabsf(a[i] - b[i]) / scale);
+    }
+    return worst;
+}
+
+// Block b of a chord over noise, with loud bursts every 40 blocks and a
+// quiet stretch in between
+static void FillBlock(std::vector<float>& block, int b, double sampleRate, uint32_t& noise) {
+    double level = (b % 40 < 3) ? 0.8 : (b % 40 < 20 ? 0.05 : 0.2);
+    for (int i = 0; i < FFT_SIZE; i++) {
+        double t = (double)(b * FFT_SIZE + i) / sampleRate;
+        noise = noise * 1664525u + 1013904223u;
+        double n = ((noise >> 8) / 16777216.0) * 2.0 - 1.0;
+        block[i] = (float)(level * (0.4 * sin(2.0 * M_PI * 220.0 * t) + 0.3 * sin(2.0 * M_PI * 1375.0 * t) + 0.3 * n));
+    }
+}
+
+// Spectrum of one block of the test signal under the given weighting
+static std::vector<float> WeightedSpectrum(SpectrumWeighting weighting, double sampleRate) {
+    std::unique_ptr<SpectrumAnalyzer> analyzer(new SpectrumAnalyzer());
+    std::unique_ptr<AudioData> data(new AudioData());
+    analyzer->SetSampleRate(sampleRate);
+    analyzer->SetRequiredFeatures(Feature_Spectrum);
+    analyzer->SetWeighting(weighting);
+    std::vector<float> block(FFT_SIZE);
+    uint32_t noise = 1;
+    FillBlock(block, 25, sampleRate, noise);
+    analyzer->Process(block, 0.01f, *data);
+    return std::vector<float>(data->Spectrum, data->Spectrum + BINS);
+}
+
+// Weight of a bin in dB. Spectrum is sqrt(|X| * weight), so the weight is
+// the squared ratio to the flat spectrum.
+static double WeightDb(const std::vector<float>& weighted, const std::vector<float>& flat, int bin) {
+    double ratio = (double)weighted[bin] / flat[bin];
+    return 20.0 * log10(ratio * ratio);
+}
+
+int main() {
+    const double sampleRate = 48000.0;
+    const float deltaTime = (float)(FFT_SIZE / sampleRate);
+
+    std::unique_ptr<SpectrumAnalyzer> analyzer(new SpectrumAnalyzer());
+    std::unique_ptr<AudioData> fused(new AudioData());
+    std::unique_ptr<AudioData> baseline(new AudioData());
+    Baseline reference;
+    analyzer->SetSampleRate(sampleRate);
+    analyzer->SetRequiredFeatures(Feature_Spectrum | Feature_SpectrumNormalized | Feature_History |
+                                  Feature_HistoryNormalized | Feature_HighestSample);
+
+    // Two and a half trips round the history ring
+    std::vector<float> block(FFT_SIZE);
+    uint32_t noise = 1;
+    int expansions = 0;
+    float spectrumError = 0.0f, normalizedError = 0.0f, highestError = 0.0f, scaleError = 0.0f;
+    for (int b = 0; b < 150; b++) {
+        FillBlock(block, b, sampleRate, noise);
+        analyzer->Process(block, deltaTime, *fused);
+        if (reference.Process(block, deltaTime, *baseline)) expansions++;
+        spectrumError = std::max(spectrumError, MaxError(fused->Spectrum, baseline->Spectrum, BINS));
+        normalizedError = std::max(normalizedError, MaxError(fused->SpectrumNormalized, baseline->SpectrumNormalized, BINS));
+        highestError = std::max(highestError, MaxError(fused->SpectrumHighestSample, baseline->SpectrumHighestSample, BINS));
+        scaleError = std::max(scaleError, MaxError(&fused->Scale, &baseline->Scale, 1));
+    }
+    float historyError = MaxError(&fused->History[0][0], &baseline->History[0][0], SpectrumAnalyzer::HISTORY_SIZE * BINS);
+    float historyNormalizedError = MaxError(&fused->HistoryNormalized[0][0], &baseline->HistoryNormalized[0][0],
+                                            SpectrumAnalyzer::HISTORY_SIZE * BINS);
+
+    printf("      %d expanding blocks; max relative error: spectrum %.2g, normalized %.2g, peak hold %.2g, "
+           "history %.2g / %.2g, scale %.2g\n", expansions, spectrumError, normalizedError, highestError,
+           historyError, historyNormalizedError, scaleError);
+    const float tolerance = 1e-5f;
+    Check("level changes exercise expansion and decay", expansions >= 3 && expansions < 100);
+    Check("Spectrum matches the three-pass code", spectrumError < tolerance);
+    Check("SpectrumNormalized and Scale match", normalizedError < tolerance && scaleError < tolerance);
+    Check("History and HistoryNormalized rows match", fused->historyIndex == baseline->historyIndex &&
+                                                       historyError < tolerance && historyNormalizedError < tolerance);
+    Check("SpectrumHighestSample matches", highestError < tolerance);
+
+    // At 51.2 kHz the bins are 100 Hz apart, so 500 Hz, 1, 2 and 4 kHz are
+    // bins 5, 10, 20 and 40
+    const double weightRate = 51200.0;
+    std::vector<float> flat = WeightedSpectrum(Weighting_Flat, weightRate);
+    std::vector<float> aWeighted = WeightedSpectrum(Weighting_A, weightRate);
+    std::vector<float> tilted = WeightedSpectrum(Weighting_Tilt, weightRate);
+
+    double aAt1k = WeightDb(aWeighted, flat, 10);
+    double aAt100 = WeightDb(aWeighted, flat, 1);
+    printf("      A-weighting: %.3f dB at 1 kHz, %.2f dB at 100 Hz\n", aAt1k, aAt100);
+    Check("A-weighting is 0 dB at 1 kHz", fabs(aAt1k) < 0.1);
+    Check("A-weighting cuts 100 Hz by ~19 dB", fabs(aAt100 + 19.1) < 0.5);
+
+    // TILT_DB_PER_OCTAVE
+    const double tiltDbPerOctave = 3.0;
+    bool tiltOk = fabs(WeightDb(tilted, flat, 10)) < 0.01;
+    for (int bin = 5; bin <= 20; bin *= 2) {
+        double step = WeightDb(tilted, flat, bin * 2) - WeightDb(tilted, flat, bin);
+        printf("      tilt %d -> %d Hz: %+.3f dB\n", bin * 100, bin * 200, step);
+        tiltOk = tiltOk && fabs(step - tiltDbPerOctave) < 0.01;
+    }
+    Check("tilt is 0 dB at 1 kHz and 3 dB per octave", tiltOk);
+
+    return TestResult();
+}
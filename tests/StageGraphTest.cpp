@@ -0,0 +1,140 @@
+// Checks the analyzer's stage graph: a feature runs only its stage and that
+// stage's dependencies, skipped stages report no cost, and a stage that is
+// switched back on starts from a clean state instead of stale data.
+// Returns non-zero on failure.
+
+#include "SpectrumAnalyzer.h"
+#include "TestUtil.h"
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+static const int FFT_SIZE = SpectrumAnalyzer::FFT_SIZE;
+
+static uint32_t Bit(int stage) {
+    return 1u << stage;
+}
+
+// Active stages after the last block, as stage bits. Active stages must have
+// a cost and skipped ones none.
+static uint32_t ActiveStages(const SpectrumAnalyzer& analyzer, bool& timingOk) {
+    uint32_t stages = 0;
+    timingOk = true;
+    for (int s = 0; s < SpectrumAnalyzer::Stage_Count; s++) {
+        SpectrumAnalyzer::StageTiming timing = analyzer.GetStageTiming(s);
+        if (timing.active) stages |= Bit(s);
+        timingOk = timingOk && (timing.active ? timing.avgMicros > 0.0f : timing.avgMicros == 0.0f);
+    }
+    return stages;
+}
+
+static std::string Names(const SpectrumAnalyzer& analyzer, uint32_t stages) {
+    std::string names;
+    for (int s = 0; s < SpectrumAnalyzer::Stage_Count; s++) {
+        if (!(stages & Bit(s))) continue;
+        if (!names.empty()) names += ", ";
+        names += analyzer.GetStageTiming(s).name;
+    }
+    return names;
+}
+
+// Runs blocks of the track, starting at position
+static void Run(SpectrumAnalyzer& analyzer, AudioData& data, const std::vector<float>& track, size_t& position,
+                int blocks, float deltaTime) {
+    std::vector<float> block(FFT_SIZE);
+    for (int b = 0; b < blocks; b++) {
+        for (int i = 0; i < FFT_SIZE; i++) {
+            block[i] = track[position];
+            if (++position == track.size()) position = 0;
+        }
+        analyzer.Process(block, deltaTime, data);
+    }
+}
+
+static float Max(const float* values, int count) {
+    float m = 0.0f;
+    for (int i = 0; i < count; i++) if (values[i] > m) m = values[i];
+    return m;
+}
+
+int main() {
+    const int sampleRate = 48000;
+    const float deltaTime = (float)FFT_SIZE / sampleRate;
+    std::vector<float> clicks = ClickTrack(120.0f, sampleRate, 12.0f);
+    std::vector<float> silence(FFT_SIZE * 4, 0.0f);
+
+    std::unique_ptr<SpectrumAnalyzer> analyzer(new SpectrumAnalyzer());
+    std::unique_ptr<AudioData> data(new AudioData());
+    analyzer->SetSampleRate(sampleRate);
+    analyzer->GetTempoTracker().SetBudgetMicros(1e9f);
+    size_t position = 0;
+    bool timingOk = false;
+
+    // Which stages each request runs
+    struct Case { const char* name; uint32_t features; uint32_t stages; };
+    const uint32_t core = Bit(SpectrumAnalyzer::Stage_FFT) | Bit(SpectrumAnalyzer::Stage_Spectrum);
+    const Case cases[] = {
+        { "HighestSample", Feature_HighestSample, core | Bit(SpectrumAnalyzer::Stage_PeakHold) },
+        { "Descriptors", Feature_Descriptors,
+          core | Bit(SpectrumAnalyzer::Stage_CQT) | Bit(SpectrumAnalyzer::Stage_Descriptors) },
+        { "ConstantQ", Feature_ConstantQ, Bit(SpectrumAnalyzer::Stage_CQT) },
+        { "Spectrum", Feature_Spectrum, core },
+    };
+    for (const Case& c : cases) {
+        analyzer->SetRequiredFeatures(c.features);
+        Run(*analyzer, *data, clicks, position, 2, deltaTime);
+        uint32_t active = ActiveStages(*analyzer, timingOk);
+        char label[160];
+        snprintf(label, sizeof(label), "%s runs %s", c.name, Names(*analyzer, active).c_str());
+        Check(label, active == c.stages);
+        snprintf(label, sizeof(label), "%s: only active stages report a cost", c.name);
+        Check(label, timingOk);
+    }
+
+    // History: the rows written before the Spectrum stage was skipped are
+    // cleared when it comes back
+    analyzer->SetRequiredFeatures(Feature_History);
+    Run(*analyzer, *data, clicks, position, SpectrumAnalyzer::HISTORY_SIZE, deltaTime);
+    int filled = 0;
+    for (int row = 0; row < SpectrumAnalyzer::HISTORY_SIZE; row++) {
+        if (Max(data->History[row], SpectrumAnalyzer::NUM_BINS) > 0.0f) filled++;
+    }
+    analyzer->SetRequiredFeatures(Feature_ConstantQ);
+    Run(*analyzer, *data, clicks, position, 1, deltaTime);
+    analyzer->SetRequiredFeatures(Feature_History);
+    Run(*analyzer, *data, clicks, position, 1, deltaTime);
+    bool cleared = true;
+    for (int row = 0; row < SpectrumAnalyzer::HISTORY_SIZE; row++) {
+        if (row != data->historyIndex) cleared = cleared && Max(data->History[row], SpectrumAnalyzer::NUM_BINS) == 0.0f;
+    }
+    Check("history is cleared when its stage comes back", filled > 1 && cleared);
+
+    // Tempo: a locked tempo is dropped when the stage comes back
+    analyzer->SetRequiredFeatures(Feature_Tempo);
+    position = 0;
+    Run(*analyzer, *data, clicks, position, (int)(10.0f / deltaTime), deltaTime);
+    float lockedBpm = data->TempoBPM;
+    analyzer->SetRequiredFeatures(Feature_Spectrum);
+    Run(*analyzer, *data, clicks, position, 4, deltaTime);
+    analyzer->SetRequiredFeatures(Feature_Tempo);
+    Run(*analyzer, *data, clicks, position, 1, deltaTime);
+    printf("      tempo %.1f BPM before, %.1f after switching back on\n", lockedBpm, data->TempoBPM);
+    Check("tempo starts over when its stage comes back", lockedBpm > 0.0f && data->TempoBPM == 0.0f);
+
+    // Envelope: the peak of a loud passage isn't carried across the gap
+    analyzer->SetRequiredFeatures(Feature_Envelope);
+    position = 0;
+    Run(*analyzer, *data, clicks, position, 20, deltaTime);
+    float loudPeak = Max(data->SpectrumPeak, SpectrumAnalyzer::NUM_BINS);
+    analyzer->SetRequiredFeatures(Feature_Spectrum);
+    size_t quiet = 0;
+    Run(*analyzer, *data, silence, quiet, 4, deltaTime);
+    analyzer->SetRequiredFeatures(Feature_Envelope);
+    Run(*analyzer, *data, silence, quiet, 1, deltaTime);
+    float quietPeak = Max(data->SpectrumPeak, SpectrumAnalyzer::NUM_BINS);
+    printf("      peak envelope %.2f before, %.2f after switching back on in silence\n", loudPeak, quietPeak);
+    Check("peak envelopes start over when their stage comes back", loudPeak > 0.5f && quietPeak < 0.05f);
+
+    return TestResult();
+}
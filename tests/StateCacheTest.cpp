@@ -0,0 +1,120 @@
+// Checks the state cache against a recording context: the first call of each
+// kind is issued, repeats are elided and changes issued, the counters add up
+// and reset, and Invalidate/Forget make the next call go through. Returns
+// non-zero on failure.
+
+#include "StateCache.h"
+#include "TestUtil.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Records every call that reaches the context, as "<kind>:<object>:<value>"
+class RecordingContext : public StateContext {
+public:
+    std::vector<std::string> calls;
+
+    void SetVertexBuffer(ID3D11Buffer* buffer, unsigned stride) override { Record("vb", buffer, stride); }
+    void SetInputLayout(ID3D11InputLayout* layout) override { Record("il", layout); }
+    void SetTopology(int topology) override { Record("topo", nullptr, topology); }
+    void SetVertexShader(ID3D11VertexShader* shader) override { Record("vs", shader); }
+    void SetPixelShader(ID3D11PixelShader* shader) override { Record("ps", shader); }
+    void SetRenderTarget(ID3D11RenderTargetView* rtv, int width, int height) override { Record("rt", rtv, width * 10000 + height); }
+    void SetShaderResource(ID3D11ShaderResourceView* srv) override { Record("srv", srv); }
+    void SetBlendState(ID3D11BlendState* state) override { Record("blend", state); }
+    void SetSampler(ID3D11SamplerState* sampler) override { Record("sampler", sampler); }
+    void SetRasterizerState(ID3D11RasterizerState* state) override { Record("rs", state); }
+
+private:
+    void Record(const char* kind, const void* value, long extra = 0) {
+        char call[64];
+        snprintf(call, sizeof(call), "%s:%p:%ld", kind, value, extra);
+        calls.push_back(call);
+    }
+};
+
+// Distinct fake object addresses; never dereferenced
+template <typename T>
+static T* Fake(int id) {
+    return reinterpret_cast<T*>((uintptr_t)(0x1000 * id));
+}
+
+int main() {
+    RecordingContext context;
+    StateCache cache(&context);
+
+    ID3D11Buffer* vertices = Fake<ID3D11Buffer>(1);
+    ID3D11Buffer* segments = Fake<ID3D11Buffer>(2);
+    ID3D11VertexShader* vs = Fake<ID3D11VertexShader>(3);
+    ID3D11PixelShader* ps = Fake<ID3D11PixelShader>(4);
+    ID3D11RenderTargetView* backBuffer = Fake<ID3D11RenderTargetView>(5);
+    ID3D11RenderTargetView* history = Fake<ID3D11RenderTargetView>(6);
+    ID3D11ShaderResourceView* historySrv = Fake<ID3D11ShaderResourceView>(7);
+
+    // Nothing is known at first, including null state
+    cache.SetShaderResource(nullptr);
+    cache.SetVertexBuffer(vertices, 16);
+    cache.SetVertexShader(vs);
+    cache.SetPixelShader(ps);
+    cache.SetRenderTarget(backBuffer, 1280, 720);
+    Check("first calls issued", context.calls.size() == 5 && cache.GetTotals().issued == 5);
+
+    // The draw path sets its whole pipeline before every run
+    for (int i = 0; i < 10; i++) {
+        cache.SetShaderResource(nullptr);
+        cache.SetVertexBuffer(vertices, 16);
+        cache.SetVertexShader(vs);
+        cache.SetPixelShader(ps);
+        cache.SetRenderTarget(backBuffer, 1280, 720);
+    }
+    Check("repeats elided", context.calls.size() == 5 && cache.GetTotals().elided == 50);
+    Check("per-kind counters", cache.GetCounters(StateCache::Kind_PixelShader).issued == 1 &&
+                               cache.GetCounters(StateCache::Kind_PixelShader).elided == 10 &&
+                               cache.GetCounters(StateCache::Kind_Sampler).issued == 0);
+
+    // A change in any part of a call issues it
+    cache.SetVertexBuffer(segments, 16);
+    cache.SetVertexBuffer(segments, 20);
+    cache.SetRenderTarget(backBuffer, 640, 720);
+    cache.SetShaderResource(historySrv);
+    char last[64];
+    snprintf(last, sizeof(last), "srv:%p:0", (void*)historySrv);
+    Check("changes issued", context.calls.size() == 9 && context.calls.back() == last);
+    Check("bound shader resource", cache.GetShaderResource() == historySrv);
+
+    cache.ResetCounters();
+    Check("counters reset", cache.GetTotals().issued == 0 && cache.GetTotals().elided == 0);
+
+    // Released views: a new texture may get the same address
+    cache.SetRenderTarget(history, 640, 360);
+    cache.Forget(history);
+    cache.Forget(historySrv);
+    Check("forgotten resource unknown", cache.GetShaderResource() == nullptr);
+    size_t before = context.calls.size();
+    cache.SetRenderTarget(history, 640, 360);
+    cache.SetShaderResource(historySrv);
+    cache.SetVertexBuffer(segments, 20);
+    Check("forgotten views rebound", context.calls.size() == before + 2);
+
+    // Forgetting a view that isn't bound keeps the bound one
+    cache.Forget(backBuffer);
+    before = context.calls.size();
+    cache.SetRenderTarget(history, 640, 360);
+    Check("other view still bound", context.calls.size() == before);
+
+    // The context was touched outside the cache (swap chain resize)
+    cache.Invalidate();
+    before = context.calls.size();
+    cache.SetVertexBuffer(segments, 20);
+    cache.SetPixelShader(ps);
+    cache.SetRenderTarget(history, 640, 360);
+    Check("invalidate reissues", context.calls.size() == before + 3);
+
+    RecordingContext other;
+    cache.SetContext(&other);
+    cache.SetPixelShader(ps);
+    Check("new context starts unknown", other.calls.size() == 1);
+
+    return TestResult();
+}
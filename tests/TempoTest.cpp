@@ -0,0 +1,104 @@
+// Offline check of the tempo tracker against synthesized click tracks.
+// Each track is written to a WAV file, read back through WavReader and fed
+// through SpectrumAnalyzer one block at a time, the same way the capture
+// thread does. Returns non-zero if any track misses.
+
+#include "SpectrumAnalyzer.h"
+#include "WavReader.h"
+#include "TestUtil.h"
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct TrackResult {
+    float bpm = 0.0f;
+    float confidence = 0.0f;
+    float phaseError = 0.0f;  // Mean distance of BeatPhase from 0 on click blocks
+};
+
+static bool RunTrack(const std::string& path, float clickBpm, TrackResult& result) {
+    WavData wav;
+    if (!ReadWavFile(path, wav)) return false;
+
+    std::unique_ptr<SpectrumAnalyzer> analyzer(new SpectrumAnalyzer());
+    std::unique_ptr<AudioData> data(new AudioData());
+    analyzer->SetSampleRate(wav.sampleRate);
+    analyzer->SetRequiredFeatures(Feature_Tempo);
+    // Re-estimate every BASE_UPDATE_HOPS blocks however slow the build is, so
+    // the result doesn't depend on timing
+    analyzer->GetTempoTracker().SetBudgetMicros(1e9f);
+
+    const int blockSize = SpectrumAnalyzer::FFT_SIZE;
+    std::vector<float> block(blockSize);
+    size_t blocks = wav.samples.size() / blockSize;
+    double beatLength = 60.0 / clickBpm;
+    float phaseErrorSum = 0.0f;
+    int phaseSamples = 0;
+
+    for (size_t b = 0; b < blocks; b++) {
+        std::copy(wav.samples.begin() + b * blockSize, wav.samples.begin() + (b + 1) * blockSize, block.begin());
+        analyzer->Process(block, (float)blockSize / wav.sampleRate, *data);
+
+        // Over the second half, check the phase wraps on the blocks where clicks start
+        if (b < blocks / 2 || clickBpm <= 0.0f) continue;
+        double blockStart = (double)b * blockSize / wav.sampleRate;
+        double blockEnd = (double)(b + 1) * blockSize / wav.sampleRate;
+        double nextBeat = ceil(blockStart / beatLength) * beatLength;
+        if (nextBeat < blockEnd) {
+            float distance = data->BeatPhase < 0.5f ? data->BeatPhase : 1.0f - data->BeatPhase;
+            phaseErrorSum += distance;
+            phaseSamples++;
+        }
+    }
+
+    result.bpm = data->TempoBPM;
+    result.confidence = data->TempoConfidence;
+    result.phaseError = phaseSamples > 0 ? phaseErrorSum / phaseSamples : 0.0f;
+    return true;
+}
+
+int main() {
+    struct Case { float bpm; int sampleRate; };
+    // 96 kHz doubles the block rate; the slowest beats still need to fit the onset ring
+    const Case cases[] = { {90.0f, 48000}, {120.0f, 48000}, {128.0f, 44100}, {140.0f, 48000}, {174.0f, 44100},
+                           {120.0f, 96000}, {90.0f, 96000}, {140.0f, 88200} };
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+
+    for (const Case& c : cases) {
+        std::string path = (dir / ("tempo_click_" + std::to_string((int)c.bpm) + "_" + std::to_string(c.sampleRate) + ".wav")).string();
+        if (!WriteWav(path, ClickTrack(c.bpm, c.sampleRate, 20.0f), c.sampleRate)) {
+            std::cerr << "Could not write " << path << std::endl;
+            return 1;
+        }
+
+        TrackResult result;
+        bool ok = RunTrack(path, c.bpm, result);
+        std::remove(path.c_str());
+
+        ok = ok && fabsf(result.bpm - c.bpm) <= c.bpm * 0.02f && result.confidence > 0.3f && result.phaseError < 0.15f;
+        char name[128];
+        snprintf(name, sizeof(name), "click %5.1f BPM @ %d Hz -> %6.2f BPM, confidence %.2f, phase error %.3f",
+                 c.bpm, c.sampleRate, result.bpm, result.confidence, result.phaseError);
+        Check(name, ok);
+    }
+
+    // Silence must not produce a tempo
+    {
+        std::string path = (dir / "tempo_silence.wav").string();
+        WriteWav(path, std::vector<float>(48000 * 10, 0.0f), 48000);
+        TrackResult result;
+        bool ok = RunTrack(path, 0.0f, result);
+        std::remove(path.c_str());
+        ok = ok && result.bpm == 0.0f;
+        char name[64];
+        snprintf(name, sizeof(name), "silence -> %.2f BPM", result.bpm);
+        Check(name, ok);
+    }
+
+    return TestResult();
+}
@@ -0,0 +1,58 @@
+#pragma once
+// Shared by the offline tests, one executable each: the PASS/FAIL harness
+// and synthesized WAV input.
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+inline int s_failures = 0;
+
+inline void Check(const char* name, bool ok) {
+    printf("%s  %s\n", ok ? "PASS" : "FAIL", name);
+    if (!ok) s_failures++;
+}
+
+// Prints the verdict; returns the test's exit code
+inline int TestResult() {
+    printf("%s\n", s_failures == 0 ? "All tests passed" : "FAILED");
+    return s_failures == 0 ? 0 : 1;
+}
+
+// 16-bit PCM; samples are interleaved when there is more than one channel
+inline bool WriteWav(const std::string& path, const std::vector<float>& samples, int sampleRate, int channels = 1) {
+    auto writeU32 = [](std::ofstream& f, uint32_t v) { f.write((const char*)&v, 4); };
+    auto writeU16 = [](std::ofstream& f, uint16_t v) { f.write((const char*)&v, 2); };
+    std::ofstream f(path, std::ios::binary);
+    if (!f) return false;
+    uint32_t dataSize = (uint32_t)samples.size() * 2;
+    f.write("RIFF", 4); writeU32(f, 36 + dataSize); f.write("WAVE", 4);
+    f.write("fmt ", 4); writeU32(f, 16); writeU16(f, 1); writeU16(f, (uint16_t)channels);
+    writeU32(f, sampleRate); writeU32(f, sampleRate * channels * 2); writeU16(f, (uint16_t)(channels * 2)); writeU16(f, 16);
+    f.write("data", 4); writeU32(f, dataSize);
+    for (float s : samples) {
+        float c = s < -1.0f ? -1.0f : (s > 1.0f ? 1.0f : s);
+        writeU16(f, (uint16_t)(int16_t)(c * 32767.0f));
+    }
+    return (bool)f;
+}
+
+// Short decaying 1 kHz bursts on every beat (mono)
+inline std::vector<float> ClickTrack(float bpm, int sampleRate, float seconds) {
+    std::vector<float> samples((size_t)(sampleRate * seconds), 0.0f);
+    double beatLength = 60.0 / bpm;
+    for (double beat = 0.0; beat < seconds; beat += beatLength) {
+        size_t start = (size_t)(beat * sampleRate);
+        for (int i = 0; i < sampleRate / 50 && start + i < samples.size(); i++) {
+            double t = (double)i / sampleRate;
+            samples[start + i] += 0.8f * (float)(exp(-t * 300.0) * sin(2.0 * M_PI * 1000.0 * t));
+        }
+    }
+    return samples;
+}
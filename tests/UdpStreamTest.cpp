@@ -0,0 +1,163 @@
+// Checks the UDP spectrum stream: the delta encoding round-trips exactly,
+// a lost datagram is counted and recovered at the next key frame, and
+// frames pushed through the streamer arrive over loopback in order with
+// low latency. Returns non-zero on failure.
+
+#include "SpectrumStream.h"
+#include "TestUtil.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+static const int BANDS = 32;
+
+// Slowly drifting bands with an occasional jump, so both the nibble and
+// the byte delta paths are used
+static void MakeFrame(int n, uint8_t* bands) {
+    for (int b = 0; b < BANDS; b++) {
+        int v = 128 + (int)(100.0 * sin(n * 0.05 + b * 0.3));
+        if (n % 23 == 0 && b == 5) v = 255 - v;
+        bands[b] = (uint8_t)v;
+    }
+}
+
+static double NowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main() {
+    // Round trip, several frames per datagram
+    {
+        SpectrumStreamEncoder encoder(BANDS);
+        SpectrumStreamDecoder decoder;
+        std::vector<StreamFrame> out;
+        std::vector<std::vector<uint8_t>> sent;
+        size_t bytes = 0, datagrams = 0;
+        uint8_t bands[BANDS];
+        for (int n = 0; n < 400; n++) {
+            MakeFrame(n, bands);
+            sent.emplace_back(bands, bands + BANDS);
+            if (n % 4 == 0 && encoder.GetFrameCount() > 0) {
+                const std::vector<uint8_t>& d = encoder.Finish();
+                decoder.Decode(d.data(), d.size(), out);
+                bytes += d.size();
+                datagrams++;
+                encoder.Begin();
+            }
+            encoder.Add(bands, 1000000 + (uint64_t)n * 10667);
+        }
+        const std::vector<uint8_t>& d = encoder.Finish();
+        decoder.Decode(d.data(), d.size(), out);
+        bytes += d.size();
+        datagrams++;
+
+        bool exact = out.size() == sent.size();
+        for (size_t i = 0; exact && i < out.size(); i++) {
+            exact = out[i].sequence == i && out[i].bands == sent[i] &&
+                    out[i].timestampMicros == 1000000 + (uint64_t)i * 10667;
+        }
+        Check("round trip is exact", exact);
+        Check("no losses reported", decoder.GetLost() == 0 && decoder.GetSkipped() == 0 && decoder.GetMalformed() == 0);
+        double perFrame = (double)bytes / sent.size();
+        printf("      %.1f bytes/frame for %d bands (%zu datagrams)\n", perFrame, BANDS, datagrams);
+        Check("delta frames are smaller than raw bands", perFrame < BANDS);
+    }
+
+    // A full datagram stops accepting frames instead of overflowing
+    {
+        SpectrumStreamEncoder encoder(SpectrumStream::MAX_BANDS);
+        std::vector<uint8_t> bands(SpectrumStream::MAX_BANDS);
+        int added = 0;
+        for (int n = 0; n < 100; n++) {
+            for (size_t b = 0; b < bands.size(); b++) bands[b] = (uint8_t)((n * 97 + b * 31) & 0xFF);
+            if (!encoder.Add(bands.data(), n)) break;
+            added++;
+        }
+        Check("datagram stays under MAX_DATAGRAM", added > 0 && added < 100 &&
+              encoder.Finish().size() <= SpectrumStream::MAX_DATAGRAM);
+    }
+
+    // Dropping a datagram: counted as lost, deltas skipped until the next key
+    {
+        SpectrumStreamEncoder encoder(BANDS);
+        SpectrumStreamDecoder decoder;
+        std::vector<StreamFrame> out;
+        uint8_t bands[BANDS];
+        std::vector<uint8_t> last;
+        for (int n = 0; n < 40; n++) {
+            MakeFrame(n, bands);
+            encoder.Begin();
+            encoder.Add(bands, n);
+            const std::vector<uint8_t>& d = encoder.Finish();
+            if (n != 3) decoder.Decode(d.data(), d.size(), out);
+            if (n == 39) last.assign(bands, bands + BANDS);
+        }
+        // Frame 3 lost, 4-15 undecodable, key at 16 resyncs
+        Check("lost frame counted", decoder.GetLost() == 1);
+        Check("deltas skipped until the key", decoder.GetSkipped() == SpectrumStream::KEYFRAME_INTERVAL - 4);
+        Check("resynced at the key", !out.empty() && out[3].sequence == SpectrumStream::KEYFRAME_INTERVAL);
+        Check("values exact after resync", !out.empty() && out.back().bands == last);
+
+        // A stale datagram replayed after newer ones is dropped
+        SpectrumStreamEncoder replay(BANDS);
+        replay.Add(bands, 0);
+        size_t before = out.size();
+        decoder.Decode(replay.Finish().data(), replay.Finish().size(), out);
+        Check("late datagram dropped", out.size() == before && decoder.GetLate() == 1);
+
+        uint8_t junk[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+        Check("malformed datagram rejected", !decoder.Decode(junk, sizeof(junk), out) && decoder.GetMalformed() == 1);
+    }
+
+    // Loopback end to end through the streamer
+    {
+        UdpSocket receiver;
+        bool bound = receiver.Bind(0);
+        int port = receiver.GetLocalPort();
+        Check("receiver bound", bound && port > 0);
+
+        SpectrumStreamer streamer;
+        Check("streamer started", streamer.Start("127.0.0.1:" + std::to_string(port), BANDS));
+
+        const int FRAMES = 500;
+        std::vector<float> spectrum(256);
+        std::vector<StreamFrame> out;
+        std::vector<double> latencies;
+        SpectrumStreamDecoder decoder;
+        std::vector<uint8_t> buffer(65536);
+        std::thread reader([&] {
+            while ((int)out.size() < FRAMES) {
+                int received = receiver.Receive(buffer.data(), buffer.size(), 2000);
+                if (received <= 0) break;
+                size_t first = out.size();
+                decoder.Decode(buffer.data(), (size_t)received, out);
+                double now = NowSeconds() * 1e6;
+                for (size_t i = first; i < out.size(); i++) latencies.push_back((now - out[i].timestampMicros) / 1000.0);
+            }
+        });
+
+        // Real block rate would take 5 s; 1 ms spacing keeps the test quick
+        for (int n = 0; n < FRAMES; n++) {
+            for (int i = 0; i < 256; i++) spectrum[i] = 0.5f + 0.5f * (float)sin(n * 0.05 + i * 0.01);
+            streamer.Push(spectrum.data(), 256, NowSeconds());
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        reader.join();
+        streamer.Stop();
+
+        bool ordered = true;
+        for (size_t i = 0; i < out.size(); i++) ordered = ordered && out[i].sequence == i;
+        double mean = 0.0;
+        for (double l : latencies) mean += l;
+        if (!latencies.empty()) mean /= latencies.size();
+        printf("      %zu frames in %llu datagrams, %llu dropped, mean latency %.3f ms\n", out.size(),
+               (unsigned long long)streamer.GetSentDatagrams(), (unsigned long long)streamer.GetDroppedFrames(), mean);
+        Check("every frame arrived in order", (int)out.size() == FRAMES && ordered && decoder.GetLost() == 0);
+        Check("latency under 20 ms", !latencies.empty() && mean < 20.0);
+        Check("streamer stopped", !streamer.IsRunning());
+    }
+
+    return TestResult();
+}
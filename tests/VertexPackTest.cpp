@@ -0,0 +1,60 @@
+// Checks the 16-byte vertex packing: the SSE2 packer matches the scalar
+// reference bit for bit, values the visualizations rely on (+-1 positions,
+// 0/1 texture coordinates, the -1 solid flag, small fade alphas) survive
+// exactly or closely, and out-of-range fields clamp. Returns non-zero on failure.
+
+#include "VertexPacking.h"
+#include "TestUtil.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+int main() {
+    // Random vertices, a fair share out of range
+    std::vector<Vertex> vertices(10007);
+    uint32_t seed = 7;
+    auto next = [&seed](float lo, float hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * ((seed >> 8) / 16777216.0f);
+    };
+    for (Vertex& v : vertices) {
+        v.position = { next(-5.0f, 5.0f), next(-5.0f, 5.0f), next(0.0f, 1.0f) };
+        v.color = { next(-0.2f, 1.2f), next(-0.2f, 1.2f), next(-0.2f, 1.2f), next(-0.2f, 1.2f) };
+        v.texCoord = { next(-1.5f, 1.5f), next(-1.5f, 1.5f) };
+    }
+    std::vector<PackedVertex> simd(vertices.size()), scalar(vertices.size());
+    PackVertices(vertices.data(), simd.data(), (int)vertices.size());
+    PackVerticesScalar(vertices.data(), scalar.data(), (int)vertices.size());
+    Check("vectorized packer matches scalar", memcmp(simd.data(), scalar.data(), simd.size() * sizeof(PackedVertex)) == 0);
+
+    // Full-screen textured quad corner: exact
+    Vertex corner = { { -1.0f, 1.0f, 0.0f }, { 1.0f, 1.0f, 1.0f, 1.0f }, { 0.0f, 1.0f } };
+    PackedVertex packed;
+    PackVertices(&corner, &packed, 1);
+    Vertex back = UnpackVertex(packed);
+    Check("+-1 position exact", back.position.x == -1.0f && back.position.y == 1.0f);
+    Check("0/1 texCoord exact", back.texCoord.x == 0.0f && back.texCoord.y == 1.0f);
+    Check("white exact", back.color.x == 1.0f && back.color.w == 1.0f);
+
+    // Solid vertex with a faint fade overlay
+    Vertex fade = { { 0.3f, -0.7f, 0.5f }, { 0.0f, 0.0f, 0.0f, 0.005f }, { -1.0f, -1.0f } };
+    PackVertices(&fade, &packed, 1);
+    back = UnpackVertex(packed);
+    Check("solid flag survives", back.texCoord.x == -1.0f && back.texCoord.y == -1.0f);
+    Check("small alpha kept to 1e-4", fabsf(back.color.w - 0.005f) < 1e-4f);
+    Check("position within 1/16384", fabsf(back.position.x - 0.3f) <= 0.5f / POSITION_SCALE &&
+                                     fabsf(back.position.y + 0.7f) <= 0.5f / POSITION_SCALE);
+
+    // Out of range: clamped, not wrapped
+    Vertex wild = { { 100.0f, -100.0f, 0.0f }, { 2.0f, -1.0f, 0.5f, 1.0f }, { 3.0f, -3.0f } };
+    PackVertices(&wild, &packed, 1);
+    back = UnpackVertex(packed);
+    Check("position clamps to +-4", back.position.x > 3.99f && back.position.y < -3.99f);
+    Check("colour clamps to 0..1", back.color.x == 1.0f && back.color.y == 0.0f);
+    Check("texCoord clamps to +-1", back.texCoord.x == 1.0f && back.texCoord.y == -1.0f);
+
+    Check("36 -> 16 bytes per vertex", sizeof(Vertex) == 36 && sizeof(PackedVertex) == 16);
+
+    return TestResult();
+}
@@ -0,0 +1,10 @@
+// Batch library analysis on any platform: walks a directory of WAV files
+// and fills the per-track feature cache (see LibraryAnalyzer.h).
+//
+// Usage: MusicVisAnalyze [--cache <dir>] [--threads <n>] <directory>
+
+#include "LibraryAnalyzer.h"
+
+int main(int argc, char** argv) {
+    return RunLibraryAnalysis(argc, argv);
+}
@@ -0,0 +1,11 @@
+// Renders the visualizations on the CPU and writes the last frame of each
+// as a BMP (see HeadlessRenderer.h). Runs anywhere, no GPU needed.
+//
+// Usage: MusicVisHeadless [--wav <file>] [--frames <n>] [--fps <n>]
+//        [--size <w>x<h>] [--vis <name>] [--out <dir>] [--threads <n>]
+
+#include "HeadlessRenderer.h"
+
+int main(int argc, char** argv) {
+    return RunHeadless(argc, argv);
+}
@@ -0,0 +1,62 @@
+// Receives the UDP spectrum stream (config udpOutput) and prints, once a
+// second, the frame rate, losses, latency and the latest bands. Sender and
+// receiver must share a steady clock for the latency to mean anything, so
+// run it on the same machine.
+//
+// Usage: SpectrumReceiver [port]
+
+#include "SpectrumStream.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+int main(int argc, char** argv) {
+    int port = argc > 1 ? atoi(argv[1]) : SpectrumStream::DEFAULT_PORT;
+    UdpSocket socket;
+    if (!socket.Bind(port)) return 1;
+    printf("Listening on UDP port %d\n", socket.GetLocalPort());
+
+    SpectrumStreamDecoder decoder;
+    std::vector<uint8_t> buffer(65536);
+    std::vector<StreamFrame> frames;
+    std::vector<double> latencies;
+    StreamFrame latest;
+    uint64_t framesThisSecond = 0;
+    auto reportAt = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+    while (true) {
+        int received = socket.Receive(buffer.data(), buffer.size(), 100);
+        if (received < 0) return 1;
+        if (received > 0) {
+            frames.clear();
+            decoder.Decode(buffer.data(), (size_t)received, frames);
+            double now = std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            for (const StreamFrame& frame : frames) latencies.push_back((now - (double)frame.timestampMicros) / 1000.0);
+            framesThisSecond += frames.size();
+            if (!frames.empty()) latest = frames.back();
+        }
+
+        if (std::chrono::steady_clock::now() < reportAt) continue;
+        reportAt += std::chrono::seconds(1);
+
+        double mean = 0.0, p99 = 0.0;
+        if (!latencies.empty()) {
+            for (double l : latencies) mean += l;
+            mean /= latencies.size();
+            std::sort(latencies.begin(), latencies.end());
+            p99 = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+        }
+        printf("%4llu fps  lost %llu  skipped %llu  late %llu  latency %.2f ms (p99 %.2f)  ",
+               (unsigned long long)framesThisSecond, (unsigned long long)decoder.GetLost(),
+               (unsigned long long)decoder.GetSkipped(), (unsigned long long)decoder.GetLate(), mean, p99);
+        static const char levels[] = " .:-=+*#%@";
+        for (uint8_t band : latest.bands) putchar(levels[band * 9 / 255]);
+        printf("\n");
+        fflush(stdout);
+        framesThisSecond = 0;
+        latencies.clear();
+    }
+}